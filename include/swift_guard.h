@@ -1,11 +1,17 @@
 /* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * 데이터 경로 ABI (XDP 프로그램과 데몬이 공유하는 상수, 맵 키/값 구조체)
+ *
+ * xdp_filter.c가 포함하고, 데몬은 빌드 시 이 헤더에서 Rust 바인딩을 생성한다
+ * (src/daemon/build.rs). build.rs는 정수 상수 매크로와 고정 폭 정수, 배열, 구조체
+ * 필드만 해석하므로 그 밖의 선언은 추가하지 않는다. 맵 키/값 구조체는 암묵적 패딩
+ * 없이 배치하여 데몬이 구조체를 바이트 그대로 읽고 쓸 수 있게 한다.
+ */
 #ifndef __SWIFT_GUARD_H
 #define __SWIFT_GUARD_H
 
-/* 상수 정의 */
-#define MAX_FILTER_RULES   10240
-#define MAX_REDIRECT_IFS   64
-#define MAX_RULE_LABEL_LEN 32
+#include <stdint.h>
+#include <linux/bpf.h>  /* struct bpf_spin_lock */
 
 /* 프로토콜 정의 */
 #define IPPROTO_ANY 255
@@ -15,6 +21,18 @@
 #define ACTION_DROP     2
 #define ACTION_REDIRECT 3
 #define ACTION_COUNT    4
+#define ACTION_REDIRECT_CPU 5
+#define ACTION_REDIRECT_XSK 6   /* 수신 큐의 AF_XDP 소켓으로 (WASM 검사) */
+#define ACTION_SYNPROXY     7   /* SYN은 쿠키 SYN-ACK로 응답, 검증된 ACK와 흐름만 통과 */
+
+/* 판정별 전역 통계 인덱스 (stats_map 키) */
+#define STAT_PASS       0
+#define STAT_DROP       1
+#define STAT_REDIRECT   2
+#define STAT_ABORTED    3
+#define STAT_PARSE_FAIL 4
+#define STAT_TX         5
+#define STAT_MAX        6
 
 /* TCP 플래그 정의 */
 #define TCP_FLAG_FIN  0x01
@@ -24,37 +42,229 @@
 #define TCP_FLAG_ACK  0x10
 #define TCP_FLAG_URG  0x20
 
+/* 맵 상수 */
+#define MAX_FILTER_RULES 4096
+#define MAX_REDIRECT_IFS 64
+#define MAX_REDIRECT_CPUS 128
+#define MAX_XSK_QUEUES 64
+#define MAX_STAT_QUEUES 64
+#define MAX_RATE_SOURCES 65536
+
+/* 소스 프리픽스 블록리스트 (기본 크기, 데몬이 로드 시 xdp.map_sizes로 변경) */
+#define MAX_BLOCKLISTS        64
+#define BLOCKLIST_V4_ENTRIES  1048576
+#define BLOCKLIST_V6_ENTRIES  65536
+
+/* 규칙 플래그 (rule_verdict.flags) */
+#define RULE_F_RATE_PER_SRC 0x01   /* 레이트 리밋을 소스 IP별로 적용 */
+
+/* 흐름 캐시 상수 (CPU별 LRU, 규칙 변경 시 세대 번호로 무효화) */
+#define FLOW_CACHE_ENTRIES 65536
+#define FLOW_F_MATCHED     0x01   /* 매치된 규칙 있음 (없으면 매치 없음 캐시) */
+
+/* 샘플 이벤트 상수 (헤더 캡처 길이, 링 버퍼 크기) */
+#define EVENT_SNAP_LEN     128
+#define EVENT_RINGBUF_SIZE (4 << 20)
+
+/* SYN 프록시 상수 (쿠키로 검증된 흐름 수, 응답 TCP 헤더 = 기본 헤더 + MSS 옵션) */
+#define SYNPROXY_FLOW_ENTRIES 262144
+#define SYNPROXY_TCP_LEN      24
+
+/* 소스별 헤비 히터 탐지 상수 (count-min 스케치 HH_DEPTH x HH_WIDTH, CPU별 top-K 후보) */
+#define HH_DEPTH      4
+#define HH_WIDTH_BITS 10
+#define HH_WIDTH      (1 << HH_WIDTH_BITS)
+#define HH_TOPK       16
+#define HH_SLOTS      2                              /* 데몬이 읽는 구간 + 기록 중인 구간 */
+#define HH_TOPK_EVERY 16                             /* 추정치가 이 값의 배수일 때만 후보 표 갱신 */
+
+/* 규칙 집합 슬롯 수 (활성 집합 + 준비 중인 집합) */
+#define CLS_SLOTS 2
+
+/* 테일 콜 파이프라인 단계 (pipeline 프로그램 배열 인덱스) */
+#define STAGE_CLASSIFY_V4 0
+#define STAGE_CLASSIFY_V6 1
+#define STAGE_RATE_LIMIT  2
+#define STAGE_SAMPLE      3
+#define STAGE_ACTION_BASE 4                          /* 액션별 단계 (ACTION_PASS .. ACTION_SYNPROXY) */
+#define STAGE_ACTION(a)   (STAGE_ACTION_BASE + (a) - 1)
+#define PIPELINE_STAGES   (STAGE_ACTION_BASE + 7)
+#define PIPELINE_MAX_L3_OFF 64                       /* 이더넷 + VLAN 태그 최대 길이 이상 */
+
+/*
+ * 정책 특화 기능 (SG_FEATURES 비트마스크, src/bpf/Makefile이 변형마다 지정)
+ * 컴파일 시 상수이므로 꺼진 기능의 검사는 오브젝트에서 제거된다.
+ */
+#define SG_F_SRC_ADDR   0x001    /* 소스 프리픽스 */
+#define SG_F_DST_ADDR   0x002    /* 대상 프리픽스 */
+#define SG_F_PROTO      0x004    /* IP 프로토콜 */
+#define SG_F_PORTS      0x008    /* 소스/대상 포트 구간 */
+#define SG_F_TCP_FLAGS  0x010    /* TCP 플래그 */
+#define SG_F_EXPIRE     0x020    /* 규칙 만료 */
+#define SG_F_RATE_LIMIT 0x040    /* 레이트 리밋 */
+#define SG_F_SAMPLE     0x080    /* 이벤트 샘플링 */
+#define SG_F_REDIRECT   0x100    /* 인터페이스/CPU/AF_XDP 리디렉션 */
+#define SG_F_SYNPROXY   0x200    /* SYN 프록시 */
+#define SG_F_ALL        0x3ff
+
+
+/* 분류기 상수 (필드별 비트맵 교집합) */
+#define CLS_BITMAP_WORDS     (MAX_FILTER_RULES / 64) /* 규칙 비트맵 워드 수 */
+#define CLS_MAX_PREFIXES     16384                   /* 필드별 LPM 프리픽스 수 */
+#define CLS_MAX_PORT_CLASSES (2 * MAX_FILTER_RULES + 1) /* 포트 구간 클래스 수 */
+#define CLS_PORT_SPACE       65536
+
+/* cls_bitmaps 인덱스 배치 */
+#define CLS_BM_PROTO_BASE     0                      /* IP 프로토콜 번호별 (256개) */
+#define CLS_BM_TCP_FLAGS_BASE 256                    /* TCP 플래그 조합별 (64개 + 비 TCP 1개 + 조각 1개) */
+#define CLS_TCP_FLAGS_NONE    64                     /* 비 TCP 패킷의 플래그 인덱스 */
+#define CLS_TCP_FLAGS_FRAG    65                     /* L4 헤더가 없는 조각의 플래그 인덱스 */
+#define CLS_BM_SPORT_BASE     (CLS_BM_TCP_FLAGS_BASE + 66)
+#define CLS_BM_DPORT_BASE     (CLS_BM_SPORT_BASE + CLS_MAX_PORT_CLASSES)
+#define CLS_BM_SPORT_UNKNOWN  (CLS_BM_DPORT_BASE + CLS_MAX_PORT_CLASSES)  /* 포트를 알 수 없는 조각 */
+#define CLS_BM_DPORT_UNKNOWN  (CLS_BM_SPORT_UNKNOWN + 1)
+#define CLS_BM_ENTRIES        (CLS_BM_DPORT_UNKNOWN + 1)
+
+/* cls_port_class 인덱스 배치 */
+#define CLS_PC_SPORT_BASE 0
+#define CLS_PC_DPORT_BASE CLS_PORT_SPACE
+
 /* 구조체 정의 */
 struct prefix_key {
-    __u32 prefix_len;  /* LPM 트라이의 프리픽스 길이 */
-    __u32 addr;        /* IPv4 주소 */
+    uint32_t prefix_len;  /* LPM 트라이의 프리픽스 길이 */
+    uint32_t addr;        /* IPv4 주소 */
+};
+
+struct prefix_key_v6 {
+    uint32_t prefix_len;  /* LPM 트라이의 프리픽스 길이 */
+    uint8_t addr[16];     /* IPv6 주소 */
 };
 
 struct filter_stats {
-    __u64 packets;      /* 처리된 패킷 수 */
-    __u64 bytes;        /* 처리된 바이트 수 */
-    __u64 last_matched; /* 마지막 매치 타임스탬프 */
-};
-
-struct filter_rule {
-    __u32 priority;          /* 룰 우선순위 */
-    __u8 action;             /* 액션 (통과, 드롭, 리디렉션) */
-    __u8 protocol;           /* 프로토콜 (TCP, UDP, ICMP, ANY) */
-    __u16 src_port_min;      /* 소스 포트 범위 최소값 */
-    __u16 src_port_max;      /* 소스 포트 범위 최대값 */
-    __u16 dst_port_min;      /* 대상 포트 범위 최소값 */
-    __u16 dst_port_max;      /* 대상 포트 범위 최대값 */
-    __u8 tcp_flags;          /* TCP 플래그 (SYN, ACK, FIN 등) */
-    __u32 redirect_ifindex;  /* 리디렉션 인터페이스 인덱스 */
-    __u32 rate_limit;        /* 초당 패킷 수 레이트 리밋 */
-    __u32 expire;            /* 룰 만료 시간 (초) */
-    char label[MAX_RULE_LABEL_LEN]; /* 룰 레이블 */
-    struct filter_stats stats; /* 통계 */
-};
-
-struct if_redirect {
-    __u32 ifindex;           /* 인터페이스 인덱스 */
-    char ifname[16];         /* 인터페이스 이름 */
+    uint64_t packets;      /* 처리된 패킷 수 */
+    uint64_t bytes;        /* 처리된 바이트 수 */
+    uint64_t last_matched; /* 마지막 매치 타임스탬프 */
+};
+
+/* 분류 결과로 선택된 규칙의 판정 레코드 (패킷마다 읽는 값만 유지) */
+struct rule_verdict {
+    uint32_t rule_id;           /* 규칙 ID (통계 및 데몬 측 메타데이터 키) */
+    uint32_t redirect_target;   /* 리디렉션 대상 (인터페이스 인덱스 또는 CPU 번호) */
+    uint32_t rate_limit;        /* 초당 패킷 수 레이트 리밋 */
+    uint8_t action;             /* 액션 (통과, 드롭, 리디렉션) */
+    uint8_t flags;              /* RULE_F_* */
+    uint16_t sample_rate;       /* 이벤트 샘플링 비율 (1/N, 0 = 끔) */
+    uint64_t expire_ns;         /* 만료 시각 (bpf_ktime_get_ns 기준, 0 = 만료 없음) */
+};
+
+/* 규칙별 토큰 버킷 상태 */
+struct token_bucket {
+    struct bpf_spin_lock lock;
+    uint32_t pad;
+    uint64_t tokens;            /* 남은 토큰 x NSEC_PER_SEC */
+    uint64_t last_refill_ns;    /* 마지막 보충 시각 (bpf_ktime_get_ns) */
+};
+
+/* 소스별 토큰 버킷 상태 (LRU 맵은 스핀락 필드를 허용하지 않음) */
+struct src_bucket {
+    uint64_t tokens;            /* 남은 토큰 x NSEC_PER_SEC */
+    uint64_t last_refill_ns;    /* 마지막 보충 시각 (bpf_ktime_get_ns) */
+};
+
+/* 소스별 버킷 키 (IPv4 주소는 addr[0]에 저장) */
+struct src_bucket_key {
+    uint32_t rule_id;
+    uint32_t addr[4];
+};
+
+/* 규칙 비트맵 (비트 위치 = 우선순위 순서) */
+struct rule_bitmap {
+    uint64_t words[CLS_BITMAP_WORDS];
+};
+
+/* 분류기 구성 */
+struct cls_config {
+    uint32_t nwords;            /* 사용 중인 비트맵 워드 수 */
+    uint32_t nrules;            /* 컴파일된 규칙 수 */
+    uint32_t generation;        /* 규칙 집합 세대 (변경 시 데몬이 증가) */
+    uint32_t active;            /* 활성 규칙 집합 슬롯 (0 .. CLS_SLOTS-1) */
+};
+
+/* 흐름 캐시 키 (TCP 플래그 조건이 있는 규칙을 위해 플래그 포함, IPv4 주소는 [0]에 저장) */
+struct flow_key {
+    uint32_t saddr[4];
+    uint32_t daddr[4];
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t protocol;
+    uint8_t tcp_flags;
+    uint8_t family;             /* 4 또는 6 */
+    uint8_t pad;
+};
+
+/* 흐름 캐시 값 (분류 결과 판정 레코드의 사본) */
+struct flow_entry {
+    struct rule_verdict verdict;
+    uint32_t generation;        /* 캐시 시점의 cls_config 세대 */
+    uint32_t flags;             /* FLOW_F_* */
+};
+
+/* 블록리스트 구성 (주소 계열별 프리픽스 수, 0이면 조회 생략) */
+struct blocklist_config {
+    uint32_t nv4;
+    uint32_t nv6;
+};
+
+/* SYN 프록시 흐름 키 (네트워크 바이트 순서) */
+struct synproxy_key {
+    uint32_t saddr;
+    uint32_t daddr;
+    uint16_t sport;
+    uint16_t dport;
+};
+
+/* 헤비 히터 탐지 구성 (데몬이 수집 구간마다 epoch를 증가시켜 슬롯 전환) */
+struct hh_config {
+    uint32_t enabled;
+    uint32_t epoch;             /* 기록 슬롯 = epoch % HH_SLOTS */
+};
+
+/* 소스 IPv4 주소별 패킷 수 count-min 스케치 */
+struct hh_sketch {
+    uint32_t counts[HH_DEPTH][HH_WIDTH];
+};
+
+/* top-K 후보 (addr는 네트워크 바이트 순서, count는 기록 시점의 추정치) */
+struct hh_entry {
+    uint32_t addr;
+    uint32_t count;
+};
+
+struct hh_topk {
+    struct hh_entry entries[HH_TOPK];
+};
+
+/* 파이프라인 단계 사이에 전달되는 패킷 상태 (CPU별 1개, 테일 콜 체인은 한 CPU에서 끝남) */
+struct pipeline_state {
+    struct rule_verdict rule;      /* 분류 단계가 선택한 규칙 사본 */
+    struct src_bucket_key rl_key;  /* 소스별 레이트 리밋 키 */
+    uint16_t l3_off;               /* 이더넷/VLAN 헤더 뒤 L3 헤더 오프셋 */
+    uint8_t verdict;               /* 샘플 단계에 전달할 판정 */
+    uint8_t pad;
+};
+
+/* 샘플링된 패킷 이벤트 (events 링 버퍼 레코드) */
+struct packet_event {
+    uint64_t timestamp_ns;      /* bpf_ktime_get_ns */
+    uint32_t rule_id;
+    uint32_t ifindex;           /* 수신 인터페이스 */
+    uint32_t queue;             /* 수신 큐 */
+    uint32_t pkt_len;           /* 원래 패킷 길이 */
+    uint8_t verdict;            /* XDP 반환값 */
+    uint8_t action;             /* 규칙 액션 (ACTION_*) */
+    uint16_t snap_len;          /* data에 담긴 바이트 수 */
+    uint8_t pad[4];
+    uint8_t data[EVENT_SNAP_LEN];  /* 패킷 앞부분 (이더넷 헤더부터) */
 };
 
 #endif /* __SWIFT_GUARD_H */
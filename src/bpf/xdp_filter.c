@@ -2,10 +2,13 @@
 #include <linux/bpf.h>
 #include <bpf/bpf_helpers.h>
 #include <bpf/bpf_endian.h>
+#include <bpf/bpf_core_read.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "swift_guard.h"
+
 /* 패킷 헤더 정의 */
 struct ethhdr {
     unsigned char h_dest[6];
@@ -27,6 +30,34 @@ struct iphdr {
     uint32_t daddr;
 } __attribute__((packed));
 
+struct vlan_hdr {
+    uint16_t h_vlan_TCI;
+    uint16_t h_vlan_encapsulated_proto;
+} __attribute__((packed));
+
+struct ipv6_opt_hdr {
+    uint8_t nexthdr;
+    uint8_t hdrlen;       /* 8바이트 단위 길이 (첫 8바이트 제외) */
+} __attribute__((packed));
+
+struct frag_hdr {
+    uint8_t nexthdr;
+    uint8_t reserved;
+    uint16_t frag_off;
+    uint32_t identification;
+} __attribute__((packed));
+
+struct ipv6hdr {
+    uint8_t priority:4;
+    uint8_t version:4;
+    uint8_t flow_lbl[3];
+    uint16_t payload_len;
+    uint8_t nexthdr;
+    uint8_t hop_limit;
+    uint8_t saddr[16];
+    uint8_t daddr[16];
+} __attribute__((packed));
+
 struct tcphdr {
     uint16_t source;
     uint16_t dest;
@@ -57,211 +88,1622 @@ struct udphdr {
 #define IPPROTO_TCP 6
 #define IPPROTO_UDP 17
 #define IPPROTO_ICMP 1
-#define IPPROTO_ANY 255
+
+/* IPv6 확장 헤더 */
+#define IPPROTO_HOPOPTS  0
+#define IPPROTO_ROUTING  43
+#define IPPROTO_FRAGMENT 44
+#define IPPROTO_DSTOPTS  60
+
+/* 조각화 필드 */
+#define IP_MF      0x2000
+#define IP_OFFSET  0x1FFF
+#define IP6_OFFSET 0xFFF8
 
 /* 이더넷 프로토콜 */
 #define ETH_P_IP 0x0800
+#define ETH_P_IPV6 0x86DD
+#define ETH_P_8021Q 0x8100
+#define ETH_P_8021AD 0x88A8
+
+/* 헤더 파싱 한도 */
+#define VLAN_MAX_DEPTH    2
+#define IPV6_MAX_EXT_HDRS 4
 
 /* XDP 액션 */
 #define XDP_PASS 2
 #define XDP_DROP 1
 #define XDP_ABORTED 0
+#define XDP_TX 3
+#define XDP_REDIRECT 4
+
+/* 헤더 파싱 실패 (내부 반환값, 통계 기록 후 XDP_PASS로 처리) */
+#define XDP_PARSE_FAIL  (-1)
+
+/* 토큰 버킷 상수 (토큰은 NSEC_PER_SEC 배율로 저장, 버스트 = 1초 분량) */
+#define NSEC_PER_SEC 1000000000ULL
 
-/* 액션 정의 */
-#define ACTION_PASS     1
-#define ACTION_DROP     2
-#define ACTION_REDIRECT 3
-#define ACTION_COUNT    4
-
-/* TCP 플래그 정의 */
-#define TCP_FLAG_FIN  0x01
-#define TCP_FLAG_SYN  0x02
-#define TCP_FLAG_RST  0x04
-#define TCP_FLAG_PSH  0x08
-#define TCP_FLAG_ACK  0x10
-#define TCP_FLAG_URG  0x20
-
-/* 맵 상수 */
-#define MAX_FILTER_RULES 10240
-#define MAX_REDIRECT_IFS 64
-#define MAX_RULE_LABEL_LEN 32
-
-/* 구조체 정의 */
-struct prefix_key {
-    uint32_t prefix_len;  /* LPM 트라이의 프리픽스 길이 */
-    uint32_t addr;        /* IPv4 주소 */
+/* 분류 시 건너뛸 수 있는 만료 규칙 수 (데몬이 제거하기 전까지의 간극) */
+#define CLS_MAX_EXPIRED_SKIP 4
+
+/* SYN 프록시 응답 값 */
+#define SYNPROXY_WINDOW       65535
+#define SYNPROXY_TTL          64
+
+/* 커널에 syncookie 헬퍼가 있는지 (없으면 로드 시 상수 0이 되어 검증기가 호출 경로를 제외) */
+#define SYNCOOKIE_HELPERS bpf_core_enum_value_exists(enum bpf_func_id, BPF_FUNC_tcp_raw_gen_syncookie_ipv4)
+
+/* 이 오브젝트가 포함하는 기능 (기본값 = 전체) */
+#ifndef SG_FEATURES
+#define SG_FEATURES SG_F_ALL
+#endif
+#define SG_HAS(f)   ((SG_FEATURES & (f)) != 0)
+#define SG_NEEDS_L4 (SG_HAS(SG_F_PORTS) || SG_HAS(SG_F_TCP_FLAGS))  /* L4 헤더를 읽어야 하는 변형 */
+
+/* 활성 규칙 집합의 내부 맵 */
+struct cls_maps {
+    void *rules;
+    void *port_class;
+    void *bitmaps;
+};
+
+/* 맵 정의 */
+
+/*
+ * 규칙 집합 맵은 map-in-map으로 이중 버퍼링한다. 데몬은 새 규칙 집합을
+ * 비활성 슬롯의 새 내부 맵에 채운 뒤 cls_config.active를 바꿔 한 번에 전환한다.
+ */
+
+/* 우선순위 순서로 정렬된 판정 레코드 (인덱스 = 비트맵 비트 위치) */
+struct filter_rules_inner {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct rule_verdict);
+    __uint(max_entries, MAX_FILTER_RULES);
 };
 
-struct filter_stats {
-    uint64_t packets;      /* 처리된 패킷 수 */
-    uint64_t bytes;        /* 처리된 바이트 수 */
-    uint64_t last_matched; /* 마지막 매치 타임스탬프 */
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct filter_rules_inner);
+} filter_rules SEC(".maps");
+
+/* 규칙별 통계 (키 = 규칙 ID) */
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct filter_stats);
+    __uint(max_entries, MAX_FILTER_RULES);
+} rule_stats SEC(".maps");
+
+/* 규칙별 토큰 버킷 (키 = 규칙 ID, 모든 CPU가 공유하므로 스핀락 사용) */
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct token_bucket);
+    __uint(max_entries, MAX_FILTER_RULES);
+} rule_buckets SEC(".maps");
+
+/* 소스별 토큰 버킷 (잠금 없이 갱신) */
+struct {
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
+    __type(key, struct src_bucket_key);
+    __type(value, struct src_bucket);
+    __uint(max_entries, MAX_RATE_SOURCES);
+} src_buckets SEC(".maps");
+
+/* 소스/대상 프리픽스 -> 해당 프리픽스를 포함하는 규칙 비트맵 */
+struct cls_prefix_v4_inner {
+    __uint(type, BPF_MAP_TYPE_LPM_TRIE);
+    __type(key, struct prefix_key);
+    __type(value, struct rule_bitmap);
+    __uint(max_entries, CLS_MAX_PREFIXES);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
 };
 
-struct filter_rule {
-    uint32_t priority;          /* 룰 우선순위 */
-    uint8_t action;             /* 액션 (통과, 드롭, 리디렉션) */
-    uint8_t protocol;           /* 프로토콜 (TCP, UDP, ICMP, ANY) */
-    uint16_t src_port_min;      /* 소스 포트 범위 최소값 */
-    uint16_t src_port_max;      /* 소스 포트 범위 최대값 */
-    uint16_t dst_port_min;      /* 대상 포트 범위 최소값 */
-    uint16_t dst_port_max;      /* 대상 포트 범위 최대값 */
-    uint8_t tcp_flags;          /* TCP 플래그 (SYN, ACK, FIN 등) */
-    uint32_t redirect_ifindex;  /* 리디렉션 인터페이스 인덱스 */
-    uint32_t rate_limit;        /* 초당 패킷 수 레이트 리밋 */
-    uint32_t expire;            /* 룰 만료 시간 (초) */
-    char label[MAX_RULE_LABEL_LEN]; /* 룰 레이블 */
-    struct filter_stats stats; /* 통계 */
+struct cls_prefix_v6_inner {
+    __uint(type, BPF_MAP_TYPE_LPM_TRIE);
+    __type(key, struct prefix_key_v6);
+    __type(value, struct rule_bitmap);
+    __uint(max_entries, CLS_MAX_PREFIXES);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
 };
 
-struct if_redirect {
-    uint32_t ifindex;           /* 인터페이스 인덱스 */
-    char ifname[16];         /* 인터페이스 이름 */
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_prefix_v4_inner);
+} cls_src_v4 SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_prefix_v4_inner);
+} cls_dst_v4 SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_prefix_v6_inner);
+} cls_src_v6 SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_prefix_v6_inner);
+} cls_dst_v6 SEC(".maps");
+
+/* 포트 번호 -> 포트 구간 클래스 (소스/대상) */
+struct cls_port_class_inner {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, uint32_t);
+    __uint(max_entries, 2 * CLS_PORT_SPACE);
 };
 
-/* 맵 정의 */
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_port_class_inner);
+} cls_port_class SEC(".maps");
+
+/* 프로토콜, TCP 플래그, 포트 클래스별 규칙 비트맵 */
+struct cls_bitmaps_inner {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct rule_bitmap);
+    __uint(max_entries, CLS_BM_ENTRIES);
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY_OF_MAPS);
+    __type(key, uint32_t);
+    __uint(max_entries, CLS_SLOTS);
+    __array(values, struct cls_bitmaps_inner);
+} cls_bitmaps SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct cls_config);
+    __uint(max_entries, 1);
+} cls_config SEC(".maps");
+
+/* 흐름별 판정 캐시 (CPU별 슬롯이라 잠금 없음, 세대 불일치 항목은 재분류) */
+struct {
+    __uint(type, BPF_MAP_TYPE_LRU_PERCPU_HASH);
+    __type(key, struct flow_key);
+    __type(value, struct flow_entry);
+    __uint(max_entries, FLOW_CACHE_ENTRIES);
+} flow_cache SEC(".maps");
+
+/* 쿠키 ACK로 검증된 흐름 (값 = 마지막 패킷 시각, 밀려난 흐름의 다음 패킷은 드롭됨) */
+struct {
+    __uint(type, BPF_MAP_TYPE_LRU_HASH);
+    __type(key, struct synproxy_key);
+    __type(value, uint64_t);
+    __uint(max_entries, SYNPROXY_FLOW_ENTRIES);
+} synproxy_flows SEC(".maps");
+
+/*
+ * 소스별 헤비 히터 스케치와 후보 표 (CPU별, 슬롯별). 소스 수와 무관하게 크기가 고정되며,
+ * 데몬이 CPU별 스케치를 합산해 후보의 추정치를 다시 계산한다.
+ */
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct hh_config);
+    __uint(max_entries, 1);
+} hh_config SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct hh_sketch);
+    __uint(max_entries, HH_SLOTS);
+} hh_sketch SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct hh_topk);
+    __uint(max_entries, HH_SLOTS);
+} hh_topk SEC(".maps");
+
+/*
+ * 위협 정보 피드 등 대량의 소스 프리픽스 블록리스트 (값 = 블록리스트 ID).
+ * 규칙 맵과 달리 프리픽스와 ID만 담으므로 수백만 항목도 규칙 수 제한과 무관하다.
+ * LPM 트라이는 사전 할당을 지원하지 않으므로 항목은 추가할 때 할당된다.
+ */
 struct {
     __uint(type, BPF_MAP_TYPE_LPM_TRIE);
     __type(key, struct prefix_key);
-    __type(value, struct filter_rule);
-    __uint(max_entries, MAX_FILTER_RULES);
+    __type(value, uint32_t);
+    __uint(max_entries, BLOCKLIST_V4_ENTRIES);
     __uint(map_flags, BPF_F_NO_PREALLOC);
-} filter_rules SEC(".maps");
+} blocklist_v4 SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_LPM_TRIE);
+    __type(key, struct prefix_key_v6);
+    __type(value, uint32_t);
+    __uint(max_entries, BLOCKLIST_V6_ENTRIES);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+} blocklist_v6 SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct blocklist_config);
+    __uint(max_entries, 1);
+} blocklist_config SEC(".maps");
+
+/* 블록리스트별 드롭 통계 (키 = 블록리스트 ID) */
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct filter_stats);
+    __uint(max_entries, MAX_BLOCKLISTS);
+} blocklist_stats SEC(".maps");
 
+/* 리디렉션 대상 인터페이스 (키 = ifindex, 드라이버 일괄 전송 경로 사용) */
 struct {
-    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(type, BPF_MAP_TYPE_DEVMAP_HASH);
     __type(key, uint32_t);
-    __type(value, struct if_redirect);
+    __type(value, uint32_t);
     __uint(max_entries, MAX_REDIRECT_IFS);
 } redirect_map SEC(".maps");
 
+/* 리디렉션 대상 CPU (키 = CPU 번호, 값 = 큐 크기) */
+struct {
+    __uint(type, BPF_MAP_TYPE_CPUMAP);
+    __type(key, uint32_t);
+    __type(value, uint32_t);
+    __uint(max_entries, MAX_REDIRECT_CPUS);
+} cpu_map SEC(".maps");
+
+/* 수신 큐별 AF_XDP 소켓 (키 = 큐 번호, 값 = 데몬이 등록한 소켓 fd) */
+struct {
+    __uint(type, BPF_MAP_TYPE_XSKMAP);
+    __type(key, uint32_t);
+    __type(value, uint32_t);
+    __uint(max_entries, MAX_XSK_QUEUES);
+} xsk_map SEC(".maps");
+
 struct {
     __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
     __type(key, uint32_t);
     __type(value, struct filter_stats);
-    __uint(max_entries, 1);
+    __uint(max_entries, STAT_MAX);
 } stats_map SEC(".maps");
 
+/* 수신 큐별 통계 (키 = rx_queue_index, 큐 간 불균형 관찰용) */
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct filter_stats);
+    __uint(max_entries, MAX_STAT_QUEUES);
+} queue_stats SEC(".maps");
+
+/* 샘플링된 패킷 이벤트 (데몬이 주기적으로 일괄 소비) */
+struct {
+    __uint(type, BPF_MAP_TYPE_RINGBUF);
+    __uint(max_entries, EVENT_RINGBUF_SIZE);
+} events SEC(".maps");
+
+/*
+ * 테일 콜 파이프라인 (xdp_pipeline_func 진입점에서만 사용). 데몬은 활성 규칙 집합이
+ * 사용하는 단계만 연결하므로, 연결되지 않은 기능은 데이터 경로에 분기조차 남기지 않는다.
+ */
+struct {
+    __uint(type, BPF_MAP_TYPE_PROG_ARRAY);
+    __type(key, uint32_t);
+    __type(value, uint32_t);
+    __uint(max_entries, PIPELINE_STAGES);
+} pipeline SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __type(key, uint32_t);
+    __type(value, struct pipeline_state);
+    __uint(max_entries, 1);
+} pipeline_state SEC(".maps");
+
 /* 헬퍼 함수 */
-static __always_inline void update_stats(struct filter_stats *stats, uint32_t packets, uint32_t bytes)
+static __always_inline void update_stats(uint32_t rule_id, uint32_t bytes)
 {
-    uint32_t key = 0;
     struct filter_stats *value;
     
-    value = bpf_map_lookup_elem(&stats_map, &key);
+    /* 규칙별 통계는 CPU별 슬롯에 기록 */
+    value = bpf_map_lookup_elem(&rule_stats, &rule_id);
     if (value) {
-        __sync_fetch_and_add(&value->packets, packets);
-        __sync_fetch_and_add(&value->bytes, bytes);
+        value->packets++;
+        value->bytes += bytes;
+        value->last_matched = bpf_ktime_get_ns();
     }
 }
 
-static __always_inline int handle_ipv4(struct xdp_md *ctx, void *data, void *data_end)
+/* 판정별 전역 통계 (CPU별 슬롯이므로 원자 연산 불필요) */
+static __always_inline void count_verdict(uint32_t stat, uint32_t bytes)
 {
-    /* 이더넷 헤더 추출 */
-    struct ethhdr *eth = data;
-    if ((void *)(eth + 1) > data_end)
-        return XDP_PASS;
-        
-    /* IP 헤더 추출 */
-    struct iphdr *iph = (void *)(eth + 1);
+    struct filter_stats *value;
+
+    value = bpf_map_lookup_elem(&stats_map, &stat);
+    if (value) {
+        value->packets++;
+        value->bytes += bytes;
+    }
+}
+
+/* 수신 큐별 통계 (MAX_STAT_QUEUES 이상의 큐는 집계하지 않음) */
+static __always_inline void count_queue(uint32_t queue, uint32_t bytes)
+{
+    struct filter_stats *value;
+
+    value = bpf_map_lookup_elem(&queue_stats, &queue);
+    if (value) {
+        value->packets++;
+        value->bytes += bytes;
+    }
+}
+
+/* 스케치 행 row의 카운터 증가 후 새 값 반환 (곱셈-시프트 해시, 상수는 데몬과 동일) */
+#define HH_ROW(sk, row, mult, addr) \
+    (++(sk)->counts[row][((uint32_t)((addr) * (mult)) >> (32 - HH_WIDTH_BITS)) & (HH_WIDTH - 1)])
+
+/* 소스 주소를 스케치에 반영하고 추정치가 큰 주소를 후보 표에 유지 */
+static __always_inline void hh_update(uint32_t saddr)
+{
+    uint32_t zero = 0;
+    struct hh_config *cfg = bpf_map_lookup_elem(&hh_config, &zero);
+    if (!cfg || !cfg->enabled)
+        return;
+
+    uint32_t slot = cfg->epoch % HH_SLOTS;
+    struct hh_sketch *sk = bpf_map_lookup_elem(&hh_sketch, &slot);
+    if (!sk)
+        return;
+
+    uint32_t est = HH_ROW(sk, 0, 0x9E3779B1u, saddr);
+    uint32_t c = HH_ROW(sk, 1, 0x85EBCA77u, saddr);
+    if (c < est)
+        est = c;
+    c = HH_ROW(sk, 2, 0xC2B2AE3Du, saddr);
+    if (c < est)
+        est = c;
+    c = HH_ROW(sk, 3, 0x27D4EB2Fu, saddr);
+    if (c < est)
+        est = c;
+
+    /* 후보 표는 가끔만 갱신 (정확한 값은 데몬이 합산 스케치로 다시 계산) */
+    if (est % HH_TOPK_EVERY)
+        return;
+
+    struct hh_topk *topk = bpf_map_lookup_elem(&hh_topk, &slot);
+    if (!topk)
+        return;
+
+    uint32_t min_i = 0;
+    uint32_t min_count = 0xFFFFFFFF;
+
+    #pragma unroll
+    for (int i = 0; i < HH_TOPK; i++) {
+        if (topk->entries[i].addr == saddr) {
+            topk->entries[i].count = est;
+            return;
+        }
+        if (topk->entries[i].count < min_count) {
+            min_count = topk->entries[i].count;
+            min_i = i;
+        }
+    }
+
+    /* 가장 작은 후보보다 크면 교체 */
+    if (est > min_count && min_i < HH_TOPK) {
+        topk->entries[min_i].addr = saddr;
+        topk->entries[min_i].count = est;
+    }
+}
+
+/* 블록리스트 매치 시 블록리스트별 통계를 기록하고 1 반환 */
+static __always_inline int blocklist_hit(struct xdp_md *ctx, void *map, void *key)
+{
+    uint32_t *list = bpf_map_lookup_elem(map, key);
+    if (!list)
+        return 0;
+
+    uint32_t id = *list;
+    struct filter_stats *value = bpf_map_lookup_elem(&blocklist_stats, &id);
+    if (value) {
+        value->packets++;
+        value->bytes += ctx->data_end - ctx->data;
+        value->last_matched = bpf_ktime_get_ns();
+    }
+    return 1;
+}
+
+/* IPv4 소스 주소가 블록리스트에 있으면 1 (규칙 분류 전에 확인) */
+static __always_inline int blocklist_v4_match(struct xdp_md *ctx, void *l3, void *data_end)
+{
+    struct iphdr *iph = l3;
+    uint32_t zero = 0;
+
     if ((void *)(iph + 1) > data_end)
-        return XDP_PASS;
-        
-    uint32_t ip_src = iph->saddr;
-    uint32_t ip_dst = iph->daddr;
-    uint8_t protocol = iph->protocol;
-    uint16_t src_port = 0;
-    uint16_t dst_port = 0;
-    uint8_t tcp_flags = 0;
-    
-    /* 5-tuple 정보 추출 */
+        return 0;
+
+    struct blocklist_config *cfg = bpf_map_lookup_elem(&blocklist_config, &zero);
+    if (!cfg || cfg->nv4 == 0)
+        return 0;
+
+    struct prefix_key key = {
+        .prefix_len = 32,
+        .addr = iph->saddr,
+    };
+    return blocklist_hit(ctx, &blocklist_v4, &key);
+}
+
+/* IPv6 소스 주소가 블록리스트에 있으면 1 */
+static __always_inline int blocklist_v6_match(struct xdp_md *ctx, void *l3, void *data_end)
+{
+    struct ipv6hdr *ip6h = l3;
+    uint32_t zero = 0;
+
+    if ((void *)(ip6h + 1) > data_end)
+        return 0;
+
+    struct blocklist_config *cfg = bpf_map_lookup_elem(&blocklist_config, &zero);
+    if (!cfg || cfg->nv6 == 0)
+        return 0;
+
+    struct prefix_key_v6 key = {
+        .prefix_len = 128,
+    };
+    __builtin_memcpy(key.addr, ip6h->saddr, sizeof(key.addr));
+    return blocklist_hit(ctx, &blocklist_v6, &key);
+}
+
+/* 토큰 보충 후 패킷 하나 분량을 소비할 수 있으면 1 반환 */
+static __always_inline int bucket_consume(uint64_t *tokens, uint64_t *last_refill_ns,
+                                          uint32_t rate, uint64_t now)
+{
+    uint64_t capacity = (uint64_t)rate * NSEC_PER_SEC;
+    uint64_t elapsed = now - *last_refill_ns;
+
+    /* 1초 이상 지나면 버킷이 가득 참 (오버플로 방지) */
+    if (elapsed >= NSEC_PER_SEC)
+        *tokens = capacity;
+    else
+        *tokens += elapsed * rate;
+
+    if (*tokens > capacity)
+        *tokens = capacity;
+    *last_refill_ns = now;
+
+    if (*tokens < NSEC_PER_SEC)
+        return 0;
+
+    *tokens -= NSEC_PER_SEC;
+    return 1;
+}
+
+/* 규칙의 레이트 리밋 검사 (1 = 허용, 0 = 초과) */
+static __always_inline int rate_limit_allow(struct rule_verdict *rule, struct src_bucket_key *key)
+{
+    uint64_t now = bpf_ktime_get_ns();
+    struct token_bucket *b;
+    int allow;
+
+    if (rule->flags & RULE_F_RATE_PER_SRC) {
+        /* 동시 갱신 시 약간 초과 허용될 수 있음 (근사치) */
+        key->rule_id = rule->rule_id;
+
+        struct src_bucket *sb = bpf_map_lookup_elem(&src_buckets, key);
+        if (!sb) {
+            struct src_bucket init = {0};
+
+            bpf_map_update_elem(&src_buckets, key, &init, BPF_NOEXIST);
+            sb = bpf_map_lookup_elem(&src_buckets, key);
+            if (!sb)
+                return 1;
+        }
+        return bucket_consume(&sb->tokens, &sb->last_refill_ns, rule->rate_limit, now);
+    }
+
+    uint32_t rule_id = rule->rule_id;
+    b = bpf_map_lookup_elem(&rule_buckets, &rule_id);
+    if (!b)
+        return 1;
+
+    bpf_spin_lock(&b->lock);
+    allow = bucket_consume(&b->tokens, &b->last_refill_ns, rule->rate_limit, now);
+    bpf_spin_unlock(&b->lock);
+
+    return allow;
+}
+
+/* 64비트 워드에서 가장 낮은 설정 비트 위치 (w != 0) */
+static __always_inline uint32_t bitmap_ffs64(uint64_t w)
+{
+    uint32_t n = 0;
+
+    if (!(w & 0xffffffffULL)) { n += 32; w >>= 32; }
+    if (!(w & 0xffffULL))     { n += 16; w >>= 16; }
+    if (!(w & 0xffULL))       { n += 8;  w >>= 8;  }
+    if (!(w & 0xfULL))        { n += 4;  w >>= 4;  }
+    if (!(w & 0x3ULL))        { n += 2;  w >>= 2;  }
+    if (!(w & 0x1ULL))        { n += 1; }
+
+    return n;
+}
+
+/* 포트 -> 포트 클래스 비트맵 조회 */
+static __always_inline struct rule_bitmap *lookup_port_bitmap(struct cls_maps *maps, uint32_t pc_base,
+                                                              uint32_t bm_base, uint16_t port)
+{
+    uint32_t idx = pc_base + port;
+    uint32_t *port_class;
+
+    port_class = bpf_map_lookup_elem(maps->port_class, &idx);
+    if (!port_class)
+        return NULL;
+
+    idx = bm_base + *port_class;
+    return bpf_map_lookup_elem(maps->bitmaps, &idx);
+}
+
+/* 슬롯의 규칙 집합 내부 맵 조회 (설치되지 않았으면 -1) */
+static __always_inline int cls_maps_lookup(uint32_t slot, struct cls_maps *maps)
+{
+    maps->rules = bpf_map_lookup_elem(&filter_rules, &slot);
+    maps->port_class = bpf_map_lookup_elem(&cls_port_class, &slot);
+    maps->bitmaps = bpf_map_lookup_elem(&cls_bitmaps, &slot);
+
+    if (!maps->rules || !maps->port_class || !maps->bitmaps)
+        return -1;
+
+    return 0;
+}
+
+/* 필드별 비트맵 교집합에서 최우선 규칙 위치 탐색 (없으면 -1) */
+static __always_inline int cls_first_match(uint32_t nwords, uint32_t start,
+                                           struct rule_bitmap *src, struct rule_bitmap *dst,
+                                           struct rule_bitmap *proto, struct rule_bitmap *flags,
+                                           struct rule_bitmap *sport, struct rule_bitmap *dport)
+{
+    uint32_t first = start / 64;
+
+    for (uint32_t i = 0; i < CLS_BITMAP_WORDS; i++) {
+        if (i >= nwords)
+            break;
+        if (i < first)
+            continue;
+
+        /* 변형에 없는 필드의 비트맵은 NULL (모든 규칙 후보) */
+        uint64_t w = ~0ULL;
+        if (SG_HAS(SG_F_SRC_ADDR))
+            w &= src->words[i];
+        if (SG_HAS(SG_F_DST_ADDR))
+            w &= dst->words[i];
+        if (SG_HAS(SG_F_PROTO))
+            w &= proto->words[i];
+        if (SG_HAS(SG_F_TCP_FLAGS))
+            w &= flags->words[i];
+        if (SG_HAS(SG_F_PORTS))
+            w &= sport->words[i] & dport->words[i];
+        /* 시작 비트 이전의 규칙 제외 */
+        if (i == first)
+            w &= ~0ULL << (start % 64);
+        if (w)
+            return i * 64 + bitmap_ffs64(w);
+    }
+
+    return -1;
+}
+
+/* L4 헤더에서 포트와 TCP 플래그 추출 (TCP/UDP 외에는 0) */
+static __always_inline int parse_l4(void *l4, void *data_end, uint8_t protocol,
+                                    uint16_t *src_port, uint16_t *dst_port, uint8_t *tcp_flags)
+{
     if (protocol == IPPROTO_TCP) {
-        struct tcphdr *tcph = (void *)(iph + 1);
+        struct tcphdr *tcph = l4;
         
         if ((void *)(tcph + 1) > data_end)
-            return XDP_PASS;
+            return -1;
             
-        src_port = bpf_ntohs(tcph->source);
-        dst_port = bpf_ntohs(tcph->dest);
-        tcp_flags = (tcph->fin) | (tcph->syn << 1) | (tcph->rst << 2) | 
-                    (tcph->psh << 3) | (tcph->ack << 4) | (tcph->urg << 5);
+        *src_port = bpf_ntohs(tcph->source);
+        *dst_port = bpf_ntohs(tcph->dest);
+        *tcp_flags = (tcph->fin) | (tcph->syn << 1) | (tcph->rst << 2) | 
+                     (tcph->psh << 3) | (tcph->ack << 4) | (tcph->urg << 5);
                     
     } else if (protocol == IPPROTO_UDP) {
-        struct udphdr *udph = (void *)(iph + 1);
+        struct udphdr *udph = l4;
         
         if ((void *)(udph + 1) > data_end)
-            return XDP_PASS;
-            
-        src_port = bpf_ntohs(udph->source);
-        dst_port = bpf_ntohs(udph->dest);
-    }
-    
-    /* 필터 룰 확인 */
-    struct prefix_key key = {0};
-    struct filter_rule *rule;
-    
-    key.prefix_len = 32; // 정확한 IP 매치
-    key.addr = ip_src;
-    
-    rule = bpf_map_lookup_elem(&filter_rules, &key);
-    if (rule) {
-        /* 포트 및 프로토콜 매치 확인 */
-        if ((rule->protocol == IPPROTO_ANY || rule->protocol == protocol) &&
-            (rule->src_port_min <= src_port && src_port <= rule->src_port_max) &&
-            (rule->dst_port_min <= dst_port && dst_port <= rule->dst_port_max) &&
-            ((protocol != IPPROTO_TCP) || ((rule->tcp_flags & tcp_flags) == rule->tcp_flags))) {
+            return -1;
             
-            /* 룰에 따른 액션 수행 */
-            switch (rule->action) {
-            case ACTION_DROP:
-                update_stats(&rule->stats, 1, ctx->data_end - ctx->data);
-                return XDP_DROP;
-                
-            case ACTION_REDIRECT:
-                {
-                    uint32_t ifindex = rule->redirect_ifindex;
-                    struct if_redirect *redirect;
-                    
-                    redirect = bpf_map_lookup_elem(&redirect_map, &ifindex);
-                    if (redirect && redirect->ifindex > 0) {
-                        update_stats(&rule->stats, 1, ctx->data_end - ctx->data);
-                        return bpf_redirect(redirect->ifindex, 0);
-                    }
-                }
-                break;
-                
-            case ACTION_PASS:
-                update_stats(&rule->stats, 1, ctx->data_end - ctx->data);
-                return XDP_PASS;
-                
-            default:
-                break;
-            }
-        }
+        *src_port = bpf_ntohs(udph->source);
+        *dst_port = bpf_ntohs(udph->dest);
     }
-    
-    /* 기본적으로 패킷 통과 */
-    return XDP_PASS;
+
+    return 0;
 }
 
-SEC("xdp")
-int xdp_filter_func(struct xdp_md *ctx)
+/* 주소 필드 비트맵이 조회된 뒤의 공통 분류 (IPv4/IPv6 공유, 매치 없으면 NULL) */
+static __always_inline struct rule_verdict *classify_packet(uint32_t nwords, struct cls_maps *maps,
+                                                            struct rule_bitmap *src_bm, struct rule_bitmap *dst_bm,
+                                                            uint8_t protocol, uint8_t tcp_flags, uint8_t l4_known,
+                                                            uint16_t src_port, uint16_t dst_port)
 {
-    void *data = (void *)(long)ctx->data;
-    void *data_end = (void *)(long)ctx->data_end;
-    
-    /* 이더넷 헤더 파싱 */
-    struct ethhdr *eth = data;
-    if ((void *)(eth + 1) > data_end)
-        return XDP_PASS;
-        
-    /* IP 헤더 파싱 */
-    if (eth->h_proto == bpf_htons(ETH_P_IP)) {
-        return handle_ipv4(ctx, data, data_end);
+    /* 필드별 규칙 비트맵 조회 - 어느 필드든 후보가 없으면 매치 없음 */
+    struct rule_bitmap *proto_bm = NULL, *flags_bm = NULL, *sport_bm = NULL, *dport_bm = NULL;
+    uint32_t idx;
+
+    if (SG_HAS(SG_F_PROTO)) {
+        idx = CLS_BM_PROTO_BASE + protocol;
+        proto_bm = bpf_map_lookup_elem(maps->bitmaps, &idx);
+        if (!proto_bm)
+            return NULL;
     }
-    
-    /* 지원되지 않는 패킷은 통과 */
-    return XDP_PASS;
+
+    if (l4_known) {
+        /* TCP가 아닌 패킷은 플래그 조건을 적용하지 않음 */
+        if (SG_HAS(SG_F_TCP_FLAGS)) {
+            idx = CLS_BM_TCP_FLAGS_BASE + (protocol == IPPROTO_TCP ? tcp_flags : CLS_TCP_FLAGS_NONE);
+            flags_bm = bpf_map_lookup_elem(maps->bitmaps, &idx);
+        }
+        if (SG_HAS(SG_F_PORTS)) {
+            sport_bm = lookup_port_bitmap(maps, CLS_PC_SPORT_BASE, CLS_BM_SPORT_BASE, src_port);
+            dport_bm = lookup_port_bitmap(maps, CLS_PC_DPORT_BASE, CLS_BM_DPORT_BASE, dst_port);
+        }
+    } else {
+        /* L4 헤더가 없는 조각은 포트/플래그 조건이 없는 규칙만 매치 */
+        if (SG_HAS(SG_F_TCP_FLAGS)) {
+            idx = CLS_BM_TCP_FLAGS_BASE + CLS_TCP_FLAGS_FRAG;
+            flags_bm = bpf_map_lookup_elem(maps->bitmaps, &idx);
+        }
+        if (SG_HAS(SG_F_PORTS)) {
+            idx = CLS_BM_SPORT_UNKNOWN;
+            sport_bm = bpf_map_lookup_elem(maps->bitmaps, &idx);
+            idx = CLS_BM_DPORT_UNKNOWN;
+            dport_bm = bpf_map_lookup_elem(maps->bitmaps, &idx);
+        }
+    }
+
+    if (SG_HAS(SG_F_TCP_FLAGS) && !flags_bm)
+        return NULL;
+    if (SG_HAS(SG_F_PORTS) && (!sport_bm || !dport_bm))
+        return NULL;
+
+    /* 우선순위가 가장 높은 미만료 매치 규칙 선택 */
+    struct rule_verdict *rule = NULL;
+    uint32_t start = 0;
+    uint64_t now = 0;
+
+    for (int tries = 0; tries < CLS_MAX_EXPIRED_SKIP; tries++) {
+        int bit = cls_first_match(nwords, start, src_bm, dst_bm, proto_bm,
+                                  flags_bm, sport_bm, dport_bm);
+        if (bit < 0)
+            return NULL;
+
+        uint32_t rule_idx = bit;
+        rule = bpf_map_lookup_elem(maps->rules, &rule_idx);
+        if (!rule)
+            return NULL;
+
+        if (!SG_HAS(SG_F_EXPIRE) || !rule->expire_ns)
+            break;
+        if (!now)
+            now = bpf_ktime_get_ns();
+        if (now < rule->expire_ns)
+            break;
+
+        /* 만료된 규칙은 매치하지 않음 - 다음 순위 규칙 검색 */
+        rule = NULL;
+        start = bit + 1;
+    }
+
+    return rule;
+}
+
+/* 흐름 캐시 조회 (세대가 다르거나 캐시된 규칙이 만료되면 NULL) */
+static __always_inline struct flow_entry *flow_cache_lookup(struct flow_key *key, uint32_t generation)
+{
+    struct flow_entry *entry = bpf_map_lookup_elem(&flow_cache, key);
+
+    if (!entry || entry->generation != generation)
+        return NULL;
+    if (SG_HAS(SG_F_EXPIRE) && (entry->flags & FLOW_F_MATCHED) && entry->verdict.expire_ns &&
+        bpf_ktime_get_ns() >= entry->verdict.expire_ns)
+        return NULL;
+
+    return entry;
+}
+
+/* 분류 결과를 흐름 캐시에 기록 (매치 없음도 캐시, generation은 분류에 쓴 구성의 세대) */
+static __always_inline void flow_cache_store(struct flow_key *key, uint32_t generation,
+                                             struct rule_verdict *rule)
+{
+    struct flow_entry entry = {0};
+
+    entry.generation = generation;
+    if (rule) {
+        entry.verdict = *rule;
+        entry.flags = FLOW_F_MATCHED;
+    }
+    bpf_map_update_elem(&flow_cache, key, &entry, BPF_ANY);
+}
+
+/* 패킷 N개 중 하나를 헤더와 판정을 담아 이벤트로 기록 (링 버퍼가 가득 차면 버림) */
+static __always_inline void sample_event(struct xdp_md *ctx, struct rule_verdict *rule, int verdict)
+{
+    if (bpf_get_prandom_u32() % rule->sample_rate)
+        return;
+
+    struct packet_event *event = bpf_ringbuf_reserve(&events, sizeof(*event), 0);
+    if (!event)
+        return;
+
+    uint32_t len = ctx->data_end - ctx->data;
+    uint32_t snap = len;
+    if (snap > EVENT_SNAP_LEN)
+        snap = EVENT_SNAP_LEN;
+
+    event->timestamp_ns = bpf_ktime_get_ns();
+    event->rule_id = rule->rule_id;
+    event->ifindex = ctx->ingress_ifindex;
+    event->queue = ctx->rx_queue_index;
+    event->pkt_len = len;
+    event->verdict = verdict;
+    event->action = rule->action;
+    event->snap_len = 0;
+    if (snap > 0 && bpf_xdp_load_bytes(ctx, 0, event->data, snap) == 0)
+        event->snap_len = snap;
+
+    /* 깨우기는 생략 (데몬이 주기적으로 폴링하므로 이벤트마다 알릴 필요 없음) */
+    bpf_ringbuf_submit(event, BPF_RB_NO_WAKEUP);
+}
+
+/* 이더넷 헤더와 VLAN 태그 파싱 (0 = 성공, *h_proto와 *l3에 L3 프로토콜과 위치) */
+static __always_inline int parse_eth(void *data, void *data_end, uint16_t *h_proto, void **l3)
+{
+    struct ethhdr *eth = data;
+    if ((void *)(eth + 1) > data_end)
+        return XDP_PARSE_FAIL;
+
+    /* VLAN 태그 건너뛰기 (802.1Q/802.1ad, 최대 VLAN_MAX_DEPTH개) */
+    uint16_t proto = eth->h_proto;
+    void *next = eth + 1;
+
+#pragma unroll
+    for (int i = 0; i < VLAN_MAX_DEPTH; i++) {
+        if (proto != bpf_htons(ETH_P_8021Q) && proto != bpf_htons(ETH_P_8021AD))
+            break;
+
+        struct vlan_hdr *vh = next;
+        if ((void *)(vh + 1) > data_end)
+            return XDP_PARSE_FAIL;
+        proto = vh->h_vlan_encapsulated_proto;
+        next = vh + 1;
+    }
+
+    /* 처리 가능한 깊이보다 많은 태그 */
+    if (proto == bpf_htons(ETH_P_8021Q) || proto == bpf_htons(ETH_P_8021AD))
+        return XDP_PARSE_FAIL;
+
+    *h_proto = proto;
+    *l3 = next;
+    return 0;
+}
+
+/* 액션별 처리 (단일 프로그램과 파이프라인 액션 단계가 공유) */
+static __always_inline int act_drop(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return XDP_DROP;
+}
+
+/* ACTION_PASS, ACTION_COUNT (카운트만 하고 통과) */
+static __always_inline int act_pass(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return XDP_PASS;
+}
+
+static __always_inline int act_redirect(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    /* 대상이 devmap에 없으면 통과 (flags 하위 비트 = 실패 시 반환값) */
+    int ret = bpf_redirect_map(&redirect_map, rule->redirect_target, XDP_PASS);
+    if (ret == XDP_REDIRECT)
+        update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return ret;
+}
+
+static __always_inline int act_redirect_cpu(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    /* 전용 코어로 조향 (대상 CPU가 cpumap에 없으면 통과) */
+    int ret = bpf_redirect_map(&cpu_map, rule->redirect_target, XDP_PASS);
+    if (ret == XDP_REDIRECT)
+        update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return ret;
+}
+
+static __always_inline int act_redirect_xsk(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    /* UMEM이 WASM 메모리인 소켓으로 전달 (수신 큐에 소켓이 없으면 통과) */
+    int ret = bpf_redirect_map(&xsk_map, ctx->rx_queue_index, XDP_PASS);
+    if (ret == XDP_REDIRECT)
+        update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return ret;
+}
+
+/* 32비트 부분합을 16비트 인터넷 체크섬으로 접음 */
+static __always_inline uint16_t csum_fold(uint64_t sum)
+{
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+/*
+ * SYN을 같은 버퍼에서 쿠키 SYN-ACK로 바꿔 XDP_TX
+ *
+ * 쿠키에는 MSS만 인코딩되므로 응답 옵션은 MSS 하나뿐이다 (윈도 스케일, SACK,
+ * 타임스탬프 없이 연결됨). 헤더를 다시 쓰기 전에 패킷 길이를 응답 길이로 맞춘다.
+ */
+static __always_inline int synproxy_reply(struct xdp_md *ctx, struct rule_verdict *rule,
+                                          uint32_t l3_off, struct iphdr *iph, struct tcphdr *tcph)
+{
+    void *data_end = (void *)(long)ctx->data_end;
+    uint32_t th_len = tcph->doff * 4;
+
+    if (th_len < sizeof(*tcph) || (void *)tcph + th_len > data_end)
+        return act_drop(ctx, rule);
+
+    int64_t cookie = bpf_tcp_raw_gen_syncookie_ipv4(iph, tcph, th_len);
+    if (cookie < 0)
+        return act_drop(ctx, rule);
+
+    /* adjust_tail 이후 패킷 포인터는 무효이므로 필요한 필드를 먼저 보관 */
+    uint32_t saddr = iph->saddr;
+    uint32_t daddr = iph->daddr;
+    uint16_t sport = tcph->source;
+    uint16_t dport = tcph->dest;
+    uint32_t seq = tcph->seq;
+    int delta = (int)(l3_off + sizeof(*iph) + SYNPROXY_TCP_LEN) - (int)(ctx->data_end - ctx->data);
+
+    if (bpf_xdp_adjust_tail(ctx, delta))
+        return act_drop(ctx, rule);
+
+    void *data = (void *)(long)ctx->data;
+    data_end = (void *)(long)ctx->data_end;
+    if (l3_off > PIPELINE_MAX_L3_OFF)
+        return XDP_DROP;
+
+    struct ethhdr *eth = data;
+    iph = data + l3_off;
+    tcph = (void *)(iph + 1);
+    uint8_t *opt = (void *)(tcph + 1);
+    if ((void *)(eth + 1) > data_end || (void *)(opt + 4) > data_end)
+        return XDP_DROP;
+
+    /* 이더넷 주소 교환 (VLAN 태그는 그대로) */
+    uint8_t mac[6];
+    __builtin_memcpy(mac, eth->h_source, 6);
+    __builtin_memcpy(eth->h_source, eth->h_dest, 6);
+    __builtin_memcpy(eth->h_dest, mac, 6);
+
+    iph->tos = 0;
+    iph->tot_len = bpf_htons(sizeof(*iph) + SYNPROXY_TCP_LEN);
+    iph->id = 0;
+    iph->frag_off = bpf_htons(0x4000);   /* DF */
+    iph->ttl = SYNPROXY_TTL;
+    iph->saddr = daddr;
+    iph->daddr = saddr;
+    iph->check = 0;
+    iph->check = csum_fold(bpf_csum_diff(NULL, 0, (void *)iph, sizeof(*iph), 0));
+
+    tcph->source = dport;
+    tcph->dest = sport;
+    tcph->seq = bpf_htonl((uint32_t)cookie);
+    tcph->ack_seq = bpf_htonl(bpf_ntohl(seq) + 1);
+    ((uint8_t *)tcph)[12] = (SYNPROXY_TCP_LEN / 4) << 4;
+    ((uint8_t *)tcph)[13] = TCP_FLAG_SYN | TCP_FLAG_ACK;
+    tcph->window = bpf_htons(SYNPROXY_WINDOW);
+    tcph->urg_ptr = 0;
+
+    uint16_t mss = cookie >> 32;
+    opt[0] = 2;                          /* TCPOPT_MSS */
+    opt[1] = 4;
+    opt[2] = mss >> 8;
+    opt[3] = mss & 0xff;
+
+    /* 의사 헤더 (주소, 프로토콜, TCP 길이)를 시드로 TCP 헤더와 옵션 합산 */
+    uint32_t pseudo = (saddr >> 16) + (saddr & 0xffff) + (daddr >> 16) + (daddr & 0xffff) +
+                      bpf_htons(IPPROTO_TCP) + bpf_htons(SYNPROXY_TCP_LEN);
+    tcph->check = 0;
+    tcph->check = csum_fold(bpf_csum_diff(NULL, 0, (void *)tcph, SYNPROXY_TCP_LEN, pseudo));
+
+    update_stats(rule->rule_id, ctx->data_end - ctx->data);
+    return XDP_TX;
+}
+
+/*
+ * SYN 프록시 (IPv4 TCP만, 다른 패킷은 카운트 후 통과)
+ *
+ * SYN에는 커널 syncookie 비밀값으로 만든 쿠키를 ISN으로 담아 직접 응답하고, 쿠키가 맞는 ACK만
+ * 통과시켜 커널이 그 쿠키로 연결을 만들게 한다 (net.ipv4.tcp_syncookies = 2 필요). 검증된 흐름은
+ * synproxy_flows에 기록해 이후 패킷을 통과시키고, 나머지 TCP 패킷은 드롭한다. 헬퍼가 없는
+ * 커널에서는 통과로 동작한다.
+ */
+static __always_inline int act_synproxy(struct xdp_md *ctx, struct rule_verdict *rule)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+    uint16_t h_proto;
+    void *l3;
+
+    if (!SYNCOOKIE_HELPERS)
+        return act_pass(ctx, rule);
+    if (parse_eth(data, data_end, &h_proto, &l3) < 0 || h_proto != bpf_htons(ETH_P_IP))
+        return act_pass(ctx, rule);
+
+    struct iphdr *iph = l3;
+    if ((void *)(iph + 1) > data_end || iph->protocol != IPPROTO_TCP)
+        return act_pass(ctx, rule);
+
+    /* 쿠키 헬퍼는 옵션 없는 IP 헤더만 받으며, 조각은 검증할 수 없음 */
+    if (iph->ihl != 5 || (bpf_ntohs(iph->frag_off) & (IP_MF | IP_OFFSET)))
+        return act_drop(ctx, rule);
+
+    struct tcphdr *tcph = (void *)(iph + 1);
+    if ((void *)(tcph + 1) > data_end)
+        return act_drop(ctx, rule);
+
+    if (tcph->syn && !tcph->ack)
+        return synproxy_reply(ctx, rule, l3 - data, iph, tcph);
+
+    struct synproxy_key key = {
+        .saddr = iph->saddr,
+        .daddr = iph->daddr,
+        .sport = tcph->source,
+        .dport = tcph->dest,
+    };
+    uint64_t now = bpf_ktime_get_ns();
+    uint64_t *seen = bpf_map_lookup_elem(&synproxy_flows, &key);
+    if (seen) {
+        *seen = now;
+        return act_pass(ctx, rule);
+    }
+
+    /* 핸드셰이크의 마지막 ACK (ack_seq - 1 = 쿠키) */
+    if (tcph->ack && !tcph->syn && !tcph->rst &&
+        bpf_tcp_raw_check_syncookie_ipv4(iph, tcph) == 0) {
+        bpf_map_update_elem(&synproxy_flows, &key, &now, BPF_ANY);
+        return act_pass(ctx, rule);
+    }
+
+    return act_drop(ctx, rule);
+}
+
+/* 선택된 규칙의 레이트 리밋 및 액션 적용 */
+static __always_inline int apply_action(struct xdp_md *ctx, struct rule_verdict *rule,
+                                        struct src_bucket_key *rl_key)
+{
+    /* 레이트 리밋 초과 시 드롭 (0 = 무제한) */
+    if (SG_HAS(SG_F_RATE_LIMIT) && rule->rate_limit && !rate_limit_allow(rule, rl_key))
+        return act_drop(ctx, rule);
+
+    /* 룰에 따른 액션 수행 (리디렉션이 없는 변형은 리디렉션 경로를 포함하지 않음) */
+    switch (rule->action) {
+    case ACTION_DROP:
+        return act_drop(ctx, rule);
+    case ACTION_REDIRECT:
+        if (SG_HAS(SG_F_REDIRECT))
+            return act_redirect(ctx, rule);
+        break;
+    case ACTION_REDIRECT_CPU:
+        if (SG_HAS(SG_F_REDIRECT))
+            return act_redirect_cpu(ctx, rule);
+        break;
+    case ACTION_REDIRECT_XSK:
+        if (SG_HAS(SG_F_REDIRECT))
+            return act_redirect_xsk(ctx, rule);
+        break;
+    case ACTION_SYNPROXY:
+        if (SG_HAS(SG_F_SYNPROXY))
+            return act_synproxy(ctx, rule);
+        break;
+    case ACTION_PASS:
+    case ACTION_COUNT:
+        return act_pass(ctx, rule);
+    default:
+        break;
+    }
+    
+    /* 기본적으로 패킷 통과 */
+    return XDP_PASS;
+}
+
+/* 선택된 규칙 적용 후 샘플링 (규칙이 없으면 통과, sample_rate 0이면 분기 하나만 추가) */
+static __always_inline int apply_verdict(struct xdp_md *ctx, struct rule_verdict *rule,
+                                         struct src_bucket_key *rl_key)
+{
+    if (!rule)
+        return XDP_PASS;
+
+    int verdict = apply_action(ctx, rule, rl_key);
+    if (SG_HAS(SG_F_SAMPLE) && rule->sample_rate)
+        sample_event(ctx, rule, verdict);
+
+    return verdict;
+}
+
+/*
+ * IPv4 패킷 분류 (0 = 분류 완료, 매치가 없으면 *out = NULL)
+ * *out은 흐름 캐시 또는 활성 규칙 집합의 맵 값을 가리킨다.
+ */
+static __always_inline int lookup_ipv4(void *l3, void *data_end, struct src_bucket_key *rl_key,
+                                       struct rule_verdict **out)
+{
+    /* IP 헤더 추출 */
+    struct iphdr *iph = l3;
+    if ((void *)(iph + 1) > data_end)
+        return XDP_PARSE_FAIL;
+    if (iph->ihl < 5)
+        return XDP_PARSE_FAIL;
+
+    /* 규칙 매치와 무관하게 소스별 패킷 수 집계 */
+    hh_update(iph->saddr);
+        
+    uint8_t protocol = iph->protocol;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t tcp_flags = 0;
+    uint8_t l4_known = 1;
+    uint16_t frag_off = bpf_ntohs(iph->frag_off);
+    
+    /*
+     * 5-tuple 정보 추출 (L4 헤더 위치는 IHL 기준, 옵션 포함)
+     * 포트/플래그 조건이 없는 변형은 L4 헤더를 읽지 않으며, 흐름 키도 주소와 프로토콜만 쓴다.
+     */
+    if (!SG_NEEDS_L4) {
+        /* 조각도 같은 흐름 키로 캐시 */
+    } else if (frag_off & IP_OFFSET) {
+        /* 첫 조각이 아니면 L4 헤더 없음 */
+        l4_known = 0;
+    } else if (parse_l4((void *)iph + iph->ihl * 4, data_end, protocol,
+                        &src_port, &dst_port, &tcp_flags) < 0) {
+        /* L4 헤더가 잘린 첫 조각은 포트를 모르는 조각으로 취급 */
+        if (!(frag_off & IP_MF))
+            return XDP_PARSE_FAIL;
+        l4_known = 0;
+    }
+    
+    *out = NULL;
+
+    /* 분류기 구성 확인 */
+    uint32_t zero = 0;
+    struct cls_config *cfg = bpf_map_lookup_elem(&cls_config, &zero);
+    if (!cfg || cfg->nrules == 0)
+        return 0;
+
+    /*
+     * 세대, 활성 슬롯, 워드 수는 한 번만 읽음 - 분류 중 데몬이 구성을 바꿔도
+     * 이전 슬롯의 판정이 새 세대로 캐시되지 않는다.
+     */
+    uint32_t generation = cfg->generation;
+    uint32_t slot = cfg->active;
+    uint32_t nwords = cfg->nwords;
+
+    rl_key->addr[0] = iph->saddr;
+
+    /* 캐시된 흐름은 분류 생략 (L4 헤더가 없는 조각은 캐시하지 않음) */
+    struct flow_key fkey = {0};
+    if (l4_known) {
+        fkey.saddr[0] = iph->saddr;
+        fkey.daddr[0] = iph->daddr;
+        fkey.src_port = src_port;
+        fkey.dst_port = dst_port;
+        fkey.protocol = protocol;
+        fkey.tcp_flags = tcp_flags;
+        fkey.family = 4;
+
+        struct flow_entry *cached = flow_cache_lookup(&fkey, generation);
+        if (cached) {
+            if (cached->flags & FLOW_F_MATCHED)
+                *out = &cached->verdict;
+            return 0;
+        }
+    }
+
+    /* 활성 규칙 집합 선택 (전환 중에도 한 패킷은 한 집합만 참조) */
+    struct cls_maps maps;
+    void *src_trie, *dst_trie;
+
+    if (cls_maps_lookup(slot, &maps) < 0)
+        return 0;
+    src_trie = bpf_map_lookup_elem(&cls_src_v4, &slot);
+    dst_trie = bpf_map_lookup_elem(&cls_dst_v4, &slot);
+    if (!src_trie || !dst_trie)
+        return 0;
+
+    /* 주소 필드 비트맵 조회 - 후보가 없으면 매치 없음 */
+    struct prefix_key key = {0};
+    struct rule_bitmap *src_bm, *dst_bm;
+    struct rule_verdict *rule = NULL;
+
+    key.prefix_len = 32;
+    src_bm = dst_bm = NULL;
+    if (SG_HAS(SG_F_SRC_ADDR)) {
+        key.addr = iph->saddr;
+        src_bm = bpf_map_lookup_elem(src_trie, &key);
+    }
+    if (SG_HAS(SG_F_DST_ADDR) && (src_bm || !SG_HAS(SG_F_SRC_ADDR))) {
+        key.addr = iph->daddr;
+        dst_bm = bpf_map_lookup_elem(dst_trie, &key);
+    }
+
+    if ((src_bm || !SG_HAS(SG_F_SRC_ADDR)) && (dst_bm || !SG_HAS(SG_F_DST_ADDR)))
+        rule = classify_packet(nwords, &maps, src_bm, dst_bm, protocol, tcp_flags,
+                               l4_known, src_port, dst_port);
+
+    if (l4_known)
+        flow_cache_store(&fkey, generation, rule);
+
+    *out = rule;
+    return 0;
+}
+
+static __always_inline int handle_ipv4(struct xdp_md *ctx, void *l3, void *data_end)
+{
+    struct src_bucket_key rl_key = {0};
+    struct rule_verdict *rule;
+
+    if (blocklist_v4_match(ctx, l3, data_end))
+        return XDP_DROP;
+
+    int ret = lookup_ipv4(l3, data_end, &rl_key, &rule);
+    if (ret < 0)
+        return ret;
+
+    return apply_verdict(ctx, rule, &rl_key);
+}
+
+/* IPv6 패킷 분류 (lookup_ipv4와 같은 규약) */
+static __always_inline int lookup_ipv6(void *l3, void *data_end, struct src_bucket_key *rl_key,
+                                       struct rule_verdict **out)
+{
+    /* IPv6 헤더 추출 */
+    struct ipv6hdr *ip6h = l3;
+    if ((void *)(ip6h + 1) > data_end)
+        return XDP_PARSE_FAIL;
+        
+    uint8_t protocol = ip6h->nexthdr;
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t tcp_flags = 0;
+    uint8_t l4_known = 1;
+    uint8_t fragmented = 0;
+    void *l4 = ip6h + 1;
+
+    /* 확장 헤더 건너뛰기 (최대 IPV6_MAX_EXT_HDRS개) */
+#pragma unroll
+    for (int i = 0; i < IPV6_MAX_EXT_HDRS; i++) {
+        if (protocol == IPPROTO_HOPOPTS || protocol == IPPROTO_ROUTING ||
+            protocol == IPPROTO_DSTOPTS) {
+            struct ipv6_opt_hdr *opt = l4;
+
+            if ((void *)(opt + 1) > data_end)
+                return XDP_PARSE_FAIL;
+            protocol = opt->nexthdr;
+            l4 += (opt->hdrlen + 1) * 8;
+        } else if (protocol == IPPROTO_FRAGMENT) {
+            struct frag_hdr *fh = l4;
+
+            if ((void *)(fh + 1) > data_end)
+                return XDP_PARSE_FAIL;
+            protocol = fh->nexthdr;
+            l4 = fh + 1;
+            fragmented = 1;
+            /* 첫 조각이 아니면 L4 헤더 없음 */
+            if (SG_NEEDS_L4 && (bpf_ntohs(fh->frag_off) & IP6_OFFSET))
+                l4_known = 0;
+        } else {
+            break;
+        }
+    }
+    
+    /* 5-tuple 정보 추출 (포트/플래그 조건이 없는 변형은 생략) */
+    if (SG_NEEDS_L4 && l4_known &&
+        parse_l4(l4, data_end, protocol, &src_port, &dst_port, &tcp_flags) < 0) {
+        /* L4 헤더가 잘린 첫 조각은 포트를 모르는 조각으로 취급 */
+        if (!fragmented)
+            return XDP_PARSE_FAIL;
+        l4_known = 0;
+    }
+    
+    *out = NULL;
+
+    /* 분류기 구성 확인 */
+    uint32_t zero = 0;
+    struct cls_config *cfg = bpf_map_lookup_elem(&cls_config, &zero);
+    if (!cfg || cfg->nrules == 0)
+        return 0;
+
+    /* 구성은 한 번만 읽음 (lookup_ipv4 참고) */
+    uint32_t generation = cfg->generation;
+    uint32_t slot = cfg->active;
+    uint32_t nwords = cfg->nwords;
+
+    __builtin_memcpy(rl_key->addr, ip6h->saddr, 16);
+
+    /* 캐시된 흐름은 분류 생략 (L4 헤더가 없는 조각은 캐시하지 않음) */
+    struct flow_key fkey = {0};
+    if (l4_known) {
+        __builtin_memcpy(fkey.saddr, ip6h->saddr, 16);
+        __builtin_memcpy(fkey.daddr, ip6h->daddr, 16);
+        fkey.src_port = src_port;
+        fkey.dst_port = dst_port;
+        fkey.protocol = protocol;
+        fkey.tcp_flags = tcp_flags;
+        fkey.family = 6;
+
+        struct flow_entry *cached = flow_cache_lookup(&fkey, generation);
+        if (cached) {
+            if (cached->flags & FLOW_F_MATCHED)
+                *out = &cached->verdict;
+            return 0;
+        }
+    }
+
+    /* 활성 규칙 집합 선택 (전환 중에도 한 패킷은 한 집합만 참조) */
+    struct cls_maps maps;
+    void *src_trie, *dst_trie;
+
+    if (cls_maps_lookup(slot, &maps) < 0)
+        return 0;
+    src_trie = bpf_map_lookup_elem(&cls_src_v6, &slot);
+    dst_trie = bpf_map_lookup_elem(&cls_dst_v6, &slot);
+    if (!src_trie || !dst_trie)
+        return 0;
+
+    /* 주소 필드 비트맵 조회 (IPv4와 같은 조회 횟수) */
+    struct prefix_key_v6 key = {0};
+    struct rule_bitmap *src_bm, *dst_bm;
+    struct rule_verdict *rule = NULL;
+
+    key.prefix_len = 128;
+    src_bm = dst_bm = NULL;
+    if (SG_HAS(SG_F_SRC_ADDR)) {
+        __builtin_memcpy(key.addr, ip6h->saddr, 16);
+        src_bm = bpf_map_lookup_elem(src_trie, &key);
+    }
+    if (SG_HAS(SG_F_DST_ADDR) && (src_bm || !SG_HAS(SG_F_SRC_ADDR))) {
+        __builtin_memcpy(key.addr, ip6h->daddr, 16);
+        dst_bm = bpf_map_lookup_elem(dst_trie, &key);
+    }
+
+    if ((src_bm || !SG_HAS(SG_F_SRC_ADDR)) && (dst_bm || !SG_HAS(SG_F_DST_ADDR)))
+        rule = classify_packet(nwords, &maps, src_bm, dst_bm, protocol, tcp_flags,
+                               l4_known, src_port, dst_port);
+
+    if (l4_known)
+        flow_cache_store(&fkey, generation, rule);
+
+    *out = rule;
+    return 0;
+}
+
+static __always_inline int handle_ipv6(struct xdp_md *ctx, void *l3, void *data_end)
+{
+    struct src_bucket_key rl_key = {0};
+    struct rule_verdict *rule;
+
+    if (blocklist_v6_match(ctx, l3, data_end))
+        return XDP_DROP;
+
+    int ret = lookup_ipv6(l3, data_end, &rl_key, &rule);
+    if (ret < 0)
+        return ret;
+
+    return apply_verdict(ctx, rule, &rl_key);
+}
+
+/* 큐별/판정별 통계 기록 후 최종 XDP 반환값 (모든 진입점과 파이프라인 종료 단계가 공유) */
+static __always_inline int finish_packet(struct xdp_md *ctx, int action)
+{
+    uint32_t bytes = ctx->data_end - ctx->data;
+
+    count_queue(ctx->rx_queue_index, bytes);
+    
+    /* 판정별 통계 기록 (지원되지 않는 패킷은 통과로 집계) */
+    switch (action) {
+    case XDP_DROP:
+        count_verdict(STAT_DROP, bytes);
+        break;
+    case XDP_REDIRECT:
+        count_verdict(STAT_REDIRECT, bytes);
+        break;
+    case XDP_TX:
+        count_verdict(STAT_TX, bytes);
+        break;
+    case XDP_ABORTED:
+        count_verdict(STAT_ABORTED, bytes);
+        break;
+    case XDP_PARSE_FAIL:
+        count_verdict(STAT_PARSE_FAIL, bytes);
+        action = XDP_PASS;
+        break;
+    default:
+        count_verdict(STAT_PASS, bytes);
+        break;
+    }
+    
+    return action;
+}
+
+/*
+ * 단일 프로그램 진입점 (모든 기능을 한 함수에서 처리)
+ * 섹션 "xdp"의 첫 프로그램이므로 `ip link ... xdp obj xdp_filter.o sec xdp`도 이 프로그램을 로드한다.
+ */
+SEC("xdp")
+int xdp_filter_func(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+    uint16_t h_proto;
+    void *l3;
+    
+    /* 이더넷 헤더 파싱 */
+    int action = parse_eth(data, data_end, &h_proto, &l3);
+    if (action < 0)
+        return finish_packet(ctx, action);
+
+    if (h_proto == bpf_htons(ETH_P_IP)) {
+        /* IP 헤더 파싱 */
+        action = handle_ipv4(ctx, l3, data_end);
+    } else if (h_proto == bpf_htons(ETH_P_IPV6)) {
+        action = handle_ipv6(ctx, l3, data_end);
+    } else {
+        action = XDP_PASS;
+    }
+
+    return finish_packet(ctx, action);
+}
+
+/*
+ * 테일 콜 파이프라인
+ *
+ * 파싱 단계(xdp_pipeline_func) -> 주소 계열별 분류 단계 -> [레이트 리밋 단계] -> 액션 단계
+ * -> [샘플 단계] 순서로 진행한다. 각 단계는 다음 단계가 연결되어 있지 않으면 통과로
+ * 끝나므로, 데몬은 규칙이 없는 주소 계열과 사용되지 않는 액션/기능의 단계를 연결하지 않는다.
+ * 단계 사이의 상태는 pipeline_state CPU별 슬롯으로 전달한다.
+ */
+
+static __always_inline struct pipeline_state *pipeline_state_get(void)
+{
+    uint32_t zero = 0;
+
+    return bpf_map_lookup_elem(&pipeline_state, &zero);
+}
+
+/* 액션 결과 확정 (규칙이 샘플링 대상이면 샘플 단계로) */
+static __always_inline int stage_done(struct xdp_md *ctx, struct pipeline_state *st, int verdict)
+{
+    if (SG_HAS(SG_F_SAMPLE) && st->rule.sample_rate) {
+        st->verdict = verdict;
+        bpf_tail_call(ctx, &pipeline, STAGE_SAMPLE);
+    }
+
+    return finish_packet(ctx, verdict);
+}
+
+/* 규칙 액션 단계로 (범위를 벗어난 액션은 단계 없이 통과) */
+static __always_inline int stage_action(struct xdp_md *ctx, struct pipeline_state *st)
+{
+    uint8_t action = st->rule.action;
+
+    if (action < ACTION_PASS || action > ACTION_SYNPROXY)
+        return finish_packet(ctx, XDP_PASS);
+
+    bpf_tail_call(ctx, &pipeline, STAGE_ACTION(action));
+
+    /* 단계가 연결되지 않음 (데몬이 규칙 집합과 단계를 전환하는 사이) */
+    return finish_packet(ctx, XDP_PASS);
+}
+
+/* 분류 결과에 따라 레이트 리밋 또는 액션 단계로 */
+static __always_inline int stage_dispatch(struct xdp_md *ctx, struct pipeline_state *st,
+                                          struct rule_verdict *rule)
+{
+    if (!rule)
+        return finish_packet(ctx, XDP_PASS);
+
+    /* 맵 값 포인터는 테일 콜 후 사용할 수 없으므로 사본 전달 */
+    st->rule = *rule;
+    if (!SG_HAS(SG_F_RATE_LIMIT) || !st->rule.rate_limit)
+        return stage_action(ctx, st);
+
+    bpf_tail_call(ctx, &pipeline, STAGE_RATE_LIMIT);
+
+    /* 단계가 연결되지 않음 (데몬이 규칙 집합과 단계를 전환하는 사이) */
+    return finish_packet(ctx, XDP_PASS);
+}
+
+/* 파이프라인 진입점 (이더넷/VLAN 파싱 후 주소 계열별 분류 단계로) */
+SEC("xdp")
+int xdp_pipeline_func(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+    struct pipeline_state *st = pipeline_state_get();
+    uint16_t h_proto;
+    void *l3;
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+
+    int ret = parse_eth(data, data_end, &h_proto, &l3);
+    if (ret < 0)
+        return finish_packet(ctx, ret);
+
+    st->l3_off = l3 - data;
+    if (h_proto == bpf_htons(ETH_P_IP))
+        bpf_tail_call(ctx, &pipeline, STAGE_CLASSIFY_V4);
+    else if (h_proto == bpf_htons(ETH_P_IPV6))
+        bpf_tail_call(ctx, &pipeline, STAGE_CLASSIFY_V6);
+
+    /* 지원하지 않는 프로토콜이거나 해당 주소 계열의 규칙이 없음 */
+    return finish_packet(ctx, XDP_PASS);
+}
+
+SEC("xdp")
+int xdp_classify_v4(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+    struct pipeline_state *st = pipeline_state_get();
+    struct rule_verdict *rule;
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+
+    /* 검증기가 패킷 포인터 범위를 알 수 있도록 오프셋을 한 번만 읽어 상한 확인 */
+    uint32_t l3_off = st->l3_off;
+    if (l3_off > PIPELINE_MAX_L3_OFF)
+        return finish_packet(ctx, XDP_PASS);
+
+    if (blocklist_v4_match(ctx, data + l3_off, data_end))
+        return finish_packet(ctx, XDP_DROP);
+
+    __builtin_memset(&st->rl_key, 0, sizeof(st->rl_key));
+    int ret = lookup_ipv4(data + l3_off, data_end, &st->rl_key, &rule);
+    if (ret < 0)
+        return finish_packet(ctx, ret);
+
+    return stage_dispatch(ctx, st, rule);
+}
+
+SEC("xdp")
+int xdp_classify_v6(struct xdp_md *ctx)
+{
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+    struct pipeline_state *st = pipeline_state_get();
+    struct rule_verdict *rule;
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+
+    uint32_t l3_off = st->l3_off;
+    if (l3_off > PIPELINE_MAX_L3_OFF)
+        return finish_packet(ctx, XDP_PASS);
+
+    if (blocklist_v6_match(ctx, data + l3_off, data_end))
+        return finish_packet(ctx, XDP_DROP);
+
+    __builtin_memset(&st->rl_key, 0, sizeof(st->rl_key));
+    int ret = lookup_ipv6(data + l3_off, data_end, &st->rl_key, &rule);
+    if (ret < 0)
+        return finish_packet(ctx, ret);
+
+    return stage_dispatch(ctx, st, rule);
+}
+
+/* 레이트 리밋이 있는 규칙만 거치는 단계 */
+SEC("xdp")
+int xdp_rate_limit(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+
+    if (!rate_limit_allow(&st->rule, &st->rl_key))
+        return stage_done(ctx, st, act_drop(ctx, &st->rule));
+
+    return stage_action(ctx, st);
+}
+
+/* 샘플링 대상 규칙만 거치는 마지막 단계 */
+SEC("xdp")
+int xdp_sample(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+
+    sample_event(ctx, &st->rule, st->verdict);
+    return finish_packet(ctx, st->verdict);
+}
+
+/* 액션 단계 (ACTION_PASS와 ACTION_COUNT는 같은 프로그램을 연결) */
+SEC("xdp")
+int xdp_act_pass(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_pass(ctx, &st->rule));
+}
+
+SEC("xdp")
+int xdp_act_drop(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_drop(ctx, &st->rule));
+}
+
+SEC("xdp")
+int xdp_act_redirect(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_redirect(ctx, &st->rule));
+}
+
+SEC("xdp")
+int xdp_act_redirect_cpu(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_redirect_cpu(ctx, &st->rule));
+}
+
+SEC("xdp")
+int xdp_act_redirect_xsk(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_redirect_xsk(ctx, &st->rule));
+}
+
+SEC("xdp")
+int xdp_act_synproxy(struct xdp_md *ctx)
+{
+    struct pipeline_state *st = pipeline_state_get();
+
+    if (!st)
+        return finish_packet(ctx, XDP_PASS);
+    return stage_done(ctx, st, act_synproxy(ctx, &st->rule));
 }
 
 char _license[] SEC("license") = "GPL";
@@ -7,6 +7,8 @@ use std::net::SocketAddr;
 use tokio::io::{AsyncReadExt, AsyncWriteExt};
 use tokio::net::TcpStream;
 
+use swift_guard_common::api::{decode_frame, encode_frame, WireFormat};
+
 /// 필터 규칙 통계
 #[derive(Debug, Serialize, Deserialize, Clone)]
 pub struct RuleStats {
@@ -64,7 +66,32 @@ pub struct SystemStats {
     pub mbps: f64,
 }
 
-/// API 요청
+/// 필터 규칙 명세 (일괄 요청용, AddRule과 같은 필드)
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct RuleSpec {
+    pub src_ip: Option<String>,
+    pub dst_ip: Option<String>,
+    pub src_port_min: u16,
+    pub src_port_max: u16,
+    pub dst_port_min: u16,
+    pub dst_port_max: u16,
+    pub protocol: u8,
+    pub tcp_flags: u8,
+    pub action: u8,
+    pub redirect_if: Option<String>,
+    #[serde(default)]
+    pub redirect_cpu: Option<u32>,
+    pub priority: u32,
+    pub rate_limit: u32,
+    #[serde(default)]
+    pub rate_limit_per_source: bool,
+    #[serde(default)]
+    pub sample_rate: u16,
+    pub expire: u32,
+    pub label: String,
+}
+
+/// API 요청 (변형 순서는 데몬 정의와 같아야 함, 바이너리 인코딩이 순서 번호 사용)
 #[derive(Debug, Serialize, Deserialize)]
 pub enum ApiRequest {
     /// XDP 프로그램 연결
@@ -91,8 +118,17 @@ pub enum ApiRequest {
         tcp_flags: u8,
         action: u8,
         redirect_if: Option<String>,
+        /// CPU 리디렉션 대상 (redirect-cpu 액션)
+        #[serde(default)]
+        redirect_cpu: Option<u32>,
         priority: u32,
         rate_limit: u32,
+        /// 레이트 리밋을 소스 IP별로 적용
+        #[serde(default)]
+        rate_limit_per_source: bool,
+        /// 매치된 패킷 N개 중 하나를 이벤트로 샘플링 (0 = 끔)
+        #[serde(default)]
+        sample_rate: u16,
         expire: u32,
         label: String,
     },
@@ -109,6 +145,33 @@ pub enum ApiRequest {
     
     /// 통계 조회
     GetStats {},
+    
+    /// 필터 규칙 일괄 추가
+    BulkAddRules {
+        rules: Vec<RuleSpec>,
+    },
+    
+    /// 규칙 집합 전체 교체
+    ReplaceRuleset {
+        rules: Vec<RuleSpec>,
+    },
+    
+    /// 규칙의 이벤트 샘플링 비율 변경 (0 = 끔)
+    SetSampleRate {
+        label: String,
+        sample_rate: u16,
+    },
+    
+    /// 소스 프리픽스 블록리스트 불러오기 (데몬이 path의 파일을 읽음, 같은 이름이면 교체)
+    LoadBlocklist {
+        name: String,
+        path: String,
+    },
+    
+    /// 소스 프리픽스 블록리스트 삭제
+    DeleteBlocklist {
+        name: String,
+    },
 }
 
 /// API 응답
@@ -139,16 +202,25 @@ pub enum ApiResponse {
 #[derive(Debug)]
 pub struct ApiClient {
     server_addr: String,
+    /// 요청 인코딩 (응답은 같은 인코딩으로 수신)
+    format: WireFormat,
 }
 
 impl ApiClient {
-    /// 새로운 API 클라이언트 생성
+    /// 새로운 API 클라이언트 생성 (JSON 인코딩)
     pub fn new(server_addr: &str) -> Result<Self> {
         Ok(Self {
             server_addr: server_addr.to_string(),
+            format: WireFormat::Json,
         })
     }
     
+    /// 바이너리 인코딩 사용 (대량 규칙 전송용)
+    pub fn with_binary(mut self) -> Self {
+        self.format = WireFormat::Binary;
+        self
+    }
+    
     /// 요청 전송 및 응답 수신
     pub async fn send_request(&self, request: &ApiRequest) -> Result<ApiResponse> {
         // 서버에 연결
@@ -157,7 +229,7 @@ impl ApiClient {
             .map_err(|e| anyhow!("Failed to connect to API server: {}", e))?;
         
         // 요청 직렬화
-        let request_bytes = serde_json::to_vec(request)
+        let request_bytes = encode_frame(request, self.format)
             .map_err(|e| anyhow!("Failed to serialize request: {}", e))?;
         
         // 요청 길이 전송 (4바이트 빅 엔디안)
@@ -186,9 +258,90 @@ impl ApiClient {
             .map_err(|e| anyhow!("Failed to receive response: {}", e))?;
         
         // 응답 역직렬화
-        let response: ApiResponse = serde_json::from_slice(&response_bytes)
+        let (response, _): (ApiResponse, _) = decode_frame(&response_bytes)
             .map_err(|e| anyhow!("Failed to deserialize response: {}", e))?;
         
         Ok(response)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use swift_guard_common::api::ApiRequest as DaemonRequest;
+    
+    fn spec(label: &str) -> RuleSpec {
+        RuleSpec {
+            src_ip: Some("10.0.0.0/8".to_string()),
+            dst_ip: None,
+            src_port_min: 0,
+            src_port_max: 65535,
+            dst_port_min: 80,
+            dst_port_max: 80,
+            protocol: 6,
+            tcp_flags: 0x02,
+            action: 2,
+            redirect_if: None,
+            redirect_cpu: None,
+            priority: 100,
+            rate_limit: 0,
+            rate_limit_per_source: false,
+            sample_rate: 0,
+            expire: 0,
+            label: label.to_string(),
+        }
+    }
+    
+    #[test]
+    fn test_binary_variants_match_daemon() {
+        let name = || "list".to_string();
+        let requests = vec![
+            ApiRequest::Attach { interface: "eth0".to_string(), mode: 1, force: true },
+            ApiRequest::Detach { interface: "eth0".to_string() },
+            ApiRequest::AddRule {
+                src_ip: Some("192.168.1.0/24".to_string()),
+                dst_ip: Some("10.0.0.1".to_string()),
+                src_port_min: 1024,
+                src_port_max: 65535,
+                dst_port_min: 443,
+                dst_port_max: 443,
+                protocol: 6,
+                tcp_flags: 0x12,
+                action: 3,
+                redirect_if: Some("eth1".to_string()),
+                redirect_cpu: Some(2),
+                priority: 10,
+                rate_limit: 1000,
+                rate_limit_per_source: true,
+                sample_rate: 64,
+                expire: 60,
+                label: "web".to_string(),
+            },
+            ApiRequest::DeleteRule { label: "web".to_string() },
+            ApiRequest::ListRules { include_stats: true },
+            ApiRequest::GetStats {},
+            ApiRequest::BulkAddRules { rules: vec![spec("a"), spec("b")] },
+            ApiRequest::ReplaceRuleset { rules: vec![spec("c")] },
+            ApiRequest::SetSampleRate { label: "web".to_string(), sample_rate: 8 },
+            ApiRequest::LoadBlocklist { name: name(), path: "/etc/swift-guard/list.txt".to_string() },
+            ApiRequest::DeleteBlocklist { name: name() },
+        ];
+        
+        for request in &requests {
+            // 새 변형을 추가하면 여기서 컴파일 오류 - 위 목록에도 추가할 것
+            match request {
+                ApiRequest::Attach { .. } | ApiRequest::Detach { .. } | ApiRequest::AddRule { .. }
+                | ApiRequest::DeleteRule { .. } | ApiRequest::ListRules { .. } | ApiRequest::GetStats {}
+                | ApiRequest::BulkAddRules { .. } | ApiRequest::ReplaceRuleset { .. }
+                | ApiRequest::SetSampleRate { .. } | ApiRequest::LoadBlocklist { .. }
+                | ApiRequest::DeleteBlocklist { .. } => {}
+            }
+            
+            // 데몬이 같은 변형, 같은 필드 값으로 디코딩해야 함 (JSON 표현으로 비교)
+            let frame = encode_frame(request, WireFormat::Binary).unwrap();
+            let (decoded, format): (DaemonRequest, _) = decode_frame(&frame).unwrap();
+            assert_eq!(format, WireFormat::Binary);
+            assert_eq!(serde_json::to_value(&decoded).unwrap(), serde_json::to_value(request).unwrap());
+        }
+    }
+}
@@ -5,7 +5,7 @@ use anyhow::{anyhow, Context, Result};
 use clap::{Parser, Subcommand};
 //use ipnet::IpNet;
 use log::{debug, error, info};
-use serde::Serialize;
+use serde::{Deserialize, Serialize};
 use std::net::IpAddr;
 use std::path::PathBuf;
 use tokio::net::TcpStream;
@@ -14,7 +14,7 @@ use tokio::io::{AsyncReadExt, AsyncWriteExt};
 mod api;
 mod utils;
 
-use api::{ApiClient, ApiRequest, ApiResponse};
+use api::{ApiClient, ApiRequest, ApiResponse, RuleSpec};
 use utils::parse_port_range;
 
 #[derive(Parser, Debug)]
@@ -56,11 +56,11 @@ enum Commands {
 
     /// 필터링 규칙 추가
     AddRule {
-        /// 소스 IP 주소 (a.b.c.d 또는 a.b.c.d/prefix)
+        /// 소스 IP 주소 (a.b.c.d[/prefix] 또는 IPv6 주소[/prefix])
         #[clap(long)]
         src_ip: Option<String>,
 
-        /// 대상 IP 주소 (a.b.c.d 또는 a.b.c.d/prefix)
+        /// 대상 IP 주소 (a.b.c.d[/prefix] 또는 IPv6 주소[/prefix])
         #[clap(long)]
         dst_ip: Option<String>,
 
@@ -72,7 +72,7 @@ enum Commands {
         #[clap(long)]
         dst_port: Option<String>,
 
-        /// 프로토콜 (tcp, udp, icmp, any)
+        /// 프로토콜 (tcp, udp, icmp, icmpv6, any)
         #[clap(long)]
         protocol: Option<String>,
 
@@ -84,7 +84,7 @@ enum Commands {
         #[clap(long)]
         pkt_len: Option<String>,
 
-        /// 액션 (pass, drop, redirect, count)
+        /// 액션 (pass, drop, redirect, count, redirect-cpu, redirect-xsk, synproxy)
         #[clap(long)]
         action: String,
 
@@ -92,6 +92,10 @@ enum Commands {
         #[clap(long)]
         redirect_if: Option<String>,
 
+        /// 리디렉션 대상 CPU (redirect-cpu 액션에 필요)
+        #[clap(long)]
+        redirect_cpu: Option<u32>,
+
         /// 규칙 우선순위 (높을수록 우선)
         #[clap(long, default_value = "0")]
         priority: u32,
@@ -100,6 +104,14 @@ enum Commands {
         #[clap(long, default_value = "0")]
         rate_limit: u32,
 
+        /// 레이트 리밋을 규칙 전체가 아닌 소스 IP별로 적용
+        #[clap(long)]
+        rate_limit_per_source: bool,
+
+        /// 매치된 패킷 N개 중 하나의 헤더를 이벤트로 기록 (0 = 끔)
+        #[clap(long, default_value = "0")]
+        sample_rate: u16,
+
         /// 규칙 만료 시간 (초, 0 = 만료 없음)
         #[clap(long, default_value = "0")]
         expire: u32,
@@ -116,6 +128,44 @@ enum Commands {
         label: String,
     },
 
+    /// 규칙의 이벤트 샘플링 비율 변경
+    Sample {
+        /// 규칙 레이블
+        #[clap(long)]
+        label: String,
+
+        /// 매치된 패킷 N개 중 하나를 기록 (0 = 끔)
+        #[clap(long)]
+        rate: u16,
+    },
+
+    /// 소스 프리픽스 블록리스트 불러오기 (한 줄에 프리픽스 하나, 같은 이름이면 교체)
+    LoadBlocklist {
+        /// 블록리스트 이름
+        #[clap(long)]
+        name: String,
+
+        /// 프리픽스 파일 경로 (데몬이 직접 읽음)
+        file: PathBuf,
+    },
+
+    /// 소스 프리픽스 블록리스트 삭제
+    DeleteBlocklist {
+        /// 블록리스트 이름
+        #[clap(long)]
+        name: String,
+    },
+
+    /// 파일의 규칙을 한 번에 가져오기 (JSON 배열, 항목 필드는 add-rule 옵션과 같음)
+    ImportRules {
+        /// 규칙 파일 경로
+        file: PathBuf,
+
+        /// 기존 규칙 집합을 파일 내용으로 교체
+        #[clap(long)]
+        replace: bool,
+    },
+
     /// 활성 규칙 나열
     ListRules {
         /// 통계 포함
@@ -207,82 +257,47 @@ async fn main() -> Result<()> {
         },
         
         Commands::AddRule { src_ip, dst_ip, src_port, dst_port, protocol, tcp_flags, 
-                          pkt_len, action, redirect_if, priority, rate_limit, expire, label } => {
+                          pkt_len, action, redirect_if, redirect_cpu, priority, rate_limit, rate_limit_per_source, sample_rate, expire, label } => {
             debug!("Adding filter rule: {}", label);
             
-            // 액션 파싱
-            let action_value = match action.as_str() {
-                "pass" => 1,
-                "drop" => 2,
-                "redirect" => 3,
-                "count" => 4,
-                _ => return Err(anyhow!("Invalid action: {}", action)),
-            };
-            
-            // 프로토콜 파싱
-            let protocol_value = match protocol {
-                Some(p) => match p.as_str() {
-                    "tcp" => 6,
-                    "udp" => 17,
-                    "icmp" => 1,
-                    "any" => 255,
-                    _ => return Err(anyhow!("Invalid protocol: {}", p)),
-                },
-                None => 255, // ANY
-            };
-            
-            // 포트 범위 파싱
-            let (src_port_min, src_port_max) = match src_port {
-                Some(p) => parse_port_range(p)?,
-                None => (0, 65535),
-            };
-            
-            let (dst_port_min, dst_port_max) = match dst_port {
-                Some(p) => parse_port_range(p)?,
-                None => (0, 65535),
-            };
-            
-            // TCP 플래그 파싱
-            let tcp_flags_value = match tcp_flags {
-                Some(f) => {
-                    let mut flags = 0;
-                    for flag in f.split(',') {
-                        match flag.trim() {
-                            "FIN" => flags |= 0x01,
-                            "SYN" => flags |= 0x02,
-                            "RST" => flags |= 0x04,
-                            "PSH" => flags |= 0x08,
-                            "ACK" => flags |= 0x10,
-                            "URG" => flags |= 0x20,
-                            _ => return Err(anyhow!("Invalid TCP flag: {}", flag)),
-                        }
-                    }
-                    flags
-                },
-                None => 0,
-            };
-            
-            // 리디렉션 인터페이스 확인
-            if action_value == 3 && redirect_if.is_none() {
-                return Err(anyhow!("Redirect action requires 'redirect_if' parameter"));
-            }
-            
-            let request = ApiRequest::AddRule {
+            let entry = RuleEntry {
                 src_ip: src_ip.clone(),
                 dst_ip: dst_ip.clone(),
-                src_port_min,
-                src_port_max,
-                dst_port_min,
-                dst_port_max,
-                protocol: protocol_value,
-                tcp_flags: tcp_flags_value,
-                action: action_value,
+                src_port: src_port.clone(),
+                dst_port: dst_port.clone(),
+                protocol: protocol.clone(),
+                tcp_flags: tcp_flags.clone(),
+                action: action.clone(),
                 redirect_if: redirect_if.clone(),
+                redirect_cpu: *redirect_cpu,
                 priority: *priority,
                 rate_limit: *rate_limit,
+                rate_limit_per_source: *rate_limit_per_source,
+                sample_rate: *sample_rate,
                 expire: *expire,
                 label: label.clone(),
             };
+            let spec = parse_rule_entry(&entry)?;
+            
+            let request = ApiRequest::AddRule {
+                src_ip: spec.src_ip,
+                dst_ip: spec.dst_ip,
+                src_port_min: spec.src_port_min,
+                src_port_max: spec.src_port_max,
+                dst_port_min: spec.dst_port_min,
+                dst_port_max: spec.dst_port_max,
+                protocol: spec.protocol,
+                tcp_flags: spec.tcp_flags,
+                action: spec.action,
+                redirect_if: spec.redirect_if,
+                redirect_cpu: spec.redirect_cpu,
+                priority: spec.priority,
+                rate_limit: spec.rate_limit,
+                rate_limit_per_source: spec.rate_limit_per_source,
+                sample_rate: spec.sample_rate,
+                expire: spec.expire,
+                label: spec.label,
+            };
             
             let response = client.send_request(&request).await
                 .context("Failed to send add rule request")?;
@@ -323,6 +338,119 @@ async fn main() -> Result<()> {
             }
         },
         
+        Commands::Sample { label, rate } => {
+            debug!("Setting sample rate of {} to {}", label, rate);
+            
+            let request = ApiRequest::SetSampleRate {
+                label: label.clone(),
+                sample_rate: *rate,
+            };
+            
+            let response = client.send_request(&request).await
+                .context("Failed to send sample rate request")?;
+            
+            match response {
+                ApiResponse::Success { message } => {
+                    println!("{}", message);
+                },
+                ApiResponse::Error { message } => {
+                    return Err(anyhow!("Error: {}", message));
+                },
+                ApiResponse::Rules { .. } | ApiResponse::Stats { .. } => {
+                    return Err(anyhow!("Unexpected response type"))
+                }
+            }
+        },
+        
+        Commands::LoadBlocklist { name, file } => {
+            debug!("Loading blocklist {} from {}", name, file.display());
+            
+            // 데몬의 작업 디렉터리와 무관하도록 절대 경로로 전달
+            let path = std::fs::canonicalize(file)
+                .context(format!("Failed to resolve {}", file.display()))?;
+            let request = ApiRequest::LoadBlocklist {
+                name: name.clone(),
+                path: path.to_string_lossy().to_string(),
+            };
+            
+            let response = client.send_request(&request).await
+                .context("Failed to send load blocklist request")?;
+            
+            match response {
+                ApiResponse::Success { message } => {
+                    println!("{}", message);
+                },
+                ApiResponse::Error { message } => {
+                    return Err(anyhow!("Error: {}", message));
+                },
+                ApiResponse::Rules { .. } | ApiResponse::Stats { .. } => {
+                    return Err(anyhow!("Unexpected response type"))
+                }
+            }
+        },
+        
+        Commands::DeleteBlocklist { name } => {
+            debug!("Deleting blocklist {}", name);
+            
+            let request = ApiRequest::DeleteBlocklist {
+                name: name.clone(),
+            };
+            
+            let response = client.send_request(&request).await
+                .context("Failed to send delete blocklist request")?;
+            
+            match response {
+                ApiResponse::Success { message } => {
+                    println!("{}", message);
+                },
+                ApiResponse::Error { message } => {
+                    return Err(anyhow!("Error: {}", message));
+                },
+                ApiResponse::Rules { .. } | ApiResponse::Stats { .. } => {
+                    return Err(anyhow!("Unexpected response type"))
+                }
+            }
+        },
+        
+        Commands::ImportRules { file, replace } => {
+            debug!("Importing filter rules from {}", file.display());
+            
+            let content = std::fs::read_to_string(file)
+                .context(format!("Failed to read {}", file.display()))?;
+            let entries: Vec<RuleEntry> = serde_json::from_str(&content)
+                .context(format!("Failed to parse {}", file.display()))?;
+            
+            let rules = entries.iter()
+                .enumerate()
+                .map(|(i, entry)| parse_rule_entry(entry)
+                    .with_context(|| format!("Invalid rule #{} ({})", i + 1, entry.label)))
+                .collect::<Result<Vec<RuleSpec>>>()?;
+            let count = rules.len();
+            
+            let request = if *replace {
+                ApiRequest::ReplaceRuleset { rules }
+            } else {
+                ApiRequest::BulkAddRules { rules }
+            };
+            
+            // 대량 전송은 바이너리 인코딩 사용
+            let response = ApiClient::new(&cli.api_server)?.with_binary()
+                .send_request(&request).await
+                .context("Failed to send import request")?;
+            
+            match response {
+                ApiResponse::Success { message } => {
+                    println!("{} rules imported: {}", count, message);
+                },
+                ApiResponse::Error { message } => {
+                    return Err(anyhow!("Error: {}", message));
+                },
+                ApiResponse::Rules { .. } | ApiResponse::Stats { .. } => {
+                    return Err(anyhow!("Unexpected response type"))
+                }
+            }
+        },
+        
         Commands::ListRules { stats } => {
             debug!("Listing filter rules");
             
@@ -391,3 +519,124 @@ async fn main() -> Result<()> {
     
     Ok(())
 }
+
+/// 규칙 파일 항목 (add-rule 옵션과 같은 이름과 형식)
+#[derive(Debug, Deserialize)]
+struct RuleEntry {
+    #[serde(default)]
+    src_ip: Option<String>,
+    #[serde(default)]
+    dst_ip: Option<String>,
+    #[serde(default)]
+    src_port: Option<String>,
+    #[serde(default)]
+    dst_port: Option<String>,
+    #[serde(default)]
+    protocol: Option<String>,
+    #[serde(default)]
+    tcp_flags: Option<String>,
+    action: String,
+    #[serde(default)]
+    redirect_if: Option<String>,
+    #[serde(default)]
+    redirect_cpu: Option<u32>,
+    #[serde(default)]
+    priority: u32,
+    #[serde(default)]
+    rate_limit: u32,
+    #[serde(default)]
+    rate_limit_per_source: bool,
+    #[serde(default)]
+    sample_rate: u16,
+    #[serde(default)]
+    expire: u32,
+    label: String,
+}
+
+/// 규칙 항목을 API 규칙 명세로 변환
+fn parse_rule_entry(entry: &RuleEntry) -> Result<RuleSpec> {
+    // 액션 파싱
+    let action_value = match entry.action.as_str() {
+        "pass" => 1,
+        "drop" => 2,
+        "redirect" => 3,
+        "count" => 4,
+        "redirect-cpu" => 5,
+        "redirect-xsk" => 6,
+        "synproxy" => 7,
+        _ => return Err(anyhow!("Invalid action: {}", entry.action)),
+    };
+    
+    // 프로토콜 파싱
+    let protocol_value = match &entry.protocol {
+        Some(p) => match p.as_str() {
+            "tcp" => 6,
+            "udp" => 17,
+            "icmp" => 1,
+            "icmpv6" => 58,
+            "any" => 255,
+            _ => return Err(anyhow!("Invalid protocol: {}", p)),
+        },
+        None => 255, // ANY
+    };
+    
+    // 포트 범위 파싱
+    let (src_port_min, src_port_max) = match &entry.src_port {
+        Some(p) => parse_port_range(p)?,
+        None => (0, 65535),
+    };
+    
+    let (dst_port_min, dst_port_max) = match &entry.dst_port {
+        Some(p) => parse_port_range(p)?,
+        None => (0, 65535),
+    };
+    
+    // TCP 플래그 파싱
+    let tcp_flags_value = match &entry.tcp_flags {
+        Some(f) => {
+            let mut flags = 0;
+            for flag in f.split(',') {
+                match flag.trim() {
+                    "FIN" => flags |= 0x01,
+                    "SYN" => flags |= 0x02,
+                    "RST" => flags |= 0x04,
+                    "PSH" => flags |= 0x08,
+                    "ACK" => flags |= 0x10,
+                    "URG" => flags |= 0x20,
+                    _ => return Err(anyhow!("Invalid TCP flag: {}", flag)),
+                }
+            }
+            flags
+        },
+        None => 0,
+    };
+    
+    // 리디렉션 인터페이스 확인
+    if action_value == 3 && entry.redirect_if.is_none() {
+        return Err(anyhow!("Redirect action requires 'redirect_if' parameter"));
+    }
+    
+    if action_value == 5 && entry.redirect_cpu.is_none() {
+        return Err(anyhow!("Redirect-cpu action requires 'redirect_cpu' parameter"));
+    }
+    
+    Ok(RuleSpec {
+        src_ip: entry.src_ip.clone(),
+        dst_ip: entry.dst_ip.clone(),
+        src_port_min,
+        src_port_max,
+        dst_port_min,
+        dst_port_max,
+        protocol: protocol_value,
+        tcp_flags: tcp_flags_value,
+        action: action_value,
+        redirect_if: entry.redirect_if.clone(),
+        redirect_cpu: entry.redirect_cpu,
+        priority: entry.priority,
+        rate_limit: entry.rate_limit,
+        rate_limit_per_source: entry.rate_limit_per_source,
+        sample_rate: entry.sample_rate,
+        expire: entry.expire,
+        label: entry.label.clone(),
+    })
+}
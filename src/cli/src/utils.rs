@@ -68,6 +68,7 @@ pub fn protocol_name_to_num(name: &str) -> Result<u8> {
         "tcp" => Ok(6),
         "udp" => Ok(17),
         "icmp" => Ok(1),
+        "icmpv6" => Ok(58),
         "any" => Ok(255),
         _ => Err(anyhow!("Unknown protocol: {}", name)),
     }
@@ -80,6 +81,9 @@ pub fn action_name_to_num(name: &str) -> Result<u8> {
         "drop" => Ok(2),
         "redirect" => Ok(3),
         "count" => Ok(4),
+        "redirect-cpu" => Ok(5),
+        "redirect-xsk" => Ok(6),
+        "synproxy" => Ok(7),
         _ => Err(anyhow!("Unknown action: {}", name)),
     }
 }
@@ -91,6 +95,9 @@ pub fn action_num_to_name(num: u8) -> String {
         2 => "drop".to_string(),
         3 => "redirect".to_string(),
         4 => "count".to_string(),
+        5 => "redirect-cpu".to_string(),
+        6 => "redirect-xsk".to_string(),
+        7 => "synproxy".to_string(),
         _ => "unknown".to_string(),
     }
 }
@@ -99,6 +106,7 @@ pub fn action_num_to_name(num: u8) -> String {
 pub fn protocol_num_to_name(num: u8) -> String {
     match num {
         1 => "icmp".to_string(),
+        58 => "icmpv6".to_string(),
         6 => "tcp".to_string(),
         17 => "udp".to_string(),
         255 => "any".to_string(),
@@ -1,9 +1,74 @@
 // Swift-Guard Common API
 // CLI와 데몬 간의 통신을 위한 API 정의
 
+use anyhow::{anyhow, Context, Result};
+use serde::de::DeserializeOwned;
 use serde::{Deserialize, Serialize};
 
-/// API 요청
+/// 바이너리(bincode) 프레임의 첫 바이트 (JSON 프레임은 '{' 또는 '"'로 시작)
+pub const BINARY_FRAME_MAGIC: u8 = 0xB1;
+
+/// 프레임 인코딩
+///
+/// 바이너리 인코딩은 열거형 변형을 순서 번호로 기록하므로, 요청/응답 열거형의
+/// 변형 순서도 프로토콜의 일부다. 새 변형은 양쪽 정의의 같은 위치에 추가한다.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum WireFormat {
+    Json,
+    Binary,
+}
+
+/// 프레임 본문 인코딩 (길이 접두사 제외)
+pub fn encode_frame<T: Serialize>(value: &T, format: WireFormat) -> Result<Vec<u8>> {
+    match format {
+        WireFormat::Json => serde_json::to_vec(value).context("Failed to encode JSON frame"),
+        WireFormat::Binary => {
+            let mut frame = vec![BINARY_FRAME_MAGIC];
+            bincode::serialize_into(&mut frame, value).context("Failed to encode binary frame")?;
+            Ok(frame)
+        }
+    }
+}
+
+/// 프레임 본문 디코딩 (첫 바이트로 인코딩 판별)
+pub fn decode_frame<T: DeserializeOwned>(frame: &[u8]) -> Result<(T, WireFormat)> {
+    match frame.first() {
+        Some(&BINARY_FRAME_MAGIC) => bincode::deserialize(&frame[1..])
+            .map(|value| (value, WireFormat::Binary))
+            .context("Failed to decode binary frame"),
+        Some(_) => serde_json::from_slice(frame)
+            .map(|value| (value, WireFormat::Json))
+            .context("Failed to decode JSON frame"),
+        None => Err(anyhow!("Empty frame")),
+    }
+}
+
+/// 필터 규칙 명세 (일괄 요청용, AddRule과 같은 필드)
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct RuleSpec {
+    pub src_ip: Option<String>,
+    pub dst_ip: Option<String>,
+    pub src_port_min: u16,
+    pub src_port_max: u16,
+    pub dst_port_min: u16,
+    pub dst_port_max: u16,
+    pub protocol: u8,
+    pub tcp_flags: u8,
+    pub action: u8,
+    pub redirect_if: Option<String>,
+    #[serde(default)]
+    pub redirect_cpu: Option<u32>,
+    pub priority: u32,
+    pub rate_limit: u32,
+    #[serde(default)]
+    pub rate_limit_per_source: bool,
+    #[serde(default)]
+    pub sample_rate: u16,
+    pub expire: u32,
+    pub label: String,
+}
+
+/// API 요청 (바이너리 인코딩이 변형 순서 번호를 쓰므로 CLI 정의와 앞부분 순서가 같아야 함)
 #[derive(Debug, Serialize, Deserialize)]
 pub enum ApiRequest {
     /// XDP 프로그램 연결
@@ -30,8 +95,17 @@ pub enum ApiRequest {
         tcp_flags: u8,
         action: u8,
         redirect_if: Option<String>,
+        /// CPU 리디렉션 대상 (redirect-cpu 액션)
+        #[serde(default)]
+        redirect_cpu: Option<u32>,
         priority: u32,
         rate_limit: u32,
+        /// 레이트 리밋을 소스 IP별로 적용
+        #[serde(default)]
+        rate_limit_per_source: bool,
+        /// 매치된 패킷 N개 중 하나를 이벤트로 샘플링 (0 = 끔)
+        #[serde(default)]
+        sample_rate: u16,
         expire: u32,
         label: String,
     },
@@ -49,6 +123,33 @@ pub enum ApiRequest {
     /// 통계 조회
     GetStats {},
     
+    /// 필터 규칙 일괄 추가 (분류기는 한 번만 재구성)
+    BulkAddRules {
+        rules: Vec<RuleSpec>,
+    },
+    
+    /// 규칙 집합 전체 교체
+    ReplaceRuleset {
+        rules: Vec<RuleSpec>,
+    },
+    
+    /// 규칙의 이벤트 샘플링 비율 변경 (0 = 끔)
+    SetSampleRate {
+        label: String,
+        sample_rate: u16,
+    },
+    
+    /// 소스 프리픽스 블록리스트 불러오기 (데몬이 path의 파일을 읽음, 같은 이름이면 교체)
+    LoadBlocklist {
+        name: String,
+        path: String,
+    },
+    
+    /// 소스 프리픽스 블록리스트 삭제
+    DeleteBlocklist {
+        name: String,
+    },
+    
     /// WASM 모듈 로드
     LoadWasmModule {
         name: String,
@@ -148,3 +249,30 @@ pub struct WasmModuleInfo {
     pub state: String,
     pub loaded_at: u64,
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_frame_roundtrip() {
+        let request = ApiRequest::DeleteRule { label: "block-ssh".to_string() };
+
+        for format in [WireFormat::Json, WireFormat::Binary] {
+            let frame = encode_frame(&request, format).unwrap();
+            let (decoded, detected): (ApiRequest, _) = decode_frame(&frame).unwrap();
+            assert_eq!(detected, format);
+            match decoded {
+                ApiRequest::DeleteRule { label } => assert_eq!(label, "block-ssh"),
+                other => panic!("unexpected request: {:?}", other),
+            }
+        }
+    }
+
+    #[test]
+    fn test_binary_frame_is_tagged() {
+        let frame = encode_frame(&ApiRequest::GetStats {}, WireFormat::Binary).unwrap();
+        assert_eq!(frame[0], BINARY_FRAME_MAGIC);
+        assert!(encode_frame(&ApiRequest::GetStats {}, WireFormat::Json).unwrap()[0] != BINARY_FRAME_MAGIC);
+    }
+}
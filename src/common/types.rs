@@ -44,6 +44,12 @@ pub enum ActionType {
     Redirect = 3,
     /// 통계만 수집 (패킷 통과)
     Count = 4,
+    /// 전용 CPU로 리디렉션 (cpumap)
+    RedirectCpu = 5,
+    /// 데몬의 AF_XDP 소켓으로 리디렉션 (WASM 검사)
+    RedirectXsk = 6,
+    /// SYN 쿠키 프록시 (XDP에서 SYN-ACK 응답, 검증된 ACK만 통과)
+    Synproxy = 7,
 }
 
 impl ActionType {
@@ -54,6 +60,9 @@ impl ActionType {
             2 => Some(Self::Drop),
             3 => Some(Self::Redirect),
             4 => Some(Self::Count),
+            5 => Some(Self::RedirectCpu),
+            6 => Some(Self::RedirectXsk),
+            7 => Some(Self::Synproxy),
             _ => None,
         }
     }
@@ -65,6 +74,9 @@ impl ActionType {
             "drop" => Some(Self::Drop),
             "redirect" => Some(Self::Redirect),
             "count" => Some(Self::Count),
+            "redirect-cpu" => Some(Self::RedirectCpu),
+            "redirect-xsk" => Some(Self::RedirectXsk),
+            "synproxy" => Some(Self::Synproxy),
             _ => None,
         }
     }
@@ -76,6 +88,9 @@ impl ActionType {
             Self::Drop => "drop",
             Self::Redirect => "redirect",
             Self::Count => "count",
+            Self::RedirectCpu => "redirect-cpu",
+            Self::RedirectXsk => "redirect-xsk",
+            Self::Synproxy => "synproxy",
         }
     }
 }
@@ -89,6 +104,8 @@ pub enum ProtocolType {
     Tcp = 6,
     /// UDP
     Udp = 17,
+    /// ICMPv6
+    Icmpv6 = 58,
     /// 모든 프로토콜
     Any = 255,
 }
@@ -100,6 +117,7 @@ impl ProtocolType {
             1 => Some(Self::Icmp),
             6 => Some(Self::Tcp),
             17 => Some(Self::Udp),
+            58 => Some(Self::Icmpv6),
             255 => Some(Self::Any),
             _ => None,
         }
@@ -111,6 +129,7 @@ impl ProtocolType {
             "icmp" => Some(Self::Icmp),
             "tcp" => Some(Self::Tcp),
             "udp" => Some(Self::Udp),
+            "icmpv6" => Some(Self::Icmpv6),
             "any" => Some(Self::Any),
             _ => None,
         }
@@ -122,6 +141,7 @@ impl ProtocolType {
             Self::Icmp => "icmp",
             Self::Tcp => "tcp",
             Self::Udp => "udp",
+            Self::Icmpv6 => "icmpv6",
             Self::Any => "any",
         }
     }
@@ -1,7 +1,7 @@
 // Swift-Guard Common Utilities
 // 공통 유틸리티 함수
 
-use std::net::{IpAddr, Ipv4Addr};
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
 use anyhow::{anyhow, Result};
 
 /// 포트 범위 문자열 파싱 (예: "80" 또는 "1024-2048")
@@ -63,6 +63,33 @@ pub fn parse_ip_prefix(s: &str) -> Result<(u32, u32)> {
     Ok((ip, prefix_len))
 }
 
+/// IPv6 주소 문자열에서 IPv6 주소(u128)와 프리픽스 길이 추출
+pub fn parse_ipv6_prefix(s: &str) -> Result<(u128, u32)> {
+    let parts: Vec<&str> = s.split('/').collect();
+    
+    let ip_str = parts[0].trim();
+    let addr = ip_str.parse::<Ipv6Addr>()
+        .map_err(|_| anyhow!("Invalid IPv6 address format: {}", ip_str))?;
+    
+    let prefix_len = if parts.len() > 1 {
+        parts[1].trim().parse::<u32>()
+            .map_err(|_| anyhow!("Invalid prefix length: {}", parts[1]))?
+    } else {
+        128 // 프리픽스가 지정되지 않은 경우 128(정확한 IP 매치)
+    };
+    
+    if prefix_len > 128 {
+        return Err(anyhow!("Invalid prefix length: {}", prefix_len));
+    }
+    
+    Ok((u128::from(addr), prefix_len))
+}
+
+/// IPv6 주소(u128)를 문자열로 변환
+pub fn ipv6_to_string(addr: u128) -> String {
+    Ipv6Addr::from(addr).to_string()
+}
+
 /// IPv4 주소를 문자열로 변환
 pub fn ipv4_to_string(addr: u32) -> String {
     format!("{}.{}.{}.{}", 
@@ -126,6 +153,9 @@ pub fn action_num_to_name(num: u8) -> String {
         2 => "drop".to_string(),
         3 => "redirect".to_string(),
         4 => "count".to_string(),
+        5 => "redirect-cpu".to_string(),
+        6 => "redirect-xsk".to_string(),
+        7 => "synproxy".to_string(),
         _ => "unknown".to_string(),
     }
 }
@@ -134,6 +164,7 @@ pub fn action_num_to_name(num: u8) -> String {
 pub fn protocol_num_to_name(num: u8) -> String {
     match num {
         1 => "icmp".to_string(),
+        58 => "icmpv6".to_string(),
         6 => "tcp".to_string(),
         17 => "udp".to_string(),
         255 => "any".to_string(),
@@ -191,6 +222,14 @@ mod tests {
         assert!(parse_ip_prefix("192.168.1.1/33").is_err());
     }
     
+    #[test]
+    fn test_parse_ipv6_prefix() {
+        assert_eq!(parse_ipv6_prefix("2001:db8::1").unwrap(), (0x2001_0db8_0000_0000_0000_0000_0000_0001, 128));
+        assert_eq!(parse_ipv6_prefix("2001:db8::/32").unwrap(), (0x2001_0db8_u128 << 96, 32));
+        assert!(parse_ipv6_prefix("2001:db8::zz").is_err());
+        assert!(parse_ipv6_prefix("::/129").is_err());
+    }
+    
     #[test]
     fn test_ipv4_conversions() {
         let addr = Ipv4Addr::new(192, 168, 1, 1);
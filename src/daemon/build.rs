@@ -0,0 +1,316 @@
+// src/daemon/build.rs
+//! include/swift_guard.h에서 데이터 경로 ABI 바인딩 생성 (src/abi.rs가 포함)
+//!
+//! 헤더는 정수 상수 매크로와 고정 폭 정수, 배열, 구조체 필드로 된 구조체만 정의하므로
+//! 외부 도구(libclang) 없이 직접 해석한다. 이 범위를 벗어난 정의는 빌드를 실패시킨다.
+
+use std::collections::BTreeMap;
+use std::env;
+use std::fmt::Write as _;
+use std::path::PathBuf;
+
+const ABI_HEADER: &str = "../../include/swift_guard.h";
+
+/// 헤더가 linux/bpf.h에서 가져와 쓰는 구조체 (커널 UAPI 정의와 같은 배치)
+const EXTERNAL_STRUCTS: &[(&str, &[(&str, &str)])] = &[
+    ("bpf_spin_lock", &[("val", "u32")]),
+];
+
+fn main() {
+    println!("cargo:rerun-if-changed={}", ABI_HEADER);
+
+    let header = std::fs::read_to_string(ABI_HEADER)
+        .expect("Failed to read swift_guard.h");
+    let bindings = generate(&header);
+
+    let out_path = PathBuf::from(env::var("OUT_DIR").expect("OUT_DIR not set")).join("swift_guard.rs");
+    std::fs::write(&out_path, bindings)
+        .expect("Failed to write swift_guard.rs");
+}
+
+/// 헤더 전체를 Rust 상수와 #[repr(C)] 구조체로 변환
+fn generate(header: &str) -> String {
+    let source = strip_comments(header).replace("\\\n", " ");
+    let mut consts: BTreeMap<String, i64> = BTreeMap::new();
+    let mut out = String::new();
+    let mut body = String::new();
+
+    // 전처리 지시문은 상수 매크로만 해석 (함수형 매크로, 헤더 가드, #include는 생략)
+    for line in source.lines() {
+        let line = line.trim();
+        let Some(directive) = line.strip_prefix('#') else {
+            body.push_str(line);
+            body.push('\n');
+            continue;
+        };
+        let Some(define) = directive.trim_start().strip_prefix("define") else {
+            continue;
+        };
+        let define = define.trim_start();
+        let name_len = define.find(|c: char| !(c.is_ascii_alphanumeric() || c == '_')).unwrap_or(define.len());
+        let (name, value) = define.split_at(name_len);
+        if value.starts_with('(') || value.trim().is_empty() {
+            continue;
+        }
+
+        let tokens = tokenize(value);
+        let mut parser = Parser { tokens: &tokens, pos: 0, consts: &consts };
+        let value = parser.expr_end();
+        let ty = if (0..=u32::MAX as i64).contains(&value) {
+            "u32"
+        } else if value >= 0 {
+            "u64"
+        } else {
+            "i64"
+        };
+        writeln!(out, "pub const {}: {} = {};", name, ty, value).unwrap();
+        consts.insert(name.to_string(), value);
+    }
+
+    // 구조체 정의 (정의 순서대로, 참조하는 외부 구조체는 앞에 생성)
+    let tokens = tokenize(&body);
+    let mut structs = Vec::new();
+    let mut pos = 0;
+    while pos < tokens.len() {
+        let mut parser = Parser { tokens: &tokens, pos, consts: &consts };
+        structs.push(parser.struct_def());
+        pos = parser.pos;
+    }
+
+    let defined: Vec<&str> = structs.iter().map(|(name, _)| name.as_str()).collect();
+    for (name, fields) in EXTERNAL_STRUCTS {
+        let used = structs.iter().any(|(_, f)| f.iter().any(|(_, ty)| ty.contains(name)));
+        if used && !defined.contains(name) {
+            let fields: Vec<(String, String)> = fields.iter()
+                .map(|(field, ty)| (field.to_string(), ty.to_string()))
+                .collect();
+            write_struct(&mut out, name, &fields);
+        }
+    }
+    for (name, fields) in &structs {
+        write_struct(&mut out, name, fields);
+    }
+
+    out
+}
+
+/// 구조체 하나 출력 (모든 필드가 정수와 그 배열이므로 0 바이트 패턴이 기본값)
+fn write_struct(out: &mut String, name: &str, fields: &[(String, String)]) {
+    writeln!(out, "\n#[repr(C)]\n#[derive(Debug, Copy, Clone)]\npub struct {} {{", name).unwrap();
+    for (field, ty) in fields {
+        writeln!(out, "    pub {}: {},", field, ty).unwrap();
+    }
+    writeln!(out, "}}\n\nimpl Default for {} {{", name).unwrap();
+    writeln!(out, "    fn default() -> Self {{\n        unsafe {{ std::mem::zeroed() }}\n    }}\n}}").unwrap();
+}
+
+/// /* */ 및 // 주석 제거 (줄 번호 유지를 위해 줄바꿈은 남김)
+fn strip_comments(source: &str) -> String {
+    let mut out = String::with_capacity(source.len());
+    let mut rest = source;
+
+    while !rest.is_empty() {
+        if let Some(after) = rest.strip_prefix("/*") {
+            let end = after.find("*/").expect("swift_guard.h: unterminated comment");
+            out.extend(after[..end].chars().filter(|c| *c == '\n'));
+            rest = &after[end + 2..];
+        } else if let Some(after) = rest.strip_prefix("//") {
+            rest = &after[after.find('\n').unwrap_or(after.len())..];
+        } else {
+            let c = rest.chars().next().unwrap();
+            out.push(c);
+            rest = &rest[c.len_utf8()..];
+        }
+    }
+
+    out
+}
+
+/// 식별자, 정수, 구두점 토큰으로 분리
+fn tokenize(source: &str) -> Vec<String> {
+    let mut tokens = Vec::new();
+    let mut chars = source.chars().peekable();
+
+    while let Some(&c) = chars.peek() {
+        if c.is_whitespace() {
+            chars.next();
+        } else if c.is_ascii_alphanumeric() || c == '_' {
+            let mut token = String::new();
+            while let Some(&c) = chars.peek().filter(|c| c.is_ascii_alphanumeric() || **c == '_') {
+                token.push(c);
+                chars.next();
+            }
+            tokens.push(token);
+        } else if (c == '<' || c == '>') && {
+            chars.next();
+            chars.peek() == Some(&c)
+        } {
+            chars.next();
+            tokens.push(format!("{}{}", c, c));
+        } else if "()[]{};*/%+-|".contains(c) {
+            chars.next();
+            tokens.push(c.to_string());
+        } else {
+            panic!("swift_guard.h: unsupported character '{}'", c);
+        }
+    }
+
+    tokens
+}
+
+/// 상수 식과 구조체 정의 파서
+struct Parser<'t> {
+    tokens: &'t [String],
+    pos: usize,
+    consts: &'t BTreeMap<String, i64>,
+}
+
+impl<'t> Parser<'t> {
+    fn peek(&self) -> Option<&str> {
+        self.tokens.get(self.pos).map(String::as_str)
+    }
+
+    fn next(&mut self) -> &'t str {
+        let token = self.tokens.get(self.pos).expect("swift_guard.h: unexpected end of definition");
+        self.pos += 1;
+        token
+    }
+
+    fn expect(&mut self, token: &str) {
+        let found = self.next();
+        assert_eq!(found, token, "swift_guard.h: expected '{}', found '{}'", token, found);
+    }
+
+    fn ident(&mut self) -> &'t str {
+        let token = self.next();
+        assert!(token.starts_with(|c: char| c.is_ascii_alphabetic() || c == '_'),
+            "swift_guard.h: expected identifier, found '{}'", token);
+        token
+    }
+
+    /// 토큰 끝까지가 식 하나여야 함 (#define 값)
+    fn expr_end(&mut self) -> i64 {
+        let value = self.expr();
+        if let Some(token) = self.peek() {
+            panic!("swift_guard.h: unexpected '{}' in constant expression", token);
+        }
+        value
+    }
+
+    /// 식 = 시프트 ('|' 시프트)*
+    fn expr(&mut self) -> i64 {
+        let mut value = self.shift();
+        while self.peek() == Some("|") {
+            self.pos += 1;
+            value |= self.shift();
+        }
+        value
+    }
+
+    fn shift(&mut self) -> i64 {
+        let mut value = self.additive();
+        loop {
+            match self.peek() {
+                Some("<<") => { self.pos += 1; value <<= self.additive(); }
+                Some(">>") => { self.pos += 1; value >>= self.additive(); }
+                _ => return value,
+            }
+        }
+    }
+
+    fn additive(&mut self) -> i64 {
+        let mut value = self.term();
+        loop {
+            match self.peek() {
+                Some("+") => { self.pos += 1; value += self.term(); }
+                Some("-") => { self.pos += 1; value -= self.term(); }
+                _ => return value,
+            }
+        }
+    }
+
+    fn term(&mut self) -> i64 {
+        let mut value = self.unary();
+        loop {
+            match self.peek() {
+                Some("*") => { self.pos += 1; value *= self.unary(); }
+                Some("/") => { self.pos += 1; value /= self.unary(); }
+                Some("%") => { self.pos += 1; value %= self.unary(); }
+                _ => return value,
+            }
+        }
+    }
+
+    fn unary(&mut self) -> i64 {
+        if self.peek() == Some("-") {
+            self.pos += 1;
+            return -self.unary();
+        }
+
+        let token = self.next();
+        if token == "(" {
+            let value = self.expr();
+            self.expect(")");
+            value
+        } else if token.starts_with(|c: char| c.is_ascii_digit()) {
+            let digits = token.trim_end_matches(['u', 'U', 'l', 'L']);
+            let value = match digits.strip_prefix("0x").or_else(|| digits.strip_prefix("0X")) {
+                Some(hex) => i64::from_str_radix(hex, 16),
+                None => digits.parse(),
+            };
+            value.unwrap_or_else(|_| panic!("swift_guard.h: invalid number '{}'", token))
+        } else {
+            *self.consts.get(token)
+                .unwrap_or_else(|| panic!("swift_guard.h: unknown constant '{}'", token))
+        }
+    }
+
+    /// struct 이름 { 필드; ... }; (필드 = 타입 이름 [크기]...)
+    fn struct_def(&mut self) -> (String, Vec<(String, String)>) {
+        self.expect("struct");
+        let name = self.ident().to_string();
+        self.expect("{");
+
+        let mut fields = Vec::new();
+        while self.peek() != Some("}") {
+            let mut ty = match self.ident() {
+                "struct" => self.ident().to_string(),
+                c_type => rust_int_type(c_type).to_string(),
+            };
+            let field = self.ident().to_string();
+
+            let mut dims = Vec::new();
+            while self.peek() == Some("[") {
+                self.pos += 1;
+                dims.push(self.expr());
+                self.expect("]");
+            }
+            // C의 a[N][M]은 Rust의 [[T; M]; N]
+            for dim in dims.iter().rev() {
+                ty = format!("[{}; {}]", ty, dim);
+            }
+
+            self.expect(";");
+            fields.push((field, ty));
+        }
+
+        self.expect("}");
+        self.expect(";");
+        (name, fields)
+    }
+}
+
+/// 고정 폭 정수 타입 (stdint.h)
+fn rust_int_type(c_type: &str) -> &'static str {
+    match c_type {
+        "uint8_t" => "u8",
+        "uint16_t" => "u16",
+        "uint32_t" => "u32",
+        "uint64_t" => "u64",
+        "int8_t" => "i8",
+        "int16_t" => "i16",
+        "int32_t" => "i32",
+        "int64_t" => "i64",
+        _ => panic!("swift_guard.h: unsupported field type '{}'", c_type),
+    }
+}
@@ -0,0 +1,71 @@
+//! 데이터 경로 ABI 모듈
+//! build.rs가 include/swift_guard.h에서 생성한 상수/구조체와 맵 값 바이트 변환
+//!
+//! 맵 키와 값은 호스트 바이트 순서의 C 구조체 그대로이므로 필드별로 파싱하지 않고
+//! 같은 배치의 Rust 구조체로 읽고 쓴다.
+
+#[allow(non_camel_case_types, non_upper_case_globals, non_snake_case, dead_code)]
+mod bindings {
+    include!(concat!(env!("OUT_DIR"), "/swift_guard.rs"));
+}
+
+pub use bindings::*;
+
+/// 모든 바이트 패턴이 유효하고 암묵적 패딩이 없는 맵 키/값 구조체
+///
+/// # Safety
+/// 구현 타입은 #[repr(C)]이고 정수 필드와 그 배열로만 구성되어야 한다.
+pub unsafe trait Pod: Copy + 'static {}
+
+macro_rules! pod {
+    ($($ty:ty),* $(,)?) => {
+        $(unsafe impl Pod for $ty {})*
+    };
+}
+
+pod!(
+    prefix_key, prefix_key_v6, filter_stats, rule_verdict, token_bucket,
+    src_bucket, src_bucket_key, rule_bitmap, cls_config, flow_key, flow_entry,
+    blocklist_config, synproxy_key, hh_config, hh_sketch, hh_entry, hh_topk,
+    pipeline_state, packet_event,
+);
+
+// 규칙 비트맵 워드 배열 (struct rule_bitmap의 words)
+unsafe impl<const N: usize> Pod for [u64; N] {}
+
+/// 값의 바이트 표현 (맵 갱신용, 복사 없음)
+pub fn as_bytes<T: Pod>(value: &T) -> &[u8] {
+    unsafe { std::slice::from_raw_parts(value as *const T as *const u8, std::mem::size_of::<T>()) }
+}
+
+/// 맵에서 읽은 바이트의 구조체 값 (길이가 짧으면 None, 정렬은 요구하지 않음)
+pub fn from_bytes<T: Pod>(bytes: &[u8]) -> Option<T> {
+    if bytes.len() < std::mem::size_of::<T>() {
+        return None;
+    }
+    Some(unsafe { std::ptr::read_unaligned(bytes.as_ptr() as *const T) })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::mem::size_of;
+
+    #[test]
+    fn test_layout() {
+        // xdp_filter.c와 같은 크기 (암묵적 패딩 없음)
+        assert_eq!(size_of::<prefix_key_v6>(), 20);
+        assert_eq!(size_of::<rule_verdict>(), 24);
+        assert_eq!(size_of::<token_bucket>(), 24);
+        assert_eq!(size_of::<flow_key>(), 40);
+        assert_eq!(size_of::<pipeline_state>(), 48);
+        assert_eq!(size_of::<packet_event>(), 160);
+
+        let verdict = rule_verdict { rule_id: 7, action: ACTION_DROP as u8, expire_ns: 1, ..Default::default() };
+        let bytes = as_bytes(&verdict);
+        assert_eq!(&bytes[..4], &7u32.to_ne_bytes());
+        let back: rule_verdict = from_bytes(&bytes[..]).unwrap();
+        assert_eq!((back.rule_id, back.action, back.expire_ns), (7, 2, 1));
+        assert!(from_bytes::<rule_verdict>(&bytes[..16]).is_none());
+    }
+}
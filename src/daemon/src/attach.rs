@@ -0,0 +1,448 @@
+//! XDP 연결 관리 모듈
+//! 스켈레톤의 한 프로그램을 여러 인터페이스에 연결 (모든 인터페이스가 같은 맵 공유)
+//!
+//! 요청한 모드에서 연결하지 못하면 오프로드 -> 드라이버 -> 제네릭 순서로 낮춘다.
+//! `libxdp` 기능으로 빌드하고 xdp.multiprog를 켜면 libxdp 디스패처를 통해 연결해
+//! 같은 인터페이스의 다른 XDP 프로그램과 공존한다.
+//!
+//! 맵을 고정하면 bpf_link로 연결해 링크도 고정하고, 종료할 때 분리하지 않는다.
+//! 다음 데몬은 고정된 링크의 프로그램만 원자적으로 교체하므로 패킷 경로가 끊기지 않는다.
+
+use anyhow::{anyhow, Result};
+use log::{info, warn};
+use std::collections::BTreeMap;
+use std::ffi::CString;
+use std::os::unix::io::{AsRawFd, FromRawFd, OwnedFd};
+use std::path::{Path, PathBuf};
+
+use crate::bpf::{XdpFilterSkel, XdpMode};
+
+// XDP 연결 플래그 (linux/if_link.h)
+const XDP_FLAGS_UPDATE_IF_NOEXIST: u32 = 1 << 0;
+const XDP_FLAGS_SKB_MODE: u32 = 1 << 1;
+const XDP_FLAGS_DRV_MODE: u32 = 1 << 2;
+const XDP_FLAGS_HW_MODE: u32 = 1 << 3;
+const XDP_FLAGS_REPLACE: u32 = 1 << 4;
+
+#[cfg(feature = "libxdp")]
+mod libxdp {
+    //! libxdp 바인딩 (xdp-tools의 libxdp.h 중 사용하는 부분)
+    use std::os::raw::{c_char, c_int, c_long, c_uint, c_void};
+
+    #[repr(C)]
+    pub struct xdp_program {
+        _private: [u8; 0],
+    }
+
+    #[repr(C)]
+    pub struct xdp_program_opts {
+        pub sz: usize,
+        pub obj: *mut libbpf_sys::bpf_object,
+        pub opts: *mut libbpf_sys::bpf_object_open_opts,
+        pub prog_name: *const c_char,
+        pub find_filename: *const c_char,
+        pub open_filename: *const c_char,
+        pub pin_path: *const c_char,
+        pub id: u32,
+        pub fd: c_int,
+    }
+
+    // enum xdp_attach_mode
+    pub const XDP_MODE_NATIVE: c_uint = 1;
+    pub const XDP_MODE_SKB: c_uint = 2;
+    pub const XDP_MODE_HW: c_uint = 3;
+
+    #[link(name = "xdp")]
+    extern "C" {
+        pub fn xdp_program__create(opts: *mut xdp_program_opts) -> *mut xdp_program;
+        pub fn xdp_program__bpf_obj(prog: *mut xdp_program) -> *mut libbpf_sys::bpf_object;
+        pub fn xdp_program__attach(prog: *mut xdp_program, ifindex: c_int, mode: c_uint, flags: c_uint) -> c_int;
+        pub fn xdp_program__detach(prog: *mut xdp_program, ifindex: c_int, mode: c_uint, flags: c_uint) -> c_int;
+        pub fn xdp_program__close(prog: *mut xdp_program);
+        pub fn libxdp_get_error(ptr: *const c_void) -> c_long;
+    }
+}
+
+/// 연결 방식
+enum Handle {
+    /// 넷링크로 직접 연결 (분리 시 연결 플래그와 프로그램 fd로 자신만 제거)
+    Direct { flags: u32 },
+    /// 고정된 bpf_link (고정을 지우고 fd를 닫으면 분리)
+    Link { fd: OwnedFd, pin: PathBuf },
+    /// libxdp 디스패처의 구성 프로그램
+    #[cfg(feature = "libxdp")]
+    Dispatcher(*mut libxdp::xdp_program),
+}
+
+/// 인터페이스 하나의 연결 상태
+struct Attachment {
+    ifindex: i32,
+    mode: XdpMode,
+    handle: Handle,
+}
+
+/// XDP 연결 관리자
+pub struct AttachManager<'a> {
+    skel: &'a XdpFilterSkel,
+    /// 연결할 프로그램 (xdp_filter_func 또는 파이프라인 진입점)
+    program: String,
+    /// 로드된 오브젝트 경로 (libxdp가 같은 오브젝트를 다시 열 때 사용)
+    #[cfg_attr(not(feature = "libxdp"), allow(dead_code))]
+    obj_path: PathBuf,
+    /// libxdp 디스패처 사용
+    multiprog: bool,
+    /// XDP 링크 고정 디렉터리 (맵을 고정할 때)
+    link_dir: Option<PathBuf>,
+    /// 인터페이스 이름별 연결
+    attached: BTreeMap<String, Attachment>,
+}
+
+impl<'a> AttachManager<'a> {
+    pub fn new(skel: &'a XdpFilterSkel, program: &str, obj_path: &Path, multiprog: bool) -> Self {
+        if multiprog && !cfg!(feature = "libxdp") {
+            warn!("xdp.multiprog requires a build with the libxdp feature, attaching directly");
+        }
+
+        Self {
+            skel,
+            program: program.to_string(),
+            obj_path: obj_path.to_path_buf(),
+            multiprog: multiprog && cfg!(feature = "libxdp"),
+            link_dir: skel.pin_path.as_ref().map(|dir| dir.join("links")),
+            attached: BTreeMap::new(),
+        }
+    }
+
+    /// 인터페이스에 연결하고 실제로 연결된 모드 반환
+    ///
+    /// force가 없으면 다른 프로그램이 이미 연결된 인터페이스는 건드리지 않고, 요청한
+    /// 모드가 실패하면 더 낮은 모드로 재시도한다. force면 요청한 모드로만 연결하며
+    /// 기존 프로그램을 교체한다.
+    pub fn attach(&mut self, interface: &str, mode: XdpMode, force: bool) -> Result<XdpMode> {
+        if let Some(existing) = self.attached.get(interface) {
+            return Err(anyhow!("XDP program already attached to {} in {} mode",
+                               interface, existing.mode.to_str()));
+        }
+
+        let ifindex = interface_index(interface)?;
+
+        // 이전 데몬이 고정한 링크가 있으면 그 모드 그대로 프로그램만 교체
+        if !self.multiprog {
+            if let Some((candidate, handle)) = self.update_pinned_link(interface)? {
+                info!("Replaced program on pinned link of {} with {} ({} mode)",
+                      interface, self.program, candidate.to_str());
+                self.attached.insert(interface.to_string(), Attachment { ifindex, mode: candidate, handle });
+                return Ok(candidate);
+            }
+        }
+
+        let modes = if force { &fallback_modes(mode)[..1] } else { fallback_modes(mode) };
+        let mut last_error = None;
+
+        for &candidate in modes {
+            let result = if self.multiprog {
+                self.attach_dispatcher(ifindex, candidate)
+            } else if self.link_dir.is_some() && !force {
+                self.attach_link(interface, ifindex, candidate)
+            } else {
+                self.attach_direct(ifindex, candidate, force)
+            };
+
+            match result {
+                Ok(handle) => {
+                    info!("Attached {} to {} in {} mode", self.program, interface, candidate.to_str());
+                    self.attached.insert(interface.to_string(), Attachment { ifindex, mode: candidate, handle });
+                    return Ok(candidate);
+                }
+                Err(e) => {
+                    warn!("Failed to attach {} to {} in {} mode: {}",
+                          self.program, interface, candidate.to_str(), e);
+                    last_error = Some(e);
+                }
+            }
+        }
+
+        Err(last_error.unwrap_or_else(|| anyhow!("No XDP mode available for {}", interface)))
+    }
+
+    /// 인터페이스에서 분리 (연결되어 있지 않았으면 false)
+    pub fn detach(&mut self, interface: &str) -> Result<bool> {
+        let attachment = match self.attached.remove(interface) {
+            Some(attachment) => attachment,
+            None => return Ok(false),
+        };
+
+        self.detach_one(&attachment)?;
+        info!("Detached {} from {}", self.program, interface);
+        Ok(true)
+    }
+
+    /// 데몬 종료 시 모든 연결 정리 (실패는 기록만 함)
+    ///
+    /// 고정된 링크는 fd만 닫으므로 프로그램이 연결된 채로 남고, 나머지는 분리한다.
+    pub fn release_all(&mut self) {
+        for (interface, attachment) in std::mem::take(&mut self.attached) {
+            if let Handle::Link { pin, .. } = &attachment.handle {
+                info!("Leaving {} attached to {} (link pinned at {})", self.program, interface, pin.display());
+                continue;
+            }
+            match self.detach_one(&attachment) {
+                Ok(()) => info!("Detached {} from {}", self.program, interface),
+                Err(e) => warn!("Failed to detach {} from {}: {}", self.program, interface, e),
+            }
+        }
+    }
+
+    fn prog_fd(&self) -> Result<i32> {
+        self.skel.progs().stage(&self.program)
+            .map(|prog| prog.fd())
+            .ok_or_else(|| anyhow!("Program {} not found", self.program))
+    }
+
+    /// 스켈레톤 프로그램을 넷링크로 연결 (맵은 스켈레톤 그대로)
+    ///
+    /// 데몬 맵을 공유하는 호스트 프로그램이므로, 커널이 장치에 바인딩되지 않은 프로그램을
+    /// 거부하면 오프로드는 실패하고 드라이버 모드로 넘어간다.
+    fn attach_direct(&self, ifindex: i32, mode: XdpMode, force: bool) -> Result<Handle> {
+        let mut flags = mode_flags(mode);
+        if !force {
+            flags |= XDP_FLAGS_UPDATE_IF_NOEXIST;
+        }
+
+        let ret = unsafe { libbpf_sys::bpf_xdp_attach(ifindex, self.prog_fd()?, flags, std::ptr::null()) };
+        if ret < 0 {
+            return Err(anyhow!("bpf_xdp_attach failed: {}", std::io::Error::from_raw_os_error(-ret)));
+        }
+
+        Ok(Handle::Direct { flags: mode_flags(mode) })
+    }
+
+    /// 고정된 링크 경로 (모드를 이름에 포함해 다음 데몬이 연결 모드를 알 수 있게 함)
+    fn link_pin(&self, interface: &str, mode: XdpMode) -> Option<PathBuf> {
+        self.link_dir.as_ref().map(|dir| dir.join(format!("{}.{}", interface, mode.to_str())))
+    }
+
+    /// 인터페이스의 고정된 링크를 열어 이 프로그램으로 교체 (고정된 링크가 없으면 None)
+    ///
+    /// 커널이 링크의 프로그램 포인터를 한 번에 바꾸므로 교체 중에도 모든 패킷이 이전 또는
+    /// 새 프로그램 중 하나를 거친다. 장치가 사라져 끊어진 링크는 고정을 지우고 None.
+    fn update_pinned_link(&self, interface: &str) -> Result<Option<(XdpMode, Handle)>> {
+        for mode in [XdpMode::Offload, XdpMode::Driver, XdpMode::Generic] {
+            let pin = match self.link_pin(interface, mode) {
+                Some(pin) if pin.exists() => pin,
+                _ => continue,
+            };
+
+            let c_pin = CString::new(pin.to_string_lossy().as_bytes())?;
+            let fd = unsafe { libbpf_sys::bpf_obj_get(c_pin.as_ptr()) };
+            if fd < 0 {
+                return Err(anyhow!("Failed to open pinned link {}: {}",
+                                   pin.display(), std::io::Error::from_raw_os_error(-fd)));
+            }
+            let fd = unsafe { OwnedFd::from_raw_fd(fd) };
+
+            let ret = unsafe { libbpf_sys::bpf_link_update(fd.as_raw_fd(), self.prog_fd()?, std::ptr::null()) };
+            if ret == -libc::ENOLINK {
+                warn!("Pinned link {} is defunct, removing", pin.display());
+                std::fs::remove_file(&pin)?;
+                return Ok(None);
+            }
+            if ret < 0 {
+                return Err(anyhow!("bpf_link_update failed: {}", std::io::Error::from_raw_os_error(-ret)));
+            }
+
+            return Ok(Some((mode, Handle::Link { fd, pin })));
+        }
+
+        Ok(None)
+    }
+
+    /// bpf_link로 연결하고 링크 고정 (다른 프로그램이 연결된 인터페이스에서는 실패)
+    fn attach_link(&self, interface: &str, ifindex: i32, mode: XdpMode) -> Result<Handle> {
+        let pin = self.link_pin(interface, mode)
+            .ok_or_else(|| anyhow!("No link pin directory"))?;
+
+        let mut opts: libbpf_sys::bpf_link_create_opts = unsafe { std::mem::zeroed() };
+        opts.sz = std::mem::size_of::<libbpf_sys::bpf_link_create_opts>() as libbpf_sys::size_t;
+        opts.flags = mode_flags(mode);
+
+        let fd = unsafe { libbpf_sys::bpf_link_create(self.prog_fd()?, ifindex, libbpf_sys::BPF_XDP, &opts) };
+        if fd < 0 {
+            return Err(anyhow!("bpf_link_create failed: {}", std::io::Error::from_raw_os_error(-fd)));
+        }
+        let fd = unsafe { OwnedFd::from_raw_fd(fd) };
+
+        if let Some(dir) = pin.parent() {
+            std::fs::create_dir_all(dir)?;
+        }
+        let c_pin = CString::new(pin.to_string_lossy().as_bytes())?;
+        let ret = unsafe { libbpf_sys::bpf_obj_pin(fd.as_raw_fd(), c_pin.as_ptr()) };
+        if ret < 0 {
+            // fd를 닫으면 링크도 해제되어 분리됨
+            return Err(anyhow!("Failed to pin link at {}: {}",
+                               pin.display(), std::io::Error::from_raw_os_error(-ret)));
+        }
+
+        Ok(Handle::Link { fd, pin })
+    }
+
+    #[cfg(not(feature = "libxdp"))]
+    fn attach_dispatcher(&self, _ifindex: i32, _mode: XdpMode) -> Result<Handle> {
+        Err(anyhow!("libxdp support not built"))
+    }
+
+    /// libxdp로 디스패처에 연결
+    ///
+    /// libxdp는 구성 프로그램을 직접 로드하므로 같은 오브젝트를 다시 열고, 맵은 로드 전에
+    /// 스켈레톤 맵 fd를 재사용하도록 지정해 직접 연결과 같은 규칙과 통계를 쓴다.
+    #[cfg(feature = "libxdp")]
+    fn attach_dispatcher(&self, ifindex: i32, mode: XdpMode) -> Result<Handle> {
+        use std::ffi::{CStr, CString};
+
+        let path = CString::new(self.obj_path.to_string_lossy().as_bytes())?;
+        let name = CString::new(self.program.as_str())?;
+        let mut opts: libxdp::xdp_program_opts = unsafe { std::mem::zeroed() };
+        opts.sz = std::mem::size_of::<libxdp::xdp_program_opts>();
+        opts.open_filename = path.as_ptr();
+        opts.prog_name = name.as_ptr();
+
+        let prog = unsafe { libxdp::xdp_program__create(&mut opts) };
+        let err = unsafe { libxdp::libxdp_get_error(prog as *const _) };
+        if err != 0 {
+            return Err(anyhow!("xdp_program__create failed: {}", std::io::Error::from_raw_os_error(-err as i32)));
+        }
+
+        unsafe {
+            let obj = libxdp::xdp_program__bpf_obj(prog);
+
+            // 연결할 프로그램 외에는 로드하지 않음
+            let mut p = libbpf_sys::bpf_object__next_program(obj, std::ptr::null_mut());
+            while !p.is_null() {
+                if CStr::from_ptr(libbpf_sys::bpf_program__name(p)).to_bytes() != self.program.as_bytes() {
+                    libbpf_sys::bpf_program__set_autoload(p, false);
+                }
+                p = libbpf_sys::bpf_object__next_program(obj, p);
+            }
+
+            // 데몬 맵 공유 (.rodata 같은 내부 맵은 오브젝트별)
+            let mut m = libbpf_sys::bpf_object__next_map(obj, std::ptr::null_mut());
+            while !m.is_null() {
+                let map_name = CStr::from_ptr(libbpf_sys::bpf_map__name(m)).to_string_lossy();
+                if let Some(map) = self.skel.obj.map(map_name.as_ref()) {
+                    let ret = libbpf_sys::bpf_map__reuse_fd(m, map.fd());
+                    if ret < 0 {
+                        libxdp::xdp_program__close(prog);
+                        return Err(anyhow!("Failed to share map {}: {}", map_name,
+                                           std::io::Error::from_raw_os_error(-ret)));
+                    }
+                }
+                m = libbpf_sys::bpf_object__next_map(obj, m);
+            }
+
+            let ret = libxdp::xdp_program__attach(prog, ifindex, libxdp_mode(mode), 0);
+            if ret < 0 {
+                libxdp::xdp_program__close(prog);
+                return Err(anyhow!("xdp_program__attach failed: {}", std::io::Error::from_raw_os_error(-ret)));
+            }
+        }
+
+        Ok(Handle::Dispatcher(prog))
+    }
+
+    fn detach_one(&self, attachment: &Attachment) -> Result<()> {
+        match &attachment.handle {
+            &Handle::Direct { flags } => {
+                // 그사이 다른 프로그램으로 교체되었으면 건드리지 않음
+                let mut opts: libbpf_sys::bpf_xdp_attach_opts = unsafe { std::mem::zeroed() };
+                opts.sz = std::mem::size_of::<libbpf_sys::bpf_xdp_attach_opts>() as libbpf_sys::size_t;
+                opts.old_prog_fd = self.prog_fd()?;
+
+                let ret = unsafe { libbpf_sys::bpf_xdp_detach(attachment.ifindex, flags | XDP_FLAGS_REPLACE, &opts) };
+                if ret < 0 {
+                    return Err(anyhow!("bpf_xdp_detach failed: {}", std::io::Error::from_raw_os_error(-ret)));
+                }
+            }
+            Handle::Link { pin, .. } => {
+                // 고정을 지우면 남은 참조는 이 fd뿐이므로 attachment를 버릴 때 분리됨
+                std::fs::remove_file(pin)?;
+            }
+            #[cfg(feature = "libxdp")]
+            &Handle::Dispatcher(prog) => {
+                let ret = unsafe { libxdp::xdp_program__detach(prog, attachment.ifindex, libxdp_mode(attachment.mode), 0) };
+                unsafe { libxdp::xdp_program__close(prog) };
+                if ret < 0 {
+                    return Err(anyhow!("xdp_program__detach failed: {}", std::io::Error::from_raw_os_error(-ret)));
+                }
+            }
+        }
+
+        Ok(())
+    }
+}
+
+impl<'a> std::fmt::Debug for AttachManager<'a> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("AttachManager")
+            .field("program", &self.program)
+            .field("multiprog", &self.multiprog)
+            .field("attached", &self.attached.iter()
+                .map(|(name, a)| (name.as_str(), a.mode.to_str()))
+                .collect::<Vec<_>>())
+            .finish()
+    }
+}
+
+impl<'a> Drop for AttachManager<'a> {
+    fn drop(&mut self) {
+        self.release_all();
+    }
+}
+
+/// 요청한 모드부터 시도할 모드 순서
+fn fallback_modes(mode: XdpMode) -> &'static [XdpMode] {
+    match mode {
+        XdpMode::Offload => &[XdpMode::Offload, XdpMode::Driver, XdpMode::Generic],
+        XdpMode::Driver => &[XdpMode::Driver, XdpMode::Generic],
+        XdpMode::Generic => &[XdpMode::Generic],
+    }
+}
+
+fn mode_flags(mode: XdpMode) -> u32 {
+    match mode {
+        XdpMode::Driver => XDP_FLAGS_DRV_MODE,
+        XdpMode::Generic => XDP_FLAGS_SKB_MODE,
+        XdpMode::Offload => XDP_FLAGS_HW_MODE,
+    }
+}
+
+#[cfg(feature = "libxdp")]
+fn libxdp_mode(mode: XdpMode) -> std::os::raw::c_uint {
+    match mode {
+        XdpMode::Driver => libxdp::XDP_MODE_NATIVE,
+        XdpMode::Generic => libxdp::XDP_MODE_SKB,
+        XdpMode::Offload => libxdp::XDP_MODE_HW,
+    }
+}
+
+fn interface_index(interface: &str) -> Result<i32> {
+    let c_name = std::ffi::CString::new(interface)
+        .map_err(|_| anyhow!("Invalid interface name: {}", interface))?;
+    let ifindex = unsafe { libc::if_nametoindex(c_name.as_ptr()) };
+    if ifindex == 0 {
+        return Err(anyhow!("Unknown interface: {}", interface));
+    }
+
+    Ok(ifindex as i32)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_fallback_modes() {
+        assert_eq!(fallback_modes(XdpMode::Offload), &[XdpMode::Offload, XdpMode::Driver, XdpMode::Generic]);
+        assert_eq!(fallback_modes(XdpMode::Generic), &[XdpMode::Generic]);
+        assert_eq!(mode_flags(XdpMode::Driver), XDP_FLAGS_DRV_MODE);
+    }
+}
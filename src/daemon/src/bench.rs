@@ -0,0 +1,525 @@
+// src/daemon/src/bench.rs
+//! xdp_filter_func 마이크로 벤치마크
+//! BPF_PROG_TEST_RUN으로 고정 패킷 코퍼스를 반복 실행해 규칙 수별 패킷당 처리 시간 측정
+#![allow(dead_code)]
+
+use anyhow::{anyhow, Context, Result};
+use clap::Parser;
+use log::{info, warn};
+use std::fs::File;
+use std::io::{BufWriter, Write};
+use std::net::{Ipv4Addr, Ipv6Addr};
+use std::path::PathBuf;
+
+mod abi;
+mod blocklist;
+mod bpf;
+mod checks;
+mod classifier;
+mod config;
+mod features;
+mod heavy_hitters;
+mod maps;
+mod memory;
+mod percpu;
+mod pipeline;
+mod ruleset;
+mod telemetry;
+mod timer_wheel;
+
+use crate::maps::{FilterRule, MapManager};
+
+const XDP_DROP: u32 = 1;
+const XDP_PASS: u32 = 2;
+const XDP_TX: u32 = 3;
+const XDP_REDIRECT: u32 = 4;
+
+const ETH_P_IP: u16 = 0x0800;
+const ETH_P_IPV6: u16 = 0x86DD;
+const ETH_P_8021Q: u16 = 0x8100;
+
+const PROTO_TCP: u8 = 6;
+const PROTO_UDP: u8 = 17;
+
+const ACTION_DROP: u8 = abi::ACTION_DROP as u8;
+const ACTION_REDIRECT_CPU: u8 = abi::ACTION_REDIRECT_CPU as u8;
+
+/// 최소 이더넷 프레임 길이 (FCS 제외)
+const MIN_FRAME_LEN: usize = 60;
+
+#[derive(Parser, Debug)]
+#[clap(name = "swift-guard-bench", about = "BPF_PROG_TEST_RUN microbenchmark for xdp_filter_func")]
+struct Args {
+    /// BPF 오브젝트 파일 경로
+    #[clap(short, long, default_value = "src/bpf/xdp_filter.o")]
+    bpf_obj: PathBuf,
+
+    /// 측정할 규칙 수 (쉼표로 구분, 최대 규칙 수를 넘으면 채움 규칙을 CIDR로 묶어 같은 수의 소스를 덮음)
+    #[clap(short, long, value_delimiter = ',', default_value = "10,100,1000,10000,100000")]
+    rules: Vec<usize>,
+
+    /// 패킷마다 커널 안에서 반복 실행할 횟수 (흐름 캐시 적중 경로)
+    #[clap(long, default_value = "100000")]
+    repeat: u32,
+
+    /// 실행마다 흐름 캐시를 비워 분류기 경로를 측정할 횟수 (0 = 측정 안 함)
+    #[clap(long, default_value = "1000")]
+    cold_iterations: u32,
+
+    /// 단일 프로그램 대신 테일 콜 파이프라인 진입점 측정
+    #[clap(long)]
+    pipeline: bool,
+
+    /// 측정 대신 데이터 경로 동작 검사 실행 (레이트 리밋 등, 실패하면 0이 아닌 종료 코드)
+    #[clap(long)]
+    check: bool,
+
+    /// 결과 CSV 파일 경로
+    #[clap(short, long, default_value = "results/prog_test_run.csv")]
+    output: PathBuf,
+}
+
+/// 코퍼스 패킷 하나
+struct BenchCase {
+    name: &'static str,
+    family: &'static str,
+    protocol: &'static str,
+    packet: Vec<u8>,
+    /// 규칙 집합이 설치된 상태에서 기대하는 XDP 반환값
+    expected: u32,
+}
+
+/// 측정 결과 한 건
+struct BenchResult {
+    rule_count: usize,
+    /// 실제로 설치한 규칙 수 (분류기 비트 수, 최대 규칙 수 이하)
+    installed_rules: usize,
+    case: &'static str,
+    family: &'static str,
+    protocol: &'static str,
+    mode: &'static str,
+    repeat: u32,
+    expected: u32,
+    verdict: u32,
+    ns_per_packet: f64,
+}
+
+fn main() -> Result<()> {
+    env_logger::Builder::from_env(env_logger::Env::default().default_filter_or("info")).init();
+    let args = Args::parse();
+
+    let skel = bpf::XdpFilterSkel::builder()
+        .obj_path(&args.bpf_obj)
+        .open()
+        .context("BPF 오브젝트 로드 실패")?;
+    let program = if args.pipeline { pipeline::ENTRY_PROGRAM } else { "xdp_filter_func" };
+    let prog_fd = skel.progs().stage(program)
+        .ok_or_else(|| anyhow!("{} 프로그램을 찾을 수 없습니다", program))?
+        .fd();
+    let flow_cache = skel.maps().flow_cache()
+        .ok_or_else(|| anyhow!("flow_cache 맵을 찾을 수 없습니다"))?;
+
+    let mut map_manager = MapManager::new(&skel);
+    if args.check {
+        return checks::run_all(&mut checks::Checker {
+            map_manager: &mut map_manager,
+            prog_fd,
+            flow_cache,
+            features: skel.features,
+        });
+    }
+
+    let cases = corpus();
+    let mut results = Vec::new();
+    info!("최대 규칙 수 {} (이를 넘는 크기는 채움 규칙을 CIDR로 묶어 측정)", classifier::MAX_FILTER_RULES);
+
+    for &count in &args.rules {
+        let rules = rule_set(count)?;
+        let installed = rules.len();
+        map_manager.replace_rules(rules)
+            .with_context(|| format!("규칙 {}개 설치 실패", installed))?;
+        info!("규칙 크기 {}: 규칙 {}개 설치 완료, 패킷 {}종 측정 중...", count, installed, cases.len());
+
+        for case in &cases {
+            // 첫 실행이 캐시를 채우므로 반복 실행은 흐름 캐시 적중 경로를 측정
+            clear_flow_cache(flow_cache)?;
+            let (verdict, duration) = test_run(prog_fd, &case.packet, args.repeat)?;
+            results.push(BenchResult {
+                rule_count: count,
+                installed_rules: installed,
+                case: case.name,
+                family: case.family,
+                protocol: case.protocol,
+                mode: "warm",
+                repeat: args.repeat,
+                expected: case.expected,
+                verdict,
+                ns_per_packet: duration as f64,
+            });
+
+            if args.cold_iterations > 0 {
+                let mut total_ns = 0u64;
+                let mut verdict = 0;
+                for _ in 0..args.cold_iterations {
+                    clear_flow_cache(flow_cache)?;
+                    let (ret, duration) = test_run(prog_fd, &case.packet, 1)?;
+                    verdict = ret;
+                    total_ns += duration as u64;
+                }
+                results.push(BenchResult {
+                    rule_count: count,
+                    installed_rules: installed,
+                    case: case.name,
+                    family: case.family,
+                    protocol: case.protocol,
+                    mode: "cold",
+                    repeat: args.cold_iterations,
+                    expected: case.expected,
+                    verdict,
+                    ns_per_packet: total_ns as f64 / args.cold_iterations as f64,
+                });
+            }
+        }
+    }
+
+    for result in &results {
+        if result.verdict != result.expected {
+            warn!("{} (규칙 {}개, {}): 판정 {} (기대값 {})",
+                  result.case, result.rule_count, result.mode, result.verdict, result.expected);
+        }
+    }
+
+    print_results(&results);
+    write_csv(&args.output, &results)?;
+    info!("결과 저장: {}", args.output.display());
+
+    Ok(())
+}
+
+/// BPF_PROG_TEST_RUN 한 번 실행 (반환값, 반복당 평균 ns)
+fn test_run(prog_fd: i32, packet: &[u8], repeat: u32) -> Result<(u32, u32)> {
+    let mut opts: libbpf_sys::bpf_test_run_opts = unsafe { std::mem::zeroed() };
+    opts.sz = std::mem::size_of::<libbpf_sys::bpf_test_run_opts>() as libbpf_sys::size_t;
+    opts.data_in = packet.as_ptr() as *const libc::c_void;
+    opts.data_size_in = packet.len() as u32;
+    opts.repeat = repeat as i32;
+
+    let ret = unsafe { libbpf_sys::bpf_prog_test_run_opts(prog_fd, &mut opts) };
+    if ret != 0 {
+        return Err(anyhow!(
+            "bpf_prog_test_run_opts failed: {}",
+            std::io::Error::from_raw_os_error(-ret)
+        ));
+    }
+
+    Ok((opts.retval, opts.duration))
+}
+
+/// 흐름 캐시 항목 전체 삭제
+fn clear_flow_cache(map: &libbpf_rs::Map) -> Result<()> {
+    let keys: Vec<Vec<u8>> = map.keys().collect();
+    for key in keys {
+        // 순회 중 LRU가 회수한 항목은 이미 없을 수 있음
+        let _ = map.delete(&key);
+    }
+    Ok(())
+}
+
+/// 고정 규칙 5개와 코퍼스에 매치되지 않는 채움 규칙으로 규칙 count개 생성
+///
+/// 채움 규칙은 IPv4/IPv6 LPM과 포트 클래스를 모두 키우되 코퍼스 패킷의 판정은 바꾸지 않는다.
+/// count가 최대 규칙 수를 넘으면 연속된 소스 2^k개를 채움 규칙 하나(CIDR)로 묶어 소스
+/// count개를 덮고, 설치하는 규칙 수(분류기 비트 수)는 최대 규칙 수로 유지한다.
+fn rule_set(count: usize) -> Result<Vec<FilterRule>> {
+    let mut rules = vec![
+        bench_rule("bench-hit-tcp4", Some("198.51.100.0/24"), PROTO_TCP, Some(80), ACTION_DROP, 100)?,
+        bench_rule("bench-hit-udp4", Some("198.51.100.0/24"), PROTO_UDP, Some(53), ACTION_DROP, 100)?,
+        bench_rule("bench-hit-tcp6", Some("2001:db8:bad::/48"), PROTO_TCP, Some(80), ACTION_DROP, 100)?,
+        bench_rule("bench-redirect", None, PROTO_TCP, Some(8080), ACTION_REDIRECT_CPU, 100)?,
+        bench_rule("bench-hit-udp6", Some("2001:db8:bad::/48"), PROTO_UDP, Some(53), ACTION_DROP, 100)?,
+    ];
+
+    let fill_sources = count.saturating_sub(rules.len());
+    let fill_rules = fill_sources.min(classifier::MAX_FILTER_RULES - rules.len());
+    let mut block_bits = 0;
+    while fill_rules << block_bits < fill_sources {
+        block_bits += 1;
+    }
+    // IPv4 채움 규칙은 10.0.0.0/8 안에 있어야 코퍼스와 겹치지 않음
+    if (fill_rules as u64) << block_bits > 1 << 24 {
+        return Err(anyhow!("규칙 {}개는 최대 규칙 수({})의 채움 규칙으로 나타낼 수 없습니다",
+                           count, classifier::MAX_FILTER_RULES));
+    }
+
+    for i in 0..fill_rules {
+        let dst_port = 1024 + (i % 4096) as u16;
+        let mut rule = bench_rule(&format!("bench-fill-{}", i), None, PROTO_TCP, Some(dst_port), ACTION_DROP, 0)?;
+        let base = (i as u32) << block_bits;
+        if i % 4 == 3 {
+            let prefix = u128::from(Ipv6Addr::new(0x2001, 0x0db8, 0x00f0, 0, 0, 0, 0, 0)) | base as u128;
+            rule.src_ip6 = Some((prefix, 128 - block_bits));
+        } else {
+            rule.src_ip = Some((u32::from(Ipv4Addr::new(10, 0, 0, 0)) | base, 32 - block_bits));
+        }
+        rules.push(rule);
+    }
+
+    Ok(rules)
+}
+
+fn bench_rule(label: &str, src: Option<&str>, protocol: u8, dst_port: Option<u16>,
+              action: u8, priority: u32) -> Result<FilterRule> {
+    let (src_ip, src_ip6) = match src {
+        Some(s) if s.contains(':') => (None, Some(swift_guard::utils::parse_ipv6_prefix(s)?)),
+        Some(s) => (Some(swift_guard::utils::parse_ip_prefix(s)?), None),
+        None => (None, None),
+    };
+    let (dst_port_min, dst_port_max) = dst_port.map(|p| (p, p)).unwrap_or((0, u16::MAX));
+
+    Ok(FilterRule {
+        src_ip,
+        dst_ip: None,
+        src_ip6,
+        dst_ip6: None,
+        src_port_min: 0,
+        src_port_max: u16::MAX,
+        dst_port_min,
+        dst_port_max,
+        protocol,
+        tcp_flags: 0,
+        action,
+        redirect_ifindex: 0,
+        redirect_cpu: 0,
+        priority,
+        rate_limit: 0,
+        rate_limit_per_source: false,
+        sample_rate: 0,
+        expire: 0,
+        label: label.to_string(),
+        creation_time: 0,
+        expire_deadline_ns: 0,
+    })
+}
+
+/// 패킷 코퍼스 (주소 대역은 문서용 대역 사용)
+fn corpus() -> Vec<BenchCase> {
+    let client4 = [192, 0, 2, 1];
+    let blocked4 = [198, 51, 100, 7];
+    let server4 = [203, 0, 113, 10];
+    let client6 = Ipv6Addr::new(0x2001, 0x0db8, 0, 0, 0, 0, 0, 1).octets();
+    let blocked6 = Ipv6Addr::new(0x2001, 0x0db8, 0x0bad, 0, 0, 0, 0, 7).octets();
+    let server6 = Ipv6Addr::new(0x2001, 0x0db8, 0, 0, 0, 0, 0, 0x10).octets();
+
+    // MSS, SACK 허용, 타임스탬프, 윈도 스케일 (SYN에 흔한 조합)
+    let syn_options = [2, 4, 0x05, 0xb4, 4, 2, 8, 10, 0, 0, 0, 1, 0, 0, 0, 0, 1, 3, 3, 7];
+    // NOP x3 + EOL
+    let ip_options = [1, 1, 1, 0];
+
+    let case = |name, family, protocol, packet, expected| BenchCase { name, family, protocol, packet, expected };
+
+    vec![
+        case("v4_tcp_miss", "ipv4", "tcp",
+             ethernet(None, ETH_P_IP, &ipv4(client4, server4, PROTO_TCP, &[], &tcp(40000, 443, &[]))), XDP_PASS),
+        case("v4_tcp_hit", "ipv4", "tcp",
+             ethernet(None, ETH_P_IP, &ipv4(blocked4, server4, PROTO_TCP, &[], &tcp(40000, 80, &[]))), XDP_DROP),
+        case("v4_tcp_options_miss", "ipv4", "tcp",
+             ethernet(None, ETH_P_IP, &ipv4(client4, server4, PROTO_TCP, &[], &tcp(40000, 443, &syn_options))), XDP_PASS),
+        case("v4_ip_options_hit", "ipv4", "tcp",
+             ethernet(None, ETH_P_IP, &ipv4(blocked4, server4, PROTO_TCP, &ip_options, &tcp(40000, 80, &[]))), XDP_DROP),
+        case("v4_vlan_hit", "ipv4", "tcp",
+             ethernet(Some(100), ETH_P_IP, &ipv4(blocked4, server4, PROTO_TCP, &[], &tcp(40000, 80, &[]))), XDP_DROP),
+        case("v4_udp_miss", "ipv4", "udp",
+             ethernet(None, ETH_P_IP, &ipv4(client4, server4, PROTO_UDP, &[], &udp(40000, 53, 32))), XDP_PASS),
+        case("v4_udp_hit", "ipv4", "udp",
+             ethernet(None, ETH_P_IP, &ipv4(blocked4, server4, PROTO_UDP, &[], &udp(40000, 53, 32))), XDP_DROP),
+        case("v4_tcp_redirect", "ipv4", "tcp",
+             ethernet(None, ETH_P_IP, &ipv4(client4, server4, PROTO_TCP, &[], &tcp(40000, 8080, &[]))), XDP_REDIRECT),
+        case("v6_tcp_miss", "ipv6", "tcp",
+             ethernet(None, ETH_P_IPV6, &ipv6(client6, server6, PROTO_TCP, &tcp(40000, 443, &[]))), XDP_PASS),
+        case("v6_tcp_hit", "ipv6", "tcp",
+             ethernet(None, ETH_P_IPV6, &ipv6(blocked6, server6, PROTO_TCP, &tcp(40000, 80, &[]))), XDP_DROP),
+        case("v6_udp_miss", "ipv6", "udp",
+             ethernet(None, ETH_P_IPV6, &ipv6(client6, server6, PROTO_UDP, &udp(40000, 53, 32))), XDP_PASS),
+        case("v6_vlan_udp_hit", "ipv6", "udp",
+             ethernet(Some(200), ETH_P_IPV6, &ipv6(blocked6, server6, PROTO_UDP, &udp(40000, 53, 32))), XDP_DROP),
+    ]
+}
+
+/// 이더넷 헤더 (선택적 802.1Q 태그) + L3, 최소 프레임 길이까지 채움
+fn ethernet(vlan: Option<u16>, ethertype: u16, l3: &[u8]) -> Vec<u8> {
+    let mut frame = Vec::with_capacity(18 + l3.len());
+    frame.extend_from_slice(&[0x02, 0, 0, 0, 0, 0x02]);
+    frame.extend_from_slice(&[0x02, 0, 0, 0, 0, 0x01]);
+    if let Some(vid) = vlan {
+        frame.extend_from_slice(&ETH_P_8021Q.to_be_bytes());
+        frame.extend_from_slice(&(vid & 0x0fff).to_be_bytes());
+    }
+    frame.extend_from_slice(&ethertype.to_be_bytes());
+    frame.extend_from_slice(l3);
+    if frame.len() < MIN_FRAME_LEN {
+        frame.resize(MIN_FRAME_LEN, 0);
+    }
+    frame
+}
+
+fn ipv4(src: [u8; 4], dst: [u8; 4], protocol: u8, options: &[u8], l4: &[u8]) -> Vec<u8> {
+    let header_len = 20 + options.len();
+    let total_len = (header_len + l4.len()) as u16;
+
+    let mut packet = Vec::with_capacity(header_len + l4.len());
+    packet.push(0x40 | (header_len / 4) as u8);
+    packet.push(0);
+    packet.extend_from_slice(&total_len.to_be_bytes());
+    packet.extend_from_slice(&[0, 1, 0x40, 0]);  // ID 1, DF
+    packet.push(64);
+    packet.push(protocol);
+    packet.extend_from_slice(&[0, 0]);
+    packet.extend_from_slice(&src);
+    packet.extend_from_slice(&dst);
+    packet.extend_from_slice(options);
+
+    let checksum = ipv4_checksum(&packet);
+    packet[10..12].copy_from_slice(&checksum.to_be_bytes());
+
+    packet.extend_from_slice(l4);
+    packet
+}
+
+fn ipv4_checksum(header: &[u8]) -> u16 {
+    let mut sum: u32 = header.chunks(2)
+        .map(|word| u16::from_be_bytes([word[0], *word.get(1).unwrap_or(&0)]) as u32)
+        .sum();
+    while sum > 0xffff {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    !(sum as u16)
+}
+
+fn ipv6(src: [u8; 16], dst: [u8; 16], next_header: u8, l4: &[u8]) -> Vec<u8> {
+    let mut packet = Vec::with_capacity(40 + l4.len());
+    packet.extend_from_slice(&[0x60, 0, 0, 0]);
+    packet.extend_from_slice(&(l4.len() as u16).to_be_bytes());
+    packet.push(next_header);
+    packet.push(64);
+    packet.extend_from_slice(&src);
+    packet.extend_from_slice(&dst);
+    packet.extend_from_slice(l4);
+    packet
+}
+
+/// SYN 세그먼트 (options는 4바이트 배수)
+fn tcp(src_port: u16, dst_port: u16, options: &[u8]) -> Vec<u8> {
+    let header_len = 20 + options.len();
+    let mut segment = Vec::with_capacity(header_len);
+    segment.extend_from_slice(&src_port.to_be_bytes());
+    segment.extend_from_slice(&dst_port.to_be_bytes());
+    segment.extend_from_slice(&1u32.to_be_bytes());
+    segment.extend_from_slice(&0u32.to_be_bytes());
+    segment.push(((header_len / 4) as u8) << 4);
+    segment.push(0x02);
+    segment.extend_from_slice(&64240u16.to_be_bytes());
+    segment.extend_from_slice(&[0, 0, 0, 0]);  // 체크섬, 긴급 포인터
+    segment.extend_from_slice(options);
+    segment
+}
+
+fn udp(src_port: u16, dst_port: u16, payload_len: usize) -> Vec<u8> {
+    let mut datagram = Vec::with_capacity(8 + payload_len);
+    datagram.extend_from_slice(&src_port.to_be_bytes());
+    datagram.extend_from_slice(&dst_port.to_be_bytes());
+    datagram.extend_from_slice(&((8 + payload_len) as u16).to_be_bytes());
+    datagram.extend_from_slice(&[0, 0]);
+    datagram.resize(8 + payload_len, 0);
+    datagram
+}
+
+fn print_results(results: &[BenchResult]) {
+    println!("최대 규칙 수: {}", classifier::MAX_FILTER_RULES);
+    println!("{:>8} {:>9}  {:<22} {:<5} {:>10} {:>8} {:>12} {:>10}",
+             "rules", "installed", "case", "mode", "repeat", "verdict", "ns/packet", "Mpps");
+    for r in results {
+        println!("{:>8} {:>9}  {:<22} {:<5} {:>10} {:>8} {:>12.1} {:>10.2}",
+                 r.rule_count, r.installed_rules, r.case, r.mode, r.repeat, verdict_name(r.verdict),
+                 r.ns_per_packet, mpps(r.ns_per_packet));
+    }
+}
+
+fn write_csv(path: &PathBuf, results: &[BenchResult]) -> Result<()> {
+    if let Some(dir) = path.parent().filter(|d| !d.as_os_str().is_empty()) {
+        std::fs::create_dir_all(dir)
+            .with_context(|| format!("Failed to create {}", dir.display()))?;
+    }
+
+    let file = File::create(path)
+        .with_context(|| format!("Failed to create {}", path.display()))?;
+    let mut out = BufWriter::new(file);
+
+    writeln!(out, "rule_count,installed_rules,max_rules,case,family,protocol,mode,repeat,expected,verdict,ns_per_packet,mpps")?;
+    for r in results {
+        writeln!(out, "{},{},{},{},{},{},{},{},{},{},{:.2},{:.4}",
+                 r.rule_count, r.installed_rules, classifier::MAX_FILTER_RULES, r.case, r.family, r.protocol, r.mode, r.repeat,
+                 verdict_name(r.expected), verdict_name(r.verdict), r.ns_per_packet, mpps(r.ns_per_packet))?;
+    }
+
+    out.flush()?;
+    Ok(())
+}
+
+fn verdict_name(verdict: u32) -> &'static str {
+    match verdict {
+        0 => "aborted",
+        XDP_DROP => "drop",
+        XDP_PASS => "pass",
+        XDP_TX => "tx",
+        XDP_REDIRECT => "redirect",
+        _ => "unknown",
+    }
+}
+
+fn mpps(ns_per_packet: f64) -> f64 {
+    if ns_per_packet > 0.0 { 1e3 / ns_per_packet } else { 0.0 }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_corpus_headers() {
+        for case in corpus() {
+            assert!(case.packet.len() >= MIN_FRAME_LEN, "{}", case.name);
+        }
+
+        // VLAN 태그 뒤 IPv4 헤더 (IHL 6 = 옵션 4바이트)
+        let cases = corpus();
+        let vlan = cases.iter().find(|c| c.name == "v4_vlan_hit").unwrap();
+        assert_eq!(&vlan.packet[12..14], &ETH_P_8021Q.to_be_bytes());
+        assert_eq!(&vlan.packet[16..18], &ETH_P_IP.to_be_bytes());
+
+        let opts = cases.iter().find(|c| c.name == "v4_ip_options_hit").unwrap();
+        assert_eq!(opts.packet[14], 0x46);
+        assert_eq!(ipv4_checksum(&opts.packet[14..38]), 0);
+    }
+
+    #[test]
+    fn test_rule_set_size() {
+        assert_eq!(rule_set(1000).unwrap().len(), 1000);
+        assert_eq!(rule_set(3).unwrap().len(), 5);
+
+        // 최대 규칙 수를 넘으면 채움 규칙이 /27 (소스 32개)로 묶여 소스 100000개를 덮음
+        let rules = rule_set(100_000).unwrap();
+        assert_eq!(rules.len(), classifier::MAX_FILTER_RULES);
+        let covered: u64 = rules[5..].iter()
+            .map(|r| match (r.src_ip, r.src_ip6) {
+                (Some((_, len)), None) => 1u64 << (32 - len),
+                (None, Some((_, len))) => 1u64 << (128 - len),
+                _ => panic!("fill rule without source prefix"),
+            })
+            .sum();
+        assert!(covered >= 100_000 - 5);
+        assert_eq!(rules[5].src_ip, Some((u32::from(Ipv4Addr::new(10, 0, 0, 0)), 27)));
+        assert_eq!(rules[6].src_ip, Some((u32::from(Ipv4Addr::new(10, 0, 0, 32)), 27)));
+
+        assert!(rule_set(100_000_000).is_err());
+    }
+}
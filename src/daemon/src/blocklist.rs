@@ -0,0 +1,296 @@
+//! 소스 프리픽스 블록리스트 모듈
+//! 이름 있는 블록리스트(위협 정보 피드 등)의 프리픽스 소속 관리와 맵 변경분 계산
+//!
+//! 같은 프리픽스가 여러 블록리스트에 있을 수 있으므로 프리픽스마다 소속 블록리스트
+//! 비트마스크를 유지하고, 맵에는 가장 낮은 블록리스트 ID를 기록한다.
+
+use anyhow::{anyhow, Context, Result};
+use std::collections::{HashMap, HashSet};
+use std::hash::Hash;
+use std::path::Path;
+
+use swift_guard::utils;
+
+use crate::abi;
+use crate::classifier;
+
+/// 블록리스트 최대 개수 (소속 비트마스크 폭)
+pub const MAX_BLOCKLISTS: usize = abi::MAX_BLOCKLISTS as usize;
+
+/// 블록리스트 정보 (스냅숏과 텔레메트리 레이블)
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct BlocklistInfo {
+    pub id: u32,
+    pub name: String,
+    /// 중복을 제외한 프리픽스 수
+    pub prefixes: usize,
+}
+
+/// 파싱된 프리픽스 목록 (주소 계열별 (주소, 프리픽스 길이), 호스트 비트는 0)
+#[derive(Debug, Default)]
+pub struct PrefixList {
+    pub v4: Vec<(u32, u32)>,
+    pub v6: Vec<(u128, u32)>,
+}
+
+impl PrefixList {
+    /// 한 줄에 프리픽스 하나 ('#' 뒤는 주석, 빈 줄 무시, ':'가 있으면 IPv6)
+    pub fn parse(text: &str) -> Result<Self> {
+        let mut list = Self::default();
+
+        for (n, line) in text.lines().enumerate() {
+            let entry = line.split('#').next().unwrap_or("").trim();
+            if entry.is_empty() {
+                continue;
+            }
+
+            if entry.contains(':') {
+                let (addr, len) = utils::parse_ipv6_prefix(entry)
+                    .with_context(|| format!("Invalid prefix on line {}", n + 1))?;
+                list.v6.push((addr & classifier::prefix_mask_v6(len), len));
+            } else {
+                let (addr, len) = utils::parse_ip_prefix(entry)
+                    .with_context(|| format!("Invalid prefix on line {}", n + 1))?;
+                list.v4.push((addr & classifier::prefix_mask(len), len));
+            }
+        }
+
+        Ok(list)
+    }
+
+    /// 프리픽스 파일 읽기
+    pub fn read(path: &Path) -> Result<Self> {
+        let text = std::fs::read_to_string(path)
+            .with_context(|| format!("Failed to read blocklist {}", path.display()))?;
+        Self::parse(&text).with_context(|| format!("Failed to parse blocklist {}", path.display()))
+    }
+}
+
+/// 주소 계열 하나의 맵 변경분 (updates 값 = 기록할 블록리스트 ID)
+#[derive(Debug)]
+pub struct Changes<K> {
+    pub updates: Vec<(K, u32)>,
+    pub deletes: Vec<K>,
+}
+
+/// 블록리스트 하나를 교체하거나 삭제할 때의 맵 변경분
+#[derive(Debug)]
+pub struct BlocklistChanges {
+    pub id: u32,
+    /// 새로 할당된 ID (이전 블록리스트의 통계 초기화 필요)
+    pub new_id: bool,
+    pub v4: Changes<(u32, u32)>,
+    pub v6: Changes<(u128, u32)>,
+}
+
+/// 비트마스크에서 가장 낮은 블록리스트 ID
+fn lowest(mask: u64) -> u32 {
+    mask.trailing_zeros()
+}
+
+/// 주소 계열 하나의 프리픽스별 소속 비트마스크
+#[derive(Debug)]
+struct Members<K> {
+    masks: HashMap<K, u64>,
+    /// 맵의 최대 항목 수
+    capacity: usize,
+}
+
+impl<K: Copy + Eq + Hash> Members<K> {
+    fn new(capacity: usize) -> Self {
+        Self {
+            masks: HashMap::new(),
+            capacity,
+        }
+    }
+
+    /// 블록리스트 id의 소속을 next로 바꿨을 때 맵 항목 수
+    fn len_after(&self, id: u32, next: &HashSet<K>) -> usize {
+        let bit = 1u64 << id;
+        let added = next.iter().filter(|key| !self.masks.contains_key(key)).count();
+        let removed = self.masks.iter()
+            .filter(|(key, mask)| **mask == bit && !next.contains(key))
+            .count();
+
+        self.masks.len() + added - removed
+    }
+
+    /// 블록리스트 id의 소속을 next로 교체하고 맵 변경분 반환
+    fn replace(&mut self, id: u32, next: &HashSet<K>) -> Changes<K> {
+        let bit = 1u64 << id;
+        let mut changes = Changes { updates: Vec::new(), deletes: Vec::new() };
+
+        // 빠진 프리픽스 (다른 블록리스트에 남아 있으면 기록된 ID만 갱신)
+        self.masks.retain(|key, mask| {
+            if *mask & bit == 0 || next.contains(key) {
+                return true;
+            }
+            let before = lowest(*mask);
+            *mask &= !bit;
+            if *mask == 0 {
+                changes.deletes.push(*key);
+                return false;
+            }
+            if lowest(*mask) != before {
+                changes.updates.push((*key, lowest(*mask)));
+            }
+            true
+        });
+
+        // 추가된 프리픽스 (이미 다른 블록리스트에 있으면 더 낮은 ID일 때만 기록)
+        for key in next {
+            let mask = self.masks.entry(*key).or_insert(0);
+            let before = *mask;
+            *mask |= bit;
+            if before == 0 || lowest(*mask) != lowest(before) {
+                changes.updates.push((*key, lowest(*mask)));
+            }
+        }
+
+        changes
+    }
+}
+
+/// 이름 있는 블록리스트 집합
+#[derive(Debug)]
+pub struct Blocklists {
+    /// 인덱스 = 블록리스트 ID
+    names: Vec<Option<String>>,
+    counts: Vec<usize>,
+    v4: Members<(u32, u32)>,
+    v6: Members<(u128, u32)>,
+}
+
+impl Blocklists {
+    /// capacity_v4/capacity_v6 = blocklist_v4/blocklist_v6 맵의 최대 항목 수
+    pub fn new(capacity_v4: usize, capacity_v6: usize) -> Self {
+        Self {
+            names: vec![None; MAX_BLOCKLISTS],
+            counts: vec![0; MAX_BLOCKLISTS],
+            v4: Members::new(capacity_v4),
+            v6: Members::new(capacity_v6),
+        }
+    }
+
+    /// 블록리스트 name의 내용을 list로 교체 (없으면 새 ID 할당)
+    ///
+    /// 맵 용량을 넘으면 아무것도 바꾸지 않고 실패한다.
+    pub fn replace(&mut self, name: &str, list: &PrefixList) -> Result<BlocklistChanges> {
+        let (id, new_id) = match self.names.iter().position(|n| n.as_deref() == Some(name)) {
+            Some(id) => (id as u32, false),
+            None => {
+                let id = self.names.iter().position(|n| n.is_none())
+                    .ok_or_else(|| anyhow!("Blocklist limit reached ({})", MAX_BLOCKLISTS))?;
+                (id as u32, true)
+            }
+        };
+
+        let next_v4: HashSet<(u32, u32)> = list.v4.iter().copied().collect();
+        let next_v6: HashSet<(u128, u32)> = list.v6.iter().copied().collect();
+
+        let len_v4 = self.v4.len_after(id, &next_v4);
+        if len_v4 > self.v4.capacity {
+            return Err(anyhow!("Blocklist {} needs {} IPv4 prefixes but blocklist_v4 holds {} (raise xdp.map_sizes.blocklist_v4)",
+                name, len_v4, self.v4.capacity));
+        }
+        let len_v6 = self.v6.len_after(id, &next_v6);
+        if len_v6 > self.v6.capacity {
+            return Err(anyhow!("Blocklist {} needs {} IPv6 prefixes but blocklist_v6 holds {} (raise xdp.map_sizes.blocklist_v6)",
+                name, len_v6, self.v6.capacity));
+        }
+
+        self.names[id as usize] = Some(name.to_string());
+        self.counts[id as usize] = next_v4.len() + next_v6.len();
+
+        Ok(BlocklistChanges {
+            id,
+            new_id,
+            v4: self.v4.replace(id, &next_v4),
+            v6: self.v6.replace(id, &next_v6),
+        })
+    }
+
+    /// 블록리스트 name 삭제 (없으면 None)
+    pub fn remove(&mut self, name: &str) -> Option<BlocklistChanges> {
+        let id = self.names.iter().position(|n| n.as_deref() == Some(name))?;
+
+        let changes = BlocklistChanges {
+            id: id as u32,
+            new_id: false,
+            v4: self.v4.replace(id as u32, &HashSet::new()),
+            v6: self.v6.replace(id as u32, &HashSet::new()),
+        };
+        self.names[id] = None;
+        self.counts[id] = 0;
+
+        Some(changes)
+    }
+
+    /// blocklist_v4에 기록된 프리픽스 수
+    pub fn len_v4(&self) -> usize {
+        self.v4.masks.len()
+    }
+
+    /// blocklist_v6에 기록된 프리픽스 수
+    pub fn len_v6(&self) -> usize {
+        self.v6.masks.len()
+    }
+
+    pub fn contains_v4(&self, prefix: (u32, u32)) -> bool {
+        self.v4.masks.contains_key(&prefix)
+    }
+
+    pub fn contains_v6(&self, prefix: (u128, u32)) -> bool {
+        self.v6.masks.contains_key(&prefix)
+    }
+
+    /// ID 순서의 블록리스트 목록
+    pub fn info(&self) -> Vec<BlocklistInfo> {
+        self.names.iter()
+            .enumerate()
+            .filter_map(|(id, name)| name.as_ref().map(|name| BlocklistInfo {
+                id: id as u32,
+                name: name.clone(),
+                prefixes: self.counts[id],
+            }))
+            .collect()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_overlapping_lists() {
+        let mut lists = Blocklists::new(3, 16);
+        let feed = PrefixList::parse("# feed\n203.0.113.0/24\n198.51.100.7\n203.0.113.9/24\n2001:db8::/32\n").unwrap();
+        assert_eq!(feed.v4, vec![(0xCB007100, 24), (0xC6336407, 32), (0xCB007100, 24)]);
+
+        let changes = lists.replace("feed", &feed).unwrap();
+        assert_eq!((changes.id, changes.new_id), (0, true));
+        assert_eq!(changes.v4.updates.len(), 2);
+        assert_eq!(changes.v6.updates, vec![((0x20010DB8 << 96, 32), 0)]);
+
+        // 겹치는 프리픽스는 낮은 ID(feed)로 남고 새 프리픽스만 기록
+        let local = PrefixList::parse("203.0.113.0/24\n192.0.2.1\n").unwrap();
+        let changes = lists.replace("local", &local).unwrap();
+        assert_eq!(changes.id, 1);
+        assert_eq!(changes.v4.updates, vec![((0xC0000201, 32), 1)]);
+        assert_eq!(lists.len_v4(), 3);
+
+        // 용량 초과는 아무것도 바꾸지 않음
+        assert!(lists.replace("big", &PrefixList::parse("10.0.0.0/8\n").unwrap()).is_err());
+        assert_eq!(lists.info().len(), 2);
+
+        // feed 삭제 시 local에 남은 프리픽스는 local ID로 다시 기록
+        let changes = lists.remove("feed").unwrap();
+        assert_eq!(changes.v4.updates, vec![((0xCB007100, 24), 1)]);
+        assert_eq!(changes.v4.deletes, vec![(0xC6336407, 32)]);
+        assert_eq!(changes.v6.deletes.len(), 1);
+        assert!(lists.contains_v4((0xCB007100, 24)));
+        assert_eq!(lists.info(), vec![BlocklistInfo { id: 1, name: "local".to_string(), prefixes: 2 }]);
+
+        assert!(PrefixList::parse("203.0.113.0/33\n").is_err());
+    }
+}
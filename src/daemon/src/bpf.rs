@@ -2,17 +2,42 @@
 use anyhow::{anyhow, Context, Result};
 use libbpf_rs::{Map, Object, ObjectBuilder, Program};
 use log::{debug, error, info};
-use std::path::Path;
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
 use std::process::Command;
 
+use crate::features::Features;
+use crate::memory::{self, MapMemory};
+use crate::ruleset::{self, RuleSetMaps};
+
+/// 고정하지 않는 맵 (프로그램 fd나 단계 간 임시 상태를 담아 오브젝트별로 새로 만듦)
+const UNPINNED_MAPS: &[&str] = &["pipeline", "pipeline_state"];
+
+/// 구성(xdp.map_sizes)으로 최대 항목 수를 바꿀 수 있는 맵
+///
+/// 규칙 집합 내부 맵은 분류기 비트맵 크기가 컴파일 시점에 정해져 있어 제외한다.
+const RESIZABLE_MAPS: &[&str] = &["blocklist_v4", "blocklist_v6", "flow_cache", "src_buckets", "synproxy_flows"];
+
 pub struct XdpFilterSkel {
     pub obj: Object,
+    /// 로드된 오브젝트의 기능 집합 (특화 변형이면 일부)
+    pub features: Features,
+    /// 맵 고정 디렉터리 (bpffs)
+    pub pin_path: Option<PathBuf>,
+    /// 이전 데몬이 고정한 맵을 재사용했는지 여부
+    pub maps_reused: bool,
 }
 
+// 로드 후 오브젝트는 읽기만 하고 맵/프로그램 조작은 fd에 대한 syscall이므로
+// 맵 기록 스레드와 API 작업이 같은 스켈레톤을 공유할 수 있음
+unsafe impl Sync for XdpFilterSkel {}
+
 impl XdpFilterSkel {
     pub fn builder() -> XdpFilterSkelBuilder {
         XdpFilterSkelBuilder {
             obj_path: None,
+            pin_path: None,
+            map_sizes: HashMap::new(),
         }
     }
 
@@ -27,10 +52,54 @@ impl XdpFilterSkel {
             obj: &self.obj,
         }
     }
+
+    /// 맵별 메모리 추정치 (규칙 집합 내부 맵은 "rule_sets" 하나로 합산)
+    pub fn map_memory(&self) -> Result<Vec<MapMemory>> {
+        let ncpus = libbpf_rs::num_possible_cpus()?;
+        let mut maps = Vec::new();
+
+        for map in self.obj.maps_iter() {
+            if map.name().contains('.') {
+                continue;
+            }
+            let info = map_info(map)?;
+            maps.push(MapMemory {
+                name: map.name().to_string(),
+                max_entries: info.max_entries,
+                bytes: memory::estimate_bytes(info.type_, info.key_size, info.value_size, info.max_entries, ncpus),
+            });
+        }
+
+        // 활성 슬롯과 교체 대기 슬롯이 동시에 채워질 수 있음
+        maps.push(MapMemory {
+            name: "rule_sets".to_string(),
+            max_entries: ruleset::SLOTS,
+            bytes: RuleSetMaps::memory_estimate(ncpus) * ruleset::SLOTS as u64,
+        });
+
+        Ok(maps)
+    }
+}
+
+/// 커널이 보고하는 맵 정보 (로드 후 실제 최대 항목 수 등)
+pub fn map_info(map: &Map) -> Result<libbpf_sys::bpf_map_info> {
+    let mut info: libbpf_sys::bpf_map_info = unsafe { std::mem::zeroed() };
+    let mut len = std::mem::size_of::<libbpf_sys::bpf_map_info>() as u32;
+
+    let ret = unsafe {
+        libbpf_sys::bpf_obj_get_info_by_fd(map.fd(), &mut info as *mut _ as *mut libc::c_void, &mut len)
+    };
+    if ret != 0 {
+        return Err(anyhow!("Failed to get info for map {}: {}", map.name(), std::io::Error::last_os_error()));
+    }
+
+    Ok(info)
 }
 
 pub struct XdpFilterSkelBuilder {
     obj_path: Option<String>,
+    pin_path: Option<PathBuf>,
+    map_sizes: HashMap<String, u32>,
 }
 
 impl XdpFilterSkelBuilder {
@@ -39,13 +108,68 @@ impl XdpFilterSkelBuilder {
         self
     }
 
+    /// 맵을 bpffs 디렉터리에 고정 (이미 고정된 맵이 있으면 새로 만들지 않고 재사용)
+    pub fn pin_path<P: AsRef<Path>>(mut self, path: P) -> Self {
+        self.pin_path = Some(path.as_ref().to_path_buf());
+        self
+    }
+
+    /// 맵 최대 항목 수 재정의 (RESIZABLE_MAPS만 허용)
+    pub fn map_sizes(mut self, sizes: HashMap<String, u32>) -> Self {
+        self.map_sizes = sizes;
+        self
+    }
+
     pub fn open(self) -> Result<XdpFilterSkel> {
         let mut builder = ObjectBuilder::default();
         let path = self.obj_path.ok_or_else(|| anyhow!("No Object file path provided"))?;
-        let object = builder.open_file(path)?;
+        let features = Features::of_object(Path::new(&path));
+        let mut object = builder.open_file(path)?;
+
+        for (name, size) in &self.map_sizes {
+            if !RESIZABLE_MAPS.contains(&name.as_str()) {
+                return Err(anyhow!("Map {} cannot be resized (resizable maps: {})", name, RESIZABLE_MAPS.join(", ")));
+            }
+            // 특화 변형에 없는 맵은 무시
+            if let Some(map) = object.map_mut(name) {
+                map.set_max_entries(*size)
+                    .with_context(|| format!("Failed to set max entries for map {}", name))?;
+                debug!("Map {} max entries set to {}", name, size);
+            }
+        }
+
+        // libbpf는 로드할 때 고정 경로에 호환되는 맵이 있으면 그 fd를 쓰고, 없으면 만들어 고정
+        let mut maps_reused = false;
+        if let Some(dir) = &self.pin_path {
+            std::fs::create_dir_all(dir)
+                .with_context(|| format!("Failed to create pin directory {}", dir.display()))?;
+            maps_reused = dir.join("cls_config").exists();
+
+            for map in object.maps_iter_mut() {
+                let name = map.name().to_string();
+                // .rodata 같은 내부 맵은 오브젝트별
+                if name.contains('.') || UNPINNED_MAPS.contains(&name.as_str()) {
+                    continue;
+                }
+                map.set_pin_path(dir.join(&name))
+                    .with_context(|| format!("Failed to set pin path for map {}", name))?;
+            }
+        }
+
+        let obj = object.load().with_context(|| match &self.pin_path {
+            // 맵 정의가 바뀐 오브젝트는 이전 고정 맵을 재사용할 수 없음
+            Some(dir) => format!("Failed to load object (remove {} if map definitions changed)", dir.display()),
+            None => "Failed to load object".to_string(),
+        })?;
+        if let (true, Some(dir)) = (maps_reused, &self.pin_path) {
+            info!("{}에 고정된 맵 재사용", dir.display());
+        }
 
         Ok(XdpFilterSkel {
-            obj: object.load().expect("Failed to load object"),
+            obj,
+            features,
+            pin_path: self.pin_path,
+            maps_reused,
         })
     }
 }
@@ -62,10 +186,102 @@ impl<'a> XdpFilterMaps<'a> {
     pub fn redirect_map(&self) -> Option<&Map> {
         self.obj.map("redirect_map")
     }
+
+    pub fn cpu_map(&self) -> Option<&Map> {
+        self.obj.map("cpu_map")
+    }
     
     pub fn stats_map(&self) -> Option<&Map> {
         self.obj.map("stats_map")
     }
+
+    pub fn queue_stats(&self) -> Option<&Map> {
+        self.obj.map("queue_stats")
+    }
+
+    pub fn events(&self) -> Option<&Map> {
+        self.obj.map("events")
+    }
+
+    pub fn cls_src_v4(&self) -> Option<&Map> {
+        self.obj.map("cls_src_v4")
+    }
+
+    pub fn cls_dst_v4(&self) -> Option<&Map> {
+        self.obj.map("cls_dst_v4")
+    }
+
+    pub fn cls_src_v6(&self) -> Option<&Map> {
+        self.obj.map("cls_src_v6")
+    }
+
+    pub fn cls_dst_v6(&self) -> Option<&Map> {
+        self.obj.map("cls_dst_v6")
+    }
+
+    pub fn cls_port_class(&self) -> Option<&Map> {
+        self.obj.map("cls_port_class")
+    }
+
+    pub fn cls_bitmaps(&self) -> Option<&Map> {
+        self.obj.map("cls_bitmaps")
+    }
+
+    pub fn cls_config(&self) -> Option<&Map> {
+        self.obj.map("cls_config")
+    }
+
+    pub fn rule_stats(&self) -> Option<&Map> {
+        self.obj.map("rule_stats")
+    }
+
+    pub fn rule_buckets(&self) -> Option<&Map> {
+        self.obj.map("rule_buckets")
+    }
+
+    pub fn src_buckets(&self) -> Option<&Map> {
+        self.obj.map("src_buckets")
+    }
+
+    pub fn xsk_map(&self) -> Option<&Map> {
+        self.obj.map("xsk_map")
+    }
+
+    pub fn flow_cache(&self) -> Option<&Map> {
+        self.obj.map("flow_cache")
+    }
+
+    pub fn pipeline(&self) -> Option<&Map> {
+        self.obj.map("pipeline")
+    }
+
+    pub fn hh_config(&self) -> Option<&Map> {
+        self.obj.map("hh_config")
+    }
+
+    pub fn hh_sketch(&self) -> Option<&Map> {
+        self.obj.map("hh_sketch")
+    }
+
+    pub fn hh_topk(&self) -> Option<&Map> {
+        self.obj.map("hh_topk")
+    }
+
+    pub fn blocklist_v4(&self) -> Option<&Map> {
+        self.obj.map("blocklist_v4")
+    }
+
+    pub fn blocklist_v6(&self) -> Option<&Map> {
+        self.obj.map("blocklist_v6")
+    }
+
+    pub fn blocklist_config(&self) -> Option<&Map> {
+        self.obj.map("blocklist_config")
+    }
+
+    pub fn blocklist_stats(&self) -> Option<&Map> {
+        self.obj.map("blocklist_stats")
+    }
 }
 
 pub struct XdpFilterProgs<'a> {
@@ -76,16 +292,68 @@ impl<'a> XdpFilterProgs<'a> {
     pub fn xdp_filter_func(&self) -> Option<&Program> {
         self.obj.prog("xdp_filter_func")
     }
+
+    pub fn xdp_pipeline_func(&self) -> Option<&Program> {
+        self.obj.prog("xdp_pipeline_func")
+    }
+
+    /// 파이프라인 단계 프로그램
+    pub fn stage(&self, name: &str) -> Option<&Program> {
+        self.obj.prog(name)
+    }
 }
 
 /// XDP 모드 열거형
-#[derive(Debug, Clone, Copy)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum XdpMode {
     Driver = 0,  // 드라이버/네이티브 모드
     Generic = 1, // SKB 기반 제네릭 모드
     Offload = 2, // 하드웨어 오프로드 모드
 }
 
+impl XdpMode {
+    /// API 요청의 모드 번호
+    pub fn from_u32(mode: u32) -> Option<Self> {
+        match mode {
+            0 => Some(Self::Driver),
+            1 => Some(Self::Generic),
+            2 => Some(Self::Offload),
+            _ => None,
+        }
+    }
+
+    /// 구성 파일의 모드 이름
+    pub fn from_str(s: &str) -> Option<Self> {
+        match s.to_lowercase().as_str() {
+            "driver" => Some(Self::Driver),
+            "generic" => Some(Self::Generic),
+            "offload" => Some(Self::Offload),
+            _ => None,
+        }
+    }
+
+    pub fn to_str(&self) -> &'static str {
+        match self {
+            Self::Driver => "driver",
+            Self::Generic => "generic",
+            Self::Offload => "offload",
+        }
+    }
+}
+
+/// 커널에 XDP용 syncookie 헬퍼가 있는지 (없으면 synproxy 규칙이 통과로 동작, 한 번만 확인)
+pub fn syncookie_supported() -> bool {
+    static SUPPORTED: std::sync::OnceLock<bool> = std::sync::OnceLock::new();
+
+    *SUPPORTED.get_or_init(|| unsafe {
+        libbpf_sys::libbpf_probe_bpf_helper(
+            libbpf_sys::BPF_PROG_TYPE_XDP,
+            libbpf_sys::BPF_FUNC_tcp_raw_gen_syncookie_ipv4,
+            std::ptr::null(),
+        ) == 1
+    })
+}
+
 /// XDP 프로그램 로드
 pub fn load_xdp_program(obj_path: &Path, interface: &str) -> Result<()> {
     // BPF 오브젝트 파일 존재 확인
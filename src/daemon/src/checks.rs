@@ -0,0 +1,230 @@
+//! BPF_PROG_TEST_RUN 동작 검사 모듈
+//! 고정 패킷으로 타이밍, 이전 패킷 또는 응답 내용에 의존하는 데이터 경로 동작
+//! (레이트 리밋, 흐름 캐시, SYN 프록시)을 확인
+
+use anyhow::{anyhow, Result};
+use libbpf_rs::Map;
+use log::{error, info, warn};
+
+use crate::abi;
+use crate::bpf;
+use crate::features::Features;
+use crate::maps::{FilterRule, MapManager};
+use crate::{bench_rule, clear_flow_cache, ethernet, ipv4, ipv4_checksum, tcp, test_run, verdict_name};
+use crate::{ETH_P_IP, PROTO_TCP, XDP_DROP, XDP_PASS, XDP_TX};
+
+const ACTION_PASS: u8 = abi::ACTION_PASS as u8;
+const ACTION_DROP: u8 = abi::ACTION_DROP as u8;
+const ACTION_SYNPROXY: u8 = abi::ACTION_SYNPROXY as u8;
+
+const CLIENT4: [u8; 4] = [198, 51, 100, 7];
+const SERVER4: [u8; 4] = [203, 0, 113, 10];
+
+/// 검사 대상 프로그램과 규칙 설치 경로
+pub struct Checker<'a, 'm> {
+    pub map_manager: &'m mut MapManager<'a>,
+    pub prog_fd: i32,
+    pub flow_cache: &'a Map,
+    pub features: Features,
+}
+
+/// 검사 결과 (실패는 Err)
+enum Outcome {
+    Passed,
+    Skipped(&'static str),
+}
+
+type Check = fn(&mut Checker) -> Result<Outcome>;
+
+const CHECKS: &[(&str, Check)] = &[
+    ("rate_limit", check_rate_limit),
+    ("flow_cache_generation", check_flow_cache_generation),
+    ("synproxy_reply", check_synproxy_reply),
+];
+
+/// 모든 검사 실행 (하나라도 실패하면 Err)
+pub fn run_all(checker: &mut Checker) -> Result<()> {
+    let mut failed = 0;
+
+    for (name, check) in CHECKS {
+        match check(checker) {
+            Ok(Outcome::Passed) => info!("{}: 통과", name),
+            Ok(Outcome::Skipped(reason)) => warn!("{}: 건너뜀 ({})", name, reason),
+            Err(e) => {
+                error!("{}: 실패: {}", name, e);
+                failed += 1;
+            }
+        }
+    }
+
+    if failed > 0 {
+        return Err(anyhow!("검사 {}개 중 {}개 실패", CHECKS.len(), failed));
+    }
+    Ok(())
+}
+
+impl<'a, 'm> Checker<'a, 'm> {
+    /// 로드된 오브젝트가 규칙을 처리할 수 있으면 규칙 집합 교체
+    fn install(&mut self, rules: Vec<FilterRule>) -> Result<bool> {
+        if !rules.iter().all(|rule| self.features.contains(Features::required(rule))) {
+            return Ok(false);
+        }
+        self.map_manager.replace_rules(rules)?;
+        Ok(true)
+    }
+
+    /// 패킷 count개를 하나씩 실행해 판정별 횟수 반환 (통과, 드롭)
+    fn run_each(&self, packet: &[u8], count: u32) -> Result<(u32, u32)> {
+        let mut passed = 0;
+        let mut dropped = 0;
+        for _ in 0..count {
+            match test_run(self.prog_fd, packet, 1)?.0 {
+                XDP_PASS => passed += 1,
+                XDP_DROP => dropped += 1,
+                verdict => return Err(anyhow!("예상하지 못한 판정: {}", verdict_name(verdict))),
+            }
+        }
+        Ok((passed, dropped))
+    }
+}
+
+/// 레이트 리밋: 버킷 용량(초당 RATE개)을 넘는 패킷은 드롭되고, 규칙 집합을 교체하면
+/// 데몬이 버킷을 초기화하므로 다시 RATE개가 통과
+fn check_rate_limit(checker: &mut Checker) -> Result<Outcome> {
+    const RATE: u32 = 10;
+
+    let mut rule = bench_rule("check-rate", Some("198.51.100.0/24"), PROTO_TCP, Some(80), ACTION_PASS, 100)?;
+    rule.rate_limit = RATE;
+    let packet = ethernet(None, ETH_P_IP, &ipv4(CLIENT4, SERVER4, PROTO_TCP, &[], &tcp(40000, 80, &[])));
+
+    for round in ["설치", "교체"] {
+        if !checker.install(vec![rule.clone()])? {
+            return Ok(Outcome::Skipped("레이트 리밋이 없는 변형"));
+        }
+        clear_flow_cache(checker.flow_cache)?;
+
+        // 실행 중 보충되는 토큰 하나까지 허용 (100ms에 하나)
+        let (passed, dropped) = checker.run_each(&packet, RATE * 2)?;
+        if passed < RATE || passed > RATE + 1 {
+            return Err(anyhow!("규칙 {} 후 패킷 {}개 중 {}개 통과, {}개 드롭 (기대값 {}개 통과)",
+                               round, RATE * 2, passed, dropped, RATE));
+        }
+    }
+
+    Ok(Outcome::Passed)
+}
+
+/// 흐름 캐시 무효화: 캐시에 적중하던 흐름도 규칙 집합을 교체하면 새 규칙의 판정을 받음
+///
+/// 교체 사이에 캐시를 비우지 않으므로 세대 번호가 바뀌지 않으면 이전 판정이 남는다.
+fn check_flow_cache_generation(checker: &mut Checker) -> Result<Outcome> {
+    let packet = ethernet(None, ETH_P_IP, &ipv4(CLIENT4, SERVER4, PROTO_TCP, &[], &tcp(40000, 80, &[])));
+    let rule = |action| bench_rule("check-cache", Some("198.51.100.0/24"), PROTO_TCP, Some(80), action, 100);
+
+    clear_flow_cache(checker.flow_cache)?;
+    for (action, expected) in [(ACTION_DROP, XDP_DROP), (ACTION_PASS, XDP_PASS), (ACTION_DROP, XDP_DROP)] {
+        if !checker.install(vec![rule(action)?])? {
+            return Ok(Outcome::Skipped("규칙을 처리할 수 없는 변형"));
+        }
+
+        // 첫 실행이 캐시를 채우고 반복 실행은 캐시 적중 경로
+        for repeat in [1, 100] {
+            let verdict = test_run(checker.prog_fd, &packet, repeat)?.0;
+            if verdict != expected {
+                return Err(anyhow!("규칙 교체 후 판정 {} (기대값 {}, 반복 {})",
+                                   verdict_name(verdict), verdict_name(expected), repeat));
+            }
+        }
+    }
+    if checker.flow_cache.keys().next().is_none() {
+        return Err(anyhow!("흐름 캐시 항목이 없음 (캐시 적중 경로를 검사하지 못함)"));
+    }
+
+    Ok(Outcome::Passed)
+}
+
+/// BPF_PROG_TEST_RUN 한 번 실행 (반환값, 프로그램이 고친 패킷)
+fn test_run_output(prog_fd: i32, packet: &[u8]) -> Result<(u32, Vec<u8>)> {
+    let mut out = vec![0u8; packet.len() + 256];
+    let mut opts: libbpf_sys::bpf_test_run_opts = unsafe { std::mem::zeroed() };
+    opts.sz = std::mem::size_of::<libbpf_sys::bpf_test_run_opts>() as libbpf_sys::size_t;
+    opts.data_in = packet.as_ptr() as *const libc::c_void;
+    opts.data_size_in = packet.len() as u32;
+    opts.data_out = out.as_mut_ptr() as *mut libc::c_void;
+    opts.data_size_out = out.len() as u32;
+    opts.repeat = 1;
+
+    let ret = unsafe { libbpf_sys::bpf_prog_test_run_opts(prog_fd, &mut opts) };
+    if ret != 0 {
+        return Err(anyhow!(
+            "bpf_prog_test_run_opts failed: {}",
+            std::io::Error::from_raw_os_error(-ret)
+        ));
+    }
+
+    out.truncate(opts.data_size_out as usize);
+    Ok((opts.retval, out))
+}
+
+/// SYN 프록시: SYN에는 주소와 포트를 맞바꾼 SYN-ACK를 같은 인터페이스로 돌려보냄
+///
+/// 응답의 IP 헤더 체크섬과 의사 헤더를 포함한 TCP 체크섬이 맞아야 한다.
+fn check_synproxy_reply(checker: &mut Checker) -> Result<Outcome> {
+    if !bpf::syncookie_supported() {
+        return Ok(Outcome::Skipped("커널에 XDP syncookie 헬퍼가 없음"));
+    }
+    let rule = bench_rule("check-synproxy", Some("198.51.100.0/24"), PROTO_TCP, Some(80), ACTION_SYNPROXY, 100)?;
+    if !checker.install(vec![rule])? {
+        return Ok(Outcome::Skipped("SYN 프록시가 없는 변형"));
+    }
+    clear_flow_cache(checker.flow_cache)?;
+
+    let syn = ethernet(None, ETH_P_IP, &ipv4(CLIENT4, SERVER4, PROTO_TCP, &[], &tcp(40000, 80, &[])));
+    let (verdict, reply) = test_run_output(checker.prog_fd, &syn)?;
+    if verdict != XDP_TX {
+        return Err(anyhow!("SYN 판정 {} (기대값 tx)", verdict_name(verdict)));
+    }
+    if reply.len() < 34 || reply[14] != 0x45 {
+        return Err(anyhow!("응답에 옵션 없는 IPv4 헤더가 없음 ({}바이트)", reply.len()));
+    }
+
+    let ip = &reply[14..34];
+    let total_len = u16::from_be_bytes([ip[2], ip[3]]) as usize;
+    if total_len < 40 || reply.len() < 14 + total_len {
+        return Err(anyhow!("잘못된 IP 전체 길이 {} (프레임 {}바이트)", total_len, reply.len()));
+    }
+    let segment = &reply[34..14 + total_len];
+
+    // 이더넷, IP 주소와 TCP 포트 교환 (SYN의 순서 번호는 1)
+    let (server_port, client_port) = (80u16.to_be_bytes(), 40000u16.to_be_bytes());
+    let ack = 2u32.to_be_bytes();
+    let expected: [(&str, &[u8], &[u8]); 8] = [
+        ("이더넷 대상 주소", &reply[0..6], &syn[6..12]),
+        ("이더넷 소스 주소", &reply[6..12], &syn[0..6]),
+        ("IP 소스 주소", &ip[12..16], &SERVER4),
+        ("IP 대상 주소", &ip[16..20], &CLIENT4),
+        ("TCP 소스 포트", &segment[0..2], &server_port),
+        ("TCP 대상 포트", &segment[2..4], &client_port),
+        ("TCP 확인 번호", &segment[8..12], &ack),
+        ("TCP 플래그 (SYN|ACK)", &segment[13..14], &[0x12]),
+    ];
+    for (field, actual, wanted) in expected {
+        if actual != wanted {
+            return Err(anyhow!("{}: {:02x?} (기대값 {:02x?})", field, actual, wanted));
+        }
+    }
+
+    if ipv4_checksum(ip) != 0 {
+        return Err(anyhow!("IP 헤더 체크섬 오류"));
+    }
+    let mut pseudo = Vec::with_capacity(12 + segment.len());
+    pseudo.extend_from_slice(&ip[12..20]);
+    pseudo.extend_from_slice(&[0, PROTO_TCP]);
+    pseudo.extend_from_slice(&(segment.len() as u16).to_be_bytes());
+    pseudo.extend_from_slice(segment);
+    if ipv4_checksum(&pseudo) != 0 {
+        return Err(anyhow!("TCP 체크섬 오류"));
+    }
+
+    Ok(Outcome::Passed)
+}
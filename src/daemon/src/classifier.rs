@@ -0,0 +1,554 @@
+//! 분류기 컴파일러 모듈
+//! 필터 규칙 집합을 필드별 비트맵 교집합 구조로 컴파일
+//!
+//! 규칙은 우선순위 순서로 정렬되어 입력되며, 입력 인덱스가 곧 비트맵의 비트 위치입니다.
+//! XDP 프로그램은 필드마다 한 번씩 맵을 조회한 뒤 비트맵을 AND하여
+//! 가장 낮은 설정 비트(= 최우선 규칙)를 선택합니다.
+
+use anyhow::{anyhow, Result};
+use std::collections::BTreeMap;
+use std::ops::BitAnd;
+
+use crate::abi;
+
+/// 최대 규칙 수
+pub const MAX_FILTER_RULES: usize = abi::MAX_FILTER_RULES as usize;
+/// 규칙 비트맵 워드 수
+pub const BITMAP_WORDS: usize = abi::CLS_BITMAP_WORDS as usize;
+/// 필드별 LPM 프리픽스 수
+pub const MAX_PREFIXES: usize = abi::CLS_MAX_PREFIXES as usize;
+/// 포트 구간 클래스 수
+pub const MAX_PORT_CLASSES: usize = abi::CLS_MAX_PORT_CLASSES as usize;
+/// 포트 공간 크기
+pub const PORT_SPACE: usize = abi::CLS_PORT_SPACE as usize;
+
+/// cls_bitmaps 인덱스 배치
+pub const BM_PROTO_BASE: u32 = abi::CLS_BM_PROTO_BASE;
+pub const BM_TCP_FLAGS_BASE: u32 = abi::CLS_BM_TCP_FLAGS_BASE;
+pub const TCP_FLAGS_NONE: u32 = abi::CLS_TCP_FLAGS_NONE;
+pub const TCP_FLAGS_FRAG: u32 = abi::CLS_TCP_FLAGS_FRAG;
+pub const BM_SPORT_BASE: u32 = abi::CLS_BM_SPORT_BASE;
+pub const BM_DPORT_BASE: u32 = abi::CLS_BM_DPORT_BASE;
+pub const BM_SPORT_UNKNOWN: u32 = abi::CLS_BM_SPORT_UNKNOWN;
+pub const BM_DPORT_UNKNOWN: u32 = abi::CLS_BM_DPORT_UNKNOWN;
+pub const BM_ENTRIES: u32 = abi::CLS_BM_ENTRIES;
+
+/// cls_port_class 인덱스 배치
+pub const PC_SPORT_BASE: u32 = abi::CLS_PC_SPORT_BASE;
+pub const PC_DPORT_BASE: u32 = abi::CLS_PC_DPORT_BASE;
+
+/// 모든 프로토콜 매치
+const PROTO_ANY: u8 = abi::IPPROTO_ANY as u8;
+/// TCP 프로토콜 번호
+const PROTO_TCP: u8 = 6;
+
+/// 규칙 비트맵
+#[derive(Clone, PartialEq, Eq)]
+pub struct RuleBitmap {
+    words: [u64; BITMAP_WORDS],
+}
+
+impl RuleBitmap {
+    /// 빈 비트맵 생성
+    pub fn new() -> Self {
+        Self {
+            words: [0u64; BITMAP_WORDS],
+        }
+    }
+
+    /// 비트 설정
+    pub fn set(&mut self, bit: usize) {
+        self.words[bit / 64] |= 1u64 << (bit % 64);
+    }
+
+    /// 비트 확인
+    pub fn test(&self, bit: usize) -> bool {
+        (self.words[bit / 64] & (1u64 << (bit % 64))) != 0
+    }
+
+    /// 빈 비트맵 여부
+    pub fn is_empty(&self) -> bool {
+        self.words.iter().all(|w| *w == 0)
+    }
+
+    /// 맵 값 바이트 (struct rule_bitmap과 같은 배치, 복사 없음)
+    pub fn as_bytes(&self) -> &[u8] {
+        abi::as_bytes(&self.words)
+    }
+}
+
+impl Default for RuleBitmap {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl std::fmt::Debug for RuleBitmap {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let bits: Vec<usize> = (0..MAX_FILTER_RULES).filter(|b| self.test(*b)).collect();
+        f.debug_tuple("RuleBitmap").field(&bits).finish()
+    }
+}
+
+/// 분류기에 입력되는 규칙의 매치 필드
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MatchFields {
+    pub src_ip: Option<(u32, u32)>,  // (IP, 프리픽스 길이)
+    pub dst_ip: Option<(u32, u32)>,  // (IP, 프리픽스 길이)
+    pub src_ip6: Option<(u128, u32)>,  // (IPv6, 프리픽스 길이)
+    pub dst_ip6: Option<(u128, u32)>,  // (IPv6, 프리픽스 길이)
+    pub protocol: u8,
+    pub src_port_min: u16,
+    pub src_port_max: u16,
+    pub dst_port_min: u16,
+    pub dst_port_max: u16,
+    pub tcp_flags: u8,
+}
+
+impl MatchFields {
+    /// IPv4 패킷에 매치될 수 있는지 (IPv6 주소 조건이 없음)
+    fn matches_v4(&self) -> bool {
+        self.src_ip6.is_none() && self.dst_ip6.is_none()
+    }
+
+    /// IPv6 패킷에 매치될 수 있는지 (IPv4 주소 조건이 없음)
+    fn matches_v6(&self) -> bool {
+        self.src_ip.is_none() && self.dst_ip.is_none()
+    }
+}
+
+/// 컴파일된 분류기
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct CompiledClassifier {
+    /// 컴파일된 규칙 수
+    pub nrules: u32,
+    /// 사용 중인 비트맵 워드 수
+    pub nwords: u32,
+    /// 소스 프리픽스 (마스킹된 주소, 길이) -> 비트맵
+    pub src_v4: BTreeMap<(u32, u32), RuleBitmap>,
+    /// 대상 프리픽스 (마스킹된 주소, 길이) -> 비트맵
+    pub dst_v4: BTreeMap<(u32, u32), RuleBitmap>,
+    /// IPv6 소스 프리픽스 -> 비트맵
+    pub src_v6: BTreeMap<(u128, u32), RuleBitmap>,
+    /// IPv6 대상 프리픽스 -> 비트맵
+    pub dst_v6: BTreeMap<(u128, u32), RuleBitmap>,
+    /// cls_bitmaps 인덱스 -> 비트맵
+    pub bitmaps: BTreeMap<u32, RuleBitmap>,
+    /// cls_port_class 값 (소스 포트 65536개 + 대상 포트 65536개)
+    pub port_class: Vec<u32>,
+}
+
+/// 프리픽스 길이에 대한 IPv4 마스크
+pub fn prefix_mask(prefix_len: u32) -> u32 {
+    if prefix_len == 0 {
+        0
+    } else {
+        u32::MAX << (32 - prefix_len.min(32))
+    }
+}
+
+/// 프리픽스 길이에 대한 IPv6 마스크
+pub fn prefix_mask_v6(prefix_len: u32) -> u128 {
+    if prefix_len == 0 {
+        0
+    } else {
+        u128::MAX << (128 - prefix_len.min(128))
+    }
+}
+
+/// 규칙 집합 컴파일 (rules는 우선순위 순서로 정렬되어 있어야 함)
+pub fn compile(rules: &[MatchFields]) -> Result<CompiledClassifier> {
+    if rules.len() > MAX_FILTER_RULES {
+        return Err(anyhow!("Too many rules: {} (max {})", rules.len(), MAX_FILTER_RULES));
+    }
+
+    // 주소 패밀리가 맞지 않는 규칙은 해당 트라이에서 제외 (비트가 설정되지 않음)
+    let src_v4 = compile_prefixes(
+        rules.iter().map(|r| r.matches_v4().then(|| r.src_ip.unwrap_or((0, 0)))),
+        prefix_mask,
+    )?;
+    let dst_v4 = compile_prefixes(
+        rules.iter().map(|r| r.matches_v4().then(|| r.dst_ip.unwrap_or((0, 0)))),
+        prefix_mask,
+    )?;
+    let src_v6 = compile_prefixes(
+        rules.iter().map(|r| r.matches_v6().then(|| r.src_ip6.unwrap_or((0, 0)))),
+        prefix_mask_v6,
+    )?;
+    let dst_v6 = compile_prefixes(
+        rules.iter().map(|r| r.matches_v6().then(|| r.dst_ip6.unwrap_or((0, 0)))),
+        prefix_mask_v6,
+    )?;
+
+    let mut bitmaps = BTreeMap::new();
+
+    // 프로토콜별 비트맵
+    for proto in 0..256u32 {
+        let mut bitmap = RuleBitmap::new();
+        for (bit, rule) in rules.iter().enumerate() {
+            if rule.protocol == PROTO_ANY || rule.protocol as u32 == proto {
+                bitmap.set(bit);
+            }
+        }
+        bitmaps.insert(BM_PROTO_BASE + proto, bitmap);
+    }
+
+    // TCP 플래그 조합별 비트맵 (규칙의 플래그가 모두 포함된 조합만 매치)
+    for flags in 0..64u32 {
+        let mut bitmap = RuleBitmap::new();
+        for (bit, rule) in rules.iter().enumerate() {
+            if (rule.tcp_flags as u32 & flags) == rule.tcp_flags as u32 {
+                bitmap.set(bit);
+            }
+        }
+        bitmaps.insert(BM_TCP_FLAGS_BASE + flags, bitmap);
+    }
+
+    // 비 TCP 패킷은 플래그 조건 없이 모든 규칙 후보
+    let mut all = RuleBitmap::new();
+    for bit in 0..rules.len() {
+        all.set(bit);
+    }
+    bitmaps.insert(BM_TCP_FLAGS_BASE + TCP_FLAGS_NONE, all);
+
+    // L4 헤더가 없는 조각: 플래그/포트 조건이 없는 규칙만 후보
+    let mut no_flags = RuleBitmap::new();
+    let mut any_sport = RuleBitmap::new();
+    let mut any_dport = RuleBitmap::new();
+    for (bit, rule) in rules.iter().enumerate() {
+        if rule.tcp_flags == 0 {
+            no_flags.set(bit);
+        }
+        if rule.src_port_min == 0 && rule.src_port_max == u16::MAX {
+            any_sport.set(bit);
+        }
+        if rule.dst_port_min == 0 && rule.dst_port_max == u16::MAX {
+            any_dport.set(bit);
+        }
+    }
+    bitmaps.insert(BM_TCP_FLAGS_BASE + TCP_FLAGS_FRAG, no_flags);
+    bitmaps.insert(BM_SPORT_UNKNOWN, any_sport);
+    bitmaps.insert(BM_DPORT_UNKNOWN, any_dport);
+
+    // 포트 구간 클래스
+    let mut port_class = vec![0u32; 2 * PORT_SPACE];
+    let sport = compile_port_classes(rules.iter().map(|r| (r.src_port_min, r.src_port_max)));
+    let dport = compile_port_classes(rules.iter().map(|r| (r.dst_port_min, r.dst_port_max)));
+
+    for (class, bitmap) in sport.1.into_iter().enumerate() {
+        bitmaps.insert(BM_SPORT_BASE + class as u32, bitmap);
+    }
+    for (class, bitmap) in dport.1.into_iter().enumerate() {
+        bitmaps.insert(BM_DPORT_BASE + class as u32, bitmap);
+    }
+    port_class[PC_SPORT_BASE as usize..PC_SPORT_BASE as usize + PORT_SPACE].copy_from_slice(&sport.0);
+    port_class[PC_DPORT_BASE as usize..PC_DPORT_BASE as usize + PORT_SPACE].copy_from_slice(&dport.0);
+
+    Ok(CompiledClassifier {
+        nrules: rules.len() as u32,
+        nwords: ((rules.len() + 63) / 64) as u32,
+        src_v4,
+        dst_v4,
+        src_v6,
+        dst_v6,
+        bitmaps,
+        port_class,
+    })
+}
+
+/// 프리픽스 필드 컴파일
+///
+/// 저장된 프리픽스 P의 비트맵은 P를 포함하는(더 짧거나 같은) 프리픽스를 가진 모든 규칙입니다.
+/// 패킷 주소에 대한 최장 프리픽스 매치 결과가 곧 해당 주소에 매치되는 규칙 집합이 됩니다.
+/// 와일드카드 규칙은 /0으로 입력하고, 이 주소 패밀리에 해당하지 않는 규칙은 None으로 입력합니다.
+fn compile_prefixes<A, I>(fields: I, mask: fn(u32) -> A) -> Result<BTreeMap<(A, u32), RuleBitmap>>
+where
+    A: Copy + Ord + BitAnd<Output = A>,
+    I: Iterator<Item = Option<(A, u32)>>,
+{
+    let prefixes: Vec<Option<(A, u32)>> = fields
+        .map(|f| f.map(|(addr, prefix_len)| (addr & mask(prefix_len), prefix_len)))
+        .collect();
+
+    let mut result: BTreeMap<(A, u32), RuleBitmap> = BTreeMap::new();
+    for prefix in prefixes.iter().flatten() {
+        result.entry(*prefix).or_insert_with(RuleBitmap::new);
+    }
+
+    if result.len() > MAX_PREFIXES {
+        return Err(anyhow!("Too many distinct prefixes: {} (max {})", result.len(), MAX_PREFIXES));
+    }
+
+    for (&(addr, prefix_len), bitmap) in result.iter_mut() {
+        for (bit, prefix) in prefixes.iter().enumerate() {
+            if let Some((rule_addr, rule_len)) = *prefix {
+                if rule_len <= prefix_len && (addr & mask(rule_len)) == rule_addr {
+                    bitmap.set(bit);
+                }
+            }
+        }
+    }
+
+    Ok(result)
+}
+
+/// 포트 범위 필드 컴파일
+///
+/// 모든 범위 경계로 포트 공간을 기본 구간(클래스)으로 나누고,
+/// 포트 -> 클래스 배열과 클래스별 비트맵을 반환합니다.
+fn compile_port_classes<I>(ranges: I) -> (Vec<u32>, Vec<RuleBitmap>)
+where
+    I: Iterator<Item = (u16, u16)>,
+{
+    let ranges: Vec<(u16, u16)> = ranges.collect();
+
+    // 구간 시작점
+    let mut bounds: Vec<u32> = vec![0];
+    for &(min, max) in &ranges {
+        bounds.push(min as u32);
+        if (max as u32) + 1 < PORT_SPACE as u32 {
+            bounds.push(max as u32 + 1);
+        }
+    }
+    bounds.sort_unstable();
+    bounds.dedup();
+
+    let mut classes = vec![RuleBitmap::new(); bounds.len()];
+    for (bit, &(min, max)) in ranges.iter().enumerate() {
+        let first = bounds.binary_search(&(min as u32)).unwrap_or(0);
+        for class in first..bounds.len() {
+            if bounds[class] > max as u32 {
+                break;
+            }
+            classes[class].set(bit);
+        }
+    }
+
+    let mut port_class = vec![0u32; PORT_SPACE];
+    let mut class = 0usize;
+    for (port, slot) in port_class.iter_mut().enumerate() {
+        while class + 1 < bounds.len() && bounds[class + 1] <= port as u32 {
+            class += 1;
+        }
+        *slot = class as u32;
+    }
+
+    (port_class, classes)
+}
+
+impl CompiledClassifier {
+    /// 패킷 필드 분류 (XDP 프로그램과 동일한 탐색, 테스트 및 검증용)
+    pub fn classify(&self, saddr: u32, daddr: u32, protocol: u8,
+                    src_port: u16, dst_port: u16, tcp_flags: u8) -> Option<usize> {
+        if self.nrules == 0 {
+            return None;
+        }
+
+        let src = longest_match(&self.src_v4, saddr, 32, prefix_mask)?;
+        let dst = longest_match(&self.dst_v4, daddr, 32, prefix_mask)?;
+        self.classify_fields(src, dst, protocol, src_port, dst_port, tcp_flags)
+    }
+
+    /// L4 헤더가 없는 IPv4 조각 분류 (테스트 및 검증용)
+    pub fn classify_fragment(&self, saddr: u32, daddr: u32, protocol: u8) -> Option<usize> {
+        if self.nrules == 0 {
+            return None;
+        }
+
+        let src = longest_match(&self.src_v4, saddr, 32, prefix_mask)?;
+        let dst = longest_match(&self.dst_v4, daddr, 32, prefix_mask)?;
+        let proto = self.bitmaps.get(&(BM_PROTO_BASE + protocol as u32))?;
+        let flags = self.bitmaps.get(&(BM_TCP_FLAGS_BASE + TCP_FLAGS_FRAG))?;
+        let sport = self.bitmaps.get(&BM_SPORT_UNKNOWN)?;
+        let dport = self.bitmaps.get(&BM_DPORT_UNKNOWN)?;
+        first_set_bit(self.nwords, [src, dst, proto, flags, sport, dport])
+    }
+
+    /// IPv6 패킷 필드 분류 (테스트 및 검증용)
+    pub fn classify_v6(&self, saddr: u128, daddr: u128, protocol: u8,
+                       src_port: u16, dst_port: u16, tcp_flags: u8) -> Option<usize> {
+        if self.nrules == 0 {
+            return None;
+        }
+
+        let src = longest_match(&self.src_v6, saddr, 128, prefix_mask_v6)?;
+        let dst = longest_match(&self.dst_v6, daddr, 128, prefix_mask_v6)?;
+        self.classify_fields(src, dst, protocol, src_port, dst_port, tcp_flags)
+    }
+
+    /// 주소 이외 필드의 비트맵 교집합
+    fn classify_fields(&self, src: &RuleBitmap, dst: &RuleBitmap, protocol: u8,
+                       src_port: u16, dst_port: u16, tcp_flags: u8) -> Option<usize> {
+        let proto = self.bitmaps.get(&(BM_PROTO_BASE + protocol as u32))?;
+        let flags_idx = if protocol == PROTO_TCP { (tcp_flags & 0x3f) as u32 } else { TCP_FLAGS_NONE };
+        let flags = self.bitmaps.get(&(BM_TCP_FLAGS_BASE + flags_idx))?;
+        let sport_class = self.port_class[PC_SPORT_BASE as usize + src_port as usize];
+        let sport = self.bitmaps.get(&(BM_SPORT_BASE + sport_class))?;
+        let dport_class = self.port_class[PC_DPORT_BASE as usize + dst_port as usize];
+        let dport = self.bitmaps.get(&(BM_DPORT_BASE + dport_class))?;
+        first_set_bit(self.nwords, [src, dst, proto, flags, sport, dport])
+    }
+}
+
+/// 비트맵 교집합의 가장 낮은 설정 비트
+fn first_set_bit(nwords: u32, bitmaps: [&RuleBitmap; 6]) -> Option<usize> {
+    for i in 0..nwords as usize {
+        let w = bitmaps.iter().fold(u64::MAX, |acc, b| acc & b.words[i]);
+        if w != 0 {
+            return Some(i * 64 + w.trailing_zeros() as usize);
+        }
+    }
+
+    None
+}
+
+/// 최장 프리픽스 매치
+fn longest_match<A>(prefixes: &BTreeMap<(A, u32), RuleBitmap>, addr: A, width: u32,
+                    mask: fn(u32) -> A) -> Option<&RuleBitmap>
+where
+    A: Copy + Ord + BitAnd<Output = A>,
+{
+    (0..=width)
+        .rev()
+        .find_map(|len| prefixes.get(&(addr & mask(len), len)))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn rule(src_ip: Option<(u32, u32)>, dst_ip: Option<(u32, u32)>, protocol: u8) -> MatchFields {
+        MatchFields {
+            src_ip,
+            dst_ip,
+            src_ip6: None,
+            dst_ip6: None,
+            protocol,
+            src_port_min: 0,
+            src_port_max: 65535,
+            dst_port_min: 0,
+            dst_port_max: 65535,
+            tcp_flags: 0,
+        }
+    }
+
+    #[test]
+    fn test_cidr_prefix_match() {
+        let rules = vec![rule(Some((0x0A000000, 8)), None, PROTO_ANY)];
+        let cls = compile(&rules).unwrap();
+
+        assert_eq!(cls.classify(0x0A010203, 0xC0A80101, 17, 1000, 53, 0), Some(0));
+        assert_eq!(cls.classify(0x0B010203, 0xC0A80101, 17, 1000, 53, 0), None);
+    }
+
+    #[test]
+    fn test_overlapping_priority() {
+        // 0: 10.1.0.0/16 (우선), 1: 10.0.0.0/8
+        let rules = vec![
+            rule(Some((0x0A010000, 16)), None, PROTO_ANY),
+            rule(Some((0x0A000000, 8)), None, PROTO_ANY),
+        ];
+        let cls = compile(&rules).unwrap();
+
+        assert_eq!(cls.classify(0x0A010203, 0, 6, 1, 2, 0), Some(0));
+        assert_eq!(cls.classify(0x0A020203, 0, 6, 1, 2, 0), Some(1));
+
+        // 우선순위가 넓은 프리픽스에 있으면 넓은 규칙이 선택됨
+        let rules = vec![
+            rule(Some((0x0A000000, 8)), None, PROTO_ANY),
+            rule(Some((0x0A010000, 16)), None, PROTO_ANY),
+        ];
+        let cls = compile(&rules).unwrap();
+        assert_eq!(cls.classify(0x0A010203, 0, 6, 1, 2, 0), Some(0));
+    }
+
+    #[test]
+    fn test_dst_and_protocol() {
+        let rules = vec![
+            rule(None, Some((0xC0A80100, 24)), 6),
+            rule(None, None, 17),
+        ];
+        let cls = compile(&rules).unwrap();
+
+        assert_eq!(cls.classify(1, 0xC0A80105, 6, 1, 80, 0), Some(0));
+        assert_eq!(cls.classify(1, 0xC0A80205, 6, 1, 80, 0), None);
+        assert_eq!(cls.classify(1, 0xC0A80105, 17, 1, 80, 0), Some(1));
+    }
+
+    #[test]
+    fn test_port_ranges() {
+        let mut r0 = rule(None, None, 6);
+        r0.dst_port_min = 80;
+        r0.dst_port_max = 80;
+        let mut r1 = rule(None, None, 6);
+        r1.dst_port_min = 1;
+        r1.dst_port_max = 1023;
+        let mut r2 = rule(None, None, 6);
+        r2.src_port_min = 1024;
+        r2.src_port_max = 2048;
+        let cls = compile(&[r0, r1, r2]).unwrap();
+
+        assert_eq!(cls.classify(1, 2, 6, 5000, 80, 0), Some(0));
+        assert_eq!(cls.classify(1, 2, 6, 5000, 443, 0), Some(1));
+        assert_eq!(cls.classify(1, 2, 6, 5000, 8080, 0), None);
+        assert_eq!(cls.classify(1, 2, 6, 2048, 8080, 0), Some(2));
+        assert_eq!(cls.classify(1, 2, 6, 2049, 8080, 0), None);
+    }
+
+    #[test]
+    fn test_tcp_flags() {
+        let mut syn = rule(None, None, PROTO_ANY);
+        syn.tcp_flags = 0x02;
+        let cls = compile(&[syn]).unwrap();
+
+        assert_eq!(cls.classify(1, 2, 6, 1, 2, 0x02), Some(0));
+        assert_eq!(cls.classify(1, 2, 6, 1, 2, 0x12), Some(0));
+        assert_eq!(cls.classify(1, 2, 6, 1, 2, 0x10), None);
+        // TCP가 아닌 패킷은 플래그 조건 무시
+        assert_eq!(cls.classify(1, 2, 17, 1, 2, 0), Some(0));
+    }
+
+    #[test]
+    fn test_ipv6_and_family() {
+        let mut v6 = rule(None, None, 6);
+        v6.src_ip6 = Some((0x2001_0db8_u128 << 96, 32));
+        let v4 = rule(Some((0x0A000000, 8)), None, 6);
+        let any = rule(None, None, 17);
+        let cls = compile(&[v6, v4, any]).unwrap();
+
+        let addr6 = (0x2001_0db8_u128 << 96) | 1;
+        assert_eq!(cls.classify_v6(addr6, 1, 6, 1, 2, 0), Some(0));
+        assert_eq!(cls.classify_v6(1, 1, 6, 1, 2, 0), None);
+        // IPv4 규칙은 IPv6 패킷에 매치되지 않고, 주소 조건 없는 규칙은 양쪽 모두 매치
+        assert_eq!(cls.classify_v6(1, 1, 17, 1, 2, 0), Some(2));
+        assert_eq!(cls.classify(0x0A000001, 1, 6, 1, 2, 0), Some(1));
+        assert_eq!(cls.classify(0x0B000001, 1, 17, 1, 2, 0), Some(2));
+    }
+
+    #[test]
+    fn test_fragments() {
+        // 0: 포트 조건 있는 드롭, 1: 포트/플래그 조건 없는 규칙
+        let mut ports = rule(None, None, 6);
+        ports.dst_port_min = 80;
+        ports.dst_port_max = 80;
+        let mut syn = rule(None, None, 6);
+        syn.tcp_flags = 0x02;
+        let any = rule(Some((0x0A000000, 8)), None, 6);
+        let cls = compile(&[ports, syn, any]).unwrap();
+
+        assert_eq!(cls.classify(0x0A000001, 2, 6, 1, 80, 0), Some(0));
+        // 조각은 포트/플래그 조건 규칙을 건너뜀
+        assert_eq!(cls.classify_fragment(0x0A000001, 2, 6), Some(2));
+        assert_eq!(cls.classify_fragment(0x0B000001, 2, 6), None);
+    }
+
+    #[test]
+    fn test_empty_and_limits() {
+        let cls = compile(&[]).unwrap();
+        assert_eq!(cls.nwords, 0);
+        assert_eq!(cls.classify(1, 2, 6, 1, 2, 0), None);
+
+        let rules = vec![rule(None, None, PROTO_ANY); MAX_FILTER_RULES + 1];
+        assert!(compile(&rules).is_err());
+    }
+}
@@ -4,6 +4,7 @@
 use anyhow::{anyhow, Context, Result};
 use log::{debug, error, info, warn};
 use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
 use std::fs::File;
 use std::io::Read;
 use std::path::Path;
@@ -17,6 +18,71 @@ pub struct DaemonConfig {
     pub telemetry: TelemetryConfig,
     /// WASM 구성
     pub wasm: WasmConfig,
+    /// 샘플 이벤트 구성
+    #[serde(default)]
+    pub events: EventsConfig,
+    /// XDP 데이터 경로 구성
+    #[serde(default)]
+    pub xdp: XdpConfig,
+    /// 시작 시 연결할 인터페이스 (항목이 모두 주석이면 null)
+    #[serde(default)]
+    pub interfaces: Option<Vec<InterfaceConfig>>,
+    /// 시작 시 불러올 소스 프리픽스 블록리스트
+    #[serde(default)]
+    pub blocklists: Vec<BlocklistConfig>,
+}
+
+/// 소스 프리픽스 블록리스트 (한 줄에 프리픽스 하나인 파일)
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct BlocklistConfig {
+    /// 블록리스트 이름 (통계 레이블)
+    pub name: String,
+    /// 프리픽스 파일 경로
+    pub path: String,
+}
+
+/// 시작 시 연결할 인터페이스
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct InterfaceConfig {
+    /// 인터페이스 이름
+    pub name: String,
+    /// 연결 모드 (driver, generic, offload - 실패하면 낮은 모드로)
+    #[serde(default = "default_xdp_mode")]
+    pub mode: String,
+    /// 연결 여부
+    #[serde(default = "default_true")]
+    pub enabled: bool,
+}
+
+fn default_xdp_mode() -> String {
+    "driver".to_string()
+}
+
+fn default_true() -> bool {
+    true
+}
+
+/// XDP 데이터 경로 구성
+#[derive(Debug, Clone, Default, Deserialize, Serialize)]
+pub struct XdpConfig {
+    /// 테일 콜 파이프라인 진입점 연결 (false면 단일 프로그램)
+    #[serde(default)]
+    pub pipeline: bool,
+    /// 규칙이 쓰는 기능 (지정하면 이를 모두 포함하는 가장 작은 특화 오브젝트 로드)
+    #[serde(default)]
+    pub features: Option<Vec<String>>,
+    /// libxdp 디스패처로 연결해 다른 XDP 프로그램과 공존 (libxdp 기능 빌드 필요)
+    #[serde(default)]
+    pub multiprog: bool,
+    /// 맵과 XDP 링크를 고정할 bpffs 디렉터리 (지정하면 재시작해도 규칙과 카운터 유지)
+    #[serde(default)]
+    pub pin_path: Option<String>,
+    /// 맵 이름별 최대 항목 수 (blocklist_v4, blocklist_v6, flow_cache, src_buckets, synproxy_flows)
+    #[serde(default)]
+    pub map_sizes: HashMap<String, u32>,
+    /// BPF 맵 메모리 예산 (MiB, 맵이 가득 찼을 때의 추정치가 넘으면 시작 실패)
+    #[serde(default)]
+    pub memory_budget_mb: Option<u64>,
 }
 
 /// 일반 구성
@@ -41,6 +107,101 @@ pub struct TelemetryConfig {
     pub export_enabled: bool,
     /// 내보내기 URL
     pub export_url: Option<String>,
+    /// 소스별 헤비 히터 탐지
+    #[serde(default)]
+    pub heavy_hitters: HeavyHitterConfig,
+}
+
+/// 소스별 헤비 히터 탐지 구성 (IPv4 소스 주소, 수집 간격마다 집계)
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct HeavyHitterConfig {
+    /// 데이터 경로 스케치 갱신 활성화
+    #[serde(default)]
+    pub enabled: bool,
+    /// 보고할 상위 소스 수
+    #[serde(default = "default_hh_top_k")]
+    pub top_k: usize,
+    /// 자동 규칙 설치 기준 (초당 패킷 수, 0이면 보고만)
+    #[serde(default)]
+    pub threshold_pps: u64,
+    /// 기준을 넘은 소스에 설치할 규칙 ("drop" 또는 "rate-limit")
+    #[serde(default = "default_hh_action")]
+    pub action: String,
+    /// rate-limit 규칙의 초당 패킷 수
+    #[serde(default)]
+    pub rate_limit: u32,
+    /// 자동 설치 규칙의 만료 시간 (초)
+    #[serde(default = "default_hh_expire")]
+    pub expire: u32,
+}
+
+impl Default for HeavyHitterConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            top_k: default_hh_top_k(),
+            threshold_pps: 0,
+            action: default_hh_action(),
+            rate_limit: 0,
+            expire: default_hh_expire(),
+        }
+    }
+}
+
+fn default_hh_top_k() -> usize {
+    10
+}
+
+fn default_hh_action() -> String {
+    "drop".to_string()
+}
+
+fn default_hh_expire() -> u32 {
+    300
+}
+
+/// 샘플 이벤트 구성 (sample_rate가 설정된 규칙의 패킷 헤더)
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct EventsConfig {
+    /// 이벤트 소비 활성화
+    #[serde(default)]
+    pub enabled: bool,
+    /// 이벤트를 추가 기록할 파일 (JSON lines)
+    #[serde(default = "default_events_path")]
+    pub path: String,
+    /// 로드된 WASM 모듈로 샘플 헤더 검사
+    #[serde(default)]
+    pub inspect_with_wasm: bool,
+    /// 한 번에 기록할 이벤트 수
+    #[serde(default = "default_events_batch_size")]
+    pub batch_size: usize,
+    /// 이벤트가 버퍼에 머무는 최대 시간 (밀리초)
+    #[serde(default = "default_events_flush_interval_ms")]
+    pub flush_interval_ms: u64,
+}
+
+impl Default for EventsConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            path: default_events_path(),
+            inspect_with_wasm: false,
+            batch_size: default_events_batch_size(),
+            flush_interval_ms: default_events_flush_interval_ms(),
+        }
+    }
+}
+
+fn default_events_path() -> String {
+    "/var/log/swift-guard/events.jsonl".to_string()
+}
+
+fn default_events_batch_size() -> usize {
+    256
+}
+
+fn default_events_flush_interval_ms() -> u64 {
+    1000
 }
 
 /// WASM 구성
@@ -52,6 +213,79 @@ pub struct WasmConfig {
     pub auto_load: bool,
     /// 자동 로드 모듈 목록
     pub auto_load_modules: Vec<String>,
+    /// 게스트 호출 한 번(배치 하나)의 실행 시간 한도 (밀리초)
+    #[serde(default = "default_execution_timeout_ms")]
+    pub execution_timeout_ms: u64,
+    /// 인스턴스당 선형 메모리 한도 (MB, AF_XDP UMEM은 별도)
+    #[serde(default = "default_memory_limit_mb")]
+    pub memory_limit_mb: u64,
+    /// 한도를 넘거나 트랩이 발생한 패킷의 판정
+    #[serde(default)]
+    pub timeout_policy: TimeoutPolicy,
+    /// AF_XDP 검사 경로 (redirect-xsk 액션, 없으면 비활성)
+    #[serde(default)]
+    pub xsk: Option<XskConfig>,
+}
+
+/// 실행 한도 초과 시 판정
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Deserialize, Serialize)]
+#[serde(rename_all = "kebab-case")]
+pub enum TimeoutPolicy {
+    /// 통과 (가용성 우선)
+    FailOpen,
+    /// 차단 (보안 우선)
+    FailClosed,
+}
+
+impl Default for TimeoutPolicy {
+    fn default() -> Self {
+        TimeoutPolicy::FailOpen
+    }
+}
+
+fn default_execution_timeout_ms() -> u64 {
+    10
+}
+
+fn default_memory_limit_mb() -> u64 {
+    32
+}
+
+/// AF_XDP 검사 경로 구성
+#[derive(Debug, Clone, Deserialize, Serialize)]
+pub struct XskConfig {
+    /// UMEM을 소유하고 프레임을 검사할 모듈 (modules_dir 기준 파일 이름)
+    pub module: String,
+    /// 바인드할 수신 큐 번호
+    #[serde(default)]
+    pub queue_id: u32,
+    /// 워커를 둘 수신 큐 목록 (비어 있으면 queue_id 하나, 큐마다 인스턴스/UMEM 하나)
+    #[serde(default)]
+    pub queues: Vec<u32>,
+    /// 큐별로 고정할 CPU (queues와 같은 순서, 없으면 큐 번호와 같은 CPU)
+    #[serde(default)]
+    pub cpus: Vec<usize>,
+    /// UMEM 프레임 수
+    #[serde(default = "default_xsk_frame_count")]
+    pub frame_count: u32,
+    /// UMEM 프레임 크기 (2048 또는 4096)
+    #[serde(default = "default_xsk_frame_size")]
+    pub frame_size: u32,
+    /// 링 크기 (2의 거듭제곱)
+    #[serde(default = "default_xsk_ring_size")]
+    pub ring_size: u32,
+}
+
+fn default_xsk_frame_count() -> u32 {
+    4096
+}
+
+fn default_xsk_frame_size() -> u32 {
+    2048
+}
+
+fn default_xsk_ring_size() -> u32 {
+    2048
 }
 
 impl Default for DaemonConfig {
@@ -67,12 +301,21 @@ impl Default for DaemonConfig {
                 interval: 10,
                 export_enabled: false,
                 export_url: None,
+                heavy_hitters: HeavyHitterConfig::default(),
             },
             wasm: WasmConfig {
                 modules_dir: "/usr/local/lib/swift-guard/wasm".to_string(),
                 auto_load: false,
                 auto_load_modules: Vec::new(),
+                execution_timeout_ms: default_execution_timeout_ms(),
+                memory_limit_mb: default_memory_limit_mb(),
+                timeout_policy: TimeoutPolicy::default(),
+                xsk: None,
             },
+            events: EventsConfig::default(),
+            xdp: XdpConfig::default(),
+            interfaces: None,
+            blocklists: Vec::new(),
         }
     }
 }
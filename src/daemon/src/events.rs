@@ -0,0 +1,366 @@
+//! 샘플 이벤트 소비 모듈
+//! events 링 버퍼의 샘플링된 패킷 헤더를 모아 파일에 기록하고 WASM 모듈로 검사
+
+use anyhow::{anyhow, Context, Result};
+use libbpf_rs::Map;
+use log::{debug, error, info, warn};
+use serde::Serialize;
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Write};
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+
+use crate::abi;
+use crate::config::EventsConfig;
+use crate::maps::{self, SharedSnapshot};
+use crate::wasm::WasmManager;
+
+/// 캡처되는 패킷 앞부분 길이
+pub const EVENT_SNAP_LEN: usize = abi::EVENT_SNAP_LEN as usize;
+
+/// struct packet_event 크기
+pub const PACKET_EVENT_SIZE: usize = std::mem::size_of::<abi::packet_event>();
+
+/// 링 버퍼 확인 간격 (데이터 경로가 깨우지 않으므로 주기적으로 소비)
+const POLL_INTERVAL: Duration = Duration::from_millis(100);
+
+/// 샘플링된 패킷 이벤트 (struct packet_event)
+#[derive(Debug, Clone, Copy)]
+pub struct PacketEvent {
+    pub timestamp_ns: u64,
+    pub rule_id: u32,
+    pub ifindex: u32,
+    pub queue: u32,
+    pub pkt_len: u32,
+    pub verdict: u8,
+    pub action: u8,
+    pub snap_len: u16,
+    pub data: [u8; EVENT_SNAP_LEN],
+}
+
+impl PacketEvent {
+    /// 링 버퍼 레코드 파싱
+    pub fn parse(record: &[u8]) -> Option<Self> {
+        let event: abi::packet_event = abi::from_bytes(record)?;
+
+        Some(Self {
+            timestamp_ns: event.timestamp_ns,
+            rule_id: event.rule_id,
+            ifindex: event.ifindex,
+            queue: event.queue,
+            pkt_len: event.pkt_len,
+            verdict: event.verdict,
+            action: event.action,
+            snap_len: event.snap_len.min(EVENT_SNAP_LEN as u16),
+            data: event.data,
+        })
+    }
+
+    /// 캡처된 헤더 바이트
+    pub fn header(&self) -> &[u8] {
+        &self.data[..self.snap_len as usize]
+    }
+}
+
+/// XDP 반환값 이름
+fn verdict_name(verdict: u8) -> &'static str {
+    match verdict {
+        0 => "aborted",
+        1 => "drop",
+        2 => "pass",
+        3 => "tx",
+        4 => "redirect",
+        _ => "unknown",
+    }
+}
+
+/// 파일에 기록되는 이벤트 한 줄
+#[derive(Serialize)]
+struct EventRecord<'a> {
+    /// UNIX 시간 (ns)
+    timestamp_ns: u64,
+    rule_id: u32,
+    rule: &'a str,
+    verdict: &'static str,
+    ifindex: u32,
+    queue: u32,
+    pkt_len: u32,
+    /// 캡처된 헤더 (16진수)
+    data: &'a str,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    wasm_blocked: Option<bool>,
+}
+
+/// libbpf 링 버퍼 (콜백 상태와 함께 소비 스레드로 이동)
+struct RingBuffer {
+    ring: *mut libbpf_sys::ring_buffer,
+    /// 콜백이 이벤트를 쌓는 버퍼 (주소가 콜백 컨텍스트로 등록되므로 Box로 고정)
+    batch: Box<Vec<PacketEvent>>,
+}
+
+// 링 버퍼는 소비 스레드 하나에서만 사용
+unsafe impl Send for RingBuffer {}
+
+impl RingBuffer {
+    fn new(map: &Map, capacity: usize) -> Result<Self> {
+        let mut batch = Box::new(Vec::with_capacity(capacity));
+        let ctx = &mut *batch as *mut Vec<PacketEvent> as *mut libc::c_void;
+
+        let ring = unsafe {
+            libbpf_sys::ring_buffer__new(map.fd(), Some(on_event), ctx, std::ptr::null())
+        };
+        if ring.is_null() {
+            return Err(anyhow!(
+                "Failed to create ring buffer for {}: {}",
+                map.name(),
+                std::io::Error::last_os_error()
+            ));
+        }
+
+        Ok(Self { ring, batch })
+    }
+
+    /// 대기 중인 레코드를 모두 batch로 옮김
+    fn consume(&mut self) -> Result<()> {
+        let ret = unsafe { libbpf_sys::ring_buffer__consume(self.ring) };
+        if ret < 0 {
+            return Err(anyhow!(
+                "ring_buffer__consume failed: {}",
+                std::io::Error::from_raw_os_error(-ret)
+            ));
+        }
+
+        Ok(())
+    }
+}
+
+impl Drop for RingBuffer {
+    fn drop(&mut self) {
+        unsafe { libbpf_sys::ring_buffer__free(self.ring) };
+    }
+}
+
+/// 링 버퍼 레코드 콜백 (ctx = Vec<PacketEvent>)
+unsafe extern "C" fn on_event(ctx: *mut libc::c_void, data: *mut libc::c_void, size: libbpf_sys::size_t) -> libc::c_int {
+    let batch = &mut *(ctx as *mut Vec<PacketEvent>);
+    let record = std::slice::from_raw_parts(data as *const u8, size as usize);
+
+    if let Some(event) = PacketEvent::parse(record) {
+        batch.push(event);
+    }
+
+    0
+}
+
+/// 이벤트 기록 대상
+struct EventSink {
+    writer: BufWriter<File>,
+    rules: Arc<SharedSnapshot>,
+    wasm: Option<WasmManager>,
+    /// 16진수 변환 버퍼 (이벤트마다 재사용)
+    hex: String,
+    written: u64,
+}
+
+impl EventSink {
+    fn open(config: &EventsConfig, rules: Arc<SharedSnapshot>, wasm: Option<WasmManager>) -> Result<Self> {
+        let path = Path::new(&config.path);
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent)
+                .with_context(|| format!("Failed to create directory: {}", parent.display()))?;
+        }
+
+        let file = OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(path)
+            .with_context(|| format!("Failed to open event log {}", path.display()))?;
+
+        Ok(Self {
+            writer: BufWriter::new(file),
+            rules,
+            wasm,
+            hex: String::with_capacity(EVENT_SNAP_LEN * 2),
+            written: 0,
+        })
+    }
+
+    /// 모인 이벤트를 한 번에 기록하고 비움
+    fn flush(&mut self, batch: &mut Vec<PacketEvent>) -> Result<()> {
+        if batch.is_empty() {
+            return Ok(());
+        }
+
+        // 레이블 조회용 표는 배치마다 한 번 구성
+        let snapshot = self.rules.load();
+        let mut labels = Vec::new();
+        for (rule_id, rule) in &snapshot.rules {
+            let index = *rule_id as usize;
+            if labels.len() <= index {
+                labels.resize(index + 1, "");
+            }
+            labels[index] = rule.label.as_str();
+        }
+        let boot_offset = maps::monotonic_to_unix_offset_ns();
+
+        for event in batch.iter() {
+            let wasm_blocked = match &self.wasm {
+                Some(wasm) if event.snap_len > 0 => match wasm.inspect_packet(event.header()) {
+                    Ok(blocked) => Some(blocked),
+                    Err(e) => {
+                        debug!("WASM inspection of sampled event failed: {}", e);
+                        None
+                    }
+                },
+                _ => None,
+            };
+
+            self.hex.clear();
+            for byte in event.header() {
+                self.hex.push(char::from_digit((byte >> 4) as u32, 16).unwrap_or('0'));
+                self.hex.push(char::from_digit((byte & 0x0f) as u32, 16).unwrap_or('0'));
+            }
+
+            let record = EventRecord {
+                timestamp_ns: event.timestamp_ns + boot_offset,
+                rule_id: event.rule_id,
+                rule: labels.get(event.rule_id as usize).copied().unwrap_or(""),
+                verdict: verdict_name(event.verdict),
+                ifindex: event.ifindex,
+                queue: event.queue,
+                pkt_len: event.pkt_len,
+                data: &self.hex,
+                wasm_blocked,
+            };
+            serde_json::to_writer(&mut self.writer, &record)
+                .context("Failed to serialize event")?;
+            self.writer.write_all(b"\n")?;
+        }
+
+        self.writer.flush().context("Failed to write event log")?;
+        self.written += batch.len() as u64;
+        batch.clear();
+
+        Ok(())
+    }
+}
+
+/// 실행 중인 이벤트 소비 스레드
+#[derive(Debug)]
+pub struct EventConsumer {
+    stop: Arc<AtomicBool>,
+    handle: Option<JoinHandle<()>>,
+}
+
+impl EventConsumer {
+    /// events 링 버퍼 소비 시작
+    ///
+    /// 이벤트는 batch_size개가 모이거나 flush_interval_ms가 지나면 한 번에 기록한다.
+    pub fn start(
+        events_map: &Map,
+        config: &EventsConfig,
+        rules: Arc<SharedSnapshot>,
+        wasm: Option<WasmManager>,
+    ) -> Result<Self> {
+        let batch_size = config.batch_size.max(1);
+        let flush_interval = Duration::from_millis(config.flush_interval_ms.max(1));
+
+        let mut ring = RingBuffer::new(events_map, batch_size)?;
+        let mut sink = EventSink::open(config, rules, wasm)?;
+
+        let stop = Arc::new(AtomicBool::new(false));
+        let thread_stop = stop.clone();
+        let handle = std::thread::Builder::new()
+            .name("events".to_string())
+            .spawn(move || {
+                let mut last_flush = Instant::now();
+                let mut failed = false;
+
+                loop {
+                    let stopping = thread_stop.load(Ordering::Relaxed);
+                    if !stopping {
+                        std::thread::sleep(POLL_INTERVAL.min(flush_interval));
+                    }
+
+                    if let Err(e) = ring.consume() {
+                        warn!("Failed to consume sampled events: {}", e);
+                    }
+
+                    if stopping || ring.batch.len() >= batch_size || last_flush.elapsed() >= flush_interval {
+                        match sink.flush(&mut ring.batch) {
+                            Ok(()) => failed = false,
+                            Err(e) => {
+                                // 기록 실패가 이어지면 버퍼가 무한히 자라지 않도록 버림
+                                if !failed {
+                                    error!("Failed to write sampled events: {}", e);
+                                }
+                                failed = true;
+                                ring.batch.clear();
+                            }
+                        }
+                        last_flush = Instant::now();
+                    }
+
+                    if stopping {
+                        break;
+                    }
+                }
+
+                info!("Event consumer stopped after writing {} events", sink.written);
+            })?;
+
+        info!("Consuming sampled events into {}", config.path);
+
+        Ok(Self {
+            stop,
+            handle: Some(handle),
+        })
+    }
+
+    /// 남은 이벤트를 기록하고 정지
+    pub fn shutdown(&mut self) {
+        self.stop.store(true, Ordering::Relaxed);
+        if let Some(handle) = self.handle.take() {
+            let _ = handle.join();
+        }
+    }
+}
+
+impl Drop for EventConsumer {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_event() {
+        let mut value = abi::packet_event {
+            timestamp_ns: 42,
+            rule_id: 7,
+            queue: 3,
+            pkt_len: 1500,
+            verdict: 1,
+            snap_len: 4,
+            ..Default::default()
+        };
+        value.data[..4].copy_from_slice(&[0xde, 0xad, 0xbe, 0xef]);
+        let record = abi::as_bytes(&value);
+
+        let event = PacketEvent::parse(record).unwrap();
+        assert_eq!(event.timestamp_ns, 42);
+        assert_eq!(event.rule_id, 7);
+        assert_eq!(event.queue, 3);
+        assert_eq!(event.pkt_len, 1500);
+        assert_eq!(verdict_name(event.verdict), "drop");
+        assert_eq!(event.header(), &[0xde, 0xad, 0xbe, 0xef]);
+
+        assert!(PacketEvent::parse(&record[..PACKET_EVENT_SIZE - 1]).is_none());
+    }
+}
@@ -0,0 +1,219 @@
+//! 정책 특화 XDP 프로그램 변형 모듈
+//! 규칙이 쓰는 매치 필드/기능 비트마스크와 src/bpf/Makefile이 빌드하는 변형 오브젝트 선택
+
+use anyhow::{anyhow, Result};
+use std::fmt;
+use std::path::{Path, PathBuf};
+
+use crate::abi;
+use crate::maps::FilterRule;
+
+// 기능 비트 (SG_F_*)
+pub const FEATURE_SRC_ADDR: u32 = abi::SG_F_SRC_ADDR;
+pub const FEATURE_DST_ADDR: u32 = abi::SG_F_DST_ADDR;
+pub const FEATURE_PROTO: u32 = abi::SG_F_PROTO;
+pub const FEATURE_PORTS: u32 = abi::SG_F_PORTS;
+pub const FEATURE_TCP_FLAGS: u32 = abi::SG_F_TCP_FLAGS;
+pub const FEATURE_EXPIRE: u32 = abi::SG_F_EXPIRE;
+pub const FEATURE_RATE_LIMIT: u32 = abi::SG_F_RATE_LIMIT;
+pub const FEATURE_SAMPLE: u32 = abi::SG_F_SAMPLE;
+pub const FEATURE_REDIRECT: u32 = abi::SG_F_REDIRECT;
+pub const FEATURE_SYNPROXY: u32 = abi::SG_F_SYNPROXY;
+pub const FEATURE_ALL: u32 = abi::SG_F_ALL;
+
+/// 구성 파일의 기능 이름
+const FEATURE_NAMES: &[(&str, u32)] = &[
+    ("src_addr", FEATURE_SRC_ADDR),
+    ("dst_addr", FEATURE_DST_ADDR),
+    ("protocol", FEATURE_PROTO),
+    ("ports", FEATURE_PORTS),
+    ("tcp_flags", FEATURE_TCP_FLAGS),
+    ("expire", FEATURE_EXPIRE),
+    ("rate_limit", FEATURE_RATE_LIMIT),
+    ("sample", FEATURE_SAMPLE),
+    ("redirect", FEATURE_REDIRECT),
+    ("synproxy", FEATURE_SYNPROXY),
+];
+
+/// src/bpf/Makefile의 특화 변형 (xdp_filter-<이름>.o, SG_FEATURES와 동일하게 유지)
+const VARIANTS: &[(&str, u32)] = &[
+    ("src", FEATURE_SRC_ADDR),
+    ("addr", FEATURE_SRC_ADDR | FEATURE_DST_ADDR | FEATURE_PROTO),
+    ("match", FEATURE_SRC_ADDR | FEATURE_DST_ADDR | FEATURE_PROTO | FEATURE_PORTS
+        | FEATURE_TCP_FLAGS | FEATURE_EXPIRE),
+];
+
+/// XDP 프로그램 기능 집합
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Features(u32);
+
+impl Features {
+    /// 특화되지 않은 전체 프로그램
+    pub const ALL: Features = Features(FEATURE_ALL);
+
+    /// 규칙 하나가 데이터 경로에서 쓰는 기능
+    pub fn required(rule: &FilterRule) -> Self {
+        let mut bits = 0;
+
+        if rule.src_ip.is_some() || rule.src_ip6.is_some() {
+            bits |= FEATURE_SRC_ADDR;
+        }
+        if rule.dst_ip.is_some() || rule.dst_ip6.is_some() {
+            bits |= FEATURE_DST_ADDR;
+        }
+        if rule.protocol != 255 {
+            bits |= FEATURE_PROTO;
+        }
+        if rule.src_port_min != 0 || rule.src_port_max != 65535
+            || rule.dst_port_min != 0 || rule.dst_port_max != 65535 {
+            bits |= FEATURE_PORTS;
+        }
+        if rule.tcp_flags != 0 {
+            bits |= FEATURE_TCP_FLAGS;
+        }
+        if rule.expire > 0 {
+            bits |= FEATURE_EXPIRE;
+        }
+        if rule.rate_limit > 0 {
+            bits |= FEATURE_RATE_LIMIT;
+        }
+        if rule.sample_rate > 0 {
+            bits |= FEATURE_SAMPLE;
+        }
+        if matches!(rule.action, 3 | 5 | 6) {
+            bits |= FEATURE_REDIRECT;
+        }
+        if rule.action == 7 {
+            bits |= FEATURE_SYNPROXY;
+        }
+
+        Features(bits)
+    }
+
+    /// 구성 파일의 기능 이름 목록 파싱
+    pub fn parse(names: &[String]) -> Result<Self> {
+        let mut bits = 0;
+
+        for name in names {
+            let (_, bit) = FEATURE_NAMES.iter()
+                .find(|(n, _)| *n == name.as_str())
+                .ok_or_else(|| anyhow!("Unknown XDP feature: {}", name))?;
+            bits |= bit;
+        }
+
+        Ok(Features(bits))
+    }
+
+    /// 오브젝트 파일 이름에서 기능 집합 결정 (변형이 아니면 전체)
+    pub fn of_object(path: &Path) -> Self {
+        let stem = path.file_stem().and_then(|s| s.to_str()).unwrap_or("");
+
+        stem.rsplit_once('-')
+            .and_then(|(_, suffix)| VARIANTS.iter().find(|(name, _)| *name == suffix))
+            .map(|(_, bits)| Features(*bits))
+            .unwrap_or(Self::ALL)
+    }
+
+    pub fn contains(self, other: Features) -> bool {
+        self.0 & other.0 == other.0
+    }
+
+    /// 규칙이 이 기능 집합으로 처리될 수 있는지 확인
+    pub fn check(self, rule: &FilterRule) -> Result<()> {
+        let missing = Features(Self::required(rule).0 & !self.0);
+        if missing.0 != 0 {
+            return Err(anyhow!(
+                "Rule {} uses {} which the loaded XDP program ({}) was built without",
+                rule.label, missing, self
+            ));
+        }
+        Ok(())
+    }
+}
+
+impl fmt::Display for Features {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        if *self == Self::ALL {
+            return write!(f, "all");
+        }
+
+        let names: Vec<&str> = FEATURE_NAMES.iter()
+            .filter(|(_, bit)| self.0 & bit != 0)
+            .map(|(name, _)| *name)
+            .collect();
+        if names.is_empty() {
+            write!(f, "none")
+        } else {
+            write!(f, "{}", names.join(","))
+        }
+    }
+}
+
+/// needed를 모두 포함하는 가장 작은 변형 오브젝트 (base와 같은 디렉터리, 없으면 base)
+pub fn select_object(base: &Path, needed: Features) -> PathBuf {
+    let stem = base.file_stem().and_then(|s| s.to_str()).unwrap_or("xdp_filter");
+
+    VARIANTS.iter()
+        .filter(|(_, bits)| Features(*bits).contains(needed))
+        .map(|(name, bits)| (base.with_file_name(format!("{}-{}.o", stem, name)), bits.count_ones()))
+        .filter(|(path, _)| path.exists())
+        .min_by_key(|(_, size)| *size)
+        .map(|(path, _)| path)
+        .unwrap_or_else(|| base.to_path_buf())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn rule() -> FilterRule {
+        FilterRule {
+            src_ip: Some((0xC0A80000, 16)),
+            dst_ip: None,
+            src_ip6: None,
+            dst_ip6: None,
+            src_port_min: 0,
+            src_port_max: 65535,
+            dst_port_min: 0,
+            dst_port_max: 65535,
+            protocol: 255,
+            tcp_flags: 0,
+            action: 2,
+            redirect_ifindex: 0,
+            redirect_cpu: 0,
+            priority: 0,
+            rate_limit: 0,
+            rate_limit_per_source: false,
+            sample_rate: 0,
+            expire: 0,
+            label: "test".to_string(),
+            creation_time: 0,
+            expire_deadline_ns: 0,
+        }
+    }
+
+    #[test]
+    fn test_required_features() {
+        // 소스 프리픽스 드롭 규칙은 소스 변형으로 처리 가능
+        let drop = rule();
+        let src = Features::of_object(Path::new("/usr/lib/swift-guard/xdp_filter-src.o"));
+        assert_eq!(Features::required(&drop), Features(FEATURE_SRC_ADDR));
+        assert!(src.check(&drop).is_ok());
+
+        let mut http = rule();
+        http.protocol = 6;
+        http.dst_port_min = 80;
+        http.dst_port_max = 80;
+        assert!(src.check(&http).is_err());
+        assert!(Features::of_object(Path::new("xdp_filter-match.o")).check(&http).is_ok());
+
+        let mut redirect = rule();
+        redirect.action = 5;
+        assert_eq!(Features::of_object(Path::new("xdp_filter.o")), Features::ALL);
+        assert!(Features::ALL.check(&redirect).is_ok());
+        assert_eq!(Features::required(&redirect).to_string(), "src_addr,redirect");
+
+        assert!(Features::parse(&["src_addr".to_string(), "ports".to_string()]).is_ok());
+        assert!(Features::parse(&["vlan".to_string()]).is_err());
+    }
+}
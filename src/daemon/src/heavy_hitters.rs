@@ -0,0 +1,137 @@
+//! 소스별 헤비 히터 탐지 모듈
+//! 데이터 경로의 CPU별 count-min 스케치와 top-K 후보 표를 합산해 상위 소스 추정
+
+use std::net::Ipv4Addr;
+
+use crate::abi;
+
+// 스케치 크기
+pub const HH_DEPTH: usize = abi::HH_DEPTH as usize;
+pub const HH_WIDTH_BITS: u32 = abi::HH_WIDTH_BITS;
+pub const HH_WIDTH: usize = abi::HH_WIDTH as usize;
+pub const HH_TOPK: usize = abi::HH_TOPK as usize;
+pub const HH_SLOTS: usize = abi::HH_SLOTS as usize;
+
+/// 행별 곱셈-시프트 해시 상수 (xdp_filter.c의 HH_ROW 호출과 동일)
+const ROW_MULTIPLIERS: [u32; HH_DEPTH] = [0x9E3779B1, 0x85EBCA77, 0xC2B2AE3D, 0x27D4EB2F];
+
+/// 주소(네트워크 바이트 순서 그대로 읽은 u32)의 행 row 카운터 위치
+pub fn bucket(addr: u32, row: usize) -> usize {
+    (addr.wrapping_mul(ROW_MULTIPLIERS[row]) >> (32 - HH_WIDTH_BITS)) as usize & (HH_WIDTH - 1)
+}
+
+/// 수집 구간 하나의 상위 소스
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct HeavyHitter {
+    pub addr: Ipv4Addr,
+    /// 구간 동안의 패킷 수 추정치 (과대 추정만 가능)
+    pub packets: u64,
+    pub packets_per_sec: u64,
+}
+
+/// CPU별 스케치의 합계와 후보 주소 (버퍼는 수집마다 재사용)
+#[derive(Debug)]
+pub struct SketchMerger {
+    counts: Vec<u64>,
+    candidates: Vec<u32>,
+}
+
+impl SketchMerger {
+    pub fn new() -> Self {
+        Self {
+            counts: vec![0; HH_DEPTH * HH_WIDTH],
+            candidates: Vec::with_capacity(HH_TOPK),
+        }
+    }
+
+    pub fn clear(&mut self) {
+        self.counts.fill(0);
+        self.candidates.clear();
+    }
+
+    /// CPU 하나의 hh_sketch 값 합산
+    pub fn add_sketch(&mut self, value: &abi::hh_sketch) {
+        for (total, counter) in self.counts.iter_mut().zip(value.counts.iter().flatten()) {
+            *total += *counter as u64;
+        }
+    }
+
+    /// CPU 하나의 hh_topk 값에서 후보 주소 추가 (빈 항목과 중복 제외)
+    pub fn add_topk(&mut self, value: &abi::hh_topk) {
+        for entry in &value.entries {
+            if entry.count != 0 && !self.candidates.contains(&entry.addr) {
+                self.candidates.push(entry.addr);
+            }
+        }
+    }
+
+    /// 합산 스케치의 주소 추정치 (행별 카운터의 최솟값)
+    pub fn estimate(&self, addr: u32) -> u64 {
+        (0..HH_DEPTH)
+            .map(|row| self.counts[row * HH_WIDTH + bucket(addr, row)])
+            .min()
+            .unwrap_or(0)
+    }
+
+    /// 추정치가 큰 순서로 후보 최대 top_k개를 out에 기록
+    pub fn top(&self, top_k: usize, elapsed: f64, out: &mut Vec<HeavyHitter>) {
+        out.clear();
+        out.extend(self.candidates.iter().map(|&addr| {
+            let packets = self.estimate(addr);
+            HeavyHitter {
+                addr: Ipv4Addr::from(addr.to_ne_bytes()),
+                packets,
+                packets_per_sec: (packets as f64 / elapsed) as u64,
+            }
+        }));
+        out.sort_unstable_by(|a, b| b.packets.cmp(&a.packets));
+        out.truncate(top_k);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// 데이터 경로와 같은 방식으로 CPU 하나의 스케치와 후보 표 값 생성
+    fn cpu_values(sources: &[(Ipv4Addr, u32)]) -> (Box<abi::hh_sketch>, abi::hh_topk) {
+        let mut sketch = Box::<abi::hh_sketch>::default();
+        let mut topk = abi::hh_topk::default();
+
+        for (i, (ip, packets)) in sources.iter().enumerate() {
+            let addr = u32::from_ne_bytes(ip.octets());
+            for row in 0..HH_DEPTH {
+                sketch.counts[row][bucket(addr, row)] += packets;
+            }
+            topk.entries[i] = abi::hh_entry { addr, count: *packets };
+        }
+
+        (sketch, topk)
+    }
+
+    #[test]
+    fn test_merge_cpus() {
+        let heavy = Ipv4Addr::new(203, 0, 113, 7);
+        let light = Ipv4Addr::new(198, 51, 100, 1);
+
+        // 같은 소스가 두 CPU에 나뉘어 들어온 경우 합산
+        let mut merger = SketchMerger::new();
+        for sources in [&[(heavy, 600), (light, 10)][..], &[(heavy, 400)][..]] {
+            let (sketch, topk) = cpu_values(sources);
+            merger.add_sketch(&sketch);
+            merger.add_topk(&topk);
+        }
+
+        let mut top = Vec::new();
+        merger.top(HH_TOPK, 2.0, &mut top);
+        assert_eq!(top.len(), 2);
+        assert_eq!(top[0], HeavyHitter { addr: heavy, packets: 1000, packets_per_sec: 500 });
+        assert!(top[1].addr == light && top[1].packets >= 10);
+
+        merger.top(1, 2.0, &mut top);
+        assert_eq!(top.len(), 1);
+
+        merger.clear();
+        assert_eq!(merger.estimate(u32::from_ne_bytes(heavy.octets())), 0);
+    }
+}
@@ -2,19 +2,35 @@
 use anyhow::{Context, Result};
 use clap::Parser;
 use log::{debug, error, info, warn};
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 use std::sync::{Arc, Mutex};
 use tokio::signal;
 
+mod abi;
+mod attach;
+mod blocklist;
 mod bpf;
+mod classifier;
 mod config;
+mod events;
+mod features;
+mod heavy_hitters;
 mod maps;
+mod memory;
+mod percpu;
+mod pipeline;
+mod ruleset;
 mod server;
 mod telemetry;
+mod timer_wheel;
 mod wasm;
+mod workers;
+mod writer;
+mod xsk;
 
 use crate::maps::MapManager;
 use crate::telemetry::TelemetryCollector;
+use crate::writer::MapWriter;
 
 #[derive(Parser, Debug)]
 #[clap(name = "swift-guard-daemon", about = "Swift-Guard Daemon")]
@@ -57,24 +73,375 @@ async fn main() -> Result<()> {
 
     info!("Swift-Guard 데몬 시작 중...");
 
-    // 특정 인터페이스에 XDP 프로그램 로드
-    if let Some(interface) = &args.interface {
-        info!("인터페이스 {}에 XDP 프로그램 로드 중...", interface);
-        if let Err(e) = bpf::load_xdp_program(&args.bpf_obj, interface) {
-            error!("XDP 프로그램 로드 실패: {}", e);
+    // 구성 로드
+    let config = config::load_config(&args.config)?;
+
+    // BPF 오브젝트 로드 (규칙 기능이 지정되면 정책 특화 변형 선택)
+    let bpf_obj = match &config.xdp.features {
+        Some(names) => {
+            let needed = features::Features::parse(names)?;
+            let path = features::select_object(&args.bpf_obj, needed);
+            info!("BPF 오브젝트 {} 사용 (필요 기능: {}, 포함 기능: {})",
+                  path.display(), needed, features::Features::of_object(&path));
+            path
         }
+        None => args.bpf_obj.clone(),
+    };
+    // 맵 고정 경로가 지정되면 이전 데몬이 고정한 맵을 재사용 (규칙, 카운터 유지)
+    let mut builder = bpf::XdpFilterSkel::builder()
+        .obj_path(&bpf_obj)
+        .map_sizes(config.xdp.map_sizes.clone());
+    if let Some(pin_path) = &config.xdp.pin_path {
+        builder = builder.pin_path(pin_path);
+    }
+    let skel = builder
+        .open()
+        .context("BPF 오브젝트 로드 실패")?;
+
+    // 맵이 가득 찼을 때의 메모리 추정치를 예산과 비교 (연결 전에 실패)
+    let map_memory = skel.map_memory()?;
+    info!("BPF 맵 메모리 최대 {} MiB 추정", map_memory.iter().map(|m| m.bytes).sum::<u64>() >> 20);
+    if let Some(budget_mb) = config.xdp.memory_budget_mb {
+        memory::check_budget(&map_memory, budget_mb << 20)?;
     }
 
+    // 스켈레톤은 프로세스가 끝날 때까지 유지 (API 작업과 맵 기록 스레드가 맵 참조를 공유)
+    let skel: &'static bpf::XdpFilterSkel = Box::leak(Box::new(skel));
+
+    // 인터페이스에 XDP 프로그램 연결 (모든 인터페이스가 스켈레톤 맵 공유, 고정된 링크가
+    // 있으면 프로그램만 교체하고, 종료 시 고정되지 않은 연결만 분리)
+    let program = if config.xdp.pipeline { pipeline::ENTRY_PROGRAM } else { "xdp_filter_func" };
+    let attach_manager = Arc::new(Mutex::new(
+        attach::AttachManager::new(skel, program, &bpf_obj, config.xdp.multiprog)
+    ));
+    attach_interfaces(&attach_manager, &args, &config);
+
+    // WASM 모듈 (사전 컴파일 산출물은 work_dir에 캐시)
+    let wasm_manager = wasm::WasmManager::from_config(
+        &config.wasm,
+        &Path::new(&config.general.work_dir).join("wasm-cache"),
+    );
+    if config.wasm.auto_load {
+        load_wasm_modules(&wasm_manager, &config.wasm);
+    }
+
+    // AF_XDP 검사 경로 (구성된 경우, 인터페이스 필요)
+    let mut xsk_workers = match (&config.wasm.xsk, &args.interface) {
+        (Some(xsk_config), Some(interface)) => {
+            match start_xsk(skel, &wasm_manager, &config.wasm, xsk_config, interface) {
+                Ok(pool) => Some(pool),
+                Err(e) => {
+                    error!("AF_XDP 검사 경로 시작 실패: {}", e);
+                    None
+                }
+            }
+        }
+        (Some(_), None) => {
+            warn!("AF_XDP 검사 경로는 --interface가 필요합니다");
+            None
+        }
+        _ => None,
+    };
+
+    // 맵 기록 스레드 (맵 관리자 소유, 규칙 복원과 블록리스트 적재 후 시작),
+    // 텔레메트리 수집기, API 서버 생성
+    let init_config = config.clone();
+    let (map_writer, snapshot) = MapWriter::start(skel, move |manager| {
+        if skel.pin_path.is_some() {
+            restore_rules(manager, skel, &init_config);
+        }
+        load_blocklists(manager, skel, &init_config);
+    }).context("맵 기록 스레드 시작 실패")?;
+    let rule_reader = maps::RuleReader::new(snapshot, skel.maps().rule_stats());
+    // 샘플 이벤트 소비 (구성된 경우)
+    let mut event_consumer = if config.events.enabled {
+        match start_events(skel, &config.events, &rule_reader, &wasm_manager) {
+            Ok(consumer) => Some(consumer),
+            Err(e) => {
+                error!("샘플 이벤트 소비 시작 실패: {}", e);
+                None
+            }
+        }
+    } else {
+        None
+    };
+    let telemetry = Arc::new(TelemetryCollector::new(
+        skel,
+        &config,
+        rule_reader.clone(),
+        args.interface.as_deref().unwrap_or("any"),
+    )?);
+    let api_server = server::ApiServer::new(
+        &args.api_addr,
+        map_writer.clone(),
+        rule_reader,
+        attach_manager.clone(),
+        telemetry.clone(),
+    )?;
+
     // Ctrl+C 대기
     info!("데몬 실행 중... Ctrl+C로 종료");
-    tokio::signal::ctrl_c().await?;
-    
-    // 종료 처리
-    if let Some(interface) = &args.interface {
-        info!("인터페이스 {}에서 XDP 프로그램 언로드 중...", interface);
-        bpf::unload_xdp_program(interface)?;
+    tokio::select! {
+        result = api_server.run() => {
+            if let Err(e) = result {
+                error!("API 서버 오류: {}", e);
+            }
+        }
+        result = run_telemetry(telemetry.clone(), map_writer.clone(), &config.telemetry) => {
+            if let Err(e) = result {
+                error!("텔레메트리 수집 오류: {}", e);
+            }
+        }
+        _ = run_metrics(telemetry.clone()) => {}
+        _ = signal::ctrl_c() => {}
+    }
+
+    if let Some(pool) = xsk_workers.as_mut() {
+        pool.shutdown();
+    }
+    if let Some(consumer) = event_consumer.as_mut() {
+        consumer.shutdown();
+    }
+    if let Ok(mut manager) = attach_manager.lock() {
+        manager.release_all();
     }
 
     info!("Swift-Guard 데몬 종료");
     Ok(())
-}
\ No newline at end of file
+}
+
+/// 규칙 테이블 저장 파일 지정 및 재사용한 맵의 규칙 테이블 복원
+///
+/// 복원하지 못하면 빈 규칙 집합으로 전환해 데이터 경로와 데몬의 규칙 테이블을 맞춘다.
+fn restore_rules(manager: &mut MapManager<'_>, skel: &bpf::XdpFilterSkel, config: &config::DaemonConfig) {
+    let state_path = Path::new(&config.general.work_dir).join("rules.json");
+
+    if skel.maps_reused {
+        match manager.restore_rules(&state_path) {
+            Ok(count) => info!("이전 데몬의 규칙 {}개 복원", count),
+            Err(e) => {
+                error!("규칙 테이블 복원 실패: {}", e);
+                if let Err(e) = manager.replace_rules(Vec::new()) {
+                    error!("규칙 집합 초기화 실패: {}", e);
+                }
+            }
+        }
+    }
+    manager.set_state_path(state_path);
+}
+
+/// 구성 파일의 블록리스트 불러오기 (실패한 블록리스트는 건너뜀)
+///
+/// 고정된 맵을 재사용하면 구성에서 빠진 이전 프리픽스를 삭제한다.
+fn load_blocklists(manager: &mut MapManager<'_>, skel: &bpf::XdpFilterSkel, config: &config::DaemonConfig) {
+    for list in &config.blocklists {
+        let result = blocklist::PrefixList::read(Path::new(&list.path))
+            .and_then(|prefixes| manager.replace_blocklist(&list.name, &prefixes));
+        if let Err(e) = result {
+            error!("블록리스트 {} 로드 실패: {}", list.name, e);
+        }
+    }
+
+    if skel.maps_reused {
+        match manager.prune_blocklists() {
+            Ok(0) => {}
+            Ok(count) => info!("이전 데몬의 블록리스트 프리픽스 {}개 삭제", count),
+            Err(e) => error!("블록리스트 정리 실패: {}", e),
+        }
+    }
+}
+
+/// --interface와 구성 파일의 인터페이스 연결 (실패한 인터페이스는 건너뜀)
+fn attach_interfaces(
+    attach_manager: &Mutex<attach::AttachManager<'static>>,
+    args: &Args,
+    config: &config::DaemonConfig,
+) {
+    let mut targets: Vec<(String, bpf::XdpMode)> = Vec::new();
+
+    for interface in config.interfaces.iter().flatten().filter(|i| i.enabled) {
+        match bpf::XdpMode::from_str(&interface.mode) {
+            Some(mode) => targets.push((interface.name.clone(), mode)),
+            None => error!("인터페이스 {}의 잘못된 XDP 모드: {}", interface.name, interface.mode),
+        }
+    }
+    if let Some(interface) = &args.interface {
+        if !targets.iter().any(|(name, _)| name == interface) {
+            targets.insert(0, (interface.clone(), bpf::XdpMode::Driver));
+        }
+    }
+
+    let mut manager = match attach_manager.lock() {
+        Ok(manager) => manager,
+        Err(_) => return,
+    };
+    for (interface, mode) in targets {
+        info!("인터페이스 {}에 XDP 프로그램 로드 중...", interface);
+        match manager.attach(&interface, mode, false) {
+            Ok(attached) if attached != mode => {
+                warn!("인터페이스 {}: {} 모드 대신 {} 모드로 연결됨", interface, mode.to_str(), attached.to_str())
+            }
+            Ok(_) => {}
+            Err(e) => error!("XDP 프로그램 로드 실패: {}", e),
+        }
+    }
+}
+
+/// 자동 로드 모듈 적재 (실패한 모듈은 건너뜀)
+fn load_wasm_modules(wasm_manager: &wasm::WasmManager, wasm_config: &config::WasmConfig) {
+    for module in &wasm_config.auto_load_modules {
+        let started = std::time::Instant::now();
+        let path = Path::new(&wasm_config.modules_dir).join(module);
+        match wasm_manager.load_module(module, &path) {
+            Ok(()) => info!("WASM 모듈 {} 로드 완료 ({:?})", module, started.elapsed()),
+            Err(e) => error!("WASM 모듈 {} 로드 실패: {}", module, e),
+        }
+    }
+}
+
+/// 모듈을 한 번 컴파일하고 큐마다 UMEM을 가진 인스턴스와 AF_XDP 소켓을 만들어 워커 시작
+fn start_xsk(
+    skel: &bpf::XdpFilterSkel,
+    wasm_manager: &wasm::WasmManager,
+    wasm_config: &config::WasmConfig,
+    xsk_config: &config::XskConfig,
+    interface: &str,
+) -> Result<workers::WorkerPool> {
+    let c_name = std::ffi::CString::new(interface)
+        .map_err(|_| anyhow::anyhow!("잘못된 인터페이스 이름: {}", interface))?;
+    let ifindex = unsafe { libc::if_nametoindex(c_name.as_ptr()) };
+    if ifindex == 0 {
+        return Err(anyhow::anyhow!("인터페이스 {}가 존재하지 않습니다", interface));
+    }
+
+    // 워커는 같은 컴파일 결과를 공유하고 Store/Instance만 따로 가짐
+    let path = Path::new(&wasm_config.modules_dir).join(&xsk_config.module);
+    let compiled = wasm_manager.compile_fixed_memory(&xsk_config.module, &path)?;
+
+    let cpu_count = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+    let bindings = workers::bindings(xsk_config, cpu_count);
+
+    let maps = skel.maps();
+    let xsk_map = maps.xsk_map()
+        .ok_or_else(|| anyhow::anyhow!("xsk_map을 찾을 수 없습니다"))?;
+
+    workers::WorkerPool::start(&compiled, wasm_manager, xsk_map, ifindex, xsk_config, &bindings)
+}
+
+/// events 링 버퍼 소비 스레드 시작
+fn start_events(
+    skel: &bpf::XdpFilterSkel,
+    events_config: &config::EventsConfig,
+    rule_reader: &maps::RuleReader,
+    wasm_manager: &wasm::WasmManager,
+) -> Result<events::EventConsumer> {
+    let maps = skel.maps();
+    let events_map = maps.events()
+        .ok_or_else(|| anyhow::anyhow!("events 맵을 찾을 수 없습니다"))?;
+    let wasm = events_config.inspect_with_wasm.then(|| wasm_manager.clone());
+
+    events::EventConsumer::start(events_map, events_config, rule_reader.snapshot_handle(), wasm)
+}
+
+/// 텔레메트리 내보내기 (실패해도 데몬은 계속 실행)
+async fn run_metrics(telemetry: Arc<TelemetryCollector<'_>>) {
+    if let Err(e) = telemetry.serve_metrics().await {
+        error!("텔레메트리 내보내기 중단: {}", e);
+    }
+    std::future::pending::<()>().await
+}
+
+/// 주기적으로 통계 수집 (헤비 히터 기준이 설정된 경우 기준을 넘은 소스에 규칙 설치)
+///
+/// 수집 실패는 기록하고 다음 주기에 다시 시도한다. 맵 기록 스레드가 멈춘 경우에만 끝난다.
+async fn run_telemetry(
+    telemetry: Arc<TelemetryCollector<'_>>,
+    map_writer: MapWriter,
+    telemetry_config: &config::TelemetryConfig,
+) -> Result<()> {
+    let mut interval = tokio::time::interval(std::time::Duration::from_secs(telemetry_config.interval.max(1)));
+    let hh_config = &telemetry_config.heavy_hitters;
+
+    loop {
+        interval.tick().await;
+        if let Err(e) = telemetry.collect_stats().await {
+            warn!("통계 수집 실패: {}", e);
+            continue;
+        }
+
+        if hh_config.enabled && hh_config.threshold_pps > 0 {
+            let hitters = match telemetry.heavy_hitters() {
+                Ok(hitters) => hitters,
+                Err(e) => {
+                    warn!("헤비 히터 조회 실패: {}", e);
+                    continue;
+                }
+            };
+            let hh_config = hh_config.clone();
+            map_writer.run(move |map_manager| {
+                install_heavy_hitter_rules(map_manager, &hh_config, &hitters);
+                Ok(())
+            }).await?;
+        }
+    }
+}
+
+/// 기준을 넘은 상위 소스마다 /32 규칙 추가 (같은 레이블의 규칙이 있으면 건너뜀)
+///
+/// 우선순위 0으로 추가하므로 더 높은 우선순위의 기존 규칙(허용 목록 등)이 먼저 적용된다.
+fn install_heavy_hitter_rules(
+    map_manager: &mut MapManager<'_>,
+    hh_config: &config::HeavyHitterConfig,
+    hitters: &[heavy_hitters::HeavyHitter],
+) {
+    let (action, rate_limit) = match hh_config.action.as_str() {
+        "drop" => (2, 0),
+        "rate-limit" if hh_config.rate_limit > 0 => (1, hh_config.rate_limit),
+        _ => {
+            warn!("잘못된 헤비 히터 규칙 구성: action={}, rate_limit={}", hh_config.action, hh_config.rate_limit);
+            return;
+        }
+    };
+    let creation_time = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .map(|d| d.as_secs())
+        .unwrap_or(0);
+
+    let rules: Vec<maps::FilterRule> = hitters.iter()
+        .filter(|hh| hh.packets_per_sec >= hh_config.threshold_pps)
+        .map(|hh| (hh, format!("hh-{}", hh.addr)))
+        .filter(|(_, label)| !map_manager.has_rule(label))
+        .map(|(hh, label)| {
+            info!("헤비 히터 {} ({} pps)에 {} 규칙 설치", hh.addr, hh.packets_per_sec, hh_config.action);
+            maps::FilterRule {
+                src_ip: Some((u32::from(hh.addr), 32)),
+                dst_ip: None,
+                src_ip6: None,
+                dst_ip6: None,
+                src_port_min: 0,
+                src_port_max: 65535,
+                dst_port_min: 0,
+                dst_port_max: 65535,
+                protocol: 255,
+                tcp_flags: 0,
+                action,
+                redirect_ifindex: 0,
+                redirect_cpu: 0,
+                priority: 0,
+                rate_limit,
+                rate_limit_per_source: false,
+                sample_rate: 0,
+                expire: hh_config.expire,
+                label,
+                creation_time,
+                expire_deadline_ns: 0,
+            }
+        })
+        .collect();
+
+    if !rules.is_empty() {
+        if let Err(e) = map_manager.add_rules(rules) {
+            error!("헤비 히터 규칙 설치 실패: {}", e);
+        }
+    }
+}
@@ -4,22 +4,38 @@
 use anyhow::{anyhow, Context, Result};
 use libbpf_rs::Map;
 use log::{debug, error, info, warn};
+use serde::{Deserialize, Serialize};
+use std::mem::size_of;
 use std::net::{IpAddr, Ipv4Addr};
-use std::time::{Duration, SystemTime, UNIX_EPOCH};
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, PoisonError, RwLock};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
 
-use crate::bpf::XdpFilterSkel;
+use crate::abi;
+use crate::blocklist::{BlocklistChanges, BlocklistInfo, Blocklists, PrefixList};
+use crate::bpf::{self, XdpFilterSkel};
+use crate::classifier::{self, CompiledClassifier, MatchFields, RuleBitmap};
+use crate::percpu::PercpuTable;
+use crate::features::Features;
+use crate::pipeline::{self, Pipeline, StageSet};
+use crate::ruleset::{self, InnerMap, RuleSetMaps};
+use crate::telemetry;
+use crate::timer_wheel::TimerWheel;
 //use crate::api::{RuleInfo, RuleStats};
 //use crate::utils;
 
 use swift_guard::api::{RuleInfo, RuleStats};
 use swift_guard::utils;
 use libbpf_rs::MapFlags;
+use std::collections::{BTreeMap, BTreeSet};
 
 /// 필터 규칙 정보
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct FilterRule {
     pub src_ip: Option<(u32, u32)>,  // (IP, 프리픽스 길이)
     pub dst_ip: Option<(u32, u32)>,  // (IP, 프리픽스 길이)
+    pub src_ip6: Option<(u128, u32)>,  // (IPv6, 프리픽스 길이)
+    pub dst_ip6: Option<(u128, u32)>,  // (IPv6, 프리픽스 길이)
     pub src_port_min: u16,
     pub src_port_max: u16,
     pub dst_port_min: u16,
@@ -28,33 +44,43 @@ pub struct FilterRule {
     pub tcp_flags: u8,
     pub action: u8,
     pub redirect_ifindex: u32,
+    pub redirect_cpu: u32,
     pub priority: u32,
     pub rate_limit: u32,
+    pub rate_limit_per_source: bool,
+    /// 이벤트 샘플링 비율 (1/N, 0 = 끔)
+    pub sample_rate: u16,
     pub expire: u32,
     pub label: String,
     pub creation_time: u64,
+    /// 만료 시각 (CLOCK_MONOTONIC ns, 0 = 만료 없음, add_rule에서 설정)
+    pub expire_deadline_ns: u64,
 }
 
 impl FilterRule {
+    /// 분류기 매치 필드 추출
+    pub fn match_fields(&self) -> MatchFields {
+        MatchFields {
+            src_ip: self.src_ip,
+            dst_ip: self.dst_ip,
+            src_ip6: self.src_ip6,
+            dst_ip6: self.dst_ip6,
+            protocol: self.protocol,
+            src_port_min: self.src_port_min,
+            src_port_max: self.src_port_max,
+            dst_port_min: self.dst_port_min,
+            dst_port_max: self.dst_port_max,
+            tcp_flags: self.tcp_flags,
+        }
+    }
+
     /// API 룰 정보로 변환
     pub fn to_rule_info(&self, stats: RuleStats) -> RuleInfo {
         RuleInfo {
             label: self.label.clone(),
             action: utils::action_num_to_name(self.action),
-            src_ip: self.src_ip.map(|(ip, prefix)| {
-                if prefix == 32 {
-                    utils::ipv4_to_string(ip)
-                } else {
-                    format!("{}/{}", utils::ipv4_to_string(ip), prefix)
-                }
-            }),
-            dst_ip: self.dst_ip.map(|(ip, prefix)| {
-                if prefix == 32 {
-                    utils::ipv4_to_string(ip)
-                } else {
-                    format!("{}/{}", utils::ipv4_to_string(ip), prefix)
-                }
-            }),
+            src_ip: format_prefix(self.src_ip, self.src_ip6),
+            dst_ip: format_prefix(self.dst_ip, self.dst_ip6),
             src_port: utils::port_range_to_string(self.src_port_min, self.src_port_max),
             dst_port: utils::port_range_to_string(self.dst_port_min, self.dst_port_max),
             protocol: utils::protocol_num_to_name(self.protocol),
@@ -66,6 +92,8 @@ impl FilterRule {
             priority: self.priority,
             redirect_if: if self.action == 3 && self.redirect_ifindex != 0 {
                 Some(format!("if{}", self.redirect_ifindex))
+            } else if self.action == 5 {
+                Some(format!("cpu{}", self.redirect_cpu))
             } else {
                 None
             },
@@ -76,13 +104,26 @@ impl FilterRule {
     }
 }
 
-/// 리디렉션 인터페이스 정보
-#[derive(Debug, Clone)]
-pub struct RedirectIf {
-    pub ifindex: u32,
-    pub ifname: String,
+/// IPv4 또는 IPv6 프리픽스를 문자열로 변환
+fn format_prefix(v4: Option<(u32, u32)>, v6: Option<(u128, u32)>) -> Option<String> {
+    match (v4, v6) {
+        (Some((ip, 32)), _) => Some(utils::ipv4_to_string(ip)),
+        (Some((ip, prefix)), _) => Some(format!("{}/{}", utils::ipv4_to_string(ip), prefix)),
+        (None, Some((ip, 128))) => Some(utils::ipv6_to_string(ip)),
+        (None, Some((ip, prefix))) => Some(format!("{}/{}", utils::ipv6_to_string(ip), prefix)),
+        (None, None) => None,
+    }
 }
 
+/// CPU 리디렉션 대상의 cpumap 큐 크기
+const CPUMAP_QUEUE_SIZE: u32 = 2048;
+
+/// rule_verdict.flags: 레이트 리밋을 소스 IP별로 적용
+const RULE_F_RATE_PER_SRC: u8 = abi::RULE_F_RATE_PER_SRC as u8;
+
+/// 만료 타이머 휠의 틱 간격 (ms)
+pub const EXPIRY_TICK_MS: u64 = 100;
+
 /*
 /// 맵 관리자
 #[derive(Debug)]
@@ -103,14 +144,156 @@ pub struct MapManager<'a> {
 //    skel: &'a XdpFilterSkel,
     filter_rules_map: Option<&'a Map>,
     redirect_map: Option<&'a Map>,
+    cpu_map: Option<&'a Map>,
     stats_map: Option<&'a Map>,
-    rules: Vec<FilterRule>,
+    cls_src_v4_map: Option<&'a Map>,
+    cls_dst_v4_map: Option<&'a Map>,
+    cls_src_v6_map: Option<&'a Map>,
+    cls_dst_v6_map: Option<&'a Map>,
+    cls_port_class_map: Option<&'a Map>,
+    cls_bitmaps_map: Option<&'a Map>,
+    cls_config_map: Option<&'a Map>,
+    rule_stats_map: Option<&'a Map>,
+    rule_buckets_map: Option<&'a Map>,
+    blocklist_v4_map: Option<&'a Map>,
+    blocklist_v6_map: Option<&'a Map>,
+    blocklist_config_map: Option<&'a Map>,
+    blocklist_stats_map: Option<&'a Map>,
+    /// 소스 프리픽스 블록리스트 소속 (블록리스트 맵에 기록된 내용과 일치)
+    blocklists: Blocklists,
+    /// 규칙 집합이 사용하는 파이프라인 단계 연결
+    pipeline: Pipeline<'a>,
+    /// 로드된 XDP 프로그램이 처리할 수 있는 기능
+    features: Features,
+    /// 규칙 테이블 (키 = 규칙 ID, 레이블 등 데이터 경로에 불필요한 메타데이터 포함)
+    rules: BTreeMap<u32, FilterRule>,
+    /// 우선순위 순서로 정렬된 규칙 ID (인덱스 = 분류기 비트 위치)
+    order: Vec<u32>,
+    /// 규칙 만료 타이머 (값 = (레이블, 만료 시각))
+    expiry: TimerWheel<(String, u64)>,
+    /// 마지막으로 맵에 기록된 분류기 (변경분만 기록하기 위해 유지)
+    compiled: Option<CompiledClassifier>,
+    /// 마지막으로 filter_rules에 기록된 값
+    rule_values: Vec<Vec<u8>>,
+    /// 규칙 집합 세대 (변경될 때마다 증가하여 XDP 흐름 캐시 무효화)
+    generation: u32,
+    /// 활성 슬롯에 설치된 규칙 집합 내부 맵
+    rule_set: Option<RuleSetMaps>,
+    /// 비활성 슬롯에 남아 있는 이전 규칙 집합 (다음 스테이징에서 재사용)
+    standby: Option<StandbySet>,
+    /// 활성 규칙 집합 슬롯
+    active_slot: u32,
+    /// 읽기 경로에 공개된 규칙 테이블
+    snapshot: Arc<SharedSnapshot>,
+    /// 규칙 테이블 저장 파일 (고정된 맵과 함께 재시작 시 복원)
+    state_path: Option<PathBuf>,
+}
+
+/// 비활성 슬롯의 내부 맵과 기록된 내용
+#[derive(Debug)]
+struct StandbySet {
+    maps: RuleSetMaps,
+    compiled: CompiledClassifier,
+    rule_values: Vec<Vec<u8>>,
+}
+
+/// 규칙 테이블 스냅숏
+///
+/// 규칙 변경이 데이터 경로에 반영될 때마다 새 스냅숏으로 통째로 교체되며(RCU),
+/// 읽는 쪽은 MapManager 잠금 없이 마지막으로 공개된 스냅숏을 참조한다.
+#[derive(Debug, Default)]
+pub struct RuleSnapshot {
+    /// 우선순위 순서의 (규칙 ID, 규칙)
+    pub rules: Vec<(u32, FilterRule)>,
+    /// ID 순서의 블록리스트
+    pub blocklists: Vec<BlocklistInfo>,
+}
+
+/// 공개된 규칙 테이블 스냅숏 (기록 스레드가 교체, 여러 스레드가 읽음)
+///
+/// 잠금은 Arc 포인터를 복사하거나 바꾸는 동안만 잡으므로, 읽는 쪽은 규칙 변경의 맵
+/// 기록을 기다리지 않는다.
+#[derive(Debug, Default)]
+pub struct SharedSnapshot(RwLock<Arc<RuleSnapshot>>);
+
+impl SharedSnapshot {
+    /// 마지막으로 공개된 스냅숏
+    pub fn load(&self) -> Arc<RuleSnapshot> {
+        self.0.read().unwrap_or_else(PoisonError::into_inner).clone()
+    }
+    
+    /// 새 스냅숏 공개 (이전 스냅숏은 마지막 참조가 사라질 때 해제)
+    pub fn store(&self, snapshot: Arc<RuleSnapshot>) {
+        *self.0.write().unwrap_or_else(PoisonError::into_inner) = snapshot;
+    }
+}
+
+/// MapManager 잠금 없는 규칙 조회기 (규칙 변경과 서로 기다리지 않음)
+#[derive(Clone)]
+pub struct RuleReader<'a> {
+    snapshot: Arc<SharedSnapshot>,
+    rule_stats_map: Option<&'a Map>,
+}
+
+impl<'a> std::fmt::Debug for RuleReader<'a> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("RuleReader")
+            .field("rules", &self.snapshot.load().rules.len())
+            .finish()
+    }
+}
+
+impl<'a> RuleReader<'a> {
+    /// 다른 스레드의 MapManager가 게시하는 스냅숏을 읽는 조회기
+    pub fn new(snapshot: Arc<SharedSnapshot>, rule_stats_map: Option<&'a Map>) -> Self {
+        Self { snapshot, rule_stats_map }
+    }
+    
+    /// 현재 스냅숏
+    pub fn snapshot(&self) -> Arc<RuleSnapshot> {
+        self.snapshot.load()
+    }
+    
+    /// 다른 스레드에서 스냅숏을 읽기 위한 핸들 (BPF 맵 참조 없음)
+    pub fn snapshot_handle(&self) -> Arc<SharedSnapshot> {
+        self.snapshot.clone()
+    }
+    
+    /// 스냅숏의 규칙 목록 조회 (우선순위 순서)
+    pub fn list_rules(&self, include_stats: bool) -> Result<Vec<RuleInfo>> {
+        let snapshot = self.snapshot.load();
+        
+        // 통계는 배치 조회로 한 번에 읽음 (규칙당 syscall 방지)
+        let stats_table = if include_stats {
+            let map = self.rule_stats_map
+                .ok_or_else(|| anyhow!("Failed to get rule_stats map"))?;
+            read_all_rule_stats(map, snapshot.rules.iter().map(|(rule_id, _)| *rule_id))?
+        } else {
+            Vec::new()
+        };
+        
+        let result = snapshot.rules.iter()
+            .map(|(rule_id, rule)| {
+                let stats = stats_table.get(*rule_id as usize)
+                    .cloned()
+                    .unwrap_or(RuleStats {
+                        packets: 0,
+                        bytes: 0,
+                        last_matched: 0,
+                    });
+                rule.to_rule_info(stats)
+            })
+            .collect();
+        
+        Ok(result)
+    }
 }
 
 impl<'a> std::fmt::Debug for MapManager<'a> {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         f.debug_struct("MapManager")
             .field("rules", &self.rules)
+            .field("order", &self.order)
             // Map은 Debug할 수 없으므로 포함하지 않음
             .finish()
     }
@@ -118,15 +301,128 @@ impl<'a> std::fmt::Debug for MapManager<'a> {
 
 impl<'a> MapManager<'a> {
     pub fn new(skel: &'a XdpFilterSkel) -> Self {
+        // 블록리스트 용량은 로드된 맵의 최대 항목 수 (xdp.map_sizes로 바뀔 수 있음)
+        let capacity = |map: Option<&Map>| map
+            .and_then(|map| bpf::map_info(map).ok())
+            .map(|info| info.max_entries as usize)
+            .unwrap_or(0);
+        let blocklists = Blocklists::new(
+            capacity(skel.maps().blocklist_v4()),
+            capacity(skel.maps().blocklist_v6()),
+        );
+        
         Self {
 //            skel,
             filter_rules_map: skel.maps().filter_rules(),
             redirect_map: skel.maps().redirect_map(),
+            cpu_map: skel.maps().cpu_map(),
             stats_map: skel.maps().stats_map(),
-            rules: Vec::new(),
+            cls_src_v4_map: skel.maps().cls_src_v4(),
+            cls_dst_v4_map: skel.maps().cls_dst_v4(),
+            cls_src_v6_map: skel.maps().cls_src_v6(),
+            cls_dst_v6_map: skel.maps().cls_dst_v6(),
+            cls_port_class_map: skel.maps().cls_port_class(),
+            cls_bitmaps_map: skel.maps().cls_bitmaps(),
+            cls_config_map: skel.maps().cls_config(),
+            rule_stats_map: skel.maps().rule_stats(),
+            rule_buckets_map: skel.maps().rule_buckets(),
+            blocklist_v4_map: skel.maps().blocklist_v4(),
+            blocklist_v6_map: skel.maps().blocklist_v6(),
+            blocklist_config_map: skel.maps().blocklist_config(),
+            blocklist_stats_map: skel.maps().blocklist_stats(),
+            blocklists,
+            pipeline: Pipeline::new(skel),
+            features: skel.features,
+            rules: BTreeMap::new(),
+            order: Vec::new(),
+            expiry: TimerWheel::new(monotonic_now_ns() / (EXPIRY_TICK_MS * 1_000_000)),
+            compiled: None,
+            rule_values: Vec::new(),
+            generation: 0,
+            rule_set: None,
+            standby: None,
+            active_slot: 0,
+            snapshot: Arc::new(SharedSnapshot::default()),
+            state_path: None,
         }
     }
     
+    /// 규칙 테이블이 바뀔 때마다 path에 저장
+    pub fn set_state_path(&mut self, path: PathBuf) {
+        self.state_path = Some(path);
+    }
+    
+    /// 고정된 맵을 재사용할 때 이전 데몬의 규칙 테이블 복원 (복원한 규칙 수 반환)
+    ///
+    /// 데이터 경로는 이전 데몬이 설치한 규칙 집합을 계속 쓰고 있으므로, 저장된 규칙을
+    /// 같은 ID로 다시 컴파일해 비활성 슬롯에 한 번 설치하고 전환한다. ID가 그대로이므로
+    /// 통계와 토큰 버킷은 초기화하지 않는다. 저장 파일이 없으면 빈 집합으로 전환한다.
+    pub fn restore_rules(&mut self, path: &Path) -> Result<usize> {
+        let saved = load_saved_rules(path, monotonic_now_ns())?;
+        
+        // 이전 데몬이 기록한 세대와 활성 슬롯에서 이어감
+        let config_map = self.cls_config_map
+            .ok_or_else(|| anyhow!("Failed to get cls_config map"))?;
+        let config = config_map.lookup(&0u32.to_le_bytes(), MapFlags::ANY)
+            .context("Failed to read cls_config map")?
+            .unwrap_or_default();
+        if let Some(config) = abi::from_bytes::<abi::cls_config>(&config) {
+            self.generation = config.generation;
+            self.active_slot = config.active % ruleset::SLOTS;
+        }
+        
+        for (rule_id, rule) in saved {
+            self.prepare_redirect(&rule)?;
+            self.order.push(rule_id);
+            self.rules.insert(rule_id, rule);
+        }
+        
+        let result = self.compile_rules()
+            .and_then(|(compiled, rule_values)| self.stage_classifier(compiled, rule_values, &[]));
+        if let Err(e) = result {
+            self.order.clear();
+            self.rules.clear();
+            return Err(e);
+        }
+        
+        for rule in self.rules.values() {
+            if rule.expire_deadline_ns != 0 {
+                self.expiry.insert(
+                    deadline_to_tick(rule.expire_deadline_ns),
+                    (rule.label.clone(), rule.expire_deadline_ns),
+                );
+            }
+        }
+        
+        Ok(self.rules.len())
+    }
+    
+    /// 잠금 없는 규칙 조회기 생성
+    pub fn reader(&self) -> RuleReader<'a> {
+        RuleReader {
+            snapshot: self.snapshot.clone(),
+            rule_stats_map: self.rule_stats_map,
+        }
+    }
+    
+    /// 현재 규칙 테이블을 새 스냅숏으로 공개 (저장 파일이 지정되면 함께 저장)
+    fn publish_snapshot(&self) {
+        let rules = self.order.iter()
+            .map(|rule_id| (*rule_id, self.rules[rule_id].clone()))
+            .collect();
+        let snapshot = Arc::new(RuleSnapshot {
+            rules,
+            blocklists: self.blocklists.info(),
+        });
+        
+        if let Some(path) = &self.state_path {
+            if let Err(e) = save_rules(path, &snapshot.rules) {
+                warn!("Failed to save rule table to {}: {}", path.display(), e);
+            }
+        }
+        self.snapshot.store(snapshot);
+    }
+    
     // 필요할 때마다 skel에서 맵을 가져오는 헬퍼 메서드
     fn filter_rules_map(&self) -> Option<&Map> {
 //        self.skel.maps().filter_rules()
@@ -150,265 +446,1019 @@ impl<'a> MapManager<'a> {
     }
 
     /// 규칙 추가
-    pub fn add_rule(&mut self, rule: FilterRule) -> Result<()> {
+    pub fn add_rule(&mut self, mut rule: FilterRule) -> Result<()> {
         debug!("Adding rule: {}", rule.label);
         
-        // 소스 IP 규칙 추가 (있는 경우)
-        if let Some((src_ip, prefix_len)) = rule.src_ip {
-            let key = self.create_prefix_key(src_ip, prefix_len);
-            let value = self.create_filter_rule(&rule)?;
-            
-            if let Some(map) = self.filter_rules_map() {
-                map.update(&key, &value, libbpf_rs::MapFlags::ANY)
-                    .context("Failed to update filter_rules map")?;
+        // 만료 시각 계산 (데이터 경로는 bpf_ktime_get_ns와 비교)
+        rule.expire_deadline_ns = if rule.expire > 0 {
+            monotonic_now_ns() + rule.expire as u64 * 1_000_000_000
+        } else {
+            0
+        };
+        
+        // 규칙 ID 할당 (삭제된 ID 재사용)
+        let rule_id = (0..classifier::MAX_FILTER_RULES as u32)
+            .find(|id| !self.rules.contains_key(id))
+            .ok_or_else(|| anyhow!("Rule limit reached ({})", classifier::MAX_FILTER_RULES))?;
+        
+        // 리디렉션 대상 설정 (필요한 경우)
+        self.prepare_redirect(&rule)?;
+        
+        // 재사용되는 ID의 이전 통계 및 토큰 버킷 초기화
+        self.reset_rule_stats(rule_id)?;
+        self.reset_rule_bucket(rule_id)?;
+        
+        // 우선순위 순서 유지 (높을수록 앞, 같은 우선순위는 추가 순서)
+        let position = self.order.iter()
+            .position(|id| self.rules[id].priority < rule.priority)
+            .unwrap_or(self.order.len());
+        self.order.insert(position, rule_id);
+        self.rules.insert(rule_id, rule);
+        
+        // 분류기 재컴파일
+        if let Err(e) = self.sync_classifier() {
+            self.order.remove(position);
+            self.rules.remove(&rule_id);
+            return Err(e);
+        }
+        
+        // 만료 타이머 등록
+        let rule = &self.rules[&rule_id];
+        if rule.expire_deadline_ns != 0 {
+            self.expiry.insert(
+                deadline_to_tick(rule.expire_deadline_ns),
+                (rule.label.clone(), rule.expire_deadline_ns),
+            );
+        }
+        
+        Ok(())
+    }
+    
+    /// 여러 규칙을 한 번에 추가
+    ///
+    /// 규칙마다 분류기를 다시 기록하는 대신 전체를 한 번 컴파일해 비활성 슬롯에 기록한 뒤
+    /// 전환하므로, 모두 추가되거나 하나도 추가되지 않는다.
+    pub fn add_rules(&mut self, rules: Vec<FilterRule>) -> Result<usize> {
+        if self.rules.len() + rules.len() > classifier::MAX_FILTER_RULES {
+            return Err(anyhow!("Rule limit reached ({})", classifier::MAX_FILTER_RULES));
+        }
+        
+        let started = Instant::now();
+        let now_ns = monotonic_now_ns();
+        
+        // 규칙 ID 할당 (삭제된 ID 재사용)
+        let new_ids: Vec<u32> = (0..classifier::MAX_FILTER_RULES as u32)
+            .filter(|id| !self.rules.contains_key(id))
+            .take(rules.len())
+            .collect();
+        
+        for rule in &rules {
+            self.prepare_redirect(rule)?;
+        }
+        
+        let old_order = self.order.clone();
+        for (&rule_id, mut rule) in new_ids.iter().zip(rules) {
+            rule.expire_deadline_ns = if rule.expire > 0 {
+                now_ns + rule.expire as u64 * 1_000_000_000
             } else {
-                return Err(anyhow!("Failed to update filter_rules map"));
+                0
+            };
+            self.rules.insert(rule_id, rule);
+            self.order.push(rule_id);
+        }
+        
+        // 우선순위 순서 (안정 정렬이므로 같은 우선순위는 추가 순서)
+        let rules_ref = &self.rules;
+        self.order.sort_by(|a, b| rules_ref[b].priority.cmp(&rules_ref[a].priority));
+        
+        // 새 ID의 이전 통계와 토큰 버킷은 스테이징 중 초기화
+        let result = self.compile_rules()
+            .and_then(|(compiled, rule_values)| self.stage_classifier(compiled, rule_values, &new_ids));
+        if let Err(e) = result {
+            self.order = old_order;
+            for rule_id in &new_ids {
+                self.rules.remove(rule_id);
             }
+            return Err(e);
         }
         
-        // 리디렉션 인터페이스 설정 (필요한 경우)
+        // 만료 타이머 등록
+        for rule_id in &new_ids {
+            let rule = &self.rules[rule_id];
+            if rule.expire_deadline_ns != 0 {
+                self.expiry.insert(
+                    deadline_to_tick(rule.expire_deadline_ns),
+                    (rule.label.clone(), rule.expire_deadline_ns),
+                );
+            }
+        }
+        
+        info!("Added {} rules in {:?}", new_ids.len(), started.elapsed());
+        
+        Ok(new_ids.len())
+    }
+    
+    /// 규칙 집합 전체 교체
+    ///
+    /// 새 규칙 집합을 비활성 슬롯의 새 내부 맵에 일괄 기록한 뒤 활성 슬롯을
+    /// 전환하므로, 데이터 경로는 교체 중에도 이전 집합 또는 새 집합만 본다.
+    pub fn replace_rules(&mut self, rules: Vec<FilterRule>) -> Result<()> {
+        if rules.len() > classifier::MAX_FILTER_RULES {
+            return Err(anyhow!("Rule limit reached ({})", classifier::MAX_FILTER_RULES));
+        }
+        
+        let started = Instant::now();
+        let now_ns = monotonic_now_ns();
+        
+        // 규칙 ID는 입력 순서대로 다시 할당
+        let mut table = BTreeMap::new();
+        for (rule_id, mut rule) in rules.into_iter().enumerate() {
+            rule.expire_deadline_ns = if rule.expire > 0 {
+                now_ns + rule.expire as u64 * 1_000_000_000
+            } else {
+                0
+            };
+            self.prepare_redirect(&rule)?;
+            table.insert(rule_id as u32, rule);
+        }
+        
+        // 우선순위 순서 (안정 정렬이므로 같은 우선순위는 입력 순서)
+        let mut order: Vec<u32> = table.keys().copied().collect();
+        order.sort_by(|a, b| table[b].priority.cmp(&table[a].priority));
+        
+        let old_rules = std::mem::replace(&mut self.rules, table);
+        let old_order = std::mem::replace(&mut self.order, order);
+        
+        let reset_ids: Vec<u32> = self.rules.keys().copied().collect();
+        let result = self.compile_rules()
+            .and_then(|(compiled, rule_values)| self.stage_classifier(compiled, rule_values, &reset_ids));
+        if let Err(e) = result {
+            self.rules = old_rules;
+            self.order = old_order;
+            return Err(e);
+        }
+        
+        // 만료 타이머 재구성
+        self.expiry = TimerWheel::new(now_ns / (EXPIRY_TICK_MS * 1_000_000));
+        for rule in self.rules.values() {
+            if rule.expire_deadline_ns != 0 {
+                self.expiry.insert(
+                    deadline_to_tick(rule.expire_deadline_ns),
+                    (rule.label.clone(), rule.expire_deadline_ns),
+                );
+            }
+        }
+        
+        info!("Rule set replaced: {} rules in {:?}", self.rules.len(), started.elapsed());
+        
+        Ok(())
+    }
+    
+    /// 리디렉션 대상 devmap/cpumap 항목 설정 (SYN 프록시는 커널 지원 확인)
+    fn prepare_redirect(&self, rule: &FilterRule) -> Result<()> {
         if rule.action == 3 && rule.redirect_ifindex != 0 {
+            // devmap 값 = 대상 ifindex
             let key = rule.redirect_ifindex.to_le_bytes();
-            let if_redirect = self.create_if_redirect(rule.redirect_ifindex, &format!("if{}", rule.redirect_ifindex))?;
             
             if let Some(map) = self.redirect_map() {
-                map.update(&key, &if_redirect, libbpf_rs::MapFlags::ANY)
+                map.update(&key, &key, libbpf_rs::MapFlags::ANY)
                     .context("Failed to update redirect_map")?;
             } else {
                 return Err(anyhow!("Failed to update redirect_map"));
             }
+        } else if rule.action == 5 {
+            if rule.redirect_cpu as usize >= libbpf_rs::num_possible_cpus()? {
+                return Err(anyhow!("Invalid redirect CPU: {}", rule.redirect_cpu));
+            }
+            
+            // cpumap 값 = 대상 CPU의 큐 크기 (커널이 CPU별 kthread 생성)
+            let key = rule.redirect_cpu.to_le_bytes();
+            
+            if let Some(map) = self.cpu_map {
+                map.update(&key, &CPUMAP_QUEUE_SIZE.to_le_bytes(), libbpf_rs::MapFlags::ANY)
+                    .context("Failed to update cpu_map")?;
+            } else {
+                return Err(anyhow!("Failed to update cpu_map"));
+            }
+        } else if rule.action == 7 && !bpf::syncookie_supported() {
+            return Err(anyhow!("Synproxy action requires a kernel with bpf_tcp_raw_gen_syncookie_ipv4 (5.20+)"));
         }
         
-        // 로컬 캐시 업데이트
-        self.rules.push(rule);
-        
         Ok(())
     }
     
+    /// 만료된 규칙 일괄 삭제 (분류기는 한 번만 재컴파일)
+    pub fn expire_rules(&mut self) -> Result<usize> {
+        let now_ns = monotonic_now_ns();
+        let expired = self.expiry.advance(now_ns / (EXPIRY_TICK_MS * 1_000_000));
+        
+        // 삭제되거나 같은 레이블로 다시 추가된 규칙의 타이머는 무시
+        let mut removed = Vec::new();
+        for (label, deadline) in expired {
+            let position = self.order.iter()
+                .position(|id| self.rules[id].label == label && self.rules[id].expire_deadline_ns == deadline);
+            
+            if let Some(position) = position {
+                let rule_id = self.order.remove(position);
+                if let Some(rule) = self.rules.remove(&rule_id) {
+                    removed.push((position, rule_id, rule));
+                }
+            }
+        }
+        
+        if removed.is_empty() {
+            return Ok(0);
+        }
+        
+        if let Err(e) = self.sync_classifier() {
+            // 삭제 역순으로 복원
+            for (position, rule_id, rule) in removed.into_iter().rev() {
+                self.order.insert(position, rule_id);
+                self.rules.insert(rule_id, rule);
+            }
+            return Err(e);
+        }
+        
+        for (_, _, rule) in &removed {
+            debug!("Rule expired: {}", rule.label);
+        }
+        
+        Ok(removed.len())
+    }
+    
+    /// 레이블이 label인 규칙이 있는지 확인
+    pub fn has_rule(&self, label: &str) -> bool {
+        self.rules.values().any(|rule| rule.label == label)
+    }
+    
     /// 규칙 삭제
     pub fn delete_rule(&mut self, label: &str) -> Result<bool> {
         debug!("Deleting rule: {}", label);
         
-        let rule_index = self.rules.iter().position(|r| r.label == label);
+        let position = self.order.iter().position(|id| self.rules[id].label == label);
         
-        if let Some(index) = rule_index {
-            let rule = &self.rules[index];
+        if let Some(position) = position {
+            let rule_id = self.order.remove(position);
+            let rule = self.rules.remove(&rule_id)
+                .ok_or_else(|| anyhow!("Rule table out of sync for id {}", rule_id))?;
             
-            // 소스 IP 규칙 삭제 (있는 경우)
-            if let Some((src_ip, prefix_len)) = rule.src_ip {
-                let key = self.create_prefix_key(src_ip, prefix_len);
-                
-                if let Some(map) = self.filter_rules_map() {
-                    map.delete(&key)
-                        .context("Failed to delete from filter_rules map")?;
-                } else {
-                    return Err(anyhow!("Failed to get filter_rules map"));
-                }
+            // 분류기 재컴파일
+            if let Err(e) = self.sync_classifier() {
+                self.order.insert(position, rule_id);
+                self.rules.insert(rule_id, rule);
+                return Err(e);
             }
             
-            // 로컬 캐시 업데이트
-            self.rules.remove(index);
-            
             Ok(true)
         } else {
             Ok(false)
         }
     }
     
-    /// 규칙 목록 조회
-    pub fn list_rules(&self, include_stats: bool) -> Result<Vec<RuleInfo>> {
-        let mut result = Vec::new();
-        
-        for rule in &self.rules {
-            let stats = if include_stats {
-                // 규칙 통계 조회
-                if let Some((src_ip, prefix_len)) = rule.src_ip {
-                    let key = self.create_prefix_key(src_ip, prefix_len);
-                    
-//                    if let Ok(value) = self.filter_rules_map.lookup(&key, 0) {
-                    if let Some(map) = self.filter_rules_map() {
-                        if let Ok(Some(value)) = map.lookup(&key, MapFlags::empty()) {
-                            if value.len() >= std::mem::size_of::<RuleStats>() {
-                                let stats_offset = value.len() - std::mem::size_of::<RuleStats>();
-                                let stats_bytes = &value[stats_offset..];
-                            
-                                // 통계 데이터 파싱
-                                let packets = u64::from_le_bytes([
-                                    stats_bytes[0], stats_bytes[1], stats_bytes[2], stats_bytes[3],
-                                    stats_bytes[4], stats_bytes[5], stats_bytes[6], stats_bytes[7],
-                                ]);
-                            
-                                let bytes = u64::from_le_bytes([
-                                    stats_bytes[8], stats_bytes[9], stats_bytes[10], stats_bytes[11],
-                                    stats_bytes[12], stats_bytes[13], stats_bytes[14], stats_bytes[15],
-                                ]);
-                            
-                                let last_matched = u64::from_le_bytes([
-                                    stats_bytes[16], stats_bytes[17], stats_bytes[18], stats_bytes[19],
-                                    stats_bytes[20], stats_bytes[21], stats_bytes[22], stats_bytes[23],
-                                ]);
-                            
-                                RuleStats {
-                                    packets,
-                                    bytes,
-                                    last_matched,
-                                
-                                }
-                            } else {
-                                 RuleStats {
-                                    packets: 0,
-                                    bytes: 0,
-                                    last_matched: 0,
-                                }
-                            }
-                        } else {
-                            RuleStats {
-                                packets: 0,
-                                bytes: 0,
-                                last_matched: 0,
-                            }
-                        }
-                    } else {
-                        RuleStats {
-                            packets: 0,
-                            bytes: 0,
-                            last_matched: 0,
-                        }
-                    }
-                } else {
-                    RuleStats {
-                        packets: 0,
-                        bytes: 0,
-                        last_matched: 0,
-                    }
-                }
-            } else {
-                RuleStats {
-                    packets: 0,
-                    bytes: 0,
-                    last_matched: 0,
-                }
-            };
-            
-            
-            result.push(rule.to_rule_info(stats));
+    /// 규칙의 이벤트 샘플링 비율 변경 (규칙이 없으면 false)
+    ///
+    /// 비트 위치는 그대로이고 판정 레코드만 바뀌므로 해당 항목 하나만 제자리에서 다시 기록된다.
+    pub fn set_sample_rate(&mut self, label: &str, sample_rate: u16) -> Result<bool> {
+        let rule_id = match self.order.iter().find(|id| self.rules[id].label == label) {
+            Some(rule_id) => *rule_id,
+            None => return Ok(false),
+        };
+        
+        let rule = self.rules.get_mut(&rule_id)
+            .ok_or_else(|| anyhow!("Rule table out of sync for id {}", rule_id))?;
+        let previous = std::mem::replace(&mut rule.sample_rate, sample_rate);
+        
+        if let Err(e) = self.sync_classifier() {
+            if let Some(rule) = self.rules.get_mut(&rule_id) {
+                rule.sample_rate = previous;
+            }
+            return Err(e);
         }
         
-        Ok(result)
+        Ok(true)
     }
     
-    /// 전체 통계 조회
-    pub fn get_stats(&self) -> Result<(u64, u64)> {
-        let key = 0u32.to_le_bytes();
+    /// 규칙별 통계 초기화 (모든 CPU 슬롯)
+    fn reset_rule_stats(&self, rule_id: u32) -> Result<()> {
+        let map = self.rule_stats_map
+            .ok_or_else(|| anyhow!("Failed to get rule_stats map"))?;
+        let ncpus = libbpf_rs::num_possible_cpus()?;
+        let zeros = vec![vec![0u8; size_of::<abi::filter_stats>()]; ncpus];
         
-//        if let Ok(value) = self.stats_map.lookup(&key, 0) {
-        if let Some(map) = self.stats_map() {
-            if let Ok(Some(value)) = map.lookup(&key, MapFlags::empty()) {
-                if value.len() >= 16 {
-                    // 통계 데이터 파싱
-                    let packets = u64::from_le_bytes([
-                        value[0], value[1], value[2], value[3],
-                        value[4], value[5], value[6], value[7],
-                    ]);
-                
-                    let bytes = u64::from_le_bytes([
-                        value[8], value[9], value[10], value[11],
-                        value[12], value[13], value[14], value[15],
-                    ]);
-                
-                    Ok((packets, bytes))
-                } else {
-                    Ok((0, 0))
-                }
-            } else {
-                Ok((0, 0))
-            }
-        } else {
-            Ok((0, 0))
+        map.update_percpu(&rule_id.to_le_bytes(), &zeros, MapFlags::ANY)
+            .context("Failed to reset rule_stats")?;
+        
+        Ok(())
+    }
+    
+    /// 규칙별 토큰 버킷 초기화 (빈 버킷은 첫 패킷에서 가득 채워짐)
+    fn reset_rule_bucket(&self, rule_id: u32) -> Result<()> {
+        let map = self.rule_buckets_map
+            .ok_or_else(|| anyhow!("Failed to get rule_buckets map"))?;
+        
+        map.update(&rule_id.to_le_bytes(), abi::as_bytes(&abi::token_bucket::default()), MapFlags::ANY)
+            .context("Failed to reset rule_buckets")?;
+        
+        Ok(())
+    }
+    
+    /// 여러 규칙 ID의 통계 및 토큰 버킷 일괄 초기화
+    fn reset_rule_state_batch(&self, rule_ids: &[u32]) -> Result<()> {
+        if rule_ids.is_empty() {
+            return Ok(());
         }
+        
+        let stats_map = self.rule_stats_map
+            .ok_or_else(|| anyhow!("Failed to get rule_stats map"))?;
+        let ncpus = libbpf_rs::num_possible_cpus()?;
+        let zeros = vec![0u8; rule_ids.len() * ncpus * size_of::<abi::filter_stats>()];
+        ruleset::update_batch_fd(stats_map.fd(), "rule_stats", rule_ids, &zeros)
+            .context("Failed to reset rule_stats")?;
+        
+        let buckets_map = self.rule_buckets_map
+            .ok_or_else(|| anyhow!("Failed to get rule_buckets map"))?;
+        let zeros = vec![0u8; rule_ids.len() * size_of::<abi::token_bucket>()];
+        ruleset::update_batch_fd(buckets_map.fd(), "rule_buckets", rule_ids, &zeros)
+            .context("Failed to reset rule_buckets")?;
+        
+        Ok(())
     }
     
-    /// 프리픽스 키 생성
-    fn create_prefix_key(&self, addr: u32, prefix_len: u32) -> Vec<u8> {
-        let mut key = Vec::with_capacity(8);
+    /// 규칙 집합을 분류기로 컴파일하여 데이터 경로에 반영
+    ///
+    /// 비트 위치나 비트맵이 바뀌면 비활성 슬롯에 새 집합을 준비해 원자적으로 전환한다.
+    /// 제자리에서 여러 항목을 기록하면 데이터 경로가 새 비트맵과 이전 판정 레코드의
+    /// 조합으로 다른 규칙의 액션을 적용할 수 있기 때문이다. 모든 비트 위치의 규칙이
+    /// 그대로이고 판정 레코드 값만 바뀐 경우(샘플링 비율 변경 등)에만 해당 항목을
+    /// 활성 슬롯에 직접 기록한다.
+    fn sync_classifier(&mut self) -> Result<()> {
+        let (compiled, rule_values) = self.compile_rules()?;
+        
+        let set = match self.rule_set.as_ref() {
+            Some(set) if verdicts_only_changed(self.compiled.as_ref(), &self.rule_values, &compiled, &rule_values) => set,
+            _ => return self.stage_classifier(compiled, rule_values, &[]),
+        };
+        
+        // 바뀐 판정 레코드가 쓸 단계를 먼저 연결
+        let stages = self.required_stages();
+        self.pipeline.link(stages)?;
         
-        // 프리픽스 길이 (u32)
-        key.extend_from_slice(&prefix_len.to_le_bytes());
+        // 같은 규칙의 판정 레코드만 덮어쓰므로 기록 중인 항목을 읽어도 다른 규칙과 섞이지 않음
+        for (index, value) in rule_values.iter().enumerate() {
+            if self.rule_values[index] != *value {
+                set.filter_rules.update(&(index as u32).to_le_bytes(), value)?;
+            }
+        }
+        
+        // 구성은 마지막에 기록 (세대 증가로 이전 판정 레코드를 담은 흐름 캐시 항목 무효화)
+        let generation = self.write_config(&compiled, self.active_slot)?;
+        self.pipeline.unlink_unused(stages);
         
-        // IPv4 주소 (u32)
-        key.extend_from_slice(&addr.to_le_bytes());
+        debug!("Classifier compiled: {} rules, {}/{} src prefixes, {}/{} dst prefixes (v4/v6)",
+            compiled.nrules, compiled.src_v4.len(), compiled.src_v6.len(),
+            compiled.dst_v4.len(), compiled.dst_v6.len());
         
-        key
+        self.rule_values = rule_values;
+        self.compiled = Some(compiled);
+        self.generation = generation;
+        self.publish_snapshot();
+        
+        Ok(())
     }
     
-    /// 필터 규칙 생성
-    fn create_filter_rule(&self, rule: &FilterRule) -> Result<Vec<u8>> {
-        let mut value = Vec::new();
+    /// 현재 규칙 테이블과 블록리스트가 사용하는 파이프라인 단계
+    fn required_stages(&self) -> StageSet {
+        let mut stages = StageSet::required(self.rules.values());
+        // 블록리스트는 분류 단계에서 규칙보다 먼저 확인
+        if self.blocklists.len_v4() > 0 {
+            stages.insert(pipeline::STAGE_CLASSIFY_V4);
+        }
+        if self.blocklists.len_v6() > 0 {
+            stages.insert(pipeline::STAGE_CLASSIFY_V6);
+        }
+        stages
+    }
+    
+    /// 블록리스트 name의 내용을 list로 교체 (없으면 추가, 맵에 기록된 프리픽스 수 반환)
+    ///
+    /// 바뀐 프리픽스만 기록하며 규칙 집합과 흐름 캐시에는 영향을 주지 않는다.
+    /// 매치 결과는 드롭뿐이므로 교체 중 잠시 이전/새 프리픽스가 섞여 보여도 무방하다.
+    pub fn replace_blocklist(&mut self, name: &str, list: &PrefixList) -> Result<usize> {
+        let started = Instant::now();
+        let changes = self.blocklists.replace(name, list)?;
+        self.apply_blocklist(&changes)?;
+        
+        info!("Blocklist {} loaded: {} IPv4, {} IPv6 prefixes in {:?}",
+            name, list.v4.len(), list.v6.len(), started.elapsed());
+        Ok(self.blocklists.len_v4() + self.blocklists.len_v6())
+    }
+    
+    /// 블록리스트 삭제 (없으면 false)
+    pub fn delete_blocklist(&mut self, name: &str) -> Result<bool> {
+        match self.blocklists.remove(name) {
+            Some(changes) => {
+                self.apply_blocklist(&changes)?;
+                Ok(true)
+            }
+            None => Ok(false),
+        }
+    }
+    
+    /// 블록리스트 맵의 항목 중 소속이 없는 항목 삭제 (삭제한 항목 수 반환)
+    ///
+    /// 고정된 맵을 재사용하면 이전 데몬이 기록한 프리픽스가 남아 있으므로, 구성의
+    /// 블록리스트를 다시 불러온 뒤 호출한다.
+    pub fn prune_blocklists(&mut self) -> Result<usize> {
+        let mut stale = Vec::new();
+        
+        // 키의 주소는 네트워크 순서
+        if let Some(map) = self.blocklist_v4_map {
+            for key in map.keys() {
+                if let Some(prefix) = abi::from_bytes::<abi::prefix_key>(&key) {
+                    if !self.blocklists.contains_v4((u32::from_be(prefix.addr), prefix.prefix_len)) {
+                        stale.push((map, key));
+                    }
+                }
+            }
+        }
         
-        // priority (u32)
-        value.extend_from_slice(&rule.priority.to_le_bytes());
+        if let Some(map) = self.blocklist_v6_map {
+            for key in map.keys() {
+                if let Some(prefix) = abi::from_bytes::<abi::prefix_key_v6>(&key) {
+                    if !self.blocklists.contains_v6((u128::from_be_bytes(prefix.addr), prefix.prefix_len)) {
+                        stale.push((map, key));
+                    }
+                }
+            }
+        }
         
-        // action (u8)
-        value.push(rule.action);
+        for (map, key) in &stale {
+            map.delete(key).context("Failed to delete stale blocklist prefix")?;
+        }
+        self.write_blocklist_config()?;
+        self.pipeline.unlink_unused(self.required_stages());
         
-        // protocol (u8)
-        value.push(rule.protocol);
+        Ok(stale.len())
+    }
+    
+    /// 블록리스트 변경분을 맵에 기록
+    ///
+    /// 분류 단계를 먼저 연결하고, 추가/갱신 후 삭제하며, 프리픽스 수는 마지막에 기록한다.
+    fn apply_blocklist(&mut self, changes: &BlocklistChanges) -> Result<()> {
+        if changes.new_id {
+            self.reset_blocklist_stats(changes.id)?;
+        }
+        self.pipeline.link(self.required_stages())?;
         
-        // src_port_min (u16)
-        value.extend_from_slice(&rule.src_port_min.to_le_bytes());
+        let v4_map = self.blocklist_v4_map
+            .ok_or_else(|| anyhow!("Failed to get blocklist_v4 map"))?;
+        for ((addr, prefix_len), id) in &changes.v4.updates {
+            v4_map.update(&create_prefix_key(*addr, *prefix_len), &id.to_le_bytes(), MapFlags::ANY)
+                .context("Failed to update blocklist_v4")?;
+        }
         
-        // src_port_max (u16)
-        value.extend_from_slice(&rule.src_port_max.to_le_bytes());
+        let v6_map = self.blocklist_v6_map
+            .ok_or_else(|| anyhow!("Failed to get blocklist_v6 map"))?;
+        for ((addr, prefix_len), id) in &changes.v6.updates {
+            v6_map.update(&create_prefix_key_v6(*addr, *prefix_len), &id.to_le_bytes(), MapFlags::ANY)
+                .context("Failed to update blocklist_v6")?;
+        }
         
-        // dst_port_min (u16)
-        value.extend_from_slice(&rule.dst_port_min.to_le_bytes());
+        for (addr, prefix_len) in &changes.v4.deletes {
+            v4_map.delete(&create_prefix_key(*addr, *prefix_len))
+                .context("Failed to delete from blocklist_v4")?;
+        }
+        for (addr, prefix_len) in &changes.v6.deletes {
+            v6_map.delete(&create_prefix_key_v6(*addr, *prefix_len))
+                .context("Failed to delete from blocklist_v6")?;
+        }
         
-        // dst_port_max (u16)
-        value.extend_from_slice(&rule.dst_port_max.to_le_bytes());
+        self.write_blocklist_config()?;
+        self.pipeline.unlink_unused(self.required_stages());
+        self.publish_snapshot();
         
-        // tcp_flags (u8)
-        value.push(rule.tcp_flags);
+        Ok(())
+    }
+    
+    /// blocklist_config 기록 (주소 계열별 프리픽스 수, 0이면 데이터 경로가 조회 생략)
+    fn write_blocklist_config(&self) -> Result<()> {
+        let map = self.blocklist_config_map
+            .ok_or_else(|| anyhow!("Failed to get blocklist_config map"))?;
         
-        // redirect_ifindex (u32)
-        value.extend_from_slice(&rule.redirect_ifindex.to_le_bytes());
+        let config = abi::blocklist_config {
+            nv4: self.blocklists.len_v4() as u32,
+            nv6: self.blocklists.len_v6() as u32,
+        };
+        map.update(&0u32.to_le_bytes(), abi::as_bytes(&config), MapFlags::ANY)
+            .context("Failed to update blocklist_config map")?;
         
-        // rate_limit (u32)
-        value.extend_from_slice(&rule.rate_limit.to_le_bytes());
+        Ok(())
+    }
+    
+    /// 블록리스트별 통계 초기화 (모든 CPU 슬롯)
+    fn reset_blocklist_stats(&self, id: u32) -> Result<()> {
+        let map = self.blocklist_stats_map
+            .ok_or_else(|| anyhow!("Failed to get blocklist_stats map"))?;
+        let ncpus = libbpf_rs::num_possible_cpus()?;
+        let zeros = vec![vec![0u8; size_of::<abi::filter_stats>()]; ncpus];
         
-        // expire (u32)
-        value.extend_from_slice(&rule.expire.to_le_bytes());
+        map.update_percpu(&id.to_le_bytes(), &zeros, MapFlags::ANY)
+            .context("Failed to reset blocklist_stats")?;
         
-        // label (char[32])
-        let mut label_bytes = [0u8; 32];
-        for (i, b) in rule.label.as_bytes().iter().enumerate() {
-            if i < 31 {
-                label_bytes[i] = *b;
-            }
+        Ok(())
+    }
+    
+    /// 현재 규칙 테이블을 분류기와 판정 레코드(비트 위치 순서)로 컴파일
+    fn compile_rules(&self) -> Result<(CompiledClassifier, Vec<Vec<u8>>)> {
+        // 특화 변형이 처리하지 못하는 규칙 거부 (해당 검사가 데이터 경로에 없음)
+        for rule_id in &self.order {
+            self.features.check(&self.rules[rule_id])?;
         }
-        value.extend_from_slice(&label_bytes);
         
-        // stats (구조체)
-        value.extend_from_slice(&[0u8; 24]); // packets, bytes, last_matched (u64 * 3)
+        let fields: Vec<MatchFields> = self.order.iter().map(|id| self.rules[id].match_fields()).collect();
+        let compiled = classifier::compile(&fields)?;
+        
+        let rule_values = self.order.iter()
+            .map(|rule_id| create_rule_verdict(*rule_id, &self.rules[rule_id]))
+            .collect();
         
-        Ok(value)
+        Ok((compiled, rule_values))
     }
     
-    /// 리디렉션 인터페이스 생성
-    fn create_if_redirect(&self, ifindex: u32, ifname: &str) -> Result<Vec<u8>> {
-        let mut value = Vec::new();
+    /// 비활성 슬롯에 규칙 집합을 준비한 뒤 전환
+    ///
+    /// 비활성 슬롯에 이전 집합의 내부 맵이 남아 있으면 바뀐 항목만 다시 기록해 재사용하고,
+    /// 없으면(처음 설치, 이전 데몬의 집합 이어받기, 실패한 스테이징 뒤) 새 내부 맵에 전체를
+    /// 기록해 설치한다. 규칙 하나의 추가, 삭제, 만료도 이 경로를 거치므로 맵 생성과
+    /// 전체 기록을 매번 반복하지 않는다.
+    fn stage_classifier(
+        &mut self,
+        compiled: CompiledClassifier,
+        rule_values: Vec<Vec<u8>>,
+        reset_ids: &[u32],
+    ) -> Result<()> {
+        let started = Instant::now();
+        let stages = self.required_stages();
+        self.pipeline.link(stages)?;
         
-        // ifindex (u32)
-        value.extend_from_slice(&ifindex.to_le_bytes());
+        // 비활성 슬롯 (아직 아무 집합도 설치되지 않았으면 비어 있는 활성 슬롯,
+        // 이전 데몬의 집합을 이어받았으면 세대가 0이 아님)
+        let slot = if self.rule_set.is_some() || self.generation != 0 {
+            (self.active_slot + 1) % ruleset::SLOTS
+        } else {
+            self.active_slot
+        };
         
-        // ifname (char[16])
-        let mut ifname_bytes = [0u8; 16];
-        for (i, b) in ifname.as_bytes().iter().enumerate() {
-            if i < 15 {
-                ifname_bytes[i] = *b;
+        // 기록 도중 실패하면 내용을 알 수 없으므로 재사용하지 않음 (take)
+        let set = match self.standby.take() {
+            Some(standby) => {
+                // map-in-map 외부 맵 갱신은 실행 중인 XDP 프로그램이 끝날 때까지 기다리므로
+                // (synchronize_rcu), 전환 전에 이 슬롯을 읽기 시작한 패킷이 남아 있지 않다
+                ruleset::install(self.filter_rules_map, "filter_rules", slot, &standby.maps.filter_rules)?;
+                write_rule_set(&standby.maps, Some((&standby.compiled, &standby.rule_values[..])),
+                               &compiled, &rule_values)?;
+                standby.maps
             }
-        }
-        value.extend_from_slice(&ifname_bytes);
+            None => {
+                let set = RuleSetMaps::create()?;
+                write_rule_set(&set, None, &compiled, &rule_values)?;
+                ruleset::install(self.filter_rules_map, "filter_rules", slot, &set.filter_rules)?;
+                ruleset::install(self.cls_src_v4_map, "cls_src_v4", slot, &set.src_v4)?;
+                ruleset::install(self.cls_dst_v4_map, "cls_dst_v4", slot, &set.dst_v4)?;
+                ruleset::install(self.cls_src_v6_map, "cls_src_v6", slot, &set.src_v6)?;
+                ruleset::install(self.cls_dst_v6_map, "cls_dst_v6", slot, &set.dst_v6)?;
+                ruleset::install(self.cls_port_class_map, "cls_port_class", slot, &set.port_class)?;
+                ruleset::install(self.cls_bitmaps_map, "cls_bitmaps", slot, &set.bitmaps)?;
+                set
+            }
+        };
+        
+        // 새 집합이 사용할 규칙 ID의 통계 및 토큰 버킷 초기화
+        self.reset_rule_state_batch(reset_ids)?;
+        
+        // 활성 슬롯 전환 후 이전 집합만 쓰던 단계 분리
+        let generation = self.write_config(&compiled, slot)?;
+        self.pipeline.unlink_unused(stages);
+        
+        info!("Rule set staged in slot {}: {} rules, {} prefixes in {:?}",
+            slot, compiled.nrules,
+            compiled.src_v4.len() + compiled.dst_v4.len() + compiled.src_v6.len() + compiled.dst_v6.len(),
+            started.elapsed());
+        
+        // 이전 활성 집합은 다음 스테이징에서 재사용 (외부 맵의 이전 슬롯에 설치된 그대로)
+        let previous = self.rule_set.replace(set).zip(self.compiled.replace(compiled));
+        let previous_values = std::mem::replace(&mut self.rule_values, rule_values);
+        self.standby = previous.map(|(maps, compiled)| StandbySet {
+            maps,
+            compiled,
+            rule_values: previous_values,
+        });
+        self.active_slot = slot;
+        self.generation = generation;
+        self.publish_snapshot();
+        
+        Ok(())
+    }
+    
+    /// cls_config 기록 (활성 슬롯과 증가된 세대, 기록된 세대 반환)
+    fn write_config(&self, compiled: &CompiledClassifier, slot: u32) -> Result<u32> {
+        let config_map = self.cls_config_map
+            .ok_or_else(|| anyhow!("Failed to get cls_config map"))?;
+        let generation = self.generation.wrapping_add(1);
+        
+        let config = abi::cls_config {
+            nwords: compiled.nwords,
+            nrules: compiled.nrules,
+            generation,
+            active: slot,
+        };
+        config_map.update(&0u32.to_le_bytes(), abi::as_bytes(&config), MapFlags::ANY)
+            .context("Failed to update cls_config map")?;
         
-        Ok(value)
+        Ok(generation)
+    }
+    
+    /// 규칙 목록 조회 (우선순위 순서)
+    pub fn list_rules(&self, include_stats: bool) -> Result<Vec<RuleInfo>> {
+        self.reader().list_rules(include_stats)
+    }
+    
+    /// 전체 통계 조회 (모든 판정 합계)
+    pub fn get_stats(&self) -> Result<(u64, u64)> {
+        if let Some(map) = self.stats_map() {
+            let verdicts = telemetry::read_verdict_stats(map)?;
+            Ok((
+                verdicts.iter().map(|v| v.packets).sum(),
+                verdicts.iter().map(|v| v.bytes).sum(),
+            ))
+        } else {
+            Ok((0, 0))
+        }
+    }
+}
+
+/// 판정 레코드 생성 (struct rule_verdict)
+fn create_rule_verdict(rule_id: u32, rule: &FilterRule) -> Vec<u8> {
+    // redirect_target: CPU 리디렉션이면 CPU 번호, 아니면 ifindex
+    let redirect_target = if rule.action == abi::ACTION_REDIRECT_CPU as u8 {
+        rule.redirect_cpu
+    } else {
+        rule.redirect_ifindex
+    };
+    
+    let mut flags = 0u8;
+    if rule.rate_limit_per_source {
+        flags |= RULE_F_RATE_PER_SRC;
+    }
+    
+    let value = abi::rule_verdict {
+        rule_id,
+        redirect_target,
+        rate_limit: rule.rate_limit,
+        action: rule.action,
+        flags,
+        sample_rate: rule.sample_rate,
+        expire_ns: rule.expire_deadline_ns,
+    };
+    
+    abi::as_bytes(&value).to_vec()
+}
+
+/// 활성 슬롯의 분류기와 비교해 판정 레코드 값만 바뀌었는지 확인
+///
+/// 비트맵과 프리픽스가 같고, 모든 비트 위치의 규칙 ID가 같아야 한다.
+fn verdicts_only_changed(
+    prev: Option<&CompiledClassifier>,
+    prev_values: &[Vec<u8>],
+    next: &CompiledClassifier,
+    next_values: &[Vec<u8>],
+) -> bool {
+    let rule_id = |value: &[u8]| abi::from_bytes::<abi::rule_verdict>(value).map(|v| v.rule_id);
+    
+    prev == Some(next)
+        && prev_values.len() == next_values.len()
+        && prev_values.iter().zip(next_values).all(|(a, b)| rule_id(a) == rule_id(b))
+}
+
+/// 규칙 집합을 내부 맵에 기록 (prev = 맵에 이미 기록된 내용, None이면 0으로 초기화된 새 맵)
+///
+/// prev와 다른 항목만 기록한다. prev에만 있는 항목은 배열 맵에서는 0으로 되돌리고
+/// LPM 트라이에서는 삭제한다. 배열 맵은 BPF_MAP_UPDATE_BATCH로 기록하고, LPM 트라이는
+/// 일괄 기록을 지원하지 않는다.
+fn write_rule_set(
+    set: &RuleSetMaps,
+    prev: Option<(&CompiledClassifier, &[Vec<u8>])>,
+    compiled: &CompiledClassifier,
+    rule_values: &[Vec<u8>],
+) -> Result<()> {
+    let (prev, prev_values) = match prev {
+        Some((prev, prev_values)) => (Some(prev), prev_values),
+        None => (None, &[][..]),
+    };
+    
+    // 규칙 값 (비트 위치 순서, 규칙 수가 줄면 남는 위치는 0)
+    let zero_value = vec![0u8; ruleset::RULE_VERDICT_SIZE as usize];
+    let mut keys = Vec::new();
+    let mut values = Vec::new();
+    for index in 0..rule_values.len().max(prev_values.len()) {
+        let value = rule_values.get(index).unwrap_or(&zero_value);
+        if prev_values.get(index).unwrap_or(&zero_value) != value {
+            keys.push(index as u32);
+            values.extend_from_slice(value);
+        }
+    }
+    set.filter_rules.update_batch(&keys, &values)?;
+    
+    // 포트 클래스 (새 맵은 모두 클래스 0)
+    let (keys, values): (Vec<u32>, Vec<u8>) = compiled.port_class.iter()
+        .enumerate()
+        .filter(|(index, class)| prev.map_or(0, |prev| prev.port_class[*index]) != **class)
+        .fold((Vec::new(), Vec::new()), |(mut keys, mut values), (index, class)| {
+            keys.push(index as u32);
+            values.extend_from_slice(&class.to_le_bytes());
+            (keys, values)
+        });
+    set.port_class.update_batch(&keys, &values)?;
+    
+    // 프로토콜/플래그/포트 클래스 비트맵 (없는 인덱스는 빈 비트맵)
+    let empty = RuleBitmap::new();
+    let prev_bitmap = |index: &u32| prev.and_then(|prev| prev.bitmaps.get(index)).unwrap_or(&empty);
+    let removed = prev.into_iter()
+        .flat_map(|prev| prev.bitmaps.keys())
+        .filter(|index| !compiled.bitmaps.contains_key(index))
+        .map(|index| (index, &empty));
+    let (keys, values): (Vec<u32>, Vec<u8>) = compiled.bitmaps.iter()
+        .chain(removed)
+        .filter(|(index, bitmap)| prev_bitmap(index) != *bitmap)
+        .fold((Vec::new(), Vec::new()), |(mut keys, mut values), (index, bitmap)| {
+            keys.push(*index);
+            values.extend_from_slice(bitmap.as_bytes());
+            (keys, values)
+        });
+    set.bitmaps.update_batch(&keys, &values)?;
+    
+    // 소스/대상 프리픽스
+    write_prefix_map(&set.src_v4, prev.map(|prev| &prev.src_v4), &compiled.src_v4, create_prefix_key)?;
+    write_prefix_map(&set.dst_v4, prev.map(|prev| &prev.dst_v4), &compiled.dst_v4, create_prefix_key)?;
+    write_prefix_map(&set.src_v6, prev.map(|prev| &prev.src_v6), &compiled.src_v6, create_prefix_key_v6)?;
+    write_prefix_map(&set.dst_v6, prev.map(|prev| &prev.dst_v6), &compiled.dst_v6, create_prefix_key_v6)?;
+    
+    Ok(())
+}
+
+/// 프리픽스 LPM 맵을 prefixes로 갱신 (용량을 넘지 않도록 삭제를 먼저 기록)
+fn write_prefix_map<A: Copy + Ord>(
+    map: &InnerMap,
+    prev: Option<&BTreeMap<(A, u32), RuleBitmap>>,
+    prefixes: &BTreeMap<(A, u32), RuleBitmap>,
+    create_key: fn(A, u32) -> Vec<u8>,
+) -> Result<()> {
+    for &(addr, prefix_len) in prev.into_iter().flat_map(|prev| prev.keys()) {
+        if !prefixes.contains_key(&(addr, prefix_len)) {
+            map.delete(&create_key(addr, prefix_len))?;
+        }
+    }
+    
+    for (&(addr, prefix_len), bitmap) in prefixes {
+        if prev.and_then(|prev| prev.get(&(addr, prefix_len))) != Some(bitmap) {
+            map.update(&create_key(addr, prefix_len), bitmap.as_bytes())?;
+        }
+    }
+    
+    Ok(())
+}
+
+/// IPv4 프리픽스 키 생성 (struct prefix_key)
+fn create_prefix_key(addr: u32, prefix_len: u32) -> Vec<u8> {
+    // LPM 트라이는 바이트 순서로 비교하므로 주소는 네트워크 순서
+    let key = abi::prefix_key {
+        prefix_len,
+        addr: (addr & classifier::prefix_mask(prefix_len)).to_be(),
+    };
+    
+    abi::as_bytes(&key).to_vec()
+}
+
+/// IPv6 프리픽스 키 생성 (struct prefix_key_v6)
+fn create_prefix_key_v6(addr: u128, prefix_len: u32) -> Vec<u8> {
+    // IPv6 주소 (16바이트, 네트워크 순서)
+    let key = abi::prefix_key_v6 {
+        prefix_len,
+        addr: (addr & classifier::prefix_mask_v6(prefix_len)).to_be_bytes(),
+    };
+    
+    abi::as_bytes(&key).to_vec()
+}
+
+/// 사용 중인 모든 규칙 ID의 통계 조회 (인덱스 = 규칙 ID, CPU별 값 합산)
+fn read_all_rule_stats(map: &Map, rule_ids: impl Iterator<Item = u32> + Clone) -> Result<Vec<RuleStats>> {
+    let count = match rule_ids.clone().max() {
+        Some(max_id) => max_id as usize + 1,
+        None => return Ok(Vec::new()),
+    };
+    
+    let mut table = vec![
+        RuleStats {
+            packets: 0,
+            bytes: 0,
+            last_matched: 0,
+        };
+        count
+    ];
+    
+    // 배치 조회로 한 번에 읽음 (규칙당 syscall 방지)
+    let mut values = PercpuTable::new(size_of::<abi::filter_stats>(), count)?;
+    values.read(map, count)?;
+    for rule_id in rule_ids {
+        for cpu in 0..values.ncpus() {
+            accumulate_rule_stats(&mut table[rule_id as usize], values.get(rule_id as usize, cpu));
+        }
+    }
+    
+    let boot_offset = monotonic_to_unix_offset_ns();
+    for stats in table.iter_mut() {
+        if stats.last_matched != 0 {
+            stats.last_matched = (stats.last_matched + boot_offset) / 1_000_000_000;
+        }
+    }
+    
+    Ok(table)
+}
+
+/// CPU 하나의 rule_stats 값을 누적 (packets, bytes 합산, last_matched 최대값)
+fn accumulate_rule_stats(stats: &mut RuleStats, value: &abi::filter_stats) {
+    stats.packets += value.packets;
+    stats.bytes += value.bytes;
+    stats.last_matched = stats.last_matched.max(value.last_matched);
+}
+
+/// 우선순위 순서의 (규칙 ID, 규칙)을 저장 (임시 파일에 쓴 뒤 이름을 바꿔 원자적으로 교체)
+///
+/// 만료 시각은 CLOCK_MONOTONIC 기준이지만 재부팅하면 고정된 맵도 사라지므로
+/// 같은 부팅 안에서만 복원된다.
+fn save_rules(path: &Path, rules: &[(u32, FilterRule)]) -> Result<()> {
+    if let Some(dir) = path.parent() {
+        std::fs::create_dir_all(dir)?;
+    }
+    
+    let tmp = path.with_extension("json.tmp");
+    std::fs::write(&tmp, serde_json::to_vec(rules)?)?;
+    std::fs::rename(&tmp, path)?;
+    
+    Ok(())
+}
+
+/// save_rules로 저장한 규칙 읽기 (파일이 없으면 빈 목록)
+///
+/// ID가 범위를 벗어나거나 중복되면 실패하고, now_ns까지 만료된 규칙은 건너뛴다.
+/// 나머지는 저장된 ID와 우선순위 순서를 유지한다.
+fn load_saved_rules(path: &Path, now_ns: u64) -> Result<Vec<(u32, FilterRule)>> {
+    let saved: Vec<(u32, FilterRule)> = match std::fs::read(path) {
+        Ok(data) => serde_json::from_slice(&data)
+            .with_context(|| format!("Failed to parse {}", path.display()))?,
+        Err(e) if e.kind() == std::io::ErrorKind::NotFound => return Ok(Vec::new()),
+        Err(e) => return Err(e).with_context(|| format!("Failed to read {}", path.display())),
+    };
+    
+    let mut seen = BTreeSet::new();
+    for (rule_id, _) in &saved {
+        if *rule_id as usize >= classifier::MAX_FILTER_RULES || !seen.insert(*rule_id) {
+            return Err(anyhow!("Invalid rule ID {} in {}", rule_id, path.display()));
+        }
+    }
+    
+    // 저장 후 만료된 규칙은 복원하지 않음
+    Ok(saved.into_iter()
+        .filter(|(_, rule)| rule.expire_deadline_ns == 0 || rule.expire_deadline_ns > now_ns)
+        .collect())
+}
+
+/// 현재 CLOCK_MONOTONIC 시각 (bpf_ktime_get_ns()와 같은 기준, ns)
+fn monotonic_now_ns() -> u64 {
+    let mut ts = libc::timespec { tv_sec: 0, tv_nsec: 0 };
+    unsafe {
+        libc::clock_gettime(libc::CLOCK_MONOTONIC, &mut ts);
+    }
+    ts.tv_sec as u64 * 1_000_000_000 + ts.tv_nsec as u64
+}
+
+/// 만료 시각을 타이머 휠 틱으로 변환 (올림)
+fn deadline_to_tick(deadline_ns: u64) -> u64 {
+    let tick_ns = EXPIRY_TICK_MS * 1_000_000;
+    (deadline_ns + tick_ns - 1) / tick_ns
+}
+
+/// bpf_ktime_get_ns() (CLOCK_MONOTONIC) 값을 UNIX 시간으로 바꾸기 위한 오프셋 (ns)
+pub fn monotonic_to_unix_offset_ns() -> u64 {
+    let mono_ns = monotonic_now_ns();
+    let unix_ns = SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_nanos() as u64)
+        .unwrap_or(0);
+    
+    unix_ns.saturating_sub(mono_ns)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn rule(label: &str, src_ip: (u32, u32)) -> FilterRule {
+        FilterRule {
+            src_ip: Some(src_ip),
+            dst_ip: None,
+            src_ip6: None,
+            dst_ip6: None,
+            src_port_min: 0,
+            src_port_max: 65535,
+            dst_port_min: 0,
+            dst_port_max: 65535,
+            protocol: 255,
+            tcp_flags: 0,
+            action: 2,
+            redirect_ifindex: 0,
+            redirect_cpu: 0,
+            priority: 0,
+            rate_limit: 0,
+            rate_limit_per_source: false,
+            sample_rate: 0,
+            expire: 0,
+            label: label.to_string(),
+            creation_time: 0,
+            expire_deadline_ns: 0,
+        }
+    }
+
+    /// 우선순위 순서의 (규칙 ID, 규칙) 컴파일
+    fn compile(rules: &[(u32, FilterRule)]) -> (CompiledClassifier, Vec<Vec<u8>>) {
+        let fields: Vec<MatchFields> = rules.iter().map(|(_, rule)| rule.match_fields()).collect();
+        let values = rules.iter().map(|(rule_id, rule)| create_rule_verdict(*rule_id, rule)).collect();
+        (classifier::compile(&fields).unwrap(), values)
+    }
+
+    #[test]
+    fn test_in_place_update() {
+        let rules = vec![(0, rule("a", (0x0A000000, 8))), (1, rule("b", (0x0A000000, 8)))];
+        let (prev, prev_values) = compile(&rules);
+
+        // 샘플링 비율만 바뀌면 제자리 갱신
+        let mut sampled = rules.clone();
+        sampled[1].1.sample_rate = 100;
+        let (next, next_values) = compile(&sampled);
+        assert!(verdicts_only_changed(Some(&prev), &prev_values, &next, &next_values));
+        assert!(!verdicts_only_changed(None, &[], &next, &next_values));
+
+        // 비트맵이 같아도 비트 위치의 규칙이 바뀌면 스테이징
+        let swapped = vec![rules[1].clone(), rules[0].clone()];
+        let (next, next_values) = compile(&swapped);
+        assert_eq!(next, prev);
+        assert!(!verdicts_only_changed(Some(&prev), &prev_values, &next, &next_values));
+
+        // 규칙 추가/삭제는 뒤쪽 규칙의 비트 위치를 옮김
+        let mut added = rules.clone();
+        added.insert(0, (2, rule("c", (0xC0A80000, 16))));
+        let (next, next_values) = compile(&added);
+        assert!(!verdicts_only_changed(Some(&prev), &prev_values, &next, &next_values));
+        let (next, next_values) = compile(&rules[1..]);
+        assert!(!verdicts_only_changed(Some(&prev), &prev_values, &next, &next_values));
+    }
+
+    #[test]
+    fn test_saved_rules() {
+        let dir = std::env::temp_dir().join(format!("swift-guard-maps-test-{}", std::process::id()));
+        let path = dir.join("rules.json");
+        let now_ns = 1_000_000_000;
+
+        let mut expired = rule("expired", (0x0A010000, 16));
+        expired.expire_deadline_ns = now_ns;
+        let mut pending = rule("pending", (0x0A020000, 16));
+        pending.expire_deadline_ns = now_ns + 1;
+        let rules = vec![
+            (7, rule("a", (0x0A000000, 8))),
+            (2, expired),
+            (5, pending),
+            (0, rule("b", (0xC0A80000, 16))),
+        ];
+
+        // 저장 순서와 ID 유지, 만료된 규칙은 제외
+        save_rules(&path, &rules).unwrap();
+        assert!(!path.with_extension("json.tmp").exists());
+        let restored = load_saved_rules(&path, now_ns).unwrap();
+        let ids: Vec<(u32, &str)> = restored.iter().map(|(id, rule)| (*id, rule.label.as_str())).collect();
+        assert_eq!(ids, vec![(7, "a"), (5, "pending"), (0, "b")]);
+        assert_eq!(restored[1].1.expire_deadline_ns, now_ns + 1);
+        assert_eq!(restored[2].1.src_ip, Some((0xC0A80000, 16)));
+
+        // 저장 파일이 없으면 빈 집합
+        assert!(load_saved_rules(&dir.join("missing.json"), now_ns).unwrap().is_empty());
+
+        // 중복 ID와 범위를 벗어난 ID는 거부
+        save_rules(&path, &[(1, rule("a", (0x0A000000, 8))), (1, rule("b", (0x0B000000, 8)))]).unwrap();
+        assert!(load_saved_rules(&path, now_ns).is_err());
+        save_rules(&path, &[(classifier::MAX_FILTER_RULES as u32, rule("a", (0x0A000000, 8)))]).unwrap();
+        assert!(load_saved_rules(&path, now_ns).is_err());
+
+        std::fs::write(&path, b"not json").unwrap();
+        assert!(load_saved_rules(&path, now_ns).is_err());
     }
 }
@@ -0,0 +1,91 @@
+//! BPF 맵 메모리 예산 모듈
+//! 맵 정의(형식, 키/값 크기, 최대 항목 수)로 커널 메모리 사용량 상한을 추정하고 예산과 비교
+
+use anyhow::{anyhow, Result};
+
+/// 맵 하나의 메모리 추정치
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct MapMemory {
+    pub name: String,
+    pub max_entries: u32,
+    /// 모든 항목이 채워졌을 때의 바이트 수
+    pub bytes: u64,
+}
+
+/// 해시 맵 항목 헤더 (struct htab_elem: 해시 노드, 해시값, 여유 목록 연결)
+const HTAB_ELEM_OVERHEAD: u64 = 48;
+/// LPM 트라이 노드 헤더 (struct lpm_trie_node: RCU 헤드, 자식 포인터 2개, 프리픽스 길이, 플래그)
+const LPM_NODE_OVERHEAD: u64 = 40;
+
+fn round_up8(size: u32) -> u64 {
+    (size as u64 + 7) & !7
+}
+
+/// 맵이 가득 찼을 때의 커널 메모리 추정치
+///
+/// 사전 할당하지 않는 맵(LPM 트라이 등)은 항목이 늘어날 때 이 값까지 커진다.
+/// 내부 맵 fd를 담는 배열과 프로그램 배열은 포인터 크기만 계산한다.
+pub fn estimate_bytes(map_type: u32, key_size: u32, value_size: u32, max_entries: u32, ncpus: usize) -> u64 {
+    let entries = max_entries as u64;
+    let ncpus = ncpus as u64;
+    let key = round_up8(key_size);
+    let value = round_up8(value_size);
+
+    match map_type {
+        libbpf_sys::BPF_MAP_TYPE_ARRAY => entries * value,
+        libbpf_sys::BPF_MAP_TYPE_PERCPU_ARRAY => entries * value * ncpus,
+        libbpf_sys::BPF_MAP_TYPE_HASH | libbpf_sys::BPF_MAP_TYPE_LRU_HASH => {
+            entries * (HTAB_ELEM_OVERHEAD + key + value)
+        }
+        libbpf_sys::BPF_MAP_TYPE_PERCPU_HASH | libbpf_sys::BPF_MAP_TYPE_LRU_PERCPU_HASH => {
+            entries * (HTAB_ELEM_OVERHEAD + key + 8 + value * ncpus)
+        }
+        libbpf_sys::BPF_MAP_TYPE_LPM_TRIE => {
+            // 키의 프리픽스 길이 필드는 노드 헤더에 포함되고 중간 노드가 항목 수만큼 더 생길 수 있음
+            2 * entries * (LPM_NODE_OVERHEAD + round_up8(key_size.saturating_sub(4) + value_size))
+        }
+        libbpf_sys::BPF_MAP_TYPE_RINGBUF => entries,
+        _ => entries * 8,
+    }
+}
+
+/// 예산(바이트)을 넘으면 큰 맵부터 나열한 오류 반환
+pub fn check_budget(maps: &[MapMemory], budget: u64) -> Result<()> {
+    let total: u64 = maps.iter().map(|m| m.bytes).sum();
+    if total <= budget {
+        return Ok(());
+    }
+
+    let mut largest: Vec<&MapMemory> = maps.iter().collect();
+    largest.sort_unstable_by(|a, b| b.bytes.cmp(&a.bytes));
+    let top: Vec<String> = largest.iter()
+        .take(3)
+        .map(|m| format!("{} {} MiB", m.name, m.bytes >> 20))
+        .collect();
+
+    Err(anyhow!(
+        "BPF maps need up to {} MiB, over the {} MiB memory budget (largest: {}); lower xdp.map_sizes or raise xdp.memory_budget_mb",
+        total >> 20, budget >> 20, top.join(", ")
+    ))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_budget() {
+        // 4M 항목 IPv4 블록리스트 (키 8바이트, 값 4바이트)
+        let blocklist = estimate_bytes(libbpf_sys::BPF_MAP_TYPE_LPM_TRIE, 8, 4, 4 << 20, 8);
+        assert_eq!(blocklist, 2 * (4 << 20) * 48);
+        assert_eq!(estimate_bytes(libbpf_sys::BPF_MAP_TYPE_PERCPU_ARRAY, 4, 24, 6, 4), 6 * 24 * 4);
+
+        let maps = vec![
+            MapMemory { name: "blocklist_v4".to_string(), max_entries: 4 << 20, bytes: blocklist },
+            MapMemory { name: "stats_map".to_string(), max_entries: 6, bytes: 576 },
+        ];
+        assert!(check_budget(&maps, 512 << 20).is_ok());
+        let err = check_budget(&maps, 256 << 20).unwrap_err().to_string();
+        assert!(err.contains("blocklist_v4 384 MiB"));
+    }
+}
@@ -0,0 +1,165 @@
+//! per-CPU 배열 맵 조회 모듈
+//! BPF_MAP_LOOKUP_BATCH로 per-CPU 배열을 재사용 버퍼에 읽어 CPU별 값 제공
+
+use anyhow::{anyhow, Result};
+use libbpf_rs::{Map, MapFlags};
+use log::debug;
+
+use crate::abi::Pod;
+
+/// 배치 조회 한 번에 읽는 최대 항목 수
+const LOOKUP_BATCH_SIZE: usize = 1024;
+
+/// per-CPU 배열 맵의 CPU별 값 버퍼
+///
+/// 버퍼는 생성 시 한 번 할당하고 조회마다 덮어쓴다.
+/// 항목 k의 CPU c 값은 (k * ncpus + c) * slot_size 위치에 있다.
+/// 버퍼가 u64 단위이므로 모든 슬롯이 8바이트 정렬되어 값 구조체로 바로 빌려 쓸 수 있다.
+#[derive(Debug)]
+pub struct PercpuTable {
+    value_size: usize,
+    /// 커널은 per-CPU 값을 CPU마다 8바이트 정렬된 슬롯으로 전달
+    slot_size: usize,
+    ncpus: usize,
+    capacity: usize,
+    /// 마지막 조회에서 읽은 항목 수
+    len: usize,
+    keys: Vec<u32>,
+    values: Vec<u64>,
+}
+
+impl PercpuTable {
+    /// 항목 capacity개를 담을 버퍼 생성
+    pub fn new(value_size: usize, capacity: usize) -> Result<Self> {
+        let ncpus = libbpf_rs::num_possible_cpus()?;
+        let slot_size = (value_size + 7) & !7;
+
+        Ok(Self {
+            value_size,
+            slot_size,
+            ncpus,
+            capacity,
+            len: 0,
+            keys: vec![0u32; LOOKUP_BATCH_SIZE.min(capacity.max(1))],
+            values: vec![0u64; capacity * ncpus * slot_size / 8],
+        })
+    }
+
+    pub fn ncpus(&self) -> usize {
+        self.ncpus
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// 맵의 [0, count) 항목 조회 (배치 조회를 지원하지 않는 커널은 항목별 조회로 대체)
+    pub fn read(&mut self, map: &Map, count: usize) -> Result<()> {
+        let count = count.min(self.capacity);
+        self.len = 0;
+
+        if let Err(e) = self.read_batch(map, count) {
+            debug!("Batch lookup on {} failed ({}), falling back to per-key lookup", map.name(), e);
+            self.read_each(map, count)?;
+        }
+
+        self.len = count;
+        Ok(())
+    }
+
+    fn read_batch(&mut self, map: &Map, count: usize) -> Result<()> {
+        // 항목 하나의 u64 개수
+        let stride = self.ncpus * self.slot_size / 8;
+        let mut out_batch = 0u32;
+        let mut read = 0usize;
+
+        let opts = libbpf_sys::bpf_map_batch_opts {
+            sz: std::mem::size_of::<libbpf_sys::bpf_map_batch_opts>() as libbpf_sys::size_t,
+            elem_flags: 0,
+            flags: 0,
+        };
+
+        while read < count {
+            let mut batch = self.keys.len().min(count - read) as u32;
+            let in_batch = if read == 0 {
+                std::ptr::null_mut()
+            } else {
+                &mut out_batch as *mut u32 as *mut libc::c_void
+            };
+
+            // 배열 맵은 키 순서로 반환되므로 최종 위치에 바로 기록
+            let ret = unsafe {
+                libbpf_sys::bpf_map_lookup_batch(
+                    map.fd(),
+                    in_batch,
+                    &mut out_batch as *mut u32 as *mut libc::c_void,
+                    self.keys.as_mut_ptr() as *mut libc::c_void,
+                    self.values[read * stride..].as_mut_ptr() as *mut libc::c_void,
+                    &mut batch,
+                    &opts,
+                )
+            };
+
+            // -ENOENT는 마지막 배치를 의미 (batch에 읽은 개수가 채워짐)
+            if ret != 0 && ret != -libc::ENOENT {
+                return Err(anyhow!(
+                    "bpf_map_lookup_batch failed: {}",
+                    std::io::Error::from_raw_os_error(-ret)
+                ));
+            }
+
+            if self.keys[..batch as usize].iter().enumerate().any(|(i, key)| *key as usize != read + i) {
+                return Err(anyhow!("bpf_map_lookup_batch returned keys out of order"));
+            }
+
+            read += batch as usize;
+            if ret != 0 || batch == 0 {
+                break;
+            }
+        }
+
+        // 반환되지 않은 항목은 0
+        self.values[read * stride..count * stride].fill(0);
+        Ok(())
+    }
+
+    fn read_each(&mut self, map: &Map, count: usize) -> Result<()> {
+        let (ncpus, slot_size, value_size) = (self.ncpus, self.slot_size, self.value_size);
+        let stride = ncpus * slot_size;
+
+        for key in 0..count {
+            let entry = &mut self.bytes_mut()[key * stride..(key + 1) * stride];
+            entry.fill(0);
+
+            if let Some(values) = map.lookup_percpu(&(key as u32).to_le_bytes(), MapFlags::empty())? {
+                for (cpu, value) in values.iter().enumerate().take(ncpus) {
+                    let offset = cpu * slot_size;
+                    let len = value.len().min(value_size);
+                    entry[offset..offset + len].copy_from_slice(&value[..len]);
+                }
+            }
+        }
+
+        Ok(())
+    }
+
+    fn bytes(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.values.as_ptr() as *const u8, self.values.len() * 8) }
+    }
+
+    fn bytes_mut(&mut self) -> &mut [u8] {
+        unsafe { std::slice::from_raw_parts_mut(self.values.as_mut_ptr() as *mut u8, self.values.len() * 8) }
+    }
+
+    /// 항목 key의 CPU cpu 값
+    pub fn value(&self, key: usize, cpu: usize) -> &[u8] {
+        let offset = (key * self.ncpus + cpu) * self.slot_size;
+        &self.bytes()[offset..offset + self.value_size]
+    }
+
+    /// 항목 key의 CPU cpu 값 (버퍼 슬롯을 복사 없이 구조체로 참조)
+    pub fn get<T: Pod>(&self, key: usize, cpu: usize) -> &T {
+        assert!(std::mem::size_of::<T>() <= self.value_size && std::mem::align_of::<T>() <= 8);
+        unsafe { &*(self.value(key, cpu).as_ptr() as *const T) }
+    }
+}
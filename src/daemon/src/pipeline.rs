@@ -0,0 +1,222 @@
+//! 테일 콜 파이프라인 모듈
+//! 활성 규칙 집합이 사용하는 단계 프로그램만 pipeline 프로그램 배열에 연결
+
+use anyhow::{Context, Result};
+use libbpf_rs::{Map, MapFlags};
+use log::{debug, warn};
+
+use crate::abi;
+use crate::bpf::XdpFilterSkel;
+use crate::maps::FilterRule;
+
+// 단계 번호
+pub const STAGE_CLASSIFY_V4: u32 = abi::STAGE_CLASSIFY_V4;
+pub const STAGE_CLASSIFY_V6: u32 = abi::STAGE_CLASSIFY_V6;
+pub const STAGE_RATE_LIMIT: u32 = abi::STAGE_RATE_LIMIT;
+pub const STAGE_SAMPLE: u32 = abi::STAGE_SAMPLE;
+pub const STAGE_ACTION_BASE: u32 = abi::STAGE_ACTION_BASE;
+pub const PIPELINE_STAGES: u32 = abi::PIPELINE_STAGES;
+
+/// 파이프라인 진입점 프로그램
+pub const ENTRY_PROGRAM: &str = "xdp_pipeline_func";
+
+/// 액션 번호(1..=7)의 단계 번호
+pub fn action_stage(action: u8) -> Option<u32> {
+    match action {
+        1..=7 => Some(STAGE_ACTION_BASE + action as u32 - 1),
+        _ => None,
+    }
+}
+
+/// 단계 번호의 프로그램 이름 (ACTION_PASS와 ACTION_COUNT는 같은 프로그램)
+fn stage_program(stage: u32) -> &'static str {
+    match stage {
+        STAGE_CLASSIFY_V4 => "xdp_classify_v4",
+        STAGE_CLASSIFY_V6 => "xdp_classify_v6",
+        STAGE_RATE_LIMIT => "xdp_rate_limit",
+        STAGE_SAMPLE => "xdp_sample",
+        s if s == STAGE_ACTION_BASE || s == STAGE_ACTION_BASE + 3 => "xdp_act_pass",
+        s if s == STAGE_ACTION_BASE + 1 => "xdp_act_drop",
+        s if s == STAGE_ACTION_BASE + 2 => "xdp_act_redirect",
+        s if s == STAGE_ACTION_BASE + 4 => "xdp_act_redirect_cpu",
+        s if s == STAGE_ACTION_BASE + 5 => "xdp_act_redirect_xsk",
+        _ => "xdp_act_synproxy",
+    }
+}
+
+/// 연결할 단계 집합 (비트 = 단계 번호)
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct StageSet(u32);
+
+impl StageSet {
+    /// 규칙 집합이 사용하는 단계
+    ///
+    /// IPv6 주소가 없는 규칙은 IPv4 패킷에, IPv4 주소가 없는 규칙은 IPv6 패킷에 매치될 수 있다.
+    pub fn required<'r>(rules: impl IntoIterator<Item = &'r FilterRule>) -> Self {
+        let mut set = Self::default();
+
+        for rule in rules {
+            if rule.src_ip6.is_none() && rule.dst_ip6.is_none() {
+                set.insert(STAGE_CLASSIFY_V4);
+            }
+            if rule.src_ip.is_none() && rule.dst_ip.is_none() {
+                set.insert(STAGE_CLASSIFY_V6);
+            }
+            if rule.rate_limit > 0 {
+                // 초과분 드롭은 이 단계 안에서 처리 (드롭 단계 불필요)
+                set.insert(STAGE_RATE_LIMIT);
+            }
+            if rule.sample_rate > 0 {
+                set.insert(STAGE_SAMPLE);
+            }
+            if let Some(stage) = action_stage(rule.action) {
+                set.insert(stage);
+            }
+        }
+
+        set
+    }
+
+    pub fn contains(self, stage: u32) -> bool {
+        self.0 & (1 << stage) != 0
+    }
+
+    pub fn insert(&mut self, stage: u32) {
+        self.0 |= 1 << stage;
+    }
+
+    fn remove(&mut self, stage: u32) {
+        self.0 &= !(1 << stage);
+    }
+}
+
+/// pipeline 프로그램 배열 관리자
+pub struct Pipeline<'a> {
+    prog_array: Option<&'a Map>,
+    /// 단계 번호별 프로그램 fd
+    programs: Vec<Option<i32>>,
+    /// 현재 연결된 단계
+    linked: StageSet,
+}
+
+impl<'a> Pipeline<'a> {
+    pub fn new(skel: &'a XdpFilterSkel) -> Self {
+        let programs = (0..PIPELINE_STAGES)
+            .map(|stage| skel.progs().stage(stage_program(stage)).map(|prog| prog.fd()))
+            .collect();
+
+        Self {
+            prog_array: skel.maps().pipeline(),
+            programs,
+            linked: StageSet::default(),
+        }
+    }
+
+    /// stages 중 연결되지 않은 단계 연결 (규칙 집합을 기록하기 전에 호출)
+    ///
+    /// 파이프라인이 없는 BPF 오브젝트에서는 아무것도 하지 않는다.
+    pub fn link(&mut self, stages: StageSet) -> Result<()> {
+        let map = match self.prog_array {
+            Some(map) => map,
+            None => return Ok(()),
+        };
+
+        for stage in 0..PIPELINE_STAGES {
+            if !stages.contains(stage) || self.linked.contains(stage) {
+                continue;
+            }
+
+            let fd = match self.programs[stage as usize] {
+                Some(fd) => fd,
+                None => {
+                    warn!("Pipeline stage program {} not found", stage_program(stage));
+                    continue;
+                }
+            };
+            map.update(&stage.to_le_bytes(), &(fd as u32).to_le_bytes(), MapFlags::ANY)
+                .with_context(|| format!("Failed to link pipeline stage {}", stage_program(stage)))?;
+            self.linked.insert(stage);
+            debug!("Linked pipeline stage {} ({})", stage, stage_program(stage));
+        }
+
+        Ok(())
+    }
+
+    /// stages에 없는 단계 분리 (새 규칙 집합이 활성화된 뒤 호출)
+    ///
+    /// 분리 직전에 이전 규칙으로 분류된 패킷은 다음 단계가 없어 통과로 끝날 수 있다.
+    pub fn unlink_unused(&mut self, stages: StageSet) {
+        let map = match self.prog_array {
+            Some(map) => map,
+            None => return,
+        };
+
+        for stage in 0..PIPELINE_STAGES {
+            if stages.contains(stage) || !self.linked.contains(stage) {
+                continue;
+            }
+
+            if let Err(e) = map.delete(&stage.to_le_bytes()) {
+                warn!("Failed to unlink pipeline stage {}: {}", stage_program(stage), e);
+                continue;
+            }
+            self.linked.remove(stage);
+            debug!("Unlinked pipeline stage {} ({})", stage, stage_program(stage));
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn rule(src_ip: Option<(u32, u32)>, src_ip6: Option<(u128, u32)>, action: u8) -> FilterRule {
+        FilterRule {
+            src_ip,
+            dst_ip: None,
+            src_ip6,
+            dst_ip6: None,
+            src_port_min: 0,
+            src_port_max: 65535,
+            dst_port_min: 0,
+            dst_port_max: 65535,
+            protocol: 255,
+            tcp_flags: 0,
+            action,
+            redirect_ifindex: 0,
+            redirect_cpu: 0,
+            priority: 0,
+            rate_limit: 0,
+            rate_limit_per_source: false,
+            sample_rate: 0,
+            expire: 0,
+            label: String::new(),
+            creation_time: 0,
+            expire_deadline_ns: 0,
+        }
+    }
+
+    #[test]
+    fn test_required_stages() {
+        let mut limited = rule(Some((0x0A000000, 8)), None, 5);
+        limited.rate_limit = 100;
+        let rules = vec![limited, rule(None, Some((1 << 127, 1)), 2)];
+
+        let set = StageSet::required(&rules);
+        assert!(set.contains(STAGE_CLASSIFY_V4));
+        assert!(set.contains(STAGE_CLASSIFY_V6));
+        assert!(set.contains(STAGE_RATE_LIMIT));
+        assert!(!set.contains(STAGE_SAMPLE));
+        assert!(set.contains(action_stage(5).unwrap()));
+        assert!(set.contains(action_stage(2).unwrap()));
+        assert!(!set.contains(action_stage(1).unwrap()));
+
+        // 주소 조건이 없는 규칙은 두 주소 계열 모두
+        let set = StageSet::required(&[rule(None, None, 4)]);
+        assert!(set.contains(STAGE_CLASSIFY_V4) && set.contains(STAGE_CLASSIFY_V6));
+        assert_eq!(stage_program(action_stage(4).unwrap()), "xdp_act_pass");
+        assert_eq!(stage_program(action_stage(7).unwrap()), "xdp_act_synproxy");
+        assert_eq!(action_stage(8), None);
+        assert_eq!(StageSet::required(std::iter::empty()), StageSet::default());
+    }
+}
@@ -0,0 +1,238 @@
+//! 규칙 집합 내부 맵 모듈
+//! map-in-map 외부 맵의 슬롯에 설치되는 분류기 내부 맵 생성 및 일괄 기록
+
+use anyhow::{anyhow, Context, Result};
+use libbpf_rs::{Map, MapFlags};
+use log::debug;
+use std::ffi::CString;
+use std::mem::size_of;
+use std::os::unix::io::{AsRawFd, FromRawFd, OwnedFd, RawFd};
+
+use crate::abi;
+use crate::classifier;
+use crate::memory;
+
+/// 외부 맵의 슬롯 수
+pub const SLOTS: u32 = abi::CLS_SLOTS;
+
+/// struct rule_verdict 크기
+pub const RULE_VERDICT_SIZE: u32 = size_of::<abi::rule_verdict>() as u32;
+
+/// 사용자 공간에서 생성한 BPF 맵 (fd를 닫으면 외부 맵이 참조하지 않는 한 해제)
+#[derive(Debug)]
+pub struct InnerMap {
+    fd: OwnedFd,
+    name: &'static str,
+}
+
+impl InnerMap {
+    /// 새 BPF 맵 생성 (외부 맵의 내부 맵 정의와 같은 형식이어야 설치 가능)
+    fn create(
+        map_type: libbpf_sys::bpf_map_type,
+        name: &'static str,
+        key_size: u32,
+        value_size: u32,
+        max_entries: u32,
+        map_flags: u32,
+    ) -> Result<Self> {
+        let c_name = CString::new(name)?;
+        let mut opts: libbpf_sys::bpf_map_create_opts = unsafe { std::mem::zeroed() };
+        opts.sz = std::mem::size_of::<libbpf_sys::bpf_map_create_opts>() as libbpf_sys::size_t;
+        opts.map_flags = map_flags;
+
+        let fd = unsafe {
+            libbpf_sys::bpf_map_create(map_type, c_name.as_ptr(), key_size, value_size, max_entries, &opts)
+        };
+        if fd < 0 {
+            return Err(anyhow!(
+                "Failed to create {} map: {}",
+                name,
+                std::io::Error::from_raw_os_error(-fd)
+            ));
+        }
+
+        Ok(Self {
+            fd: unsafe { OwnedFd::from_raw_fd(fd) },
+            name,
+        })
+    }
+
+    pub fn fd(&self) -> RawFd {
+        self.fd.as_raw_fd()
+    }
+
+    /// 단일 항목 기록
+    pub fn update(&self, key: &[u8], value: &[u8]) -> Result<()> {
+        let ret = unsafe {
+            libbpf_sys::bpf_map_update_elem(
+                self.fd(),
+                key.as_ptr() as *const libc::c_void,
+                value.as_ptr() as *const libc::c_void,
+                libbpf_sys::BPF_ANY as u64,
+            )
+        };
+        if ret != 0 {
+            return Err(anyhow!(
+                "Failed to update {} map: {}",
+                self.name,
+                std::io::Error::from_raw_os_error(-ret)
+            ));
+        }
+
+        Ok(())
+    }
+
+    /// 단일 항목 삭제 (LPM 트라이)
+    pub fn delete(&self, key: &[u8]) -> Result<()> {
+        let ret = unsafe {
+            libbpf_sys::bpf_map_delete_elem(self.fd(), key.as_ptr() as *const libc::c_void)
+        };
+        if ret != 0 {
+            return Err(anyhow!(
+                "Failed to delete from {} map: {}",
+                self.name,
+                std::io::Error::from_raw_os_error(-ret)
+            ));
+        }
+
+        Ok(())
+    }
+
+    /// 배열 맵 일괄 기록 (키 = u32 인덱스, values = 키 순서로 이어 붙인 값)
+    pub fn update_batch(&self, keys: &[u32], values: &[u8]) -> Result<()> {
+        update_batch_fd(self.fd(), self.name, keys, values)
+    }
+}
+
+/// 배열 맵 일괄 기록 (BPF_MAP_UPDATE_BATCH, 지원하지 않는 커널은 항목별 기록으로 대체)
+pub fn update_batch_fd(fd: RawFd, name: &str, keys: &[u32], values: &[u8]) -> Result<()> {
+    if keys.is_empty() {
+        return Ok(());
+    }
+    let value_size = values.len() / keys.len();
+
+    let opts = libbpf_sys::bpf_map_batch_opts {
+        sz: std::mem::size_of::<libbpf_sys::bpf_map_batch_opts>() as libbpf_sys::size_t,
+        elem_flags: 0,
+        flags: 0,
+    };
+    let mut count = keys.len() as u32;
+
+    let ret = unsafe {
+        libbpf_sys::bpf_map_update_batch(
+            fd,
+            keys.as_ptr() as *const libc::c_void,
+            values.as_ptr() as *const libc::c_void,
+            &mut count,
+            &opts,
+        )
+    };
+    if ret == 0 {
+        return Ok(());
+    }
+
+    // 일부만 기록된 경우에도 처음부터 다시 기록 (같은 값이므로 무해)
+    debug!("Batch update on {} failed ({}), falling back to per-key update",
+        name, std::io::Error::from_raw_os_error(-ret));
+    for (i, key) in keys.iter().enumerate() {
+        let value = &values[i * value_size..(i + 1) * value_size];
+        let ret = unsafe {
+            libbpf_sys::bpf_map_update_elem(
+                fd,
+                key as *const u32 as *const libc::c_void,
+                value.as_ptr() as *const libc::c_void,
+                libbpf_sys::BPF_ANY as u64,
+            )
+        };
+        if ret != 0 {
+            return Err(anyhow!(
+                "Failed to update {} map: {}",
+                name,
+                std::io::Error::from_raw_os_error(-ret)
+            ));
+        }
+    }
+
+    Ok(())
+}
+
+/// 한 규칙 집합을 구성하는 분류기 내부 맵
+#[derive(Debug)]
+pub struct RuleSetMaps {
+    pub filter_rules: InnerMap,
+    pub src_v4: InnerMap,
+    pub dst_v4: InnerMap,
+    pub src_v6: InnerMap,
+    pub dst_v6: InnerMap,
+    pub port_class: InnerMap,
+    pub bitmaps: InnerMap,
+}
+
+/// 내부 맵 정의 (형식, 이름, 키 크기, 값 크기, 최대 항목 수, 플래그)
+type InnerDef = (libbpf_sys::bpf_map_type, &'static str, u32, u32, u32, u32);
+
+/// 규칙 집합 하나의 내부 맵 정의 (RuleSetMaps 필드 순서)
+fn inner_defs() -> [InnerDef; 7] {
+    let bitmap_size = size_of::<abi::rule_bitmap>() as u32;
+    let key_v4 = size_of::<abi::prefix_key>() as u32;
+    let key_v6 = size_of::<abi::prefix_key_v6>() as u32;
+    let prefix_flags = libbpf_sys::BPF_F_NO_PREALLOC;
+
+    [
+        (libbpf_sys::BPF_MAP_TYPE_ARRAY, "filter_rules_in",
+            4, RULE_VERDICT_SIZE, classifier::MAX_FILTER_RULES as u32, 0),
+        (libbpf_sys::BPF_MAP_TYPE_LPM_TRIE, "cls_src_v4_in",
+            key_v4, bitmap_size, classifier::MAX_PREFIXES as u32, prefix_flags),
+        (libbpf_sys::BPF_MAP_TYPE_LPM_TRIE, "cls_dst_v4_in",
+            key_v4, bitmap_size, classifier::MAX_PREFIXES as u32, prefix_flags),
+        (libbpf_sys::BPF_MAP_TYPE_LPM_TRIE, "cls_src_v6_in",
+            key_v6, bitmap_size, classifier::MAX_PREFIXES as u32, prefix_flags),
+        (libbpf_sys::BPF_MAP_TYPE_LPM_TRIE, "cls_dst_v6_in",
+            key_v6, bitmap_size, classifier::MAX_PREFIXES as u32, prefix_flags),
+        (libbpf_sys::BPF_MAP_TYPE_ARRAY, "cls_port_cls_in",
+            4, 4, 2 * classifier::PORT_SPACE as u32, 0),
+        (libbpf_sys::BPF_MAP_TYPE_ARRAY, "cls_bitmaps_in",
+            4, bitmap_size, classifier::BM_ENTRIES, 0),
+    ]
+}
+
+impl RuleSetMaps {
+    /// 빈 내부 맵 생성 (배열 맵은 0으로 초기화됨)
+    pub fn create() -> Result<Self> {
+        let mut maps = inner_defs().into_iter()
+            .map(|(map_type, name, key_size, value_size, max_entries, flags)| {
+                InnerMap::create(map_type, name, key_size, value_size, max_entries, flags)
+            });
+        let mut next = || maps.next().expect("inner map definition");
+
+        Ok(Self {
+            filter_rules: next()?,
+            src_v4: next()?,
+            dst_v4: next()?,
+            src_v6: next()?,
+            dst_v6: next()?,
+            port_class: next()?,
+            bitmaps: next()?,
+        })
+    }
+
+    /// 규칙 집합 하나의 내부 맵이 가득 찼을 때의 메모리 추정치
+    pub fn memory_estimate(ncpus: usize) -> u64 {
+        inner_defs().iter()
+            .map(|(map_type, _, key_size, value_size, max_entries, _)| {
+                memory::estimate_bytes(*map_type, *key_size, *value_size, *max_entries, ncpus)
+            })
+            .sum()
+    }
+}
+
+/// 외부 맵 슬롯에 내부 맵 설치 (값 = 내부 맵 fd, 커널이 맵 참조로 변환)
+pub fn install(outer: Option<&Map>, outer_name: &str, slot: u32, inner: &InnerMap) -> Result<()> {
+    let map = outer.ok_or_else(|| anyhow!("Failed to get {} map", outer_name))?;
+    let fd = inner.fd() as u32;
+
+    map.update(&slot.to_le_bytes(), &fd.to_le_bytes(), MapFlags::ANY)
+        .with_context(|| format!("Failed to install rule set into {}[{}]", outer_name, slot))?;
+
+    Ok(())
+}
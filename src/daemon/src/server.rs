@@ -5,26 +5,42 @@ use anyhow::{anyhow, Context, Result};
 use log::{debug, error, info, warn};
 use serde_json::{self, json};
 use std::net::SocketAddr;
+use std::path::Path;
 use std::sync::{Arc, Mutex};
+use std::time::Duration;
 use tokio::io::{AsyncReadExt, AsyncWriteExt};
 use tokio::net::{TcpListener, TcpStream};
-use tokio::sync::mpsc;
+use tokio::task::LocalSet;
 
 //use crate::api::{ApiRequest, ApiResponse};
-use crate::maps::{FilterRule, MapManager};
+use crate::attach::AttachManager;
+use crate::blocklist::PrefixList;
+use crate::bpf::XdpMode;
+use crate::maps::{FilterRule, RuleReader};
 use crate::telemetry::TelemetryCollector;
+use crate::writer::MapWriter;
 //use crate::utils;
 
-use swift_guard::api::{RuleInfo, RuleStats, ApiRequest, ApiResponse, SystemStats};
+use swift_guard::api::{self, RuleInfo, RuleStats, RuleSpec, ApiRequest, ApiResponse, SystemStats, WireFormat};
 use swift_guard::utils;
 
+/// 요청 프레임 최대 크기 (대량 규칙 요청 포함)
+const MAX_FRAME_SIZE: usize = 64 << 20;
+
+/// 요청 없이 유지되는 연결을 닫기까지의 시간
+const CONNECTION_IDLE_TIMEOUT: Duration = Duration::from_secs(60);
+
 /// API 서버
 #[derive(Debug)]
 pub struct ApiServer<'a> {
     /// 바인드 주소
     addr: String,
-    /// 맵 관리자
-    map_manager: Arc<Mutex<MapManager<'a>>>,
+    /// 맵 기록 스레드 (규칙, 블록리스트 변경)
+    writer: MapWriter,
+    /// 규칙 조회기 (기록 스레드를 기다리지 않고 스냅숏 조회)
+    rule_reader: RuleReader<'a>,
+    /// XDP 연결 관리자
+    attach_manager: Arc<Mutex<AttachManager<'a>>>,
     /// 텔레메트리 수집기
     telemetry: Arc<TelemetryCollector<'a>>,
 }
@@ -33,17 +49,27 @@ impl<'a> ApiServer<'a> {
     /// 새로운 API 서버 생성
     pub fn new(
         addr: &str,
-        map_manager: Arc<Mutex<MapManager<'a>>>,
-        telemetry: Arc<TelemetryCollector>,
+        writer: MapWriter,
+        rule_reader: RuleReader<'a>,
+        attach_manager: Arc<Mutex<AttachManager<'a>>>,
+        telemetry: Arc<TelemetryCollector<'a>>,
     ) -> Result<Self> {
         Ok(Self {
             addr: addr.to_string(),
-            map_manager,
+            writer,
+            rule_reader,
+            attach_manager,
             telemetry,
         })
     }
-    
+}
+
+impl ApiServer<'static> {
     /// 서버 실행
+    ///
+    /// 연결마다 작업을 만들어 동시에 처리한다. 작업은 LocalSet에서 실행되고 요청은
+    /// await 지점마다 교대로 진행된다. 규칙, 블록리스트 변경은 맵 기록 스레드로 넘기고
+    /// 결과를 기다리므로, 큰 변경 중에도 조회 요청은 스냅숏으로 바로 응답한다.
     pub async fn run(&self) -> Result<()> {
         // TCP 리스너 생성
         let listener = TcpListener::bind(&self.addr)
@@ -52,29 +78,29 @@ impl<'a> ApiServer<'a> {
         
         info!("API server listening on {}", self.addr);
         
-        // 연결 수락 루프
+        LocalSet::new().run_until(self.accept_loop(listener)).await
+    }
+    
+    /// 연결 수락 루프
+    async fn accept_loop(&self, listener: TcpListener) -> Result<()> {
         loop {
             match listener.accept().await {
                 Ok((stream, addr)) => {
                     debug!("Accepted connection from {}", addr);
                     
                     // 요청 처리 작업 생성
-                    let map_manager = self.map_manager.clone();
+                    let writer = self.writer.clone();
+                    let rule_reader = self.rule_reader.clone();
+                    let attach_manager = self.attach_manager.clone();
                     let telemetry = self.telemetry.clone();
-/*                    
-                    tokio::spawn(async move {
-//                        if let Err(e) = handle_connection(stream, map_manager, telemetry).await {
-                        if let Err(e) = handle_connection(stream, map_manager.clone(), telemetry.clone()).await {
+                    
+                    tokio::task::spawn_local(async move {
+                        if let Err(e) = handle_connection(stream, addr, writer, rule_reader,
+                                                          attach_manager, telemetry).await {
                             error!("Connection error: {}", e);
                         }
                     });
                 }
-*/
-                    // 직접 요청 처리
-                    if let Err(e) = handle_connection(stream, map_manager.clone(), telemetry.clone()).await {
-                        error!("Connection error: {}", e);
-                    }
-                }
 
                 Err(e) => {
                     error!("Failed to accept connection: {}", e);
@@ -85,74 +111,217 @@ impl<'a> ApiServer<'a> {
 }
 
 /// 클라이언트 연결 처리
+///
+/// 연결 하나로 여러 요청을 주고받는다 (프레임 = 4바이트 빅 엔디안 길이 + JSON 또는
+/// BINARY_FRAME_MAGIC + bincode). 응답은 요청과 같은 인코딩으로 보낸다.
+/// 클라이언트가 연결을 닫거나 CONNECTION_IDLE_TIMEOUT 동안 요청이 없으면 종료한다.
 async fn handle_connection<'a>(
     mut stream: TcpStream,
-    map_manager: Arc<Mutex<MapManager<'a>>>,
+    addr: SocketAddr,
+    writer: MapWriter,
+    rule_reader: RuleReader<'a>,
+    attach_manager: Arc<Mutex<AttachManager<'a>>>,
     telemetry: Arc<TelemetryCollector<'a>>,
 ) -> Result<()> {
-    // 요청 길이 수신 (4바이트 빅 엔디안)
-    let mut len_bytes = [0u8; 4];
-    stream.read_exact(&mut len_bytes)
-        .await
-        .context("Failed to read request length")?;
-    let len = u32::from_be_bytes(len_bytes) as usize;
+    stream.set_nodelay(true)
+        .context("Failed to set TCP_NODELAY")?;
     
-    // 요청 내용 수신
-    let mut request_bytes = vec![0u8; len];
-    stream.read_exact(&mut request_bytes)
-        .await
-        .context("Failed to read request")?;
-    
-    // 요청 역직렬화
-    let request: ApiRequest = serde_json::from_slice(&request_bytes)
-        .context("Failed to deserialize request")?;
+    loop {
+        // 요청 길이 수신 (4바이트 빅 엔디안)
+        let mut len_bytes = [0u8; 4];
+        match tokio::time::timeout(CONNECTION_IDLE_TIMEOUT, stream.read_exact(&mut len_bytes)).await {
+            Ok(Ok(_)) => {}
+            Ok(Err(e)) if e.kind() == std::io::ErrorKind::UnexpectedEof => {
+                debug!("Connection from {} closed", addr);
+                return Ok(());
+            }
+            Ok(Err(e)) => return Err(e).context("Failed to read request length"),
+            Err(_) => {
+                debug!("Closing idle connection from {}", addr);
+                return Ok(());
+            }
+        }
+        let len = u32::from_be_bytes(len_bytes) as usize;
+        if len > MAX_FRAME_SIZE {
+            return Err(anyhow!("Request too large: {} bytes", len));
+        }
+        
+        // 요청 내용 수신
+        let mut request_bytes = vec![0u8; len];
+        stream.read_exact(&mut request_bytes)
+            .await
+            .context("Failed to read request")?;
+        
+        // 요청 역직렬화 및 처리 (실패는 응답으로 알리고 연결 유지)
+        let (response, format) = match api::decode_frame::<ApiRequest>(&request_bytes) {
+            Ok((request, format)) => {
+                match &request {
+                    // 대량 요청은 규칙 전체를 기록하지 않음
+                    ApiRequest::BulkAddRules { rules } | ApiRequest::ReplaceRuleset { rules } =>
+                        debug!("Processing bulk request with {} rules", rules.len()),
+                    request => debug!("Processing request: {:?}", request),
+                }
+                let response = process_request(request, &writer, &rule_reader, &attach_manager, &telemetry).await
+                    .unwrap_or_else(|e| ApiResponse::Error { message: e.to_string() });
+                (response, format)
+            }
+            Err(e) => {
+                let format = if request_bytes.first() == Some(&api::BINARY_FRAME_MAGIC) {
+                    WireFormat::Binary
+                } else {
+                    WireFormat::Json
+                };
+                (ApiResponse::Error { message: format!("Failed to deserialize request: {}", e) }, format)
+            }
+        };
+        
+        // 응답 직렬화 (길이와 내용을 한 번에 전송)
+        let response_bytes = api::encode_frame(&response, format)
+            .context("Failed to serialize response")?;
+        
+        let mut frame = Vec::with_capacity(4 + response_bytes.len());
+        frame.extend_from_slice(&(response_bytes.len() as u32).to_be_bytes());
+        frame.extend_from_slice(&response_bytes);
+        stream.write_all(&frame)
+            .await
+            .context("Failed to write response")?;
+    }
+}
+
+/// 주소 문자열 파싱 (IPv4 또는 IPv6 프리픽스)
+fn parse_address(s: Option<&str>) -> Result<(Option<(u32, u32)>, Option<(u128, u32)>)> {
+    match s {
+        Some(ip_str) if ip_str.contains(':') => Ok((None, Some(utils::parse_ipv6_prefix(ip_str)?))),
+        Some(ip_str) => Ok((Some(utils::parse_ip_prefix(ip_str)?), None)),
+        None => Ok((None, None)),
+    }
+}
+
+/// 현재 UNIX 시간 (초)
+fn unix_now() -> Result<u64> {
+    Ok(std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .map_err(|_| anyhow!("Failed to get system time"))?
+        .as_secs())
+}
+
+/// 규칙 명세 검증 및 필터 규칙 생성
+fn rule_from_spec(spec: RuleSpec, now: u64) -> Result<FilterRule> {
+    // IP 주소 파싱 (':'가 포함되면 IPv6)
+    let (src_ip_parsed, src_ip6_parsed) = parse_address(spec.src_ip.as_deref())?;
+    let (dst_ip_parsed, dst_ip6_parsed) = parse_address(spec.dst_ip.as_deref())?;
     
-    // 요청 처리
-    debug!("Processing request: {:?}", request);
-    let response = process_request(request, map_manager, telemetry).await?;
+    if (src_ip_parsed.is_some() || dst_ip_parsed.is_some())
+        && (src_ip6_parsed.is_some() || dst_ip6_parsed.is_some()) {
+        return Err(anyhow!("Source and destination addresses must be the same family"));
+    }
     
-    // 응답 직렬화
-    let response_bytes = serde_json::to_vec(&response)
-        .context("Failed to serialize response")?;
+    // 리디렉션 인터페이스 인덱스 획득
+    let redirect_ifindex = if let Some(ifname) = &spec.redirect_if {
+        // 여기서는 간단히 하기 위해 "if<number>" 형식을 파싱
+        if ifname.starts_with("if") && ifname[2..].chars().all(|c| c.is_ascii_digit()) {
+            ifname[2..].parse::<u32>()
+                .map_err(|_| anyhow!("Invalid interface format: {}", ifname))?
+        } else {
+            // devmap은 실제 ifindex가 필요하므로 인터페이스 이름 조회
+            let c_name = std::ffi::CString::new(ifname.as_str())
+                .map_err(|_| anyhow!("Invalid interface name: {}", ifname))?;
+            let ifindex = unsafe { libc::if_nametoindex(c_name.as_ptr()) };
+            if ifindex == 0 {
+                return Err(anyhow!("Unknown interface: {}", ifname));
+            }
+            ifindex
+        }
+    } else {
+        0
+    };
     
-    // 응답 길이 전송 (4바이트 빅 엔디안)
-    let len = response_bytes.len() as u32;
-    let len_bytes = len.to_be_bytes();
-    stream.write_all(&len_bytes)
-        .await
-        .context("Failed to write response length")?;
+    // 액션 확인 (데이터 경로의 액션 단계 인덱스는 액션 번호에서 계산)
+    if !(1..=7).contains(&spec.action) {
+        return Err(anyhow!("Invalid action: {}", spec.action));
+    }
+
+    // CPU 리디렉션 대상 확인
+    if spec.action == 5 && spec.redirect_cpu.is_none() {
+        return Err(anyhow!("Redirect-cpu action requires 'redirect_cpu' parameter"));
+    }
     
-    // 응답 내용 전송
-    stream.write_all(&response_bytes)
-        .await
-        .context("Failed to write response")?;
+    // SYN 프록시는 IPv4 TCP만 처리 (syncookie 헬퍼가 IPv4 헤더 기준)
+    if spec.action == 7 {
+        if spec.protocol != 6 {
+            return Err(anyhow!("Synproxy action requires protocol tcp"));
+        }
+        if src_ip6_parsed.is_some() || dst_ip6_parsed.is_some() {
+            return Err(anyhow!("Synproxy action supports IPv4 only"));
+        }
+    }
     
-    Ok(())
+    Ok(FilterRule {
+        src_ip: src_ip_parsed,
+        dst_ip: dst_ip_parsed,
+        src_ip6: src_ip6_parsed,
+        dst_ip6: dst_ip6_parsed,
+        src_port_min: spec.src_port_min,
+        src_port_max: spec.src_port_max,
+        dst_port_min: spec.dst_port_min,
+        dst_port_max: spec.dst_port_max,
+        protocol: spec.protocol,
+        tcp_flags: spec.tcp_flags,
+        action: spec.action,
+        redirect_ifindex,
+        redirect_cpu: spec.redirect_cpu.unwrap_or(0),
+        priority: spec.priority,
+        rate_limit: spec.rate_limit,
+        rate_limit_per_source: spec.rate_limit_per_source,
+        sample_rate: spec.sample_rate,
+        expire: spec.expire,
+        label: spec.label,
+        creation_time: now,
+        expire_deadline_ns: 0,
+    })
 }
 
 /// 요청 처리
 async fn process_request<'a>(
     request: ApiRequest,
-    map_manager: Arc<Mutex<MapManager<'a>>>,
-    telemetry: Arc<TelemetryCollector<'a>>,
+    writer: &MapWriter,
+    rule_reader: &RuleReader<'a>,
+    attach_manager: &Mutex<AttachManager<'a>>,
+    telemetry: &TelemetryCollector<'a>,
 ) -> Result<ApiResponse> {
     match request {
         ApiRequest::Attach { interface, mode, force } => {
-            // XDP 프로그램 연결 로직
-            // 실제 구현에서는 특정 인터페이스에 XDP 프로그램을 로드하는 로직 추가
+            let mode = XdpMode::from_u32(mode)
+                .ok_or_else(|| anyhow!("Invalid XDP mode: {}", mode))?;
             
-            Ok(ApiResponse::Success {
-                message: format!("XDP program attached to {} in mode {}", interface, mode),
-            })
+            // force가 없으면 요청한 모드가 실패할 때 낮은 모드로 재시도
+            let attached = attach_manager.lock()
+                .map_err(|_| anyhow!("Failed to lock attach_manager"))?
+                .attach(&interface, mode, force)?;
+            
+            let message = if attached == mode {
+                format!("XDP program attached to {} in {} mode", interface, attached.to_str())
+            } else {
+                format!("XDP program attached to {} in {} mode ({} mode unavailable)",
+                        interface, attached.to_str(), mode.to_str())
+            };
+            Ok(ApiResponse::Success { message })
         },
         
         ApiRequest::Detach { interface } => {
-            // XDP 프로그램 분리 로직
-            // 실제 구현에서는 특정 인터페이스에서 XDP 프로그램을 언로드하는 로직 추가
+            let detached = attach_manager.lock()
+                .map_err(|_| anyhow!("Failed to lock attach_manager"))?
+                .detach(&interface)?;
             
-            Ok(ApiResponse::Success {
-                message: format!("XDP program detached from {}", interface),
-            })
+            if detached {
+                Ok(ApiResponse::Success {
+                    message: format!("XDP program detached from {}", interface),
+                })
+            } else {
+                Ok(ApiResponse::Error {
+                    message: format!("No XDP program attached to {}", interface),
+                })
+            }
         },
         
         ApiRequest::AddRule {
@@ -166,47 +335,17 @@ async fn process_request<'a>(
             tcp_flags,
             action,
             redirect_if,
+            redirect_cpu,
             priority,
             rate_limit,
+            rate_limit_per_source,
+            sample_rate,
             expire,
             label,
         } => {
-            // IP 주소 파싱
-            let src_ip_parsed = if let Some(ip_str) = src_ip {
-                Some(utils::parse_ip_prefix(&ip_str)?)
-            } else {
-                None
-            };
-            
-            let dst_ip_parsed = if let Some(ip_str) = dst_ip {
-                Some(utils::parse_ip_prefix(&ip_str)?)
-            } else {
-                None
-            };
-            
-            // 리디렉션 인터페이스 인덱스 획득
-            let redirect_ifindex = if let Some(ifname) = redirect_if {
-                // 여기서는 간단히 하기 위해 "if<number>" 형식을 파싱
-                if ifname.starts_with("if") {
-                    ifname[2..].parse::<u32>()
-                        .map_err(|_| anyhow!("Invalid interface format: {}", ifname))?
-                } else {
-                    0
-                }
-            } else {
-                0
-            };
-            
-            // 현재 시간
-            let now = std::time::SystemTime::now()
-                .duration_since(std::time::UNIX_EPOCH)
-                .map_err(|_| anyhow!("Failed to get system time"))?
-                .as_secs();
-            
-            // 필터 규칙 생성
-            let rule = FilterRule {
-                src_ip: src_ip_parsed,
-                dst_ip: dst_ip_parsed,
+            let rule = rule_from_spec(RuleSpec {
+                src_ip,
+                dst_ip,
                 src_port_min,
                 src_port_max,
                 dst_port_min,
@@ -214,31 +353,80 @@ async fn process_request<'a>(
                 protocol,
                 tcp_flags,
                 action,
-                redirect_ifindex,
+                redirect_if,
+                redirect_cpu,
                 priority,
                 rate_limit,
+                rate_limit_per_source,
+                sample_rate,
                 expire,
                 label: label.clone(),
-                creation_time: now,
-            };
-            
-            // 맵 관리자에 규칙 추가
-            let mut map_manager = map_manager.lock()
-                .map_err(|_| anyhow!("Failed to lock map_manager"))?;
+            }, unix_now()?)?;
             
-            map_manager.add_rule(rule)?;
+            // 기록 스레드에서 규칙 추가
+            writer.run(move |map_manager| map_manager.add_rule(rule)).await?;
             
             Ok(ApiResponse::Success {
                 message: format!("Rule '{}' added successfully", label),
             })
         },
         
-        ApiRequest::DeleteRule { label } => {
-            // 맵 관리자에서 규칙 삭제
-            let mut map_manager = map_manager.lock()
-                .map_err(|_| anyhow!("Failed to lock map_manager"))?;
+        ApiRequest::BulkAddRules { rules } => {
+            // 기록 스레드로 넘기기 전에 모든 규칙을 검증
+            let now = unix_now()?;
+            let rules = rules.into_iter()
+                .map(|spec| {
+                    let label = spec.label.clone();
+                    rule_from_spec(spec, now).with_context(|| format!("Invalid rule '{}'", label))
+                })
+                .collect::<Result<Vec<_>>>()?;
+            
+            let count = writer.run(move |map_manager| map_manager.add_rules(rules)).await?;
+            
+            Ok(ApiResponse::Success {
+                message: format!("{} rules added successfully", count),
+            })
+        },
+        
+        ApiRequest::ReplaceRuleset { rules } => {
+            let now = unix_now()?;
+            let rules = rules.into_iter()
+                .map(|spec| {
+                    let label = spec.label.clone();
+                    rule_from_spec(spec, now).with_context(|| format!("Invalid rule '{}'", label))
+                })
+                .collect::<Result<Vec<_>>>()?;
+            let count = rules.len();
             
-            let deleted = map_manager.delete_rule(&label)?;
+            writer.run(move |map_manager| map_manager.replace_rules(rules)).await?;
+            
+            Ok(ApiResponse::Success {
+                message: format!("Rule set replaced with {} rules", count),
+            })
+        },
+        
+        ApiRequest::SetSampleRate { label, sample_rate } => {
+            let target = label.clone();
+            let updated = writer.run(move |map_manager| map_manager.set_sample_rate(&target, sample_rate)).await?;
+            
+            if updated {
+                Ok(ApiResponse::Success {
+                    message: match sample_rate {
+                        0 => format!("Sampling disabled for rule '{}'", label),
+                        n => format!("Rule '{}' samples 1 in {} packets", label, n),
+                    },
+                })
+            } else {
+                Ok(ApiResponse::Error {
+                    message: format!("Rule '{}' not found", label),
+                })
+            }
+        },
+        
+        ApiRequest::DeleteRule { label } => {
+            // 기록 스레드에서 규칙 삭제
+            let target = label.clone();
+            let deleted = writer.run(move |map_manager| map_manager.delete_rule(&target)).await?;
             
             if deleted {
                 Ok(ApiResponse::Success {
@@ -252,11 +440,8 @@ async fn process_request<'a>(
         },
         
         ApiRequest::ListRules { include_stats } => {
-            // 맵 관리자에서 규칙 목록 조회
-            let map_manager = map_manager.lock()
-                .map_err(|_| anyhow!("Failed to lock map_manager"))?;
-            
-            let rules = map_manager.list_rules(include_stats)?;
+            // 마지막으로 공개된 스냅숏 조회 (규칙 변경을 기다리지 않음)
+            let rules = rule_reader.list_rules(include_stats)?;
             
             Ok(ApiResponse::Rules { rules })
         },
@@ -299,5 +484,36 @@ async fn process_request<'a>(
                 message: "WASM module statistics not implemented yet".to_string(),
             })
         },
+        
+        ApiRequest::LoadBlocklist { name, path } => {
+            // 파일은 블로킹 스레드에서 읽고 파싱 (수백만 줄일 수 있음)
+            let list = tokio::task::spawn_blocking(move || PrefixList::read(Path::new(&path)))
+                .await
+                .context("Blocklist parser task failed")??;
+            let (v4_count, v6_count) = (list.v4.len(), list.v6.len());
+            
+            let target = name.clone();
+            let total = writer.run(move |map_manager| map_manager.replace_blocklist(&target, &list)).await?;
+            
+            Ok(ApiResponse::Success {
+                message: format!("Blocklist '{}' loaded: {} IPv4, {} IPv6 prefixes ({} prefixes in all blocklists)",
+                    name, v4_count, v6_count, total),
+            })
+        },
+        
+        ApiRequest::DeleteBlocklist { name } => {
+            let target = name.clone();
+            let deleted = writer.run(move |map_manager| map_manager.delete_blocklist(&target)).await?;
+            
+            if deleted {
+                Ok(ApiResponse::Success {
+                    message: format!("Blocklist '{}' deleted successfully", name),
+                })
+            } else {
+                Ok(ApiResponse::Error {
+                    message: format!("Blocklist '{}' not found", name),
+                })
+            }
+        },
     }
 }
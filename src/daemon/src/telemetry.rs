@@ -3,29 +3,122 @@
 
 use anyhow::{anyhow, Context, Result};
 use log::{debug, error, info, warn};
-use std::sync::{Arc, Mutex};
+use std::fmt::Write as _;
+use std::mem::size_of;
+use std::sync::Mutex;
 use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+use tokio::io::{AsyncReadExt, AsyncWriteExt};
+use tokio::net::TcpListener;
 use tokio::time;
 
+use crate::abi;
+use crate::blocklist::MAX_BLOCKLISTS;
 use crate::bpf::XdpFilterSkel;
+use crate::classifier;
 use crate::config::DaemonConfig;
+use crate::heavy_hitters::{HeavyHitter, SketchMerger, HH_SLOTS};
+use crate::maps::{RuleReader, RuleSnapshot};
+use crate::memory::MapMemory;
+use crate::percpu::PercpuTable;
 //use crate::api::SystemStats;
 
 use swift_guard::api::SystemStats;
 use libbpf_rs::MapFlags;
 use libbpf_rs::Map;
 
+/// 판정별 통계 인덱스 (stats_map 키)
+pub const STAT_PASS: usize = abi::STAT_PASS as usize;
+pub const STAT_DROP: usize = abi::STAT_DROP as usize;
+pub const STAT_REDIRECT: usize = abi::STAT_REDIRECT as usize;
+pub const STAT_ABORTED: usize = abi::STAT_ABORTED as usize;
+pub const STAT_PARSE_FAIL: usize = abi::STAT_PARSE_FAIL as usize;
+pub const STAT_TX: usize = abi::STAT_TX as usize;
+pub const STAT_MAX: usize = abi::STAT_MAX as usize;
+
+/// 수신 큐별 통계 항목 수
+pub const MAX_STAT_QUEUES: usize = abi::MAX_STAT_QUEUES as usize;
+
+/// 판정 이름 (내보내기 레이블, STAT_* 순서)
+const VERDICT_NAMES: [&str; STAT_MAX] = ["pass", "drop", "redirect", "aborted", "parse_fail", "tx"];
+
+/// 스크레이프 요청 읽기 제한 시간
+const SCRAPE_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// 판정별 패킷/바이트 카운터
+#[derive(Debug, Clone, Copy, Default)]
+pub struct VerdictCounter {
+    pub packets: u64,
+    pub bytes: u64,
+}
+
+/// stats_map의 판정별 카운터 조회 (CPU별 값 합산)
+pub fn read_verdict_stats(stats_map: &Map) -> Result<[VerdictCounter; STAT_MAX]> {
+    let mut counters = [VerdictCounter::default(); STAT_MAX];
+    
+    for (stat, counter) in counters.iter_mut().enumerate() {
+        let key = (stat as u32).to_le_bytes();
+        let values = stats_map.lookup_percpu(&key, MapFlags::empty())
+            .context("Failed to read stats_map")?
+            .unwrap_or_default();
+        
+        for value in values.iter().filter_map(|v| abi::from_bytes::<abi::filter_stats>(v)) {
+            counter.packets += value.packets;
+            counter.bytes += value.bytes;
+        }
+    }
+    
+    Ok(counters)
+}
+
+/// 누적 카운터와 직전 수집 구간의 비율
+#[derive(Debug, Clone, Copy, Default)]
+pub struct RateCounter {
+    pub packets: u64,
+    pub bytes: u64,
+    pub packets_per_sec: u64,
+    pub bits_per_sec: u64,
+}
+
+impl RateCounter {
+    /// 새 누적값으로 갱신하고 이전 값과의 차이로 비율 계산
+    fn update(&mut self, packets: u64, bytes: u64, elapsed: f64) {
+        self.packets_per_sec = (packets.saturating_sub(self.packets) as f64 / elapsed) as u64;
+        self.bits_per_sec = (bytes.saturating_sub(self.bytes) as f64 * 8.0 / elapsed) as u64;
+        self.packets = packets;
+        self.bytes = bytes;
+    }
+}
+
+/// CPU 하나의 통계
+#[derive(Debug, Clone, Copy, Default)]
+pub struct CpuStats {
+    /// 모든 판정 합계
+    pub total: RateCounter,
+    /// 판정별 카운터 (STAT_* 인덱스)
+    pub verdicts: [VerdictCounter; STAT_MAX],
+}
+
 /// 텔레메트리 수집기
 //#[derive(Debug)]
 pub struct TelemetryCollector<'a> {
     /// 통계 맵 참조
     stats_map: &'a  Map,
+    /// 수신 큐별 통계 맵
+    queue_stats_map: Option<&'a Map>,
+    /// 규칙별 통계 맵
+    rule_stats_map: Option<&'a Map>,
+    /// 블록리스트별 드롭 통계 맵
+    blocklist_stats_map: Option<&'a Map>,
+    /// 헤비 히터 탐지 맵 (구성에서 활성화하고 BPF 오브젝트에 있는 경우)
+    hh_maps: Option<HeavyHitterMaps<'a>>,
+    /// 규칙 레이블 조회 (맵 관리자 잠금 없이 스냅숏 사용)
+    rule_reader: RuleReader<'a>,
+    /// 내보내기 레이블로 쓰는 인터페이스 이름
+    interface: String,
     /// 구성 정보
     config: DaemonConfig,
-    /// 수집된 통계
-    stats: Arc<Mutex<CollectedStats>>,
-    /// 마지막 수집 시간
-    last_collection: Instant,
+    /// 수집 상태
+    state: Mutex<CollectorState>,
 }
 
 /// 수집된 통계
@@ -41,16 +134,155 @@ pub struct CollectedStats {
     pub mbps: f64,
     /// 마지막 업데이트 시간
     pub last_update: u64,
+    /// 판정별 카운터 (STAT_* 인덱스)
+    pub verdicts: [VerdictCounter; STAT_MAX],
+    /// CPU별 통계 (인덱스 = CPU 번호)
+    pub cpus: Vec<CpuStats>,
+    /// 수신 큐별 통계 (인덱스 = 큐 번호)
+    pub queues: Vec<RateCounter>,
+    /// 규칙별 통계 (인덱스 = 규칙 ID)
+    pub rules: Vec<RateCounter>,
+    /// 직전 수집 구간의 상위 소스 (추정치 내림차순)
+    pub heavy_hitters: Vec<HeavyHitter>,
+    /// 블록리스트별 드롭 통계 (인덱스 = 블록리스트 ID)
+    pub blocklists: Vec<RateCounter>,
+    /// 맵별 메모리 추정치 (로드 시 한 번 계산)
+    pub map_memory: Vec<MapMemory>,
+    /// 맵 메모리 예산 (바이트)
+    pub memory_budget: Option<u64>,
     /// 이전 패킷 수
     prev_packets: u64,
     /// 이전 바이트
     prev_bytes: u64,
 }
 
+impl CollectedStats {
+    fn new(ncpus: usize) -> Self {
+        Self {
+            total_packets: 0,
+            total_bytes: 0,
+            packets_per_sec: 0,
+            mbps: 0.0,
+            last_update: 0,
+            verdicts: [VerdictCounter::default(); STAT_MAX],
+            cpus: vec![CpuStats::default(); ncpus],
+            queues: vec![RateCounter::default(); MAX_STAT_QUEUES],
+            rules: vec![RateCounter::default(); classifier::MAX_FILTER_RULES],
+            heavy_hitters: Vec::new(),
+            blocklists: vec![RateCounter::default(); MAX_BLOCKLISTS],
+            map_memory: Vec::new(),
+            memory_budget: None,
+            prev_packets: 0,
+            prev_bytes: 0,
+        }
+    }
+}
+
+/// 수집 상태 (조회 버퍼와 통계 배열은 한 번 할당하여 수집마다 재사용)
+struct CollectorState {
+    stats: CollectedStats,
+    verdict_values: PercpuTable,
+    queue_values: Option<PercpuTable>,
+    rule_values: Option<PercpuTable>,
+    blocklist_values: Option<PercpuTable>,
+    hh: Option<HeavyHitterState>,
+    /// 마지막 수집 시간
+    last_collection: Instant,
+    /// 내보내기 응답 버퍼
+    export_buf: String,
+}
+
+/// 헤비 히터 탐지 맵
+struct HeavyHitterMaps<'a> {
+    config: &'a Map,
+    sketch: &'a Map,
+    topk: &'a Map,
+}
+
+/// 헤비 히터 수집 상태
+struct HeavyHitterState {
+    /// 데이터 경로가 기록 중인 구간 번호
+    epoch: u32,
+    sketch_values: PercpuTable,
+    topk_values: PercpuTable,
+    merger: SketchMerger,
+    /// 읽은 슬롯을 비우는 CPU별 0 값
+    zero_sketch: Vec<Vec<u8>>,
+    zero_topk: Vec<Vec<u8>>,
+}
+
+impl HeavyHitterState {
+    fn new(maps: &HeavyHitterMaps) -> Result<Self> {
+        let sketch_values = PercpuTable::new(size_of::<abi::hh_sketch>(), HH_SLOTS)?;
+        let topk_values = PercpuTable::new(size_of::<abi::hh_topk>(), HH_SLOTS)?;
+        let ncpus = sketch_values.ncpus();
+        let state = Self {
+            epoch: 0,
+            sketch_values,
+            topk_values,
+            merger: SketchMerger::new(),
+            zero_sketch: vec![vec![0u8; size_of::<abi::hh_sketch>()]; ncpus],
+            zero_topk: vec![vec![0u8; size_of::<abi::hh_topk>()]; ncpus],
+        };
+
+        // 고정된 맵에 남은 이전 데몬의 구간은 버림
+        for slot in 0..HH_SLOTS {
+            state.clear_slot(maps, slot)?;
+        }
+        Ok(state)
+    }
+
+    fn clear_slot(&self, maps: &HeavyHitterMaps, slot: usize) -> Result<()> {
+        let key = (slot as u32).to_le_bytes();
+        maps.sketch.update_percpu(&key, &self.zero_sketch, MapFlags::ANY)
+            .context("Failed to clear hh_sketch")?;
+        maps.topk.update_percpu(&key, &self.zero_topk, MapFlags::ANY)
+            .context("Failed to clear hh_topk")?;
+        Ok(())
+    }
+
+    /// 기록 슬롯을 전환하고 직전 구간을 합산해 상위 top_k개 소스 기록
+    ///
+    /// 전환 직전에 이전 슬롯을 조회한 CPU의 갱신 몇 건은 비우는 과정에서 누락될 수 있다.
+    fn collect(&mut self, maps: &HeavyHitterMaps, top_k: usize, elapsed: f64,
+               out: &mut Vec<HeavyHitter>) -> Result<()> {
+        let slot = self.epoch as usize % HH_SLOTS;
+        self.epoch = self.epoch.wrapping_add(1);
+        write_hh_config(maps.config, true, self.epoch)?;
+
+        self.sketch_values.read(maps.sketch, HH_SLOTS)?;
+        self.topk_values.read(maps.topk, HH_SLOTS)?;
+
+        self.merger.clear();
+        for cpu in 0..self.sketch_values.ncpus() {
+            self.merger.add_sketch(self.sketch_values.get(slot, cpu));
+            self.merger.add_topk(self.topk_values.get(slot, cpu));
+        }
+        self.merger.top(top_k, elapsed, out);
+
+        self.clear_slot(maps, slot)
+    }
+}
+
+/// hh_config 기록 (enabled, epoch)
+fn write_hh_config(map: &Map, enabled: bool, epoch: u32) -> Result<()> {
+    let value = abi::hh_config { enabled: enabled as u32, epoch };
+    map.update(&0u32.to_le_bytes(), abi::as_bytes(&value), MapFlags::ANY)
+        .context("Failed to write hh_config")
+}
+
+/// filter_stats 항목 key의 모든 CPU 합계 (패킷, 바이트)
+fn sum_stats(values: &PercpuTable, key: usize) -> (u64, u64) {
+    (0..values.ncpus())
+        .map(|cpu| values.get::<abi::filter_stats>(key, cpu))
+        .fold((0, 0), |(packets, bytes), v| (packets + v.packets, bytes + v.bytes))
+}
+
 // Debug 구현
 impl<'a> std::fmt::Debug for TelemetryCollector<'a> {
     fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
         f.debug_struct("TelemetryCollector")
+            .field("interface", &self.interface)
             .field("config", &self.config)
             .finish()
     }
@@ -58,82 +290,219 @@ impl<'a> std::fmt::Debug for TelemetryCollector<'a> {
 
 impl<'a> TelemetryCollector<'a> {
     /// 새로운 텔레메트리 수집기 생성
-    pub fn new(skel: &'a XdpFilterSkel, config: &DaemonConfig) -> Result<Self> {
+    pub fn new(
+        skel: &'a XdpFilterSkel,
+        config: &DaemonConfig,
+        rule_reader: RuleReader<'a>,
+        interface: &str,
+    ) -> Result<Self> {
         // 통계 맵 획득
         let stats_map = skel.maps().stats_map()
             .ok_or_else(|| anyhow!("Failed to get stats_map"))?;
+        let queue_stats_map = skel.maps().queue_stats();
+        let rule_stats_map = skel.maps().rule_stats();
+        let blocklist_stats_map = skel.maps().blocklist_stats();
+        
+        let stats_size = size_of::<abi::filter_stats>();
+        let verdict_values = PercpuTable::new(stats_size, STAT_MAX)?;
+        let ncpus = verdict_values.ncpus();
+        let queue_values = match queue_stats_map {
+            Some(_) => Some(PercpuTable::new(stats_size, MAX_STAT_QUEUES)?),
+            None => None,
+        };
+        let rule_values = match rule_stats_map {
+            Some(_) => Some(PercpuTable::new(stats_size, classifier::MAX_FILTER_RULES)?),
+            None => None,
+        };
+        let blocklist_values = match blocklist_stats_map {
+            Some(_) => Some(PercpuTable::new(stats_size, MAX_BLOCKLISTS)?),
+            None => None,
+        };
+        
+        let mut stats = CollectedStats::new(ncpus);
+        stats.map_memory = skel.map_memory().unwrap_or_else(|e| {
+            warn!("Failed to estimate map memory: {}", e);
+            Vec::new()
+        });
+        stats.memory_budget = config.xdp.memory_budget_mb.map(|mb| mb << 20);
+        
+        // 헤비 히터 탐지 (비활성이면 고정된 맵에 남은 이전 구성도 끔)
+        let hh_enabled = config.telemetry.heavy_hitters.enabled;
+        let hh_maps = match (skel.maps().hh_config(), skel.maps().hh_sketch(), skel.maps().hh_topk()) {
+            (Some(config), Some(sketch), Some(topk)) => {
+                write_hh_config(config, false, 0)?;
+                Some(HeavyHitterMaps { config, sketch, topk })
+            }
+            _ => None,
+        };
+        if hh_enabled && hh_maps.is_none() {
+            warn!("Heavy hitter maps not found in BPF object, detection disabled");
+        }
+        let hh_maps = hh_maps.filter(|_| hh_enabled);
+        let hh = match &hh_maps {
+            Some(maps) => {
+                let state = HeavyHitterState::new(maps)?;
+                write_hh_config(maps.config, true, state.epoch)?;
+                Some(state)
+            }
+            None => None,
+        };
         
         Ok(Self {
             stats_map,
+            queue_stats_map,
+            rule_stats_map,
+            blocklist_stats_map,
+            hh_maps,
+            rule_reader,
+            interface: interface.to_string(),
             config: config.clone(),
-            stats: Arc::new(Mutex::new(CollectedStats {
-                total_packets: 0,
-                total_bytes: 0,
-                packets_per_sec: 0,
-                mbps: 0.0,
-                last_update: 0,
-                prev_packets: 0,
-                prev_bytes: 0,
-            })),
-            last_collection: Instant::now(),
+            state: Mutex::new(CollectorState {
+                stats,
+                verdict_values,
+                queue_values,
+                rule_values,
+                blocklist_values,
+                hh,
+                last_collection: Instant::now(),
+                export_buf: String::new(),
+            }),
         })
     }
     
     /// 통계 수집
+    ///
+    /// 맵마다 배치 조회 한 번으로 모든 CPU 값을 읽고, 이전 수집과의 차이로 CPU별,
+    /// 수신 큐별, 규칙별 비율을 계산한다.
     pub async fn collect_stats(&self) -> Result<()> {
+        let mut guard = self.state.lock()
+            .map_err(|_| anyhow!("Failed to lock stats"))?;
+        let state = &mut *guard;
+        
         let now = Instant::now();
-        let elapsed = now.duration_since(self.last_collection).as_secs_f64();
+        let elapsed = now.duration_since(state.last_collection).as_secs_f64();
         
         // 최소 간격 확인
         if elapsed < 0.1 {
             return Ok(());
         }
+        state.last_collection = now;
         
-        let key = 0u32.to_le_bytes();
-        
-        // 맵에서 통계 읽기
-//        if let Ok(value) = self.stats_map.lookup(&key, 0) {
-        if let Ok(Some(value)) = self.stats_map.lookup(&key, MapFlags::empty()) {
-            if value.len() >= 16 {
-                // 통계 데이터 파싱
-                let packets = u64::from_le_bytes([
-                    value[0], value[1], value[2], value[3],
-                    value[4], value[5], value[6], value[7],
-                ]);
-                
-                let bytes = u64::from_le_bytes([
-                    value[8], value[9], value[10], value[11],
-                    value[12], value[13], value[14], value[15],
-                ]);
-                
-                // 통계 업데이트
-                let mut stats = self.stats.lock()
-                    .map_err(|_| anyhow!("Failed to lock stats"))?;
-                
-                // 초당 패킷 수 및 Mbps 계산
-                let packets_diff = packets.saturating_sub(stats.prev_packets);
-                let bytes_diff = bytes.saturating_sub(stats.prev_bytes);
-                
-                stats.packets_per_sec = (packets_diff as f64 / elapsed) as u64;
-                stats.mbps = (bytes_diff as f64 * 8.0 / elapsed) / 1_000_000.0;
-                
-                // 총계 업데이트
-                stats.total_packets = packets;
-                stats.total_bytes = bytes;
-                stats.last_update = SystemTime::now()
-                    .duration_since(UNIX_EPOCH)
-                    .map_err(|_| anyhow!("Failed to get system time"))?
-                    .as_secs();
-                
-                // 이전 값 저장
-                stats.prev_packets = packets;
-                stats.prev_bytes = bytes;
-                
-                // 로그 기록 (구성에서 활성화된 경우)
-                if self.config.telemetry.log_stats {
-                    debug!("Stats - Packets: {}, Bytes: {}, PPS: {}, Mbps: {:.2}",
-                        packets, bytes, stats.packets_per_sec, stats.mbps);
-                }
+        let stats = &mut state.stats;
+        
+        // 맵에서 CPU별 판정 통계 읽기
+        let values = &mut state.verdict_values;
+        values.read(self.stats_map, STAT_MAX)?;
+        
+        let mut verdicts = [VerdictCounter::default(); STAT_MAX];
+        for (cpu, cpu_stats) in stats.cpus.iter_mut().enumerate() {
+            let (mut packets, mut bytes) = (0u64, 0u64);
+            for (stat, total) in verdicts.iter_mut().enumerate() {
+                let value: &abi::filter_stats = values.get(stat, cpu);
+                let counter = VerdictCounter {
+                    packets: value.packets,
+                    bytes: value.bytes,
+                };
+                cpu_stats.verdicts[stat] = counter;
+                total.packets += counter.packets;
+                total.bytes += counter.bytes;
+                packets += counter.packets;
+                bytes += counter.bytes;
+            }
+            cpu_stats.total.update(packets, bytes, elapsed);
+        }
+        let packets: u64 = verdicts.iter().map(|v| v.packets).sum();
+        let bytes: u64 = verdicts.iter().map(|v| v.bytes).sum();
+        
+        // 수신 큐별 통계
+        if let (Some(map), Some(values)) = (self.queue_stats_map, state.queue_values.as_mut()) {
+            values.read(map, MAX_STAT_QUEUES)?;
+            for (queue, counter) in stats.queues.iter_mut().enumerate() {
+                let (packets, bytes) = sum_stats(values, queue);
+                counter.update(packets, bytes, elapsed);
+            }
+        }
+        
+        // 규칙별 통계 (사용 중인 가장 큰 규칙 ID까지만 조회)
+        let snapshot = self.rule_reader.snapshot();
+        if let (Some(map), Some(values)) = (self.rule_stats_map, state.rule_values.as_mut()) {
+            let count = snapshot.rules.iter()
+                .map(|(rule_id, _)| *rule_id as usize + 1)
+                .max()
+                .unwrap_or(0);
+            values.read(map, count)?;
+            for (rule_id, counter) in stats.rules.iter_mut().enumerate().take(count) {
+                let (packets, bytes) = sum_stats(values, rule_id);
+                counter.update(packets, bytes, elapsed);
+            }
+        }
+        
+        // 블록리스트별 통계 (사용 중인 가장 큰 ID까지만 조회)
+        if let (Some(map), Some(values)) = (self.blocklist_stats_map, state.blocklist_values.as_mut()) {
+            let count = snapshot.blocklists.iter()
+                .map(|list| list.id as usize + 1)
+                .max()
+                .unwrap_or(0);
+            values.read(map, count)?;
+            for (id, counter) in stats.blocklists.iter_mut().enumerate().take(count) {
+                let (packets, bytes) = sum_stats(values, id);
+                counter.update(packets, bytes, elapsed);
+            }
+        }
+        
+        // 직전 구간의 상위 소스
+        if let (Some(maps), Some(hh)) = (self.hh_maps.as_ref(), state.hh.as_mut()) {
+            hh.collect(maps, self.config.telemetry.heavy_hitters.top_k, elapsed, &mut stats.heavy_hitters)?;
+        }
+        
+        // 초당 패킷 수 및 Mbps 계산
+        let packets_diff = packets.saturating_sub(stats.prev_packets);
+        let bytes_diff = bytes.saturating_sub(stats.prev_bytes);
+        
+        stats.packets_per_sec = (packets_diff as f64 / elapsed) as u64;
+        stats.mbps = (bytes_diff as f64 * 8.0 / elapsed) / 1_000_000.0;
+        
+        // 총계 업데이트
+        stats.total_packets = packets;
+        stats.total_bytes = bytes;
+        stats.verdicts = verdicts;
+        stats.last_update = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_err(|_| anyhow!("Failed to get system time"))?
+            .as_secs();
+        
+        // 이전 값 저장
+        stats.prev_packets = packets;
+        stats.prev_bytes = bytes;
+        
+        // 로그 기록 (구성에서 활성화된 경우)
+        if self.config.telemetry.log_stats {
+            debug!("Stats - Packets: {}, Bytes: {}, PPS: {}, Mbps: {:.2}",
+                packets, bytes, stats.packets_per_sec, stats.mbps);
+            debug!("Verdicts - Pass: {}, Drop: {}, Redirect: {}, Aborted: {}, Parse fail: {}, TX: {}",
+                verdicts[STAT_PASS].packets, verdicts[STAT_DROP].packets,
+                verdicts[STAT_REDIRECT].packets, verdicts[STAT_ABORTED].packets,
+                verdicts[STAT_PARSE_FAIL].packets, verdicts[STAT_TX].packets);
+            
+            // 큐 간 불균형 (패킷이 들어온 큐 중 가장 바쁜 큐와 한가한 큐)
+            let active = stats.queues.iter().enumerate().filter(|(_, q)| q.packets > 0);
+            if let (Some((busiest, b)), Some((idlest, i))) = (
+                active.clone().max_by_key(|(_, q)| q.packets_per_sec),
+                active.min_by_key(|(_, q)| q.packets_per_sec),
+            ) {
+                debug!("Queues - Busiest: {} ({} pps), Idlest: {} ({} pps)",
+                    busiest, b.packets_per_sec, idlest, i.packets_per_sec);
+            }
+            
+            if let Some((rule_id, rule)) = snapshot.rules.iter()
+                .max_by_key(|(rule_id, _)| stats.rules[*rule_id as usize].packets_per_sec)
+            {
+                debug!("Hottest rule - {}: {} pps",
+                    rule.label, stats.rules[*rule_id as usize].packets_per_sec);
+            }
+            
+            if let Some(top) = stats.heavy_hitters.first() {
+                debug!("Top source - {}: {} pps", top.addr, top.packets_per_sec);
             }
         }
         
@@ -142,8 +511,9 @@ impl<'a> TelemetryCollector<'a> {
     
     /// 현재 통계 획득
     pub fn get_stats(&self) -> Result<SystemStats> {
-        let stats = self.stats.lock()
+        let state = self.state.lock()
             .map_err(|_| anyhow!("Failed to lock stats"))?;
+        let stats = &state.stats;
         
         Ok(SystemStats {
             total_packets: stats.total_packets,
@@ -152,4 +522,313 @@ impl<'a> TelemetryCollector<'a> {
             mbps: stats.mbps,
         })
     }
+    
+    /// 직전 수집 구간의 상위 소스
+    pub fn heavy_hitters(&self) -> Result<Vec<HeavyHitter>> {
+        let state = self.state.lock()
+            .map_err(|_| anyhow!("Failed to lock stats"))?;
+        Ok(state.stats.heavy_hitters.clone())
+    }
+    
+    /// 구성된 export_url에서 Prometheus 스크레이프 요청 처리
+    ///
+    /// 스크레이프는 마지막 수집 결과를 응답하므로 BPF 맵을 추가로 읽지 않는다.
+    /// 내보내기가 비활성이면 반환하지 않는다.
+    pub async fn serve_metrics(&self) -> Result<()> {
+        let telemetry = &self.config.telemetry;
+        if !telemetry.export_enabled {
+            return std::future::pending().await;
+        }
+        
+        let url = telemetry.export_url.as_deref()
+            .ok_or_else(|| anyhow!("Telemetry export is enabled but export_url is not set"))?;
+        let endpoint = parse_export_url(url)?;
+        
+        let listener = TcpListener::bind(&endpoint.addr)
+            .await
+            .with_context(|| format!("Failed to bind metrics endpoint {}", endpoint.addr))?;
+        
+        info!("Serving Prometheus metrics on http://{}{}", endpoint.addr, endpoint.path);
+        
+        loop {
+            let (mut stream, addr) = match listener.accept().await {
+                Ok(conn) => conn,
+                Err(e) => {
+                    warn!("Failed to accept metrics connection: {}", e);
+                    continue;
+                }
+            };
+            
+            if let Err(e) = self.handle_scrape(&mut stream, &endpoint.path).await {
+                debug!("Metrics scrape from {} failed: {}", addr, e);
+            }
+        }
+    }
+    
+    /// 스크레이프 요청 하나 처리 (요청 줄만 확인하고 응답 후 연결 종료)
+    async fn handle_scrape(&self, stream: &mut tokio::net::TcpStream, path: &str) -> Result<()> {
+        let mut request = [0u8; 1024];
+        let n = time::timeout(SCRAPE_TIMEOUT, stream.read(&mut request))
+            .await
+            .map_err(|_| anyhow!("Timed out reading scrape request"))??;
+        
+        // "GET <경로>[?질의] HTTP/1.x"
+        let line = request[..n].split(|b| *b == b'\r' || *b == b'\n').next().unwrap_or(&[]);
+        let mut parts = line.split(|b| *b == b' ');
+        let method = parts.next();
+        let target = parts.next()
+            .and_then(|target| target.split(|b| *b == b'?').next());
+        
+        if method != Some(b"GET".as_slice()) || target != Some(path.as_bytes()) {
+            stream.write_all(b"HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n").await?;
+            return Ok(());
+        }
+        
+        // 응답 버퍼를 빌려 렌더링 (잠금은 await 전에 해제)
+        let mut body = {
+            let mut state = self.state.lock()
+                .map_err(|_| anyhow!("Failed to lock stats"))?;
+            let mut body = std::mem::take(&mut state.export_buf);
+            body.clear();
+            render_prometheus(&mut body, &self.interface, &state.stats, &self.rule_reader.snapshot())
+                .map_err(|_| anyhow!("Failed to render metrics"))?;
+            body
+        };
+        
+        let header = format!(
+            "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+            body.len()
+        );
+        let result = async {
+            stream.write_all(header.as_bytes()).await?;
+            stream.write_all(body.as_bytes()).await?;
+            stream.flush().await
+        }.await;
+        
+        body.clear();
+        if let Ok(mut state) = self.state.lock() {
+            state.export_buf = body;
+        }
+        
+        result.context("Failed to send metrics")
+    }
+}
+
+/// 내보내기 엔드포인트
+#[derive(Debug, PartialEq, Eq)]
+struct ExportEndpoint {
+    /// 수신 주소 (호스트:포트)
+    addr: String,
+    /// HTTP 경로
+    path: String,
+}
+
+/// export_url 해석 ("http://주소:포트/경로" 또는 "주소:포트", 경로 기본값 /metrics)
+fn parse_export_url(url: &str) -> Result<ExportEndpoint> {
+    let rest = match url.split_once("://") {
+        Some(("http", rest)) => rest,
+        Some((scheme, _)) => {
+            return Err(anyhow!("Unsupported telemetry export scheme '{}' (only http is supported)", scheme));
+        }
+        None => url,
+    };
+    
+    let (addr, path) = match rest.find('/') {
+        Some(i) => (&rest[..i], &rest[i..]),
+        None => (rest, "/metrics"),
+    };
+    if addr.is_empty() {
+        return Err(anyhow!("Missing listen address in export_url '{}'", url));
+    }
+    
+    Ok(ExportEndpoint {
+        addr: addr.to_string(),
+        path: path.to_string(),
+    })
+}
+
+/// 메트릭 설명과 형식 줄
+fn write_header(out: &mut String, name: &str, kind: &str, help: &str) -> std::fmt::Result {
+    writeln!(out, "# HELP {} {}", name, help)?;
+    writeln!(out, "# TYPE {} {}", name, kind)
+}
+
+/// 레이블 값 이스케이프 (\\, ", 줄바꿈)
+fn write_label(out: &mut String, value: &str) {
+    for c in value.chars() {
+        match c {
+            '\\' => out.push_str("\\\\"),
+            '"' => out.push_str("\\\""),
+            '\n' => out.push_str("\\n"),
+            c => out.push(c),
+        }
+    }
+}
+
+/// 수집된 통계를 Prometheus 텍스트 형식으로 기록
+///
+/// 수신 큐는 패킷이 들어온 큐만, 규칙은 현재 규칙 집합에 있는 규칙만 기록한다.
+fn render_prometheus(
+    out: &mut String,
+    interface: &str,
+    stats: &CollectedStats,
+    rules: &RuleSnapshot,
+) -> std::fmt::Result {
+    let mut iface = String::with_capacity(interface.len());
+    write_label(&mut iface, interface);
+    
+    write_header(out, "swift_guard_packets_per_second", "gauge",
+        "Packets per second over the last collection interval")?;
+    writeln!(out, "swift_guard_packets_per_second{{interface=\"{}\"}} {}", iface, stats.packets_per_sec)?;
+    write_header(out, "swift_guard_throughput_mbps", "gauge",
+        "Throughput in Mbps over the last collection interval")?;
+    writeln!(out, "swift_guard_throughput_mbps{{interface=\"{}\"}} {:.3}", iface, stats.mbps)?;
+    
+    // CPU별 판정 카운터
+    write_header(out, "swift_guard_packets_total", "counter", "Packets by CPU and verdict")?;
+    for (cpu, cpu_stats) in stats.cpus.iter().enumerate() {
+        for (stat, counter) in cpu_stats.verdicts.iter().enumerate() {
+            writeln!(out, "swift_guard_packets_total{{interface=\"{}\",cpu=\"{}\",verdict=\"{}\"}} {}",
+                iface, cpu, VERDICT_NAMES[stat], counter.packets)?;
+        }
+    }
+    write_header(out, "swift_guard_bytes_total", "counter", "Bytes by CPU and verdict")?;
+    for (cpu, cpu_stats) in stats.cpus.iter().enumerate() {
+        for (stat, counter) in cpu_stats.verdicts.iter().enumerate() {
+            writeln!(out, "swift_guard_bytes_total{{interface=\"{}\",cpu=\"{}\",verdict=\"{}\"}} {}",
+                iface, cpu, VERDICT_NAMES[stat], counter.bytes)?;
+        }
+    }
+    write_header(out, "swift_guard_cpu_packets_per_second", "gauge", "Packets per second by CPU")?;
+    for (cpu, cpu_stats) in stats.cpus.iter().enumerate() {
+        writeln!(out, "swift_guard_cpu_packets_per_second{{interface=\"{}\",cpu=\"{}\"}} {}",
+            iface, cpu, cpu_stats.total.packets_per_sec)?;
+    }
+    
+    // 수신 큐별 카운터
+    let queues = || stats.queues.iter().enumerate().filter(|(_, q)| q.packets > 0);
+    write_header(out, "swift_guard_queue_packets_total", "counter", "Packets by receive queue")?;
+    for (queue, counter) in queues() {
+        writeln!(out, "swift_guard_queue_packets_total{{interface=\"{}\",queue=\"{}\"}} {}",
+            iface, queue, counter.packets)?;
+    }
+    write_header(out, "swift_guard_queue_bytes_total", "counter", "Bytes by receive queue")?;
+    for (queue, counter) in queues() {
+        writeln!(out, "swift_guard_queue_bytes_total{{interface=\"{}\",queue=\"{}\"}} {}",
+            iface, queue, counter.bytes)?;
+    }
+    write_header(out, "swift_guard_queue_packets_per_second", "gauge", "Packets per second by receive queue")?;
+    for (queue, counter) in queues() {
+        writeln!(out, "swift_guard_queue_packets_per_second{{interface=\"{}\",queue=\"{}\"}} {}",
+            iface, queue, counter.packets_per_sec)?;
+    }
+    
+    // 규칙별 카운터
+    write_header(out, "swift_guard_rule_packets_total", "counter", "Packets matched by rule")?;
+    write_rule_metric(out, "swift_guard_rule_packets_total", &iface, stats, rules, |c| c.packets)?;
+    write_header(out, "swift_guard_rule_bytes_total", "counter", "Bytes matched by rule")?;
+    write_rule_metric(out, "swift_guard_rule_bytes_total", &iface, stats, rules, |c| c.bytes)?;
+    write_header(out, "swift_guard_rule_packets_per_second", "gauge", "Packets per second matched by rule")?;
+    write_rule_metric(out, "swift_guard_rule_packets_per_second", &iface, stats, rules, |c| c.packets_per_sec)?;
+    
+    // 블록리스트별 카운터
+    write_header(out, "swift_guard_blocklist_packets_total", "counter", "Packets dropped by source blocklist")?;
+    for list in &rules.blocklists {
+        if let Some(counter) = stats.blocklists.get(list.id as usize) {
+            write!(out, "swift_guard_blocklist_packets_total{{interface=\"{}\",list=\"", iface)?;
+            write_label(out, &list.name);
+            writeln!(out, "\"}} {}", counter.packets)?;
+        }
+    }
+    write_header(out, "swift_guard_blocklist_prefixes", "gauge", "Unique prefixes in source blocklist")?;
+    for list in &rules.blocklists {
+        write!(out, "swift_guard_blocklist_prefixes{{interface=\"{}\",list=\"", iface)?;
+        write_label(out, &list.name);
+        writeln!(out, "\"}} {}", list.prefixes)?;
+    }
+    
+    // 맵 메모리 (가득 찼을 때의 추정치)
+    write_header(out, "swift_guard_map_memory_bytes", "gauge", "Estimated kernel memory of BPF map when full")?;
+    for map in &stats.map_memory {
+        writeln!(out, "swift_guard_map_memory_bytes{{interface=\"{}\",map=\"{}\"}} {}", iface, map.name, map.bytes)?;
+    }
+    if let Some(budget) = stats.memory_budget {
+        write_header(out, "swift_guard_map_memory_budget_bytes", "gauge", "Configured BPF map memory budget")?;
+        writeln!(out, "swift_guard_map_memory_budget_bytes{{interface=\"{}\"}} {}", iface, budget)?;
+    }
+    
+    // 상위 소스 (헤비 히터 탐지가 활성인 경우)
+    if !stats.heavy_hitters.is_empty() {
+        write_header(out, "swift_guard_heavy_hitter_packets_per_second", "gauge",
+            "Estimated packets per second of the top source addresses over the last collection interval")?;
+        for hh in &stats.heavy_hitters {
+            writeln!(out, "swift_guard_heavy_hitter_packets_per_second{{interface=\"{}\",source=\"{}\"}} {}",
+                iface, hh.addr, hh.packets_per_sec)?;
+        }
+    }
+    
+    Ok(())
+}
+
+/// 현재 규칙 집합의 규칙마다 메트릭 한 줄 기록 (레이블 = 규칙 레이블)
+fn write_rule_metric(
+    out: &mut String,
+    name: &str,
+    iface: &str,
+    stats: &CollectedStats,
+    rules: &RuleSnapshot,
+    value: impl Fn(&RateCounter) -> u64,
+) -> std::fmt::Result {
+    for (rule_id, rule) in &rules.rules {
+        if let Some(counter) = stats.rules.get(*rule_id as usize) {
+            write!(out, "{}{{interface=\"{}\",rule=\"", name, iface)?;
+            write_label(out, &rule.label);
+            writeln!(out, "\"}} {}", value(counter))?;
+        }
+    }
+    
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::blocklist::BlocklistInfo;
+
+    #[test]
+    fn test_parse_export_url() {
+        assert_eq!(
+            parse_export_url("http://0.0.0.0:9464/metrics").unwrap(),
+            ExportEndpoint { addr: "0.0.0.0:9464".to_string(), path: "/metrics".to_string() }
+        );
+        assert_eq!(parse_export_url("127.0.0.1:9100").unwrap().path, "/metrics");
+        assert!(parse_export_url("grpc://collector:4317").is_err());
+        assert!(parse_export_url("http:///metrics").is_err());
+    }
+
+    #[test]
+    fn test_render_skips_idle_queues() {
+        let mut stats = CollectedStats::new(2);
+        stats.cpus[1].verdicts[STAT_DROP].packets = 7;
+        stats.queues[3] = RateCounter { packets: 10, bytes: 600, packets_per_sec: 5, bits_per_sec: 2400 };
+        stats.heavy_hitters.push(HeavyHitter {
+            addr: std::net::Ipv4Addr::new(203, 0, 113, 7),
+            packets: 5000,
+            packets_per_sec: 500,
+        });
+        stats.blocklists[2].packets = 42;
+        let snapshot = RuleSnapshot {
+            rules: Vec::new(),
+            blocklists: vec![BlocklistInfo { id: 2, name: "feed".to_string(), prefixes: 3 }],
+        };
+
+        let mut out = String::new();
+        render_prometheus(&mut out, "eth\"0", &stats, &snapshot).unwrap();
+
+        assert!(out.contains("swift_guard_packets_total{interface=\"eth\\\"0\",cpu=\"1\",verdict=\"drop\"} 7\n"));
+        assert!(out.contains("swift_guard_queue_packets_total{interface=\"eth\\\"0\",queue=\"3\"} 10\n"));
+        assert!(!out.contains("queue=\"0\""));
+        assert!(out.contains("swift_guard_heavy_hitter_packets_per_second{interface=\"eth\\\"0\",source=\"203.0.113.7\"} 500\n"));
+        assert!(out.contains("swift_guard_blocklist_packets_total{interface=\"eth\\\"0\",list=\"feed\"} 42\n"));
+    }
 }
@@ -0,0 +1,155 @@
+//! 계층형 타이머 휠 모듈
+//! 규칙 만료 시각을 틱 단위로 관리하고 만료된 항목을 일괄 반환
+
+/// 레벨당 슬롯 수 (2^6)
+const WHEEL_BITS: u32 = 6;
+const WHEEL_SLOTS: usize = 1 << WHEEL_BITS;
+const WHEEL_MASK: u64 = (WHEEL_SLOTS as u64) - 1;
+
+/// 레벨 수 (64^4 틱까지 표현, 그 이상은 최상위 레벨에서 재배치)
+const WHEEL_LEVELS: usize = 4;
+
+/// 계층형 타이머 휠
+///
+/// 레벨 0은 틱 단위, 레벨 n은 64^n 틱 단위 슬롯을 가진다. 상위 레벨 슬롯은
+/// 현재 틱이 해당 구간에 들어설 때 하위 레벨로 재배치(cascade)된다.
+#[derive(Debug)]
+pub struct TimerWheel<T> {
+    /// 현재 틱
+    current: u64,
+    /// 타이머 수
+    len: usize,
+    /// 레벨별 슬롯 (항목 = (만료 틱, 값))
+    levels: Vec<Vec<Vec<(u64, T)>>>,
+}
+
+impl<T> TimerWheel<T> {
+    /// 새로운 타이머 휠 생성 (시작 틱 지정)
+    pub fn new(start_tick: u64) -> Self {
+        let levels = (0..WHEEL_LEVELS)
+            .map(|_| (0..WHEEL_SLOTS).map(|_| Vec::new()).collect())
+            .collect();
+
+        Self {
+            current: start_tick,
+            len: 0,
+            levels,
+        }
+    }
+
+    /// 등록된 타이머 수
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// 타이머 등록 (이미 지난 틱은 다음 advance에서 만료)
+    pub fn insert(&mut self, deadline: u64, value: T) {
+        self.len += 1;
+        self.place(deadline, value);
+    }
+
+    /// 현재 틱을 now까지 진행하고 만료된 항목 반환
+    pub fn advance(&mut self, now: u64) -> Vec<T> {
+        let mut expired = Vec::new();
+
+        while self.current <= now && self.len > 0 {
+            // 레벨 경계에 도달하면 상위 레벨 슬롯을 하위로 재배치
+            for level in 1..WHEEL_LEVELS {
+                let shift = WHEEL_BITS * level as u32;
+                if self.current & ((1u64 << shift) - 1) != 0 {
+                    break;
+                }
+                let slot = ((self.current >> shift) & WHEEL_MASK) as usize;
+                let entries = std::mem::take(&mut self.levels[level][slot]);
+                for (deadline, value) in entries {
+                    self.place(deadline, value);
+                }
+            }
+
+            let slot = (self.current & WHEEL_MASK) as usize;
+            let entries = std::mem::take(&mut self.levels[0][slot]);
+            for (deadline, value) in entries {
+                if deadline <= self.current {
+                    self.len -= 1;
+                    expired.push(value);
+                } else {
+                    self.place(deadline, value);
+                }
+            }
+
+            self.current += 1;
+        }
+
+        // 타이머가 없으면 남은 틱은 건너뜀
+        if self.current <= now {
+            self.current = now + 1;
+        }
+
+        expired
+    }
+
+    /// 만료 틱에 맞는 레벨/슬롯에 배치
+    fn place(&mut self, deadline: u64, value: T) {
+        // 이미 지난 타이머는 현재 슬롯에 배치
+        let target = deadline.max(self.current);
+        let delta = target - self.current;
+
+        let mut level = 0;
+        while level + 1 < WHEEL_LEVELS && delta >> (WHEEL_BITS * (level as u32 + 1)) != 0 {
+            level += 1;
+        }
+
+        // 최상위 레벨 범위를 넘으면 가장 먼 슬롯에 두고 재배치 시 다시 계산
+        let max_delta = (1u64 << (WHEEL_BITS * WHEEL_LEVELS as u32)) - 1;
+        let target = self.current + delta.min(max_delta);
+
+        let slot = ((target >> (WHEEL_BITS * level as u32)) & WHEEL_MASK) as usize;
+        self.levels[level][slot].push((deadline, value));
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_expires_in_order() {
+        let mut wheel = TimerWheel::new(0);
+        wheel.insert(5, "a");
+        wheel.insert(70, "b");
+        wheel.insert(5000, "c");
+        assert_eq!(wheel.len(), 3);
+
+        assert!(wheel.advance(4).is_empty());
+        assert_eq!(wheel.advance(5), vec!["a"]);
+        assert!(wheel.advance(69).is_empty());
+        assert_eq!(wheel.advance(70), vec!["b"]);
+        assert!(wheel.advance(4999).is_empty());
+        assert_eq!(wheel.advance(5000), vec!["c"]);
+        assert_eq!(wheel.len(), 0);
+    }
+
+    #[test]
+    fn test_batch_and_past_deadlines() {
+        let mut wheel = TimerWheel::new(100);
+        for i in 0..1000u64 {
+            wheel.insert(100 + (i % 300), i);
+        }
+        wheel.insert(10, 9999);
+
+        let mut expired = wheel.advance(1_000_000);
+        expired.sort();
+        assert_eq!(expired.len(), 1001);
+        assert_eq!(*expired.last().unwrap(), 9999);
+    }
+
+    #[test]
+    fn test_far_deadline_cascades() {
+        let far = (1u64 << 18) + 12345;
+        let mut wheel = TimerWheel::new(0);
+        wheel.insert(far, 1);
+
+        assert!(wheel.advance(far - 1).is_empty());
+        assert_eq!(wheel.advance(far), vec![1]);
+    }
+}
@@ -3,13 +3,44 @@
 
 use anyhow::{anyhow, Context, Result};
 use log::{debug, error, info, warn};
-use std::fs::File;
+use std::collections::hash_map::DefaultHasher;
+use std::fs::{self, File};
+use std::hash::{Hash, Hasher};
 use std::io::Read;
+use std::ops::Range;
 use std::path::{Path, PathBuf};
-use std::sync::{Arc, Mutex};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock, Weak};
 use std::time::Duration;
 use wasmtime::*;
 
+use crate::config::{TimeoutPolicy, WasmConfig};
+use crate::xsk::XdpDesc;
+
+/// WASM 페이지 크기
+const WASM_PAGE_SIZE: usize = 64 * 1024;
+
+/// inspect_batch 한 번에 넘기는 최대 패킷 수 (판정 비트맵 i64의 비트 수)
+pub const INSPECT_BATCH_MAX: usize = 64;
+
+/// inspect_batch 디스크립터 크기 (struct { u32 ptr; u32 len; })
+const BATCH_DESC_SIZE: usize = 8;
+
+/// 풀링 할당기가 미리 잡아 두는 인스턴스 슬롯 수
+const POOLED_INSTANCES: u32 = 64;
+
+/// 에포크 틱 주기 (실행 한도의 해상도)
+const EPOCH_TICK: Duration = Duration::from_millis(1);
+
+/// init 함수에 허용하는 에포크 틱 수 (검사 한도와 별도)
+const INIT_EPOCH_TICKS: u64 = 1000;
+
+/// 사전 컴파일 산출물 확장자
+const CACHE_EXTENSION: &str = "cwasm";
+
+/// 최대 크기가 없는 메모리에 예약하는 주소 공간 (이동 없이 맨 끝까지 확장 가능)
+const FIXED_MEMORY_RESERVE: usize = 4 << 30;
+
 /// WASM 모듈 상태
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum ModuleState {
@@ -35,15 +66,331 @@ pub struct WasmInspector {
     /// 상태
     state: ModuleState,
     /// wasmtime 엔진
-    engine: Engine,
+    engine: Arc<Engine>,
     /// wasmtime 스토어
     store: Option<Store<WasmInspectorData>>,
     /// wasmtime 인스턴스
     instance: Option<Instance>,
-    /// 처리된 패킷 수
-    processed_packets: u64,
-    /// 차단된 패킷 수
-    blocked_packets: u64,
+    /// 처리/차단 패킷 수
+    stats: Arc<InspectorStats>,
+    /// 실행 한도
+    budget: ExecutionBudget,
+    /// UMEM으로 예약된 게스트 메모리 영역 (게스트 오프셋, 길이)
+    umem: Option<(u32, u32)>,
+    /// load() 시 조회한 게스트 익스포트
+    exports: Option<GuestExports>,
+}
+
+/// 검사 통계
+///
+/// 인스턴스를 실행하는 스레드 하나만 기록하므로 잠금 없이 갱신하고,
+/// 워커 간 거짓 공유를 피하도록 캐시 라인 단위로 정렬한다.
+#[derive(Debug, Default)]
+#[repr(align(64))]
+pub struct InspectorStats {
+    processed: AtomicU64,
+    blocked: AtomicU64,
+    timeouts: AtomicU64,
+}
+
+impl InspectorStats {
+    fn record(&self, processed: u64, blocked: u64) {
+        self.processed.fetch_add(processed, Ordering::Relaxed);
+        if blocked != 0 {
+            self.blocked.fetch_add(blocked, Ordering::Relaxed);
+        }
+    }
+    
+    fn record_timeout(&self) {
+        self.timeouts.fetch_add(1, Ordering::Relaxed);
+    }
+    
+    /// (처리, 차단) 패킷 수
+    pub fn snapshot(&self) -> (u64, u64) {
+        (self.processed.load(Ordering::Relaxed), self.blocked.load(Ordering::Relaxed))
+    }
+    
+    /// 실행 한도를 넘긴 게스트 호출 수
+    pub fn timeouts(&self) -> u64 {
+        self.timeouts.load(Ordering::Relaxed)
+    }
+}
+
+/// 게스트 실행 한도
+#[derive(Debug, Clone, Copy)]
+pub struct ExecutionBudget {
+    /// 게스트 호출(배치) 하나에 허용하는 에포크 틱 수
+    pub epoch_ticks: u64,
+    /// 인스턴스당 선형 메모리 한도 (바이트)
+    pub memory_limit: usize,
+    /// 한도 초과 또는 트랩 시 판정
+    pub policy: TimeoutPolicy,
+}
+
+impl ExecutionBudget {
+    pub fn from_config(config: &WasmConfig) -> Self {
+        let tick_ms = EPOCH_TICK.as_millis() as u64;
+        Self {
+            epoch_ticks: ((config.execution_timeout_ms + tick_ms - 1) / tick_ms).max(1),
+            memory_limit: (config.memory_limit_mb as usize) << 20,
+            policy: config.timeout_policy,
+        }
+    }
+    
+    fn store_limits(&self, extra: usize) -> StoreLimits {
+        StoreLimitsBuilder::new()
+            .memory_size(self.memory_limit + extra)
+            .build()
+    }
+}
+
+impl Default for ExecutionBudget {
+    fn default() -> Self {
+        Self {
+            epoch_ticks: 10,
+            memory_limit: 32 << 20,
+            policy: TimeoutPolicy::FailOpen,
+        }
+    }
+}
+
+/// 에포크 인터럽트를 켠 엔진 구성
+fn epoch_config() -> Config {
+    let mut config = Config::new();
+    config.epoch_interruption(true);
+    config
+}
+
+/// 엔진을 에포크 틱 스레드에 등록 (첫 등록 시 스레드 시작)
+///
+/// 스레드는 EPOCH_TICK마다 등록된 모든 엔진의 에포크를 올리고, 게스트 호출은
+/// 호출 전에 설정한 틱 수가 지나면 Trap::Interrupt로 중단된다.
+/// 스레드는 약한 참조만 가지므로 반환된 핸들이 모두 버려지면 다음 틱에 등록이 해제된다.
+fn register_epoch_engine(engine: Engine) -> Arc<Engine> {
+    static ENGINES: OnceLock<Arc<Mutex<Vec<Weak<Engine>>>>> = OnceLock::new();
+    
+    let engines = ENGINES.get_or_init(|| {
+        let engines: Arc<Mutex<Vec<Weak<Engine>>>> = Arc::new(Mutex::new(Vec::new()));
+        let ticked = engines.clone();
+        let spawned = std::thread::Builder::new()
+            .name("wasm-epoch".to_string())
+            .spawn(move || loop {
+                std::thread::sleep(EPOCH_TICK);
+                if let Ok(mut engines) = ticked.lock() {
+                    engines.retain(|engine| match engine.upgrade() {
+                        Some(engine) => {
+                            engine.increment_epoch();
+                            true
+                        }
+                        None => false,
+                    });
+                }
+            });
+        if let Err(e) = spawned {
+            error!("Failed to start WASM epoch ticker, execution timeouts disabled: {}", e);
+        }
+        engines
+    });
+    
+    let engine = Arc::new(engine);
+    if let Ok(mut engines) = engines.lock() {
+        engines.push(Arc::downgrade(&engine));
+    }
+    
+    engine
+}
+
+/// 게스트 트랩을 정책 판정으로 변환 (트랩이 아닌 호스트 오류는 그대로 반환)
+fn trap_verdict(id: &str, stats: &InspectorStats, policy: TimeoutPolicy, err: anyhow::Error) -> Result<bool> {
+    match err.downcast_ref::<Trap>() {
+        Some(Trap::Interrupt) => {
+            stats.record_timeout();
+            debug!("WASM module {} exceeded its execution budget", id);
+        }
+        Some(trap) => debug!("WASM module {} trapped: {}", id, trap),
+        None => return Err(err),
+    }
+    
+    Ok(policy == TimeoutPolicy::FailClosed)
+}
+
+/// 워커들이 공유하는 컴파일된 모듈
+///
+/// Engine과 Module은 내부적으로 참조 계수되므로 복제 비용이 없고,
+/// instantiate()마다 독립된 Store/Instance를 만든다.
+#[derive(Clone)]
+pub struct CompiledModule {
+    id: String,
+    path: PathBuf,
+    engine: Arc<Engine>,
+    module: Module,
+    budget: ExecutionBudget,
+}
+
+impl CompiledModule {
+    /// 선형 메모리 주소가 고정되는 엔진으로 컴파일 (AF_XDP UMEM용)
+    pub fn compile_fixed_memory(
+        id: &str,
+        path: &Path,
+        cache: Option<&ModuleCache>,
+        budget: ExecutionBudget,
+    ) -> Result<Self> {
+        let mut config = epoch_config();
+        config.with_host_memory(Arc::new(FixedMemoryCreator));
+        let engine = register_epoch_engine(Engine::new(&config)
+            .context("Failed to create WASM engine with fixed memory")?);
+        let module = compile_module(&engine, path, cache)?;
+        
+        Ok(Self {
+            id: id.to_string(),
+            path: path.to_path_buf(),
+            engine,
+            module,
+            budget,
+        })
+    }
+    
+    /// 새 Store/Instance 생성
+    pub fn instantiate(&self) -> Result<WasmInspector> {
+        let mut inspector = WasmInspector::with_engine(&self.id, &self.path, self.engine.clone(), self.budget);
+        inspector.instantiate(&self.module)?;
+        
+        Ok(inspector)
+    }
+    
+    /// 모듈 ID 획득
+    pub fn id(&self) -> &str {
+        &self.id
+    }
+}
+
+/// WASM 파일 읽기 및 컴파일 (캐시가 있으면 사전 컴파일 산출물 재사용)
+fn compile_module(engine: &Engine, path: &Path, cache: Option<&ModuleCache>) -> Result<Module> {
+    let mut file = File::open(path)
+        .context(format!("Failed to open WASM file: {}", path.display()))?;
+    
+    let mut wasm_bytes = Vec::new();
+    file.read_to_end(&mut wasm_bytes)
+        .context("Failed to read WASM file")?;
+    
+    match cache {
+        Some(cache) => cache.load_or_compile(engine, path, &wasm_bytes),
+        None => Module::new(engine, wasm_bytes)
+            .context("Failed to compile WASM module"),
+    }
+}
+
+/// 사전 컴파일 산출물 캐시
+///
+/// 산출물은 `<dir>/<키>.cwasm`에 저장되고, 키는 모듈 바이트와 엔진의 컴파일
+/// 호환성 해시(wasmtime 버전, 대상 CPU, 컴파일러 설정)로 만든다. 모듈이나 엔진
+/// 구성이 바뀌면 키가 달라지므로 오래된 산출물은 읽히지 않는다.
+///
+/// 역직렬화된 산출물은 검증 없이 실행되므로 캐시 디렉터리는 데몬만 쓸 수 있어야 한다.
+#[derive(Debug, Clone)]
+pub struct ModuleCache {
+    dir: PathBuf,
+}
+
+impl ModuleCache {
+    /// 캐시 디렉터리 생성 (소유자 전용 권한)
+    pub fn new(dir: &Path) -> Result<Self> {
+        fs::create_dir_all(dir)
+            .context(format!("Failed to create WASM cache directory: {}", dir.display()))?;
+        
+        use std::os::unix::fs::PermissionsExt;
+        fs::set_permissions(dir, fs::Permissions::from_mode(0o700))
+            .context(format!("Failed to restrict WASM cache directory: {}", dir.display()))?;
+        
+        Ok(Self {
+            dir: dir.to_path_buf(),
+        })
+    }
+    
+    /// 캐시 키 (모듈 바이트 + 엔진 호환성 해시)
+    fn key(engine: &Engine, wasm_bytes: &[u8]) -> String {
+        let mut hasher = DefaultHasher::new();
+        wasm_bytes.hash(&mut hasher);
+        engine.precompile_compatibility_hash().hash(&mut hasher);
+        
+        format!("{:016x}-{}", hasher.finish(), wasm_bytes.len())
+    }
+    
+    /// 산출물 역직렬화, 없거나 사용할 수 없으면 컴파일 후 저장
+    fn load_or_compile(&self, engine: &Engine, path: &Path, wasm_bytes: &[u8]) -> Result<Module> {
+        let artifact = self.dir
+            .join(Self::key(engine, wasm_bytes))
+            .with_extension(CACHE_EXTENSION);
+        
+        if artifact.exists() {
+            // 캐시 디렉터리의 산출물은 이 데몬이 직렬화한 것만 존재
+            match unsafe { Module::deserialize_file(engine, &artifact) } {
+                Ok(module) => {
+                    debug!("Loaded precompiled WASM module {} from {}", path.display(), artifact.display());
+                    return Ok(module);
+                }
+                Err(e) => warn!("Discarding unusable WASM cache entry {}: {}", artifact.display(), e),
+            }
+        }
+        
+        let module = Module::new(engine, wasm_bytes)
+            .context("Failed to compile WASM module")?;
+        
+        // 저장 실패는 다음 시작이 느려질 뿐이므로 경고만 출력
+        if let Err(e) = self.store(&module, &artifact) {
+            warn!("Failed to cache precompiled WASM module {}: {}", path.display(), e);
+        }
+        
+        Ok(module)
+    }
+    
+    /// 임시 파일에 쓴 뒤 이름을 바꿔 부분 기록된 산출물이 읽히지 않도록 저장
+    fn store(&self, module: &Module, artifact: &Path) -> Result<()> {
+        let bytes = module.serialize()
+            .context("Failed to serialize WASM module")?;
+        
+        let tmp = artifact.with_extension(format!("{}.tmp.{}", CACHE_EXTENSION, std::process::id()));
+        fs::write(&tmp, &bytes)
+            .context(format!("Failed to write {}", tmp.display()))?;
+        fs::rename(&tmp, artifact)
+            .context(format!("Failed to rename {}", tmp.display()))?;
+        
+        debug!("Cached precompiled WASM module at {}", artifact.display());
+        Ok(())
+    }
+}
+
+/// 일반 검사 모듈용 엔진 (풀링 인스턴스 할당기 사용)
+///
+/// 메모리와 테이블 슬롯을 미리 예약해 두므로 인스턴스 생성 시 mmap이 없다.
+/// 슬롯 크기는 메모리 한도와 같게 잡는다.
+fn pooled_engine(budget: &ExecutionBudget) -> Result<Engine> {
+    let mut pooling = PoolingAllocationConfig::default();
+    pooling.instance_count(POOLED_INSTANCES);
+    pooling.instance_memory_pages(((budget.memory_limit + WASM_PAGE_SIZE - 1) / WASM_PAGE_SIZE) as u64);
+    
+    let mut config = epoch_config();
+    config.allocation_strategy(InstanceAllocationStrategy::Pooling(pooling));
+    
+    Engine::new(&config).context("Failed to create pooled WASM engine")
+}
+
+/// 호출마다 조회하지 않도록 캐시한 게스트 익스포트
+struct GuestExports {
+    /// 선형 메모리
+    memory: Memory,
+    /// inspect_packet(ptr, len) -> i32
+    inspect: TypedFunc<(i32, i32), i32>,
+    /// allocate(size) -> ptr (선택)
+    allocate: Option<TypedFunc<i32, i32>>,
+    /// deallocate(ptr, capacity) (선택)
+    deallocate: Option<TypedFunc<(i32, i32), ()>>,
+    /// inspect_batch(descs, count) -> 차단 비트맵 (선택)
+    inspect_batch: Option<TypedFunc<(i32, i32), i64>>,
+    /// inspect_batch 디스크립터 배열 (게스트 포인터)
+    batch_descs: Option<i32>,
+    /// 복사 경로용 재사용 패킷 버퍼 (게스트 포인터, 용량)
+    scratch: Option<(i32, usize)>,
 }
 
 /// WASM 모듈 컨텍스트 데이터
@@ -51,14 +398,12 @@ pub struct WasmInspector {
 pub struct WasmInspectorData {
     /// 메모리 버퍼
     memory_buffer: Vec<u8>,
-    /// 패킷 데이터
-    packet_data: Vec<u8>,
-    /// 패킷 길이
-    packet_len: usize,
     /// 결과 버퍼
     result_buffer: Vec<u8>,
     /// 로그 버퍼
     log_buffer: String,
+    /// 메모리 한도
+    limits: StoreLimits,
 }
 
 // Debug 구현
@@ -68,55 +413,167 @@ impl std::fmt::Debug for WasmInspector {
             .field("id", &self.id)
             .field("path", &self.path)
             .field("state", &self.state)
-            .field("processed_packets", &self.processed_packets)
-            .field("blocked_packets", &self.blocked_packets)
+            .field("stats", &self.stats.snapshot())
             .finish()
     }
 }
 
+/// 기준 주소가 고정된 선형 메모리
+///
+/// 최대 크기만큼 주소 공간을 미리 예약하고 확장 시 보호 속성만 바꾸므로,
+/// 메모리 일부를 AF_XDP UMEM으로 커널에 등록해도 주소가 바뀌지 않는다.
+struct FixedMemory {
+    base: *mut u8,
+    size: usize,
+    reserved: usize,
+    mapped: usize,
+    maximum: Option<usize>,
+}
+
+// 메모리 영역 자체는 wasmtime이 스토어 단위로 동기화
+unsafe impl Send for FixedMemory {}
+unsafe impl Sync for FixedMemory {}
+
+unsafe impl LinearMemory for FixedMemory {
+    fn byte_size(&self) -> usize {
+        self.size
+    }
+    
+    fn maximum_byte_size(&self) -> Option<usize> {
+        self.maximum
+    }
+    
+    fn grow_to(&mut self, new_size: usize) -> Result<()> {
+        if new_size > self.reserved {
+            return Err(anyhow!("Fixed memory cannot grow beyond {} bytes", self.reserved));
+        }
+        
+        if new_size > self.size {
+            let ret = unsafe {
+                libc::mprotect(
+                    self.base.add(self.size) as *mut libc::c_void,
+                    new_size - self.size,
+                    libc::PROT_READ | libc::PROT_WRITE,
+                )
+            };
+            if ret != 0 {
+                return Err(anyhow!("Failed to grow fixed memory: {}", std::io::Error::last_os_error()));
+            }
+        }
+        self.size = new_size;
+        
+        Ok(())
+    }
+    
+    fn as_ptr(&self) -> *mut u8 {
+        self.base
+    }
+    
+    fn wasm_accessible(&self) -> Range<usize> {
+        let base = self.base as usize;
+        base..base + self.size
+    }
+}
+
+impl Drop for FixedMemory {
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(self.base as *mut libc::c_void, self.mapped);
+        }
+    }
+}
+
+/// FixedMemory를 생성하는 메모리 생성기
+struct FixedMemoryCreator;
+
+unsafe impl MemoryCreator for FixedMemoryCreator {
+    fn new_memory(
+        &self,
+        _ty: MemoryType,
+        minimum: usize,
+        maximum: Option<usize>,
+        reserved_size_in_bytes: Option<usize>,
+        guard_size_in_bytes: usize,
+    ) -> std::result::Result<Box<dyn LinearMemory>, String> {
+        let reserved = reserved_size_in_bytes
+            .unwrap_or_else(|| maximum.unwrap_or(FIXED_MEMORY_RESERVE))
+            .max(minimum);
+        let mapped = reserved + guard_size_in_bytes;
+        
+        // 전체를 접근 불가로 예약한 뒤 최소 크기만 읽기/쓰기 허용
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                mapped,
+                libc::PROT_NONE,
+                libc::MAP_PRIVATE | libc::MAP_ANONYMOUS | libc::MAP_NORESERVE,
+                -1,
+                0,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return Err(format!("Failed to reserve fixed memory: {}", std::io::Error::last_os_error()));
+        }
+        
+        let mut memory = FixedMemory {
+            base: base as *mut u8,
+            size: 0,
+            reserved,
+            mapped,
+            maximum,
+        };
+        memory.grow_to(minimum).map_err(|e| e.to_string())?;
+        
+        Ok(Box::new(memory))
+    }
+}
+
 impl WasmInspector {
     /// 새로운 WASM 검사 모듈 생성
     pub fn new(id: &str, path: &Path) -> Result<Self> {
-        let engine = Engine::default();
+        let engine = register_epoch_engine(Engine::new(&epoch_config())
+            .context("Failed to create WASM engine")?);
         
-        Ok(Self {
+        Ok(Self::with_engine(id, path, engine, ExecutionBudget::default()))
+    }
+    
+    fn with_engine(id: &str, path: &Path, engine: Arc<Engine>, budget: ExecutionBudget) -> Self {
+        Self {
             id: id.to_string(),
             path: path.to_path_buf(),
             state: ModuleState::Initialized,
             engine,
             store: None,
             instance: None,
-            processed_packets: 0,
-            blocked_packets: 0,
-        })
+            stats: Arc::new(InspectorStats::default()),
+            budget,
+            umem: None,
+            exports: None,
+        }
     }
     
     /// 모듈 로드
     pub fn load(&mut self) -> Result<()> {
         debug!("Loading WASM module: {}", self.path.display());
         
-        // WASM 파일 읽기
-        let mut file = File::open(&self.path)
-            .context(format!("Failed to open WASM file: {}", self.path.display()))?;
-        
-        let mut wasm_bytes = Vec::new();
-        file.read_to_end(&mut wasm_bytes)
-            .context("Failed to read WASM file")?;
-        
-        // 모듈 및 인스턴스 생성
-        let module = Module::new(&self.engine, wasm_bytes)
-            .context("Failed to compile WASM module")?;
-        
+        let module = compile_module(&self.engine, &self.path, None)?;
+        self.instantiate(&module)
+    }
+    
+    /// 컴파일된 모듈로 Store/Instance 생성
+    fn instantiate(&mut self, module: &Module) -> Result<()> {
         let mut store = Store::new(
             &self.engine,
             WasmInspectorData {
                 memory_buffer: Vec::new(),
-                packet_data: Vec::new(),
-                packet_len: 0,
                 result_buffer: Vec::new(),
                 log_buffer: String::new(),
+                limits: self.budget.store_limits(0),
             },
         );
+        store.limiter(|data| &mut data.limits);
+        store.epoch_deadline_trap();
+        store.set_epoch_deadline(INIT_EPOCH_TICKS);
         
         // WASM에 노출할 호스트 함수 정의
         let log_func = Func::wrap(&mut store, |mut caller: Caller<'_, WasmInspectorData>, ptr: i32, len: i32| -> i32 {
@@ -149,14 +606,21 @@ impl WasmInspector {
         linker.define(&mut store, "env", "log", log_func)
             .context("Failed to define host function: log")?;
         
-        let instance = linker.instantiate(&mut store, &module)
+        let instance = linker.instantiate(&mut store, module)
             .context("Failed to instantiate WASM module")?;
         
-        // 메모리 획득
+        // 메모리 및 검사 함수 획득 (이후 호출에서 재사용)
         let memory = instance
             .get_memory(&mut store, "memory")
             .ok_or_else(|| anyhow!("WASM module has no exported memory"))?;
         
+        let inspect = instance
+            .get_typed_func::<(i32, i32), i32>(&mut store, "inspect_packet")
+            .context("WASM module has no inspect_packet function")?;
+        let allocate = instance.get_typed_func::<i32, i32>(&mut store, "allocate").ok();
+        let deallocate = instance.get_typed_func::<(i32, i32), ()>(&mut store, "deallocate").ok();
+        let inspect_batch = instance.get_typed_func::<(i32, i32), i64>(&mut store, "inspect_batch").ok();
+        
         // 초기화 함수 호출 (있는 경우)
         if let Ok(init_func) = instance.get_typed_func::<(), ()>(&mut store, "init") {
             init_func.call(&mut store, ())
@@ -164,6 +628,28 @@ impl WasmInspector {
             debug!("WASM module initialized");
         }
         
+        // 일괄 검사 디스크립터 배열은 한 번만 할당
+        let batch_descs = match (&inspect_batch, &allocate) {
+            (Some(_), Some(alloc)) => Some(
+                alloc.call(&mut store, (INSPECT_BATCH_MAX * BATCH_DESC_SIZE) as i32)
+                    .context("Failed to allocate batch descriptors in WASM")?,
+            ),
+            (Some(_), None) => {
+                warn!("WASM module {} exports inspect_batch without allocate, using per-packet calls", self.id);
+                None
+            }
+            _ => None,
+        };
+        
+        self.exports = Some(GuestExports {
+            memory,
+            inspect,
+            allocate,
+            deallocate,
+            inspect_batch,
+            batch_descs,
+            scratch: None,
+        });
         self.store = Some(store);
         self.instance = Some(instance);
         self.state = ModuleState::Loaded;
@@ -180,51 +666,153 @@ impl WasmInspector {
         
         let store = self.store.as_mut()
             .ok_or_else(|| anyhow!("WASM store not initialized"))?;
+        let exports = self.exports.as_mut()
+            .ok_or_else(|| anyhow!("WASM exports not initialized"))?;
         
-        let instance = self.instance.as_ref()
-            .ok_or_else(|| anyhow!("WASM instance not initialized"))?;
-        
-        // 메모리 획득
-        let memory = instance
-            .get_memory(&mut *store, "memory")
-            .ok_or_else(|| anyhow!("WASM module has no exported memory"))?;
-            
-        // 검사 함수 획득
-        let inspect_func = instance
-            .get_typed_func::<(i32, i32), i32>(store, "inspect_packet")
-            .context("WASM module has no inspect_packet function")?;
-        
-        // 패킷 데이터를 WASM 메모리에 복사
-        store.data_mut().packet_data = packet.to_vec();
-        store.data_mut().packet_len = packet.len();
+        // 할당과 검사를 합쳐 한 번의 한도 적용
+        store.set_epoch_deadline(self.budget.epoch_ticks);
         
-        // 메모리 할당 (필요한 경우)
-        let alloc_func = instance.get_typed_func::<i32, i32>(store, "allocate");
-        let ptr = if let Ok(alloc) = alloc_func {
-            alloc.call(store, packet.len() as i32)
-                .context("Failed to allocate memory in WASM")?
-        } else {
+        // 게스트 버퍼는 재사용하고 더 큰 패킷이 올 때만 재할당
+        let ptr = match (exports.scratch, &exports.allocate) {
+            (Some((ptr, capacity)), _) if capacity >= packet.len() => ptr,
+            (scratch, Some(alloc)) => {
+                if let (Some((old, capacity)), Some(dealloc)) = (scratch, &exports.deallocate) {
+                    dealloc.call(&mut *store, (old, capacity as i32))
+                        .context("Failed to free memory in WASM")?;
+                }
+                let capacity = packet.len().max(2048);
+                let ptr = alloc.call(&mut *store, capacity as i32)
+                    .context("Failed to allocate memory in WASM")?;
+                exports.scratch = Some((ptr, capacity));
+                ptr
+            }
             // 할당 함수가 없는 경우 고정 오프셋 사용
-            1024
+            (_, None) => 1024,
         };
         
-        // 패킷 데이터 복사
-        memory.write(store, ptr as usize, packet)
+        // 패킷 데이터를 게스트 메모리에 한 번만 복사
+        exports.memory.write(&mut *store, ptr as usize, packet)
             .context("Failed to write packet data to WASM memory")?;
         
-        // 검사 함수 호출
-        let result = inspect_func.call(store, (ptr, packet.len() as i32))
-            .context("Failed to call inspect_packet function")?;
+        // 검사 함수 호출 (결과 1 = 차단, 0 = 통과, 트랩은 정책 판정)
+        let blocked = match exports.inspect.call(&mut *store, (ptr, packet.len() as i32)) {
+            Ok(result) => result != 0,
+            Err(e) => trap_verdict(&self.id, &self.stats, self.budget.policy, e)
+                .context("Failed to call inspect_packet function")?,
+        };
+        self.stats.record(1, blocked as u64);
         
-        self.processed_packets += 1;
+        Ok(blocked)
+    }
+    
+    /// 게스트 메모리 끝에 UMEM 영역 예약 (호스트 주소 반환)
+    ///
+    /// 메모리를 확장해 만든 영역이므로 게스트 할당기는 이후에도 이 영역을 쓰지 않는다.
+    /// CompiledModule::compile_fixed_memory로 컴파일한 모듈에서만 주소가 고정된다.
+    pub fn reserve_umem(&mut self, len: usize) -> Result<*mut u8> {
+        let store = self.store.as_mut()
+            .ok_or_else(|| anyhow!("WASM store not initialized"))?;
+        let memory = self.exports.as_ref()
+            .ok_or_else(|| anyhow!("WASM exports not initialized"))?
+            .memory;
         
-        // 결과 해석 (1 = 차단, 0 = 통과)
-        if result != 0 {
-            self.blocked_packets += 1;
-            Ok(true) // 차단
+        // UMEM은 메모리 한도와 별도로 허용
+        let pages = (len + WASM_PAGE_SIZE - 1) / WASM_PAGE_SIZE;
+        store.data_mut().limits = self.budget.store_limits(pages * WASM_PAGE_SIZE);
+        let old_pages = memory.grow(&mut *store, pages as u64)
+            .context("Failed to grow WASM memory for UMEM")?;
+        let guest_base = old_pages as usize * WASM_PAGE_SIZE;
+        if guest_base + len > u32::MAX as usize {
+            return Err(anyhow!("UMEM does not fit in 32-bit WASM memory"));
+        }
+        
+        self.umem = Some((guest_base as u32, len as u32));
+        
+        let host = unsafe { memory.data_ptr(&*store).add(guest_base) };
+        debug!("Reserved {} bytes of WASM memory at guest offset {:#x} for UMEM", len, guest_base);
+        
+        Ok(host)
+    }
+    
+    /// UMEM 프레임을 제자리에서 검사 (verdicts[i] = 차단 여부)
+    ///
+    /// 모듈이 inspect_batch를 익스포트하면 INSPECT_BATCH_MAX개 단위로 한 번만
+    /// 게스트에 진입하고, 아니면 프레임마다 inspect_packet을 호출한다.
+    pub fn inspect_frames(&mut self, descs: &[XdpDesc], verdicts: &mut Vec<bool>) -> Result<()> {
+        if self.state != ModuleState::Loaded && self.state != ModuleState::Running {
+            return Err(anyhow!("WASM module not loaded"));
+        }
+        
+        let (guest_base, umem_len) = self.umem
+            .ok_or_else(|| anyhow!("WASM module has no UMEM"))?;
+        let store = self.store.as_mut()
+            .ok_or_else(|| anyhow!("WASM store not initialized"))?;
+        let exports = self.exports.as_ref()
+            .ok_or_else(|| anyhow!("WASM exports not initialized"))?;
+        
+        // 커널이 넘긴 디스크립터도 UMEM 범위 확인 (범위 밖은 게스트와 정책 판정 없이 차단)
+        let in_umem = |desc: &XdpDesc| desc.addr + desc.len as u64 <= umem_len as u64;
+        
+        verdicts.clear();
+        verdicts.extend(descs.iter().map(|desc| !in_umem(desc)));
+        
+        if let (Some(batch), Some(batch_descs)) = (&exports.inspect_batch, exports.batch_descs) {
+            for (chunk_index, chunk) in descs.chunks(INSPECT_BATCH_MAX).enumerate() {
+                // 디스크립터 배열 기록 (struct { u32 ptr; u32 len; })
+                let mut raw = [0u8; INSPECT_BATCH_MAX * BATCH_DESC_SIZE];
+                for (i, desc) in chunk.iter().enumerate() {
+                    let (ptr, len) = if in_umem(desc) {
+                        (guest_base + desc.addr as u32, desc.len)
+                    } else {
+                        (0, 0)
+                    };
+                    raw[i * BATCH_DESC_SIZE..i * BATCH_DESC_SIZE + 4].copy_from_slice(&ptr.to_le_bytes());
+                    raw[i * BATCH_DESC_SIZE + 4..(i + 1) * BATCH_DESC_SIZE].copy_from_slice(&len.to_le_bytes());
+                }
+                exports.memory.write(&mut *store, batch_descs as usize, &raw[..chunk.len() * BATCH_DESC_SIZE])
+                    .context("Failed to write batch descriptors to WASM memory")?;
+                
+                // 배치마다 한도 적용, 초과하면 배치 전체에 정책 판정
+                store.set_epoch_deadline(self.budget.epoch_ticks);
+                let blocked = match batch.call(&mut *store, (batch_descs, chunk.len() as i32)) {
+                    Ok(blocked) => blocked as u64,
+                    Err(e) => {
+                        let verdict = trap_verdict(&self.id, &self.stats, self.budget.policy, e)
+                            .context("Failed to call inspect_batch function")?;
+                        if verdict { u64::MAX } else { 0 }
+                    }
+                };
+                
+                for i in 0..chunk.len() {
+                    verdicts[chunk_index * INSPECT_BATCH_MAX + i] |= blocked & (1 << i) != 0;
+                }
+            }
         } else {
-            Ok(false) // 통과
+            // 배치 전체에 한도 하나 적용, 초과하면 남은 프레임은 정책 판정
+            store.set_epoch_deadline(self.budget.epoch_ticks);
+            for (i, desc) in descs.iter().enumerate() {
+                if verdicts[i] {
+                    continue;
+                }
+                let ptr = guest_base + desc.addr as u32;
+                match exports.inspect.call(&mut *store, (ptr as i32, desc.len as i32)) {
+                    Ok(result) => verdicts[i] = result != 0,
+                    Err(e) => {
+                        let verdict = trap_verdict(&self.id, &self.stats, self.budget.policy, e)
+                            .context("Failed to call inspect_packet function")?;
+                        for (blocked, desc) in verdicts[i..].iter_mut().zip(&descs[i..]) {
+                            *blocked = verdict || !in_umem(desc);
+                        }
+                        break;
+                    }
+                }
+            }
         }
+        
+        let blocked = verdicts.iter().filter(|blocked| **blocked).count();
+        self.stats.record(descs.len() as u64, blocked as u64);
+        
+        Ok(())
     }
     
     /// 상태 획득
@@ -234,7 +822,17 @@ impl WasmInspector {
     
     /// 통계 획득
     pub fn stats(&self) -> (u64, u64) {
-        (self.processed_packets, self.blocked_packets)
+        self.stats.snapshot()
+    }
+    
+    /// 한도 초과, 트랩 또는 검사 실패 시 판정
+    pub fn policy(&self) -> TimeoutPolicy {
+        self.budget.policy
+    }
+    
+    /// 통계 핸들 획득 (인스턴스가 다른 스레드로 옮겨진 뒤에도 읽기 가능)
+    pub fn stats_handle(&self) -> Arc<InspectorStats> {
+        self.stats.clone()
     }
     
     /// 모듈 ID 획득
@@ -243,25 +841,90 @@ impl WasmInspector {
     }
 }
 
-/// WASM 검사 모듈 관리자
+/// 전용 워커가 실행 중인 인스턴스 (인스턴스는 워커가 소유, 관리자는 통계만 보관)
 #[derive(Debug)]
+struct WorkerEntry {
+    module_id: String,
+    queue_id: u32,
+    cpu: usize,
+    stats: Arc<InspectorStats>,
+}
+
+/// WASM 검사 모듈 관리자 (복제본은 같은 모듈 목록 공유)
+#[derive(Clone)]
 pub struct WasmManager {
     /// 로드된 검사 모듈
     inspectors: Arc<Mutex<Vec<WasmInspector>>>,
+    /// 워커 인스턴스 (검사 경로에서는 잠그지 않음)
+    workers: Arc<Mutex<Vec<WorkerEntry>>>,
+    /// 일반 검사 모듈이 공유하는 풀링 엔진
+    engine: Arc<Engine>,
+    /// 게스트 실행 한도
+    budget: ExecutionBudget,
+    /// 사전 컴파일 산출물 캐시
+    cache: Option<ModuleCache>,
+}
+
+impl std::fmt::Debug for WasmManager {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("WasmManager")
+            .field("inspectors", &self.inspectors)
+            .field("workers", &self.workers)
+            .field("budget", &self.budget)
+            .field("cache", &self.cache)
+            .finish()
+    }
 }
 
 impl WasmManager {
-    /// 새로운 WASM 관리자 생성
+    /// 새로운 WASM 관리자 생성 (기본 한도, 캐시 없음)
     pub fn new() -> Self {
+        Self::build(ExecutionBudget::default(), None)
+    }
+    
+    /// 구성의 실행 한도와 사전 컴파일 캐시를 사용하는 WASM 관리자 생성
+    ///
+    /// 캐시 디렉터리를 만들 수 없으면 경고 후 매번 컴파일한다.
+    pub fn from_config(config: &WasmConfig, cache_dir: &Path) -> Self {
+        let cache = match ModuleCache::new(cache_dir) {
+            Ok(cache) => Some(cache),
+            Err(e) => {
+                warn!("WASM module cache disabled: {}", e);
+                None
+            }
+        };
+        
+        Self::build(ExecutionBudget::from_config(config), cache)
+    }
+    
+    fn build(budget: ExecutionBudget, cache: Option<ModuleCache>) -> Self {
+        let engine = pooled_engine(&budget).unwrap_or_else(|e| {
+            warn!("{}, falling back to on-demand allocation", e);
+            Engine::new(&epoch_config()).unwrap_or_default()
+        });
+        let engine = register_epoch_engine(engine);
+        
         Self {
             inspectors: Arc::new(Mutex::new(Vec::new())),
+            workers: Arc::new(Mutex::new(Vec::new())),
+            engine,
+            budget,
+            cache,
         }
     }
     
+    /// 모듈 컴파일(또는 캐시 적재) 후 인스턴스 생성
+    fn instantiate(&self, id: &str, path: &Path) -> Result<WasmInspector> {
+        let module = compile_module(&self.engine, path, self.cache.as_ref())?;
+        let mut inspector = WasmInspector::with_engine(id, path, self.engine.clone(), self.budget);
+        inspector.instantiate(&module)?;
+        
+        Ok(inspector)
+    }
+    
     /// 모듈 로드
     pub fn load_module(&self, id: &str, path: &Path) -> Result<()> {
-        let mut inspector = WasmInspector::new(id, path)?;
-        inspector.load()?;
+        let inspector = self.instantiate(id, path)?;
         
         let mut inspectors = self.inspectors.lock()
             .map_err(|_| anyhow!("Failed to lock inspectors"))?;
@@ -271,6 +934,57 @@ impl WasmManager {
         Ok(())
     }
     
+    /// 모듈 재로드 (새 인스턴스를 만든 뒤 교체하므로 실패하면 기존 인스턴스 유지)
+    pub fn reload_module(&self, id: &str) -> Result<()> {
+        let path = {
+            let inspectors = self.inspectors.lock()
+                .map_err(|_| anyhow!("Failed to lock inspectors"))?;
+            inspectors.iter()
+                .find(|inspector| inspector.id() == id)
+                .map(|inspector| inspector.path.clone())
+                .ok_or_else(|| anyhow!("WASM module not found: {}", id))?
+        };
+        
+        // 컴파일은 잠금 밖에서 수행
+        let inspector = self.instantiate(id, &path)?;
+        
+        let mut inspectors = self.inspectors.lock()
+            .map_err(|_| anyhow!("Failed to lock inspectors"))?;
+        match inspectors.iter_mut().find(|inspector| inspector.id() == id) {
+            Some(slot) => {
+                // 통계는 재로드 전후로 이어서 집계
+                let mut inspector = inspector;
+                inspector.stats = slot.stats.clone();
+                *slot = inspector;
+            }
+            None => inspectors.push(inspector),
+        }
+        
+        info!("WASM module reloaded: {}", id);
+        Ok(())
+    }
+    
+    /// 워커용 고정 메모리 모듈 컴파일 (같은 캐시 사용)
+    pub fn compile_fixed_memory(&self, id: &str, path: &Path) -> Result<CompiledModule> {
+        CompiledModule::compile_fixed_memory(id, path, self.cache.as_ref(), self.budget)
+    }
+    
+    /// 워커 인스턴스 등록 (통계 합산용)
+    pub fn register_worker(&self, inspector: &WasmInspector, queue_id: u32, cpu: usize) -> Result<()> {
+        let mut workers = self.workers.lock()
+            .map_err(|_| anyhow!("Failed to lock workers"))?;
+        
+        workers.push(WorkerEntry {
+            module_id: inspector.id().to_string(),
+            queue_id,
+            cpu,
+            stats: inspector.stats_handle(),
+        });
+        debug!("Registered WASM worker {} on queue {} (cpu {})", inspector.id(), queue_id, cpu);
+        
+        Ok(())
+    }
+    
     /// 패킷 검사 (모든 모듈)
     pub fn inspect_packet(&self, packet: &[u8]) -> Result<bool> {
         let mut inspectors = self.inspectors.lock()
@@ -302,6 +1016,22 @@ impl WasmManager {
                 blocked,
             ));
         }
+        drop(inspectors);
+        
+        // 워커 인스턴스는 모듈별로 합산
+        let workers = self.workers.lock()
+            .map_err(|_| anyhow!("Failed to lock workers"))?;
+        
+        for worker in workers.iter() {
+            let (processed, blocked) = worker.stats.snapshot();
+            match result.iter_mut().find(|(id, ..)| *id == worker.module_id) {
+                Some(entry) => {
+                    entry.2 += processed;
+                    entry.3 += blocked;
+                }
+                None => result.push((worker.module_id.clone(), ModuleState::Running, processed, blocked)),
+            }
+        }
         
         Ok(result)
     }
@@ -312,3 +1042,182 @@ impl Default for WasmManager {
         Self::new()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    
+    /// WAT 모듈을 테스트 디렉터리에 기록 (wasmtime은 텍스트 형식도 컴파일)
+    fn write_module(name: &str, wat: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("swift-guard-wasm-test-{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let path = dir.join(name);
+        fs::write(&path, wat).unwrap();
+        path
+    }
+    
+    fn load(path: &Path, budget: ExecutionBudget) -> WasmInspector {
+        let engine = register_epoch_engine(Engine::new(&epoch_config()).unwrap());
+        let mut inspector = WasmInspector::with_engine("test", path, engine, budget);
+        inspector.load().unwrap();
+        inspector
+    }
+    
+    fn budget(policy: TimeoutPolicy) -> ExecutionBudget {
+        ExecutionBudget {
+            epoch_ticks: 2,
+            memory_limit: 4 * WASM_PAGE_SIZE,
+            policy,
+        }
+    }
+    
+    #[test]
+    fn test_trap_policy() {
+        let spin = write_module("spin.wat", r#"
+            (module
+              (memory (export "memory") 1)
+              (func (export "inspect_packet") (param i32 i32) (result i32)
+                (loop $spin (br $spin))
+                (i32.const 0)))
+        "#);
+        let unreachable = write_module("unreachable.wat", r#"
+            (module
+              (memory (export "memory") 1)
+              (func (export "inspect_packet") (param i32 i32) (result i32)
+                (unreachable)))
+        "#);
+        
+        // 한도를 넘긴 호출은 타임아웃으로 집계되고 정책 판정을 받음
+        for (policy, blocked) in [(TimeoutPolicy::FailOpen, false), (TimeoutPolicy::FailClosed, true)] {
+            let mut inspector = load(&spin, budget(policy));
+            assert_eq!(inspector.inspect_packet(&[0u8; 64]).unwrap(), blocked);
+            assert_eq!(inspector.stats_handle().timeouts(), 1);
+            
+            // 다른 트랩도 정책 판정이지만 타임아웃은 아님
+            let mut inspector = load(&unreachable, budget(policy));
+            assert_eq!(inspector.inspect_packet(&[0u8; 64]).unwrap(), blocked);
+            assert_eq!(inspector.stats_handle().timeouts(), 0);
+        }
+    }
+    
+    #[test]
+    fn test_memory_limit() {
+        // 패킷 길이만큼 페이지를 늘리고 실패하면 1 반환
+        let grow = write_module("grow.wat", r#"
+            (module
+              (memory (export "memory") 1)
+              (func (export "inspect_packet") (param i32 i32) (result i32)
+                (i32.lt_s (memory.grow (local.get 1)) (i32.const 0))))
+        "#);
+        let mut inspector = load(&grow, budget(TimeoutPolicy::FailOpen));
+        
+        // 1 + 3페이지 = 한도, 한 페이지 더는 거부
+        assert!(!inspector.inspect_packet(&[0u8; 3]).unwrap());
+        assert!(inspector.inspect_packet(&[0u8; 1]).unwrap());
+    }
+    
+    #[test]
+    fn test_inspect_frames_batch() {
+        // 프레임 첫 바이트가 0이 아니면 차단 비트 설정
+        let batch = write_module("batch.wat", r#"
+            (module
+              (memory (export "memory") 1)
+              (global $heap (mut i32) (i32.const 1024))
+              (func (export "allocate") (param $size i32) (result i32)
+                (local $ptr i32)
+                (local.set $ptr (global.get $heap))
+                (global.set $heap (i32.add (global.get $heap) (local.get $size)))
+                (local.get $ptr))
+              (func (export "inspect_packet") (param i32 i32) (result i32)
+                (unreachable))
+              (func (export "inspect_batch") (param $descs i32) (param $count i32) (result i64)
+                (local $i i32)
+                (local $bits i64)
+                (block $done
+                  (loop $next
+                    (br_if $done (i32.ge_u (local.get $i) (local.get $count)))
+                    (if (i32.load8_u (i32.load (i32.add (local.get $descs) (i32.shl (local.get $i) (i32.const 3)))))
+                      (then
+                        (local.set $bits (i64.or (local.get $bits)
+                          (i64.shl (i64.const 1) (i64.extend_i32_u (local.get $i)))))))
+                    (local.set $i (i32.add (local.get $i) (i32.const 1)))
+                    (br $next)))
+                (local.get $bits)))
+        "#);
+        let mut inspector = load(&batch, budget(TimeoutPolicy::FailClosed));
+        
+        // 64개 청크 하나와 6개짜리 마지막 청크
+        const FRAME: usize = 256;
+        let count = INSPECT_BATCH_MAX + 6;
+        let umem = inspector.reserve_umem(count * FRAME).unwrap();
+        let blocked = |i: usize| i % 3 == 0 || i == count - 1;
+        for i in (0..count).filter(|&i| blocked(i)) {
+            unsafe { *umem.add(i * FRAME) = 1 };
+        }
+        
+        let mut descs: Vec<XdpDesc> = (0..count)
+            .map(|i| XdpDesc { addr: (i * FRAME) as u64, len: 64, options: 0 })
+            .collect();
+        // UMEM 밖 디스크립터는 차단
+        descs.push(XdpDesc { addr: (count * FRAME) as u64, len: 64, options: 0 });
+        
+        let mut verdicts = Vec::new();
+        inspector.inspect_frames(&descs, &mut verdicts).unwrap();
+        
+        assert_eq!(verdicts.len(), count + 1);
+        for i in 0..count {
+            assert_eq!(verdicts[i], blocked(i), "frame {}", i);
+        }
+        assert!(verdicts[count]);
+        assert_eq!(inspector.stats().0, (count + 1) as u64);
+        assert_eq!(inspector.stats_handle().timeouts(), 0);
+    }
+    
+    #[test]
+    fn test_module_cache() {
+        use std::os::unix::fs::MetadataExt;
+        
+        let module = |verdict: i32| format!(r#"
+            (module
+              (memory (export "memory") 1)
+              (func (export "inspect_packet") (param i32 i32) (result i32)
+                (i32.const {})))
+        "#, verdict);
+        let path = write_module("cached.wat", &module(0));
+        let cache_dir = path.with_file_name("cache");
+        let _ = fs::remove_dir_all(&cache_dir);
+        let cache = ModuleCache::new(&cache_dir).unwrap();
+        let engine = Engine::new(&epoch_config()).unwrap();
+        
+        let artifacts = || -> Vec<(PathBuf, u64)> {
+            let mut entries: Vec<_> = fs::read_dir(&cache_dir).unwrap()
+                .map(|entry| entry.unwrap().path())
+                .filter(|path| path.extension().map_or(false, |ext| ext == CACHE_EXTENSION))
+                .map(|path| {
+                    let ino = fs::metadata(&path).unwrap().ino();
+                    (path, ino)
+                })
+                .collect();
+            entries.sort();
+            entries
+        };
+        
+        // 첫 적재가 산출물을 저장하고, 두 번째 적재는 다시 쓰지 않고 같은 파일을 읽음
+        compile_module(&engine, &path, Some(&cache)).unwrap();
+        let first = artifacts();
+        assert_eq!(first.len(), 1);
+        compile_module(&engine, &path, Some(&cache)).unwrap();
+        assert_eq!(artifacts(), first);
+        
+        // 모듈이 바뀌면 새 키로 컴파일하고 새 모듈이 실행됨
+        fs::write(&path, module(1)).unwrap();
+        let compiled = compile_module(&engine, &path, Some(&cache)).unwrap();
+        let second = artifacts();
+        assert_eq!(second.len(), 2);
+        assert!(second.contains(&first[0]));
+        
+        let mut inspector = WasmInspector::with_engine("test", &path, Arc::new(engine), budget(TimeoutPolicy::FailOpen));
+        inspector.instantiate(&compiled).unwrap();
+        assert!(inspector.inspect_packet(&[0u8; 64]).unwrap());
+    }
+}
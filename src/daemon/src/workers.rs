@@ -0,0 +1,181 @@
+//! 검사 워커 풀 모듈
+//! 공유 컴파일 모듈에서 큐마다 독립된 WASM 인스턴스를 만들어 전용 코어에서 실행
+
+use anyhow::{anyhow, Context, Result};
+use libbpf_rs::{Map, MapFlags};
+use log::{error, info, warn};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+
+use crate::config::XskConfig;
+use crate::wasm::{CompiledModule, WasmManager};
+use crate::xsk::{self, XskParams, XskSocket};
+
+/// 워커 배치 (수신 큐 -> 고정할 CPU)
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct WorkerBinding {
+    pub queue_id: u32,
+    pub cpu: usize,
+}
+
+/// 구성에서 워커 배치 계산
+///
+/// queues가 비어 있으면 queue_id 하나만 사용한다. cpus가 없으면 큐 번호와 같은 CPU에
+/// 고정하는데, 일반적인 RSS IRQ 친화도(큐 n -> CPU n)와 CPUMAP 항목 번호가 이와 같다.
+pub fn bindings(config: &XskConfig, cpu_count: usize) -> Vec<WorkerBinding> {
+    let queues = if config.queues.is_empty() {
+        vec![config.queue_id]
+    } else {
+        config.queues.clone()
+    };
+
+    queues
+        .iter()
+        .enumerate()
+        .map(|(i, &queue_id)| WorkerBinding {
+            queue_id,
+            cpu: config.cpus.get(i).copied().unwrap_or(queue_id as usize) % cpu_count.max(1),
+        })
+        .collect()
+}
+
+/// 실행 중인 검사 워커 집합
+#[derive(Debug)]
+pub struct WorkerPool {
+    stop: Arc<AtomicBool>,
+    handles: Vec<JoinHandle<()>>,
+}
+
+impl WorkerPool {
+    /// 배치마다 인스턴스와 AF_XDP 소켓을 만들어 xsk_map에 등록하고 워커 스레드 시작
+    ///
+    /// UMEM은 각 인스턴스의 선형 메모리 끝에 예약하므로 큐마다 별도 UMEM을 가진다.
+    pub fn start(
+        compiled: &CompiledModule,
+        wasm: &WasmManager,
+        xsk_map: &Map,
+        ifindex: u32,
+        config: &XskConfig,
+        bindings: &[WorkerBinding],
+    ) -> Result<Self> {
+        let mut pool = Self {
+            stop: Arc::new(AtomicBool::new(false)),
+            handles: Vec::with_capacity(bindings.len()),
+        };
+
+        for binding in bindings {
+            let result = pool.spawn(compiled, wasm, xsk_map, ifindex, config, *binding)
+                .with_context(|| format!("Failed to start worker for queue {}", binding.queue_id));
+            if let Err(e) = result {
+                pool.shutdown();
+                return Err(e);
+            }
+        }
+
+        info!("Started {} WASM inspection workers for module {}", pool.handles.len(), compiled.id());
+        Ok(pool)
+    }
+
+    fn spawn(
+        &mut self,
+        compiled: &CompiledModule,
+        wasm: &WasmManager,
+        xsk_map: &Map,
+        ifindex: u32,
+        config: &XskConfig,
+        binding: WorkerBinding,
+    ) -> Result<()> {
+        let umem_len = config.frame_count as usize * config.frame_size as usize;
+        let mut inspector = compiled.instantiate()?;
+        let umem = inspector.reserve_umem(umem_len)?;
+
+        let params = XskParams {
+            ifindex,
+            queue_id: binding.queue_id,
+            frame_count: config.frame_count,
+            frame_size: config.frame_size,
+            ring_size: config.ring_size,
+        };
+        let socket = unsafe { XskSocket::create(params, umem, umem_len)? };
+
+        // 수신 큐 -> 소켓 등록 (redirect-xsk 규칙이 이 큐로 리디렉션)
+        xsk_map.update(&binding.queue_id.to_le_bytes(), &(socket.fd() as u32).to_le_bytes(), MapFlags::ANY)
+            .context("Failed to update xsk_map")?;
+
+        wasm.register_worker(&inspector, binding.queue_id, binding.cpu)?;
+
+        let stop = self.stop.clone();
+        let handle = std::thread::Builder::new()
+            .name(format!("xsk-q{}", binding.queue_id))
+            .spawn(move || {
+                if let Err(e) = pin_current_thread(binding.cpu) {
+                    warn!("Failed to pin worker for queue {} to cpu {}: {}", binding.queue_id, binding.cpu, e);
+                }
+                if let Err(e) = xsk::run_forwarder(socket, inspector, &stop) {
+                    error!("AF_XDP worker for queue {} failed: {}", binding.queue_id, e);
+                }
+            })?;
+
+        self.handles.push(handle);
+        Ok(())
+    }
+
+    /// 모든 워커 정지 후 종료 대기
+    pub fn shutdown(&mut self) {
+        self.stop.store(true, Ordering::Relaxed);
+        for handle in self.handles.drain(..) {
+            let _ = handle.join();
+        }
+    }
+}
+
+impl Drop for WorkerPool {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
+
+/// 현재 스레드를 CPU 하나에 고정
+fn pin_current_thread(cpu: usize) -> Result<()> {
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        libc::CPU_SET(cpu, &mut set);
+        if libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) != 0 {
+            return Err(anyhow!("sched_setaffinity failed: {}", std::io::Error::last_os_error()));
+        }
+    }
+
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn config(queue_id: u32, queues: Vec<u32>, cpus: Vec<usize>) -> XskConfig {
+        XskConfig {
+            module: "m.wasm".to_string(),
+            queue_id,
+            queues,
+            cpus,
+            frame_count: 4096,
+            frame_size: 2048,
+            ring_size: 2048,
+        }
+    }
+
+    #[test]
+    fn test_single_queue_default() {
+        let b = bindings(&config(3, vec![], vec![]), 8);
+        assert_eq!(b, vec![WorkerBinding { queue_id: 3, cpu: 3 }]);
+    }
+
+    #[test]
+    fn test_explicit_cpus_and_wrap() {
+        let b = bindings(&config(0, vec![0, 1, 9], vec![4, 5]), 8);
+        assert_eq!(b[0], WorkerBinding { queue_id: 0, cpu: 4 });
+        assert_eq!(b[1], WorkerBinding { queue_id: 1, cpu: 5 });
+        assert_eq!(b[2], WorkerBinding { queue_id: 9, cpu: 1 });
+    }
+}
@@ -0,0 +1,90 @@
+//! 맵 기록 스레드 모듈
+//! 규칙, 블록리스트 변경과 규칙 만료를 전용 스레드에서 차례로 실행
+
+use anyhow::{anyhow, Result};
+use log::{info, warn};
+use std::sync::mpsc::{self, Receiver, RecvTimeoutError, Sender};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+use tokio::sync::oneshot;
+
+use crate::bpf::XdpFilterSkel;
+use crate::maps::{self, MapManager, SharedSnapshot};
+
+/// 기록 스레드에서 실행할 작업
+type Job = Box<dyn FnOnce(&mut MapManager<'static>) + Send>;
+
+/// 맵 기록 스레드 핸들
+///
+/// 큰 규칙 집합 교체나 블록리스트 적재가 API 작업 스레드를 막지 않도록 MapManager는
+/// 기록 스레드만 소유한다. 조회는 기록 스레드가 게시하는 스냅숏으로 처리한다.
+#[derive(Debug, Clone)]
+pub struct MapWriter {
+    jobs: Sender<Job>,
+}
+
+impl MapWriter {
+    /// 기록 스레드 시작 (init으로 규칙 복원 등 초기 상태를 만든 뒤 스냅숏 핸들 반환)
+    pub fn start<F>(skel: &'static XdpFilterSkel, init: F) -> Result<(Self, Arc<SharedSnapshot>)>
+    where
+        F: FnOnce(&mut MapManager<'static>) + Send + 'static,
+    {
+        let (jobs, receiver) = mpsc::channel::<Job>();
+        let (ready, snapshot) = mpsc::sync_channel(1);
+
+        std::thread::Builder::new()
+            .name("map-writer".to_string())
+            .spawn(move || {
+                let mut manager = MapManager::new(skel);
+                init(&mut manager);
+                if ready.send(manager.reader().snapshot_handle()).is_ok() {
+                    run_jobs(manager, receiver);
+                }
+            })?;
+
+        let snapshot = snapshot.recv()
+            .map_err(|_| anyhow!("Map writer thread failed to start"))?;
+        Ok((Self { jobs }, snapshot))
+    }
+
+    /// 기록 스레드에서 f를 실행하고 결과 대기
+    pub async fn run<R, F>(&self, f: F) -> Result<R>
+    where
+        R: Send + 'static,
+        F: FnOnce(&mut MapManager<'static>) -> Result<R> + Send + 'static,
+    {
+        let (reply, result) = oneshot::channel();
+        self.jobs.send(Box::new(move |manager| {
+            let _ = reply.send(f(manager));
+        }))
+        .map_err(|_| anyhow!("Map writer thread stopped"))?;
+
+        result.await.map_err(|_| anyhow!("Map writer thread stopped"))?
+    }
+}
+
+/// 작업을 받은 순서대로 실행하고 틱마다 만료 타이머 휠 진행
+///
+/// 작업이 계속 들어와도 틱이 지나면 만료를 먼저 처리한다. 모든 핸들이 사라지면 끝난다.
+fn run_jobs(mut manager: MapManager<'static>, receiver: Receiver<Job>) {
+    let tick = Duration::from_millis(maps::EXPIRY_TICK_MS);
+    let mut next_tick = Instant::now() + tick;
+
+    loop {
+        match receiver.recv_timeout(next_tick.saturating_duration_since(Instant::now())) {
+            Ok(job) => job(&mut manager),
+            Err(RecvTimeoutError::Timeout) => {}
+            Err(RecvTimeoutError::Disconnected) => return,
+        }
+
+        let now = Instant::now();
+        if now >= next_tick {
+            match manager.expire_rules() {
+                Ok(0) => {}
+                Ok(count) => info!("Expired {} rules", count),
+                Err(e) => warn!("Failed to expire rules: {}", e),
+            }
+            next_tick = now + tick;
+        }
+    }
+}
@@ -0,0 +1,507 @@
+//! AF_XDP 모듈
+//! XSKMAP으로 리디렉션된 패킷을 WASM 선형 메모리에 놓인 UMEM으로 받아 복사 없이 검사
+
+use anyhow::{anyhow, Result};
+use log::{debug, info, warn};
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+
+use crate::config::TimeoutPolicy;
+use crate::wasm::WasmInspector;
+
+/* 커널 uapi (linux/if_xdp.h) */
+const AF_XDP: libc::c_int = 44;
+const SOL_XDP: libc::c_int = 283;
+
+const XDP_MMAP_OFFSETS: libc::c_int = 1;
+const XDP_RX_RING: libc::c_int = 2;
+const XDP_TX_RING: libc::c_int = 3;
+const XDP_UMEM_REG: libc::c_int = 4;
+const XDP_UMEM_FILL_RING: libc::c_int = 5;
+const XDP_UMEM_COMPLETION_RING: libc::c_int = 6;
+
+const XDP_PGOFF_RX_RING: libc::off_t = 0;
+const XDP_PGOFF_TX_RING: libc::off_t = 0x8000_0000;
+const XDP_UMEM_PGOFF_FILL_RING: libc::off_t = 0x1_0000_0000;
+const XDP_UMEM_PGOFF_COMPLETION_RING: libc::off_t = 0x1_8000_0000;
+
+const XDP_COPY: u16 = 1 << 1;
+const XDP_ZEROCOPY: u16 = 1 << 2;
+const XDP_USE_NEED_WAKEUP: u16 = 1 << 3;
+
+const XDP_RING_NEED_WAKEUP: u32 = 1 << 0;
+
+/// 한 번에 처리하는 디스크립터 수
+const XSK_BATCH_SIZE: usize = 64;
+
+/// 수신 대기 poll 타임아웃 (종료 플래그 확인 주기)
+const XSK_POLL_TIMEOUT_MS: libc::c_int = 100;
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+struct XdpUmemReg {
+    addr: u64,
+    len: u64,
+    chunk_size: u32,
+    headroom: u32,
+    flags: u32,
+    tx_metadata_len: u32,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+struct XdpRingOffset {
+    producer: u64,
+    consumer: u64,
+    desc: u64,
+    flags: u64,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+struct XdpMmapOffsets {
+    rx: XdpRingOffset,
+    tx: XdpRingOffset,
+    fr: XdpRingOffset,
+    cr: XdpRingOffset,
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+struct SockaddrXdp {
+    sxdp_family: u16,
+    sxdp_flags: u16,
+    sxdp_ifindex: u32,
+    sxdp_queue_id: u32,
+    sxdp_shared_umem_fd: u32,
+}
+
+/// RX/TX 링 디스크립터 (addr = UMEM 내 오프셋)
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct XdpDesc {
+    pub addr: u64,
+    pub len: u32,
+    pub options: u32,
+}
+
+/// AF_XDP 소켓 구성
+#[derive(Debug, Clone, Copy)]
+pub struct XskParams {
+    /// 인터페이스 인덱스
+    pub ifindex: u32,
+    /// 수신 큐 번호
+    pub queue_id: u32,
+    /// UMEM 프레임 수
+    pub frame_count: u32,
+    /// UMEM 프레임 크기 (2048 또는 4096)
+    pub frame_size: u32,
+    /// 링 크기 (2의 거듭제곱)
+    pub ring_size: u32,
+}
+
+/// mmap된 AF_XDP 링 (단일 생산자/단일 소비자)
+struct Ring {
+    map: *mut libc::c_void,
+    map_len: usize,
+    producer: *const AtomicU32,
+    consumer: *const AtomicU32,
+    flags: *const AtomicU32,
+    desc: *mut u8,
+    mask: u32,
+    size: u32,
+    /// 로컬 생산자/소비자 위치 (공유 포인터 접근 최소화)
+    cached_prod: u32,
+    cached_cons: u32,
+}
+
+impl Ring {
+    /// 소켓의 링 영역 mmap
+    fn map(fd: libc::c_int, off: &XdpRingOffset, size: u32, elem_size: usize, pgoff: libc::off_t) -> Result<Self> {
+        let map_len = off.desc as usize + size as usize * elem_size;
+        let map = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                map_len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED | libc::MAP_POPULATE,
+                fd,
+                pgoff,
+            )
+        };
+        if map == libc::MAP_FAILED {
+            return Err(anyhow!("Failed to mmap XDP ring: {}", std::io::Error::last_os_error()));
+        }
+
+        let base = map as *mut u8;
+        let ring = unsafe {
+            Self {
+                map,
+                map_len,
+                producer: base.add(off.producer as usize) as *const AtomicU32,
+                consumer: base.add(off.consumer as usize) as *const AtomicU32,
+                flags: base.add(off.flags as usize) as *const AtomicU32,
+                desc: base.add(off.desc as usize),
+                mask: size - 1,
+                size,
+                cached_prod: (*(base.add(off.producer as usize) as *const AtomicU32)).load(Ordering::Relaxed),
+                cached_cons: (*(base.add(off.consumer as usize) as *const AtomicU32)).load(Ordering::Relaxed),
+            }
+        };
+
+        Ok(ring)
+    }
+
+    fn needs_wakeup(&self) -> bool {
+        unsafe { (*self.flags).load(Ordering::Relaxed) & XDP_RING_NEED_WAKEUP != 0 }
+    }
+
+    /// 생산자 링: 기록 가능한 항목 수 (최대 n)
+    fn prod_reserve(&mut self, n: u32) -> u32 {
+        let mut free = self.size - self.cached_prod.wrapping_sub(self.cached_cons);
+        if free < n {
+            // 커널 소비 위치 갱신
+            self.cached_cons = unsafe { (*self.consumer).load(Ordering::Acquire) };
+            free = self.size - self.cached_prod.wrapping_sub(self.cached_cons);
+        }
+        free.min(n)
+    }
+
+    /// 생산자 링: 기록한 n개 항목 공개
+    fn prod_submit(&mut self, n: u32) {
+        self.cached_prod = self.cached_prod.wrapping_add(n);
+        unsafe { (*self.producer).store(self.cached_prod, Ordering::Release) };
+    }
+
+    /// 소비자 링: 읽을 수 있는 항목 수 (최대 n)
+    fn cons_peek(&mut self, n: u32) -> u32 {
+        let mut avail = self.cached_prod.wrapping_sub(self.cached_cons);
+        if avail == 0 {
+            self.cached_prod = unsafe { (*self.producer).load(Ordering::Acquire) };
+            avail = self.cached_prod.wrapping_sub(self.cached_cons);
+        }
+        avail.min(n)
+    }
+
+    /// 소비자 링: 읽은 n개 항목 반환
+    fn cons_release(&mut self, n: u32) {
+        self.cached_cons = self.cached_cons.wrapping_add(n);
+        unsafe { (*self.consumer).store(self.cached_cons, Ordering::Release) };
+    }
+
+    /// 링 위치의 주소 항목 (채움/완료 링)
+    fn addr_at(&self, idx: u32) -> *mut u64 {
+        unsafe { (self.desc as *mut u64).add((idx & self.mask) as usize) }
+    }
+
+    /// 링 위치의 디스크립터 (RX/TX 링)
+    fn desc_at(&self, idx: u32) -> *mut XdpDesc {
+        unsafe { (self.desc as *mut XdpDesc).add((idx & self.mask) as usize) }
+    }
+}
+
+impl Drop for Ring {
+    fn drop(&mut self) {
+        unsafe {
+            libc::munmap(self.map, self.map_len);
+        }
+    }
+}
+
+/// WASM 선형 메모리의 일부를 UMEM으로 등록한 AF_XDP 소켓
+pub struct XskSocket {
+    fd: libc::c_int,
+    params: XskParams,
+    fill: Ring,
+    comp: Ring,
+    rx: Ring,
+    tx: Ring,
+    /// 커널에 넘기지 않은 여유 프레임 (UMEM 오프셋)
+    free_frames: Vec<u64>,
+    /// 제로 카피 모드로 바인드되었는지 여부
+    zero_copy: bool,
+}
+
+// 링 포인터는 이 소켓을 소유한 스레드만 사용
+unsafe impl Send for XskSocket {}
+
+impl std::fmt::Debug for XskSocket {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("XskSocket")
+            .field("fd", &self.fd)
+            .field("params", &self.params)
+            .field("zero_copy", &self.zero_copy)
+            .finish()
+    }
+}
+
+impl XskSocket {
+    /// 소켓 생성 및 UMEM 등록 후 인터페이스 큐에 바인드
+    ///
+    /// umem은 페이지 정렬되고 frame_count * frame_size 바이트 이상이며, 소켓이 닫힐
+    /// 때까지 이동하지 않아야 한다.
+    pub unsafe fn create(params: XskParams, umem: *mut u8, umem_len: usize) -> Result<Self> {
+        let needed = params.frame_count as usize * params.frame_size as usize;
+        if umem_len < needed || (umem as usize) % 4096 != 0 {
+            return Err(anyhow!("UMEM area must be page aligned and at least {} bytes", needed));
+        }
+        if !params.ring_size.is_power_of_two() {
+            return Err(anyhow!("XDP ring size must be a power of two: {}", params.ring_size));
+        }
+
+        let fd = libc::socket(AF_XDP, libc::SOCK_RAW | libc::SOCK_CLOEXEC, 0);
+        if fd < 0 {
+            return Err(anyhow!("Failed to create AF_XDP socket: {}", std::io::Error::last_os_error()));
+        }
+
+        match Self::setup(fd, params, umem, needed) {
+            Ok(socket) => Ok(socket),
+            Err(e) => {
+                libc::close(fd);
+                Err(e)
+            }
+        }
+    }
+
+    unsafe fn setup(fd: libc::c_int, params: XskParams, umem: *mut u8, umem_len: usize) -> Result<Self> {
+        // UMEM 등록 (커널이 페이지를 고정)
+        let reg = XdpUmemReg {
+            addr: umem as u64,
+            len: umem_len as u64,
+            chunk_size: params.frame_size,
+            headroom: 0,
+            flags: 0,
+            tx_metadata_len: 0,
+        };
+        setsockopt(fd, XDP_UMEM_REG, &reg)?;
+
+        for opt in [XDP_UMEM_FILL_RING, XDP_UMEM_COMPLETION_RING, XDP_RX_RING, XDP_TX_RING] {
+            setsockopt(fd, opt, &params.ring_size)?;
+        }
+
+        let mut off = XdpMmapOffsets::default();
+        let mut optlen = std::mem::size_of::<XdpMmapOffsets>() as libc::socklen_t;
+        if libc::getsockopt(fd, SOL_XDP, XDP_MMAP_OFFSETS,
+                            &mut off as *mut _ as *mut libc::c_void, &mut optlen) != 0 {
+            return Err(anyhow!("Failed to get XDP mmap offsets: {}", std::io::Error::last_os_error()));
+        }
+
+        let fill = Ring::map(fd, &off.fr, params.ring_size, 8, XDP_UMEM_PGOFF_FILL_RING)?;
+        let comp = Ring::map(fd, &off.cr, params.ring_size, 8, XDP_UMEM_PGOFF_COMPLETION_RING)?;
+        let rx = Ring::map(fd, &off.rx, params.ring_size, std::mem::size_of::<XdpDesc>(), XDP_PGOFF_RX_RING)?;
+        let tx = Ring::map(fd, &off.tx, params.ring_size, std::mem::size_of::<XdpDesc>(), XDP_PGOFF_TX_RING)?;
+
+        // 제로 카피를 먼저 시도하고, 드라이버가 지원하지 않으면 복사 모드
+        let mut zero_copy = true;
+        if bind(fd, params, XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP).is_err() {
+            bind(fd, params, XDP_COPY | XDP_USE_NEED_WAKEUP)?;
+            zero_copy = false;
+        }
+
+        let free_frames = (0..params.frame_count as u64)
+            .map(|i| i * params.frame_size as u64)
+            .collect();
+
+        let mut socket = Self {
+            fd,
+            params,
+            fill,
+            comp,
+            rx,
+            tx,
+            free_frames,
+            zero_copy,
+        };
+        socket.refill();
+
+        info!("AF_XDP socket bound to ifindex {} queue {} ({} mode, {} frames)",
+            params.ifindex, params.queue_id,
+            if zero_copy { "zero-copy" } else { "copy" }, params.frame_count);
+
+        Ok(socket)
+    }
+
+    /// XSKMAP에 등록할 소켓 fd
+    pub fn fd(&self) -> libc::c_int {
+        self.fd
+    }
+
+    pub fn is_zero_copy(&self) -> bool {
+        self.zero_copy
+    }
+
+    /// 여유 프레임을 채움 링에 공급
+    fn refill(&mut self) {
+        let n = self.fill.prod_reserve(self.free_frames.len() as u32);
+        if n == 0 {
+            return;
+        }
+
+        let start = self.fill.cached_prod;
+        for i in 0..n {
+            let frame = self.free_frames.pop().unwrap_or(0);
+            unsafe { *self.fill.addr_at(start.wrapping_add(i)) = frame };
+        }
+        self.fill.prod_submit(n);
+    }
+
+    /// 전송 완료된 프레임 회수
+    fn reclaim(&mut self) {
+        let n = self.comp.cons_peek(self.params.ring_size);
+        let start = self.comp.cached_cons;
+        for i in 0..n {
+            let addr = unsafe { *self.comp.addr_at(start.wrapping_add(i)) };
+            self.free_frames.push(addr);
+        }
+        if n > 0 {
+            self.comp.cons_release(n);
+        }
+    }
+
+    /// 수신된 디스크립터를 최대 XSK_BATCH_SIZE개 읽음
+    fn receive(&mut self, descs: &mut Vec<XdpDesc>) {
+        descs.clear();
+        let n = self.rx.cons_peek(XSK_BATCH_SIZE as u32);
+        let start = self.rx.cached_cons;
+        for i in 0..n {
+            descs.push(unsafe { *self.rx.desc_at(start.wrapping_add(i)) });
+        }
+        if n > 0 {
+            self.rx.cons_release(n);
+        }
+    }
+
+    /// 통과 프레임을 TX 링에 기록 (링이 가득 차면 프레임 회수)
+    fn transmit(&mut self, descs: &[XdpDesc]) {
+        let n = self.tx.prod_reserve(descs.len() as u32);
+        let start = self.tx.cached_prod;
+        for (i, desc) in descs.iter().take(n as usize).enumerate() {
+            unsafe { *self.tx.desc_at(start.wrapping_add(i as u32)) = *desc };
+        }
+        if n > 0 {
+            self.tx.prod_submit(n);
+        }
+
+        for desc in &descs[n as usize..] {
+            self.free_frames.push(self.frame_of(desc.addr));
+        }
+
+        // 커널 TX 처리 요청
+        if n > 0 && (!self.zero_copy || self.tx.needs_wakeup()) {
+            unsafe {
+                libc::sendto(self.fd, std::ptr::null(), 0, libc::MSG_DONTWAIT, std::ptr::null(), 0);
+            }
+        }
+    }
+
+    /// 디스크립터 주소가 속한 프레임의 시작 오프셋
+    fn frame_of(&self, addr: u64) -> u64 {
+        addr & !(self.params.frame_size as u64 - 1)
+    }
+
+    /// 수신 대기 (타임아웃 시 false)
+    fn wait(&self) -> bool {
+        let mut pfd = libc::pollfd {
+            fd: self.fd,
+            events: libc::POLLIN,
+            revents: 0,
+        };
+        unsafe { libc::poll(&mut pfd, 1, XSK_POLL_TIMEOUT_MS) > 0 }
+    }
+}
+
+impl Drop for XskSocket {
+    fn drop(&mut self) {
+        unsafe {
+            libc::close(self.fd);
+        }
+    }
+}
+
+/// AF_XDP 수신 루프
+///
+/// 수신 프레임을 WASM 모듈이 제자리에서 검사한다. 통과 판정은 같은 큐의 TX 링으로
+/// 재전송하고(bump-in-the-wire), 차단 판정은 프레임을 채움 링으로 돌려보낸다.
+/// 인스턴스는 이 루프가 소유하므로 검사 경로에 잠금이 없다.
+pub fn run_forwarder(
+    mut socket: XskSocket,
+    mut inspector: WasmInspector,
+    stop: &AtomicBool,
+) -> Result<()> {
+    let mut descs = Vec::with_capacity(XSK_BATCH_SIZE);
+    let mut verdicts = Vec::with_capacity(XSK_BATCH_SIZE);
+    let mut pass = Vec::with_capacity(XSK_BATCH_SIZE);
+
+    while !stop.load(Ordering::Relaxed) {
+        socket.reclaim();
+        socket.refill();
+
+        socket.receive(&mut descs);
+        if descs.is_empty() {
+            // poll은 need_wakeup 모드에서 드라이버 수신 처리도 깨움
+            socket.wait();
+            continue;
+        }
+
+        // 호스트 오류도 트랩과 같은 정책으로 배치 전체 판정
+        if let Err(e) = inspector.inspect_frames(&descs, &mut verdicts) {
+            let blocked = inspector.policy() == TimeoutPolicy::FailClosed;
+            warn!("AF_XDP inspection failed, {} batch: {}", if blocked { "dropping" } else { "passing" }, e);
+            verdicts.clear();
+            verdicts.resize(descs.len(), blocked);
+        }
+
+        pass.clear();
+        for (desc, blocked) in descs.iter().zip(verdicts.iter()) {
+            if *blocked {
+                let frame = socket.frame_of(desc.addr);
+                socket.free_frames.push(frame);
+            } else {
+                pass.push(*desc);
+            }
+        }
+        socket.transmit(&pass);
+    }
+
+    debug!("AF_XDP forwarder for module {} on queue {} stopped", inspector.id(), socket.params.queue_id);
+
+    // UMEM은 인스턴스 메모리에 있으므로 소켓을 먼저 닫음
+    drop(socket);
+    drop(inspector);
+    Ok(())
+}
+
+unsafe fn setsockopt<T>(fd: libc::c_int, opt: libc::c_int, value: &T) -> Result<()> {
+    let ret = libc::setsockopt(
+        fd,
+        SOL_XDP,
+        opt,
+        value as *const T as *const libc::c_void,
+        std::mem::size_of::<T>() as libc::socklen_t,
+    );
+    if ret != 0 {
+        return Err(anyhow!("setsockopt(SOL_XDP, {}) failed: {}", opt, std::io::Error::last_os_error()));
+    }
+
+    Ok(())
+}
+
+unsafe fn bind(fd: libc::c_int, params: XskParams, flags: u16) -> Result<()> {
+    let addr = SockaddrXdp {
+        sxdp_family: AF_XDP as u16,
+        sxdp_flags: flags,
+        sxdp_ifindex: params.ifindex,
+        sxdp_queue_id: params.queue_id,
+        sxdp_shared_umem_fd: 0,
+    };
+
+    let ret = libc::bind(
+        fd,
+        &addr as *const SockaddrXdp as *const libc::sockaddr,
+        std::mem::size_of::<SockaddrXdp>() as libc::socklen_t,
+    );
+    if ret != 0 {
+        return Err(anyhow!("Failed to bind AF_XDP socket: {}", std::io::Error::last_os_error()));
+    }
+
+    Ok(())
+}
@@ -382,6 +382,177 @@ def create_solution_comparison():
     
     print("Generated solution comparison radar chart")
 
+def analyze_scaling():
+    """멀티 큐/멀티 코어 확장성 테스트 결과 분석"""
+    print("\nAnalyzing multi-queue scaling results...")
+    
+    results_file = os.path.join(args.results_dir, 'scaling_results.csv')
+    if not os.path.exists(results_file):
+        print(f"No scaling test results found at {results_file}")
+        return
+    
+    df = pd.read_csv(results_file)
+    print(f"Loaded {len(df)} scaling runs")
+    
+    # 기준 구성: 가장 큰 흐름 수(RSS 분산이 가장 고름)와 규칙 수, 적중률 0
+    max_flows = df['flows'].max()
+    max_rules = df['rule_count'].max()
+    base_hit = df['hit_ratio'].min()
+    
+    plt.figure(figsize=(15, 10))
+    
+    # 처리량 vs 큐 수 (규칙 수별)
+    plt.subplot(2, 2, 1)
+    subset = df[(df['flows'] == max_flows) & (df['hit_ratio'] == base_hit)]
+    for rule_count, group in subset.groupby('rule_count'):
+        group = group.sort_values('queues')
+        plt.plot(group['queues'], group['pps'] / 1e6, 'o-', linewidth=2, markersize=8, label=f'{rule_count} rules')
+    plt.xlabel('RX Queues / Cores')
+    plt.ylabel('Million Packets Per Second (Mpps)')
+    plt.title(f'Throughput vs Queue Count ({max_flows} flows)')
+    plt.grid(True)
+    plt.legend()
+    
+    # 확장 효율 (큐 1개 대비 큐당 처리량)
+    plt.subplot(2, 2, 2)
+    for rule_count, group in subset.groupby('rule_count'):
+        group = group.sort_values('queues')
+        base = group['pps'].iloc[0] / group['queues'].iloc[0]
+        if base > 0:
+            efficiency = group['pps'] / (group['queues'] * base) * 100
+            plt.plot(group['queues'], efficiency, 'o-', linewidth=2, markersize=8, label=f'{rule_count} rules')
+    plt.xlabel('RX Queues / Cores')
+    plt.ylabel('Scaling Efficiency (%)')
+    plt.title('Per-Core Efficiency vs Queue Count')
+    plt.grid(True)
+    plt.legend()
+    
+    # 처리량 vs 흐름 수 (큐 수별, 흐름이 적으면 RSS가 일부 큐에만 분산)
+    plt.subplot(2, 2, 3)
+    subset = df[(df['rule_count'] == max_rules) & (df['hit_ratio'] == base_hit)]
+    for queues, group in subset.groupby('queues'):
+        group = group.sort_values('flows')
+        plt.plot(group['flows'], group['pps'] / 1e6, 'o-', linewidth=2, markersize=8, label=f'{queues} queues')
+    plt.xlabel('Number of Flows')
+    plt.ylabel('Million Packets Per Second (Mpps)')
+    plt.title(f'Throughput vs Flow Count ({max_rules} rules)')
+    plt.grid(True)
+    plt.xscale('log')
+    plt.legend()
+    
+    # 처리량 vs 적중률 (큐 수별)
+    plt.subplot(2, 2, 4)
+    subset = df[(df['rule_count'] == max_rules) & (df['flows'] == max_flows)]
+    for queues, group in subset.groupby('queues'):
+        group = group.sort_values('hit_ratio')
+        plt.plot(group['hit_ratio'], group['pps'] / 1e6, 'o-', linewidth=2, markersize=8, label=f'{queues} queues')
+    plt.xlabel('Rule Hit Ratio (%)')
+    plt.ylabel('Million Packets Per Second (Mpps)')
+    plt.title('Throughput vs Hit Ratio')
+    plt.grid(True)
+    plt.legend()
+    
+    plt.tight_layout()
+    plt.savefig(os.path.join(args.output_dir, 'scaling.png'), dpi=300)
+    plt.close()
+    
+    # CPU별 처리량 분포 (특정 CPU에 몰리면 RSS 불균형 또는 공유 자원 경합)
+    per_cpu_file = os.path.join(args.results_dir, 'scaling_per_cpu.csv')
+    if os.path.exists(per_cpu_file):
+        cpu_df = pd.read_csv(per_cpu_file)
+        cpu_df = cpu_df[(cpu_df['rule_count'] == max_rules) & (cpu_df['flows'] == max_flows)
+                        & (cpu_df['hit_ratio'] == base_hit)]
+        
+        if not cpu_df.empty:
+            plt.figure(figsize=(15, 6))
+            
+            plt.subplot(1, 2, 1)
+            pivot = cpu_df.pivot_table(index='queues', columns='cpu', values='pps', aggfunc='sum').fillna(0)
+            sns.heatmap(pivot / 1e6, annot=True, fmt='.2f', cmap='viridis', cbar_kws={'label': 'Mpps'})
+            plt.xlabel('CPU')
+            plt.ylabel('RX Queues')
+            plt.title('Per-CPU Throughput')
+            
+            plt.subplot(1, 2, 2)
+            pivot = cpu_df.pivot_table(index='queues', columns='cpu', values='softirq_util', aggfunc='mean').fillna(0)
+            sns.heatmap(pivot, annot=True, fmt='.0f', cmap='rocket_r', vmin=0, vmax=100, cbar_kws={'label': '%soft'})
+            plt.xlabel('CPU')
+            plt.ylabel('RX Queues')
+            plt.title('Per-CPU Softirq Utilization')
+            
+            plt.tight_layout()
+            plt.savefig(os.path.join(args.output_dir, 'scaling_per_cpu.png'), dpi=300)
+            plt.close()
+    
+    # 요약 통계 출력
+    print("\nScaling Summary (Mpps by queue count and rule count):")
+    summary = df[(df['flows'] == max_flows) & (df['hit_ratio'] == base_hit)]
+    print(summary.pivot_table(index='queues', columns='rule_count', values='pps', aggfunc='mean') / 1e6)
+    
+    # 가장 바쁜 CPU가 전체의 1/큐 수보다 크게 많으면 불균형
+    skewed = df[df['max_cpu_share'] > 1.5 / df['queues']]
+    if not skewed.empty:
+        print("\nRuns with uneven per-CPU load (max CPU share > 1.5x fair share):")
+        print(skewed[['queues', 'rule_count', 'flows', 'hit_ratio', 'active_cpus', 'max_cpu_share']])
+
+def analyze_prog_test_run():
+    """BPF_PROG_TEST_RUN 마이크로 벤치마크 결과 분석"""
+    print("\nAnalyzing BPF_PROG_TEST_RUN microbenchmark results...")
+    
+    results_file = os.path.join(args.results_dir, 'prog_test_run.csv')
+    if not os.path.exists(results_file):
+        print(f"No microbenchmark results found at {results_file}")
+        return
+    
+    df = pd.read_csv(results_file)
+    print(f"Loaded {len(df)} measurements for {df['case'].nunique()} packet cases")
+    if 'max_rules' in df.columns:
+        print(f"Classifier rule limit: {df['max_rules'].iloc[0]} (larger sizes use CIDR-aggregated fill rules)")
+    
+    # 기대 판정과 다른 측정은 규칙 설치 오류 가능성이 있으므로 표시
+    mismatched = df[df['verdict'] != df['expected']]
+    if not mismatched.empty:
+        print("Warning: measurements with unexpected verdicts:")
+        print(mismatched[['rule_count', 'case', 'mode', 'expected', 'verdict']])
+    
+    modes = [m for m in ['warm', 'cold'] if m in df['mode'].values]
+    plt.figure(figsize=(15, 6 * len(modes)))
+    
+    for i, mode in enumerate(modes):
+        mode_df = df[df['mode'] == mode]
+        
+        # 패킷 종류별 ns/packet vs 규칙 수
+        plt.subplot(len(modes), 2, 2 * i + 1)
+        for case, case_df in mode_df.groupby('case'):
+            case_df = case_df.sort_values('rule_count')
+            plt.plot(case_df['rule_count'], case_df['ns_per_packet'], 'o-', linewidth=1.5, markersize=5, label=case)
+        plt.xlabel('Number of Rules')
+        plt.ylabel('Time per Packet (ns)')
+        plt.title(f'Per-Packet Cost vs Rule Count ({mode})')
+        plt.grid(True)
+        plt.xscale('log')
+        plt.legend(fontsize=8)
+        
+        # 판정별 평균 ns/packet
+        plt.subplot(len(modes), 2, 2 * i + 2)
+        pivot = mode_df.pivot_table(index='rule_count', columns='expected', values='ns_per_packet', aggfunc='mean')
+        for verdict in pivot.columns:
+            plt.plot(pivot.index, pivot[verdict], 'o-', linewidth=2, markersize=8, label=verdict)
+        plt.xlabel('Number of Rules')
+        plt.ylabel('Average Time per Packet (ns)')
+        plt.title(f'Per-Packet Cost by Verdict ({mode})')
+        plt.grid(True)
+        plt.xscale('log')
+        plt.legend()
+    
+    plt.tight_layout()
+    plt.savefig(os.path.join(args.output_dir, 'prog_test_run.png'), dpi=300)
+    plt.close()
+    
+    # 요약 통계 출력
+    print("\nMicrobenchmark Summary (mean ns/packet):")
+    print(df.pivot_table(index='rule_count', columns='mode', values='ns_per_packet', aggfunc='mean'))
+
 def generate_summary_report():
     """결과 요약 보고서 생성"""
     print("\nGenerating summary report...")
@@ -463,6 +634,54 @@ def generate_summary_report():
         else:
             f.write("No rule scaling test results found.\n\n")
         
+        f.write("## Multi-Queue Scaling Test\n\n")
+        
+        # 확장성 테스트 결과 로드
+        scaling_file = os.path.join(args.results_dir, 'scaling_results.csv')
+        if os.path.exists(scaling_file):
+            df = pd.read_csv(scaling_file)
+            df = df[(df['flows'] == df['flows'].max()) & (df['hit_ratio'] == df['hit_ratio'].min())]
+            summary = df.pivot_table(index='queues', columns='rule_count', values='pps', aggfunc='mean')
+            
+            f.write("Throughput (Mpps) by RX queue count and rule count:\n\n")
+            f.write("| Queues | " + " | ".join(f"{r} rules" for r in summary.columns) + " |\n")
+            f.write("|--------|" + "|".join("-" * 12 for _ in summary.columns) + "|\n")
+            for queues, row in summary.iterrows():
+                f.write(f"| {queues:6} | " + " | ".join(f"{row[r]/1e6:10.2f}" for r in summary.columns) + " |\n")
+            
+            f.write("\n![Scaling](scaling.png)\n\n")
+            f.write("![Per-CPU Load](scaling_per_cpu.png)\n\n")
+        else:
+            f.write("No scaling test results found.\n\n")
+        
+        f.write("## XDP Microbenchmark (BPF_PROG_TEST_RUN)\n\n")
+        
+        # 마이크로 벤치마크 결과 로드
+        prog_test_file = os.path.join(args.results_dir, 'prog_test_run.csv')
+        if os.path.exists(prog_test_file):
+            df = pd.read_csv(prog_test_file)
+            
+            f.write("Per-packet cost of `xdp_filter_func` measured in the kernel, without a NIC. ")
+            f.write("`warm` runs hit the flow cache; `cold` runs go through the full classifier.")
+            if 'max_rules' in df.columns:
+                f.write(f" The classifier holds at most {df['max_rules'].iloc[0]} rules; larger rule counts ")
+                f.write("cover the same number of source addresses with CIDR-aggregated fill rules.")
+            f.write("\n\n")
+            
+            summary = df.pivot_table(index='rule_count', columns='mode', values='ns_per_packet', aggfunc='mean')
+            f.write("| Rule Count | " + " | ".join(f"{m} (ns/packet)" for m in summary.columns) + " |\n")
+            f.write("|------------|" + "|".join("-" * 18 for _ in summary.columns) + "|\n")
+            for rule_count, row in summary.iterrows():
+                f.write(f"| {rule_count:10} | " + " | ".join(f"{row[m]:16.1f}" for m in summary.columns) + " |\n")
+            
+            mismatched = df[df['verdict'] != df['expected']]
+            if not mismatched.empty:
+                f.write(f"\n**Warning:** {len(mismatched)} measurements returned an unexpected verdict.\n")
+            
+            f.write("\n![XDP Microbenchmark](prog_test_run.png)\n\n")
+        else:
+            f.write("No microbenchmark results found.\n\n")
+        
         f.write("## WASM Module Overhead Test\n\n")
         
         # WASM 오버헤드 테스트 결과 로드
@@ -532,6 +751,8 @@ if __name__ == "__main__":
     analyze_basic_throughput()
     analyze_rule_scaling()
     analyze_wasm_overhead()
+    analyze_scaling()
+    analyze_prog_test_run()
     create_solution_comparison()
     generate_summary_report()
     
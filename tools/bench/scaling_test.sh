@@ -0,0 +1,363 @@
+#!/bin/bash
+# Swift-Guard 멀티 큐/멀티 코어 확장성 테스트 스크립트
+# 수신 큐 수(IRQ 친화도), 규칙 수, 트래픽 구성(흐름 수, 적중률)을 바꿔 가며
+# 데몬의 Prometheus 엔드포인트에서 CPU별/큐별 카운터를 수집한다.
+
+set -e
+
+# 기본 설정
+INTERFACE=""
+TX_DEV=""
+DURATION=30
+PACKET_SIZE=64
+QUEUE_COUNTS=(1 2 4 8)
+RULE_COUNTS=(10 1000 4000)
+FLOW_COUNTS=(1 1024 65536)
+HIT_RATIOS=(0 50 100)
+METRICS_URL="http://127.0.0.1:9464/metrics"
+OUTPUT_DIR="./results"
+PKTGEN_CONFIG="./tools/bench/pktgen_scaling.lua"
+XDP_FILTER="./target/release/xdp-filter"
+
+# 사용법 표시
+show_usage() {
+    echo "Usage: $0 --interface <INTERFACE> [OPTIONS]"
+    echo ""
+    echo "Requires a running swift-guard-daemon attached to INTERFACE with telemetry.export_enabled."
+    echo ""
+    echo "Options:"
+    echo "  --interface INTERFACE  Interface the daemon is attached to"
+    echo "  --tx-dev DEVICE        Device used by the traffic generator (default: INTERFACE)"
+    echo "  --duration SECONDS     Duration of each run in seconds (default: 30)"
+    echo "  --packet-size BYTES    Packet size in bytes (default: 64)"
+    echo "  --queues COUNTS        Comma-separated RX queue counts (default: 1,2,4,8)"
+    echo "  --rules COUNTS         Comma-separated rule-set sizes (default: 10,1000,4000)"
+    echo "  --flows COUNTS         Comma-separated flow counts (default: 1,1024,65536)"
+    echo "  --hit-ratios PERCENTS  Comma-separated percentages of packets matching a drop rule (default: 0,50,100)"
+    echo "  --metrics-url URL      Daemon Prometheus endpoint (default: http://127.0.0.1:9464/metrics)"
+    echo "  --output-dir DIR       Output directory for results (default: ./results)"
+    echo "  --help                 Show this help message"
+    exit 1
+}
+
+# 인수 파싱
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        --interface)
+            INTERFACE="$2"
+            shift 2
+            ;;
+        --tx-dev)
+            TX_DEV="$2"
+            shift 2
+            ;;
+        --duration)
+            DURATION="$2"
+            shift 2
+            ;;
+        --packet-size)
+            PACKET_SIZE="$2"
+            shift 2
+            ;;
+        --queues)
+            IFS=',' read -r -a QUEUE_COUNTS <<< "$2"
+            shift 2
+            ;;
+        --rules)
+            IFS=',' read -r -a RULE_COUNTS <<< "$2"
+            shift 2
+            ;;
+        --flows)
+            IFS=',' read -r -a FLOW_COUNTS <<< "$2"
+            shift 2
+            ;;
+        --hit-ratios)
+            IFS=',' read -r -a HIT_RATIOS <<< "$2"
+            shift 2
+            ;;
+        --metrics-url)
+            METRICS_URL="$2"
+            shift 2
+            ;;
+        --output-dir)
+            OUTPUT_DIR="$2"
+            shift 2
+            ;;
+        --help)
+            show_usage
+            ;;
+        *)
+            echo "Unknown option: $1"
+            show_usage
+            ;;
+    esac
+done
+
+# 인터페이스 필수 인수 확인
+if [ -z "$INTERFACE" ]; then
+    echo "Error: --interface is required"
+    show_usage
+fi
+TX_DEV="${TX_DEV:-$INTERFACE}"
+
+# 인터페이스 존재 확인
+if ! ip link show dev "$INTERFACE" &>/dev/null; then
+    echo "Error: Interface $INTERFACE does not exist"
+    exit 1
+fi
+
+# 루트 권한 확인
+if [ "$EUID" -ne 0 ]; then
+    echo "Error: This script must be run as root"
+    exit 1
+fi
+
+# 메트릭 엔드포인트 확인
+if ! curl -sf "$METRICS_URL" > /dev/null; then
+    echo "Error: Cannot scrape $METRICS_URL (is the daemon running with telemetry.export_enabled?)"
+    exit 1
+fi
+
+if ! command -v moongen &> /dev/null; then
+    echo "Error: MoonGen is required to generate multi-flow traffic"
+    exit 1
+fi
+
+if pgrep -x irqbalance > /dev/null; then
+    echo "Warning: irqbalance is running and may override the IRQ affinity set by this test"
+fi
+
+NCPUS=$(nproc)
+
+# 출력 디렉토리 생성
+mkdir -p "$OUTPUT_DIR"
+
+# 결과 파일 헤더 작성
+RESULTS_CSV="$OUTPUT_DIR/scaling_results.csv"
+PER_CPU_CSV="$OUTPUT_DIR/scaling_per_cpu.csv"
+PER_QUEUE_CSV="$OUTPUT_DIR/scaling_per_queue.csv"
+RUN_COLUMNS="queues,rule_count,flows,hit_ratio,packet_size"
+echo "$RUN_COLUMNS,pps,drop_pps,pass_pps,active_cpus,max_cpu_share,softirq_util,duration_sec" > "$RESULTS_CSV"
+echo "$RUN_COLUMNS,cpu,packets,pps,softirq_util" > "$PER_CPU_CSV"
+echo "$RUN_COLUMNS,queue,packets,pps" > "$PER_QUEUE_CSV"
+
+# 수신 큐 수 설정 및 큐 i의 IRQ를 CPU i에 고정 (RSS 간접 테이블도 균등 분배)
+configure_queues() {
+    local queues=$1
+
+    if ! ethtool -L "$INTERFACE" combined "$queues" 2>/dev/null; then
+        ethtool -L "$INTERFACE" rx "$queues"
+    fi
+    ethtool -X "$INTERFACE" equal "$queues" 2>/dev/null || true
+
+    local i=0
+    for irq in $(awk -v dev="$INTERFACE" '$NF ~ dev { sub(":", "", $1); print $1 }' /proc/interrupts); do
+        if [ "$i" -ge "$queues" ]; then
+            break
+        fi
+        echo $((i % NCPUS)) > "/proc/irq/$irq/smp_affinity_list"
+        i=$((i + 1))
+    done
+
+    # 드라이버가 채널 재구성 후 링크를 다시 올릴 때까지 대기
+    sleep 3
+}
+
+# 규칙 집합 교체 (적중 규칙 1개 + 트래픽과 겹치지 않는 채움 규칙)
+install_rules() {
+    local count=$1
+    local rules_file="$OUTPUT_DIR/scaling_rules_${count}.json"
+
+    {
+        echo "["
+        echo "  {\"src_ip\": \"198.51.100.0/24\", \"action\": \"drop\", \"priority\": 100, \"label\": \"scaling-hit\"}"
+        for ((i = 1; i < count; i++)); do
+            echo "  ,{\"src_ip\": \"10.$((i >> 16 & 255)).$((i >> 8 & 255)).$((i & 255))/32\", \"protocol\": \"tcp\", \"dst_port\": \"$((1024 + i % 4096))\", \"action\": \"drop\", \"label\": \"scaling-fill-$i\"}"
+        done
+        echo "]"
+    } > "$rules_file"
+
+    "$XDP_FILTER" import-rules "$rules_file" --replace
+}
+
+# 메트릭 스크랩에서 지정 레이블별 카운터 합계 추출 ("레이블값 합계" 줄)
+sum_metric() {
+    local file=$1
+    local metric=$2
+    local label=$3
+    local filter=${4:-}
+
+    awk -v m="$metric" -v l="$label" -v f="$filter" '
+        index($0, m "{") == 1 && (f == "" || index($0, f) > 0) {
+            s = $0
+            i = index(s, l "=\"")
+            if (i == 0) next
+            s = substr(s, i + length(l) + 2)
+            sum[substr(s, 1, index(s, "\"") - 1)] += $NF
+        }
+        END { for (k in sum) print k, sum[k] }' "$file" | sort -n
+}
+
+# 두 스크랩 사이의 증가량 ("레이블값 증가량" 줄)
+metric_delta() {
+    local before=$1
+    local after=$2
+    shift 2
+
+    join -a 2 -e 0 -o 0,1.2,2.2 <(sum_metric "$before" "$@" | sort) <(sum_metric "$after" "$@" | sort) \
+        | awk '{ print $1, $3 - $2 }' | sort -n
+}
+
+# 흐름 수와 적중률을 반영하는 MoonGen 스크립트 생성
+write_pktgen_config() {
+    local flows=$1
+    local hit_ratio=$2
+
+    cat > "$PKTGEN_CONFIG" << EOF
+-- Pktgen configuration for Swift-Guard scaling test
+-- Flows: $flows, hit ratio: $hit_ratio%, packet size: $PACKET_SIZE bytes
+
+local SRC_MAC = "aa:bb:cc:dd:ee:ff"
+local DST_MAC = "11:22:33:44:55:66"
+local CLIENT_IP = parseIPAddress("192.0.2.1")    -- 규칙에 매치되지 않는 출발지
+local BLOCKED_IP = parseIPAddress("198.51.100.1") -- scaling-hit 규칙에 매치되는 출발지
+local DST_IP = "203.0.113.10"
+local DST_PORT = 5001
+local FLOWS = $flows
+local HIT_RATIO = $hit_ratio
+local PKT_SIZE = $PACKET_SIZE
+
+function master(args)
+    local queue = device.get(args.dev):txQueue(0)
+    local mem = memory.createMemPool(function(buf)
+        buf:getUdpPacket():fill{
+            ethSrc = SRC_MAC,
+            ethDst = DST_MAC,
+            ip4Dst = DST_IP,
+            udpDst = DST_PORT,
+            pktLength = PKT_SIZE
+        }
+    end)
+    local bufs = mem:bufArray()
+    local counter = 0
+    local startTime = moongen.getTime()
+
+    -- 출발지 포트로 흐름을 나누므로 RSS가 흐름 수만큼 큐에 분산
+    while moongen.getTime() < startTime + $DURATION do
+        bufs:alloc(PKT_SIZE)
+        for i, buf in ipairs(bufs) do
+            local pkt = buf:getUdpPacket()
+            local n = counter + i
+            if (n % 100) < HIT_RATIO then
+                pkt.ip4.src:set(BLOCKED_IP + (n % 254))
+            else
+                pkt.ip4.src:set(CLIENT_IP)
+            end
+            pkt.udp:setSrcPort(1024 + (n % FLOWS))
+        end
+        bufs:offloadUdpChecksums()
+        counter = counter + bufs:size()
+        queue:send(bufs)
+    end
+
+    printf("Sent %d packets in %.2f seconds", counter, moongen.getTime() - startTime)
+end
+EOF
+}
+
+# 테스트 실행 함수
+run_test() {
+    local queues=$1
+    local rules=$2
+    local flows=$3
+    local hit_ratio=$4
+    local tag="q${queues}_r${rules}_f${flows}_h${hit_ratio}"
+    local run="$queues,$rules,$flows,$hit_ratio,$PACKET_SIZE"
+
+    echo "========================================="
+    echo "Queues: $queues, rules: $rules, flows: $flows, hit ratio: $hit_ratio%"
+    echo "========================================="
+
+    write_pktgen_config "$flows" "$hit_ratio"
+
+    curl -sf "$METRICS_URL" > "$OUTPUT_DIR/metrics_${tag}_before.txt"
+    mpstat -P ALL "$DURATION" 1 > "$OUTPUT_DIR/cpu_${tag}.log" &
+    local cpu_pid=$!
+
+    moongen "$PKTGEN_CONFIG" --dev "$TX_DEV" > "$OUTPUT_DIR/pktgen_${tag}.log" 2>&1
+    wait $cpu_pid || true
+
+    curl -sf "$METRICS_URL" > "$OUTPUT_DIR/metrics_${tag}_after.txt"
+
+    local before="$OUTPUT_DIR/metrics_${tag}_before.txt"
+    local after="$OUTPUT_DIR/metrics_${tag}_after.txt"
+
+    # CPU별 softirq 사용률 (mpstat Average 줄의 %soft 열)
+    local softirq
+    softirq=$(awk '
+        $1 == "Average:" && $2 == "CPU" { for (i = 1; i <= NF; i++) if ($i == "%soft") col = i; next }
+        $1 == "Average:" && col && $2 ~ /^[0-9]+$/ { print $2, $col }' "$OUTPUT_DIR/cpu_${tag}.log")
+
+    # CPU별 처리 패킷 증가량 (stats_map의 CPU별 카운터)
+    metric_delta "$before" "$after" swift_guard_packets_total cpu > "$OUTPUT_DIR/per_cpu_${tag}.txt"
+    while read -r cpu packets; do
+        local soft
+        soft=$(echo "$softirq" | awk -v c="$cpu" '$1 == c { print $2 }')
+        echo "$run,$cpu,$packets,$(awk -v p="$packets" -v d="$DURATION" 'BEGIN { print p / d }'),${soft:-0}" >> "$PER_CPU_CSV"
+    done < "$OUTPUT_DIR/per_cpu_${tag}.txt"
+
+    # 큐별 처리 패킷 증가량
+    metric_delta "$before" "$after" swift_guard_queue_packets_total queue | while read -r queue packets; do
+        echo "$run,$queue,$packets,$(awk -v p="$packets" -v d="$DURATION" 'BEGIN { print p / d }')" >> "$PER_QUEUE_CSV"
+    done
+
+    # 판정별 합계와 CPU 분산 정도
+    local drop pass
+    drop=$(metric_delta "$before" "$after" swift_guard_packets_total verdict | awk '$1 == "drop" { print $2 }')
+    pass=$(metric_delta "$before" "$after" swift_guard_packets_total verdict | awk '$1 == "pass" { print $2 }')
+
+    local summary
+    summary=$(awk -v d="$DURATION" '
+        { total += $2; if ($2 > max) max = $2; if ($2 > 0) active++ }
+        END { printf "%.0f,%d,%.4f", total / d, active, total > 0 ? max / total : 0 }' "$OUTPUT_DIR/per_cpu_${tag}.txt")
+    local pps=${summary%%,*}
+    local rest=${summary#*,}
+
+    local avg_soft
+    avg_soft=$(echo "$softirq" | awk '$2 > 0 { sum += $2; n++ } END { printf "%.2f", n ? sum / n : 0 }')
+
+    echo "$run,$pps,$(awk -v p="${drop:-0}" -v d="$DURATION" 'BEGIN { printf "%.0f", p / d }'),$(awk -v p="${pass:-0}" -v d="$DURATION" 'BEGIN { printf "%.0f", p / d }'),$rest,$avg_soft,$DURATION" >> "$RESULTS_CSV"
+
+    echo "Processed $pps pps across $(echo "$rest" | cut -d, -f1) CPUs"
+    echo ""
+}
+
+# 메인 스크립트
+echo "Starting Swift-Guard scaling test"
+echo "Interface: $INTERFACE (traffic from $TX_DEV)"
+echo "Queue counts: ${QUEUE_COUNTS[*]}"
+echo "Rule counts: ${RULE_COUNTS[*]}"
+echo "Flow counts: ${FLOW_COUNTS[*]}"
+echo "Hit ratios: ${HIT_RATIOS[*]}"
+echo "Results will be saved to $OUTPUT_DIR"
+echo ""
+
+for queues in "${QUEUE_COUNTS[@]}"; do
+    configure_queues "$queues"
+    for rules in "${RULE_COUNTS[@]}"; do
+        install_rules "$rules"
+        for flows in "${FLOW_COUNTS[@]}"; do
+            for hit_ratio in "${HIT_RATIOS[@]}"; do
+                run_test "$queues" "$rules" "$flows" "$hit_ratio"
+                # 시스템 안정화를 위한 대기
+                sleep 2
+            done
+        done
+    done
+done
+
+echo "All tests completed!"
+echo "Results saved to $RESULTS_CSV, $PER_CPU_CSV and $PER_QUEUE_CSV"
+echo ""
+echo "To analyze results, run:"
+echo "  python tools/analysis/analyze_performance.py"
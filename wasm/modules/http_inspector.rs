@@ -196,3 +196,28 @@ pub extern "C" fn inspect_packet(ptr: i32, len: i32) -> i32 {
     
     0 // 패킷 통과
 }
+
+// 일괄 검사 디스크립터 (호스트가 기록하는 struct { u32 ptr; u32 len; })
+#[repr(C)]
+struct PacketDesc {
+    ptr: u32,
+    len: u32,
+}
+
+// 일괄 검사 함수 (WASM 인터페이스, 선택)
+// 비트 i가 1이면 i번째 패킷 차단
+#[no_mangle]
+pub extern "C" fn inspect_batch(ptr: i32, count: i32) -> i64 {
+    let descs = unsafe {
+        std::slice::from_raw_parts(ptr as *const PacketDesc, count.clamp(0, 64) as usize)
+    };
+    
+    let mut verdicts: i64 = 0;
+    for (i, desc) in descs.iter().enumerate() {
+        if inspect_packet(desc.ptr as i32, desc.len as i32) != 0 {
+            verdicts |= 1 << i;
+        }
+    }
+    
+    verdicts
+}